@@ -33,6 +33,7 @@
 #include "scripting/toplevel/XML.h"
 #include "scripting/toplevel/XMLList.h"
 #include "scripting/toplevel/Error.h"
+#include "scripting/toplevel/JSON.h"
 #include "scripting/flash/system/flashsystem.h"
 #include "scripting/flash/net/flashnet.h"
 #include <3rdparty/pugixml/src/pugixml.hpp>
@@ -217,6 +218,8 @@ TRISTATE ASObject::isLessAtom(asAtom& r)
 
 int variables_map::getNextEnumerable(unsigned int start) const
 {
+	if (shape)
+		return start < shapeValues.size() ? int(start) : -1;
 	if(start>=Variables.size())
 		return -1;
 
@@ -521,10 +524,8 @@ void ASObject::call_toString(asAtom &ret)
 	ASATOM_DECREF(o);
 }
 
-tiny_string ASObject::call_toJSON(bool& ok,std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+bool ASObject::call_toJSON(JSONWriter& out, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
 {
-	tiny_string res;
-	ok = false;
 	multiname toJSONName(nullptr);
 	toJSONName.name_type=multiname::NAME_STRING;
 	toJSONName.name_s_id=getSystemState()->getUniqueStringId("toJSON");
@@ -532,32 +533,31 @@ tiny_string ASObject::call_toJSON(bool& ok,std::vector<ASObject *> &path, asAtom
 	toJSONName.ns.emplace_back(getSystemState(),BUILTIN_STRINGS::STRING_AS3NS,NAMESPACE);
 	toJSONName.isAttribute = false;
 	if (!ASObject::hasPropertyByMultiname(toJSONName, true, true,getInstanceWorker()))
-		return res;
+		return false;
 
 	asAtom o=asAtomHandler::invalidAtom;
 	getVariableByMultiname(o,toJSONName,SKIP_IMPL,getInstanceWorker());
 	if (!asAtomHandler::isFunction(o))
 	{
 		ASATOM_DECREF(o);
-		return res;
+		return false;
 	}
 	asAtom v=asAtomHandler::fromObject(this);
 	asAtom ret=asAtomHandler::invalidAtom;
 	asAtomHandler::callFunction(o,getInstanceWorker(), ret,v,nullptr,0,false);
 	ASATOM_DECREF(o);
 	if (getInstanceWorker()->currentCallContext && getInstanceWorker()->currentCallContext->exceptionthrown)
-		return res;
+		return false;
 	if (asAtomHandler::isString(ret))
 	{
-		res += "\"";
-		res += asAtomHandler::toString(ret,getInstanceWorker());
-		res += "\"";
+		out.append('\"');
+		out.append(asAtomHandler::toString(ret,getInstanceWorker()));
+		out.append('\"');
 	}
 	else 
-		res = asAtomHandler::toObject(ret,getInstanceWorker())->toJSON(path,replacer,spaces,filter);
+		asAtomHandler::toObject(ret,getInstanceWorker())->toJSON(out,path,replacer,spaces,filter);
 	ASATOM_DECREF(ret);
-	ok = true;
-	return res;
+	return true;
 }
 
 bool ASObject::isPrimitive() const
@@ -575,6 +575,12 @@ bool ASObject::isConstructed() const
 
 variable* variables_map::findObjVar(uint32_t nameId, const nsNameAndKind& ns, TRAIT_KIND createKind, uint32_t traitKinds)
 {
+	if (shape)
+	{
+		if (createKind==NO_CREATE_TRAIT && (!ns.hasEmptyName() || shape->find(nameId) < 0))
+			return nullptr;
+		convertShape();
+	}
 	var_iterator ret=Variables.find(nameId);
 	while(ret!=Variables.end() && ret->first==nameId)
 	{
@@ -605,7 +611,13 @@ bool ASObject::hasPropertyByMultiname(const multiname& name, bool considerDynami
 	if(considerDynamic)
 		validTraits|=DYNAMIC_TRAIT;
 
-	if(Variables.findObjVar(getSystemState(),name, validTraits)!=nullptr)
+	if (Variables.shape)
+	{
+		// properties in a shape are public dynamic ones
+		if(considerDynamic && Variables.findShapeSlot(getSystemState(),name) >= 0)
+			return true;
+	}
+	else if(Variables.findObjVar(getSystemState(),name, validTraits)!=nullptr)
 		return true;
 
 	if(classdef && classdef->borrowedVariables.findObjVar(getSystemState(),name, DECLARED_TRAIT)!=nullptr)
@@ -847,6 +859,26 @@ multiname *ASObject::setVariableByMultiname_intern(multiname& name, asAtom& o, C
 	check();
 	assert(!cls || classdef->isSubClass(cls));
 	//NOTE: we assume that [gs]etSuper and [sg]etProperty correctly manipulate the cur_level (for getActualClass)
+	if (Variables.shape)
+	{
+		int32_t slot = Variables.findShapeSlot(getSystemState(),name);
+		if (slot >= 0)
+		{
+			if (alreadyset)
+			{
+				if (o.uintval == Variables.getShapeValue(slot).uintval)
+					*alreadyset = true;
+				else
+				{
+					Variables.setShapeVar(slot,o);
+					*alreadyset = false;
+				}
+			}
+			else
+				Variables.setShapeVar(slot,o);
+			return retval;
+		}
+	}
 	bool has_getter=false;
 	variable* obj=findSettable(name, &has_getter);
 
@@ -922,7 +954,14 @@ multiname *ASObject::setVariableByMultiname_intern(multiname& name, asAtom& o, C
 				createError<ReferenceError>(getInstanceWorker(), kWriteSealedError, name.normalizedNameUnresolved(getSystemState()), this->getClassName());
 				return nullptr;
 			}
-			
+			if (Variables.shape && (name.ns.size() != 1 || name.ns[0].hasEmptyName())
+				&& Variables.addShapeVar(name.normalizedNameId(getSystemState()),o))
+			{
+				if (alreadyset)
+					*alreadyset = false;
+				return retval;
+			}
+			Variables.ensureMap();
 			variables_map::var_iterator inserted=Variables.Variables.insert(Variables.Variables.cbegin(),
 				make_pair(name.normalizedNameId(getSystemState()),variable(DYNAMIC_TRAIT,name.ns.size() == 1 ? name.ns[0] : nsNameAndKind())));
 			obj = &inserted->second;
@@ -1071,6 +1110,7 @@ void variables_map::killObjVar(SystemState* sys,const multiname& mname)
 	//The namespaces in the multiname are ordered. So it's possible to use lower_bound
 	//to find the first candidate one and move from it
 	assert(!mname.ns.empty());
+	ensureMap();
 	var_iterator ret=Variables.find(name);
 	auto nsIt=mname.ns.begin();
 
@@ -1104,6 +1144,12 @@ Class_base* variables_map::getSlotType(unsigned int n)
 
 variable* variables_map::findObjVar(SystemState* sys,const multiname& mname, TRAIT_KIND createKind, uint32_t traitKinds)
 {
+	if (shape)
+	{
+		if (createKind==NO_CREATE_TRAIT && findShapeSlot(sys,mname) < 0)
+			return nullptr;
+		convertShape();
+	}
 	uint32_t name=mname.name_type == multiname::NAME_STRING ? mname.name_s_id : mname.normalizedNameId(sys);
 
 	var_iterator ret=Variables.find(name);
@@ -1517,6 +1563,18 @@ GET_VARIABLE_RESULT ASObject::getVariableByMultinameIntern(asAtom &ret, const mu
 	assert(wrk==getWorker());
 	uint32_t nsRealId;
 	GET_VARIABLE_RESULT res = GET_VARIABLE_RESULT::GETVAR_NORMAL;
+	if (Variables.shape)
+	{
+		int32_t slot = Variables.findShapeSlot(getSystemState(),name);
+		// functions may have to be bound to this object, leave them to the map
+		if (slot >= 0 && !asAtomHandler::isFunction(Variables.getShapeValue(slot)))
+		{
+			asAtomHandler::set(ret,Variables.getShapeValue(slot));
+			if (!(opt & NO_INCREF))
+				ASATOM_INCREF(ret);
+			return res;
+		}
+	}
 	variable* obj=Variables.findObjVar(getSystemState(),name,((opt & FROM_GETLEX) || name.hasEmptyNS || name.hasBuiltinNS || name.ns.empty()) ? DECLARED_TRAIT|DYNAMIC_TRAIT : DECLARED_TRAIT,&nsRealId);
 	if(obj)
 	{
@@ -1739,6 +1797,7 @@ void variables_map::check() const
 
 void variables_map::dumpVariables()
 {
+	ensureMap();
 	var_iterator it=Variables.begin();
 	for(;it!=Variables.end();++it)
 	{
@@ -1780,6 +1839,20 @@ variables_map::~variables_map()
 
 void variables_map::destroyContents()
 {
+	if (shape)
+	{
+		ObjectShape::objectReleased(shapeValues.size());
+		shape=nullptr;
+		// release the values after the object doesn't reference them anymore, as in the map case
+		std::vector<asAtom> values;
+		values.swap(shapeValues);
+		for (auto it = values.begin(); it != values.end(); it++)
+		{
+			ASObject* o = asAtomHandler::getObject(*it);
+			if (o)
+				o->removeStoredMember();
+		}
+	}
 	while(!Variables.empty())
 	{
 		var_iterator it=Variables.begin();
@@ -1800,8 +1873,53 @@ void variables_map::destroyContents()
 	slots_vars.clear();
 	slotcount=0;
 }
+void variables_map::convertShape()
+{
+	assert(shape && Variables.empty());
+	ObjectShape::objectConverted();
+	Variables.reserve(shapeValues.size());
+	for (uint32_t i = 0; i < shapeValues.size(); i++)
+	{
+		// the stored member references move to the map
+		var_iterator inserted=Variables.insert(Variables.cbegin(),
+				make_pair(shape->getNameAt(i),variable(DYNAMIC_TRAIT,nsNameAndKind())));
+		inserted->second.var = shapeValues[i];
+	}
+	shape=nullptr;
+	shapeValues.clear();
+	shapeValues.shrink_to_fit();
+}
+bool variables_map::addShapeVar(uint32_t nameId, asAtom& v)
+{
+	ObjectShape* s = shape->addProperty(nameId);
+	if (!s)
+		return false;
+	shape=s;
+	ASObject* o = asAtomHandler::getObject(v);
+	if (o && !o->getConstant())
+		o->addStoredMember();
+	shapeValues.push_back(v);
+	return true;
+}
+void variables_map::setShapeVar(uint32_t slot, asAtom& v)
+{
+	asAtom oldvar = shapeValues[slot];
+	shapeValues[slot]=v;
+	ASObject* o = asAtomHandler::getObject(oldvar);
+	if (o && !o->getConstant())
+		o->removeStoredMember();
+	o = asAtomHandler::getObject(v);
+	if (o && !o->getConstant())
+		o->addStoredMember();
+}
 void variables_map::prepareShutdown()
 {
+	for (auto itv = shapeValues.begin(); itv != shapeValues.end(); itv++)
+	{
+		ASObject* v = asAtomHandler::getObject(*itv);
+		if (v)
+			v->prepareShutdown();
+	}
 	var_iterator it=Variables.begin();
 	while(it!=Variables.end())
 	{
@@ -1819,9 +1937,11 @@ void variables_map::prepareShutdown()
 }
 bool variables_map::cloneInstance(variables_map &map)
 {
-	if (!cloneable)
+	if (!cloneable || shape)
 		return false;
 	map.Variables = Variables;
+	// all slots are known, so avoid the over-allocation done in initSlot
+	map.slots_vars.reserve(slotcount);
 	auto it = map.Variables.begin();
 	while (it !=map.Variables.end())
 	{
@@ -1847,36 +1967,48 @@ void variables_map::removeAllDeclaredProperties()
 	}
 }
 
-bool variables_map::countCylicMemberReferences(garbagecollectorstate& gcstate, ASObject* parent)
+bool variables_map::countCylicMemberReference(garbagecollectorstate& gcstate, ASObject* parent, ASObject* o)
 {
-	gcstate.ancestors.insert(parent);
 	bool ret = false;
-	auto it=Variables.cbegin();
-	while(it!=Variables.cend())
+	if (o && !o->getCached() && !o->getConstant() && !o->getInDestruction() && o->canHaveCyclicMemberReference() && !o->getInstanceWorker()->isDeletedInGarbageCollection(o))
 	{
-		ASObject* o = asAtomHandler::getObject(it->second.var);
-		if (it->second.isrefcounted && o && !o->getCached() && !o->getConstant() && !o->getInDestruction() && o->canHaveCyclicMemberReference() && !o->getInstanceWorker()->isDeletedInGarbageCollection(o))
+		if (o==gcstate.startobj)
 		{
-			if (o==gcstate.startobj)
+			gcstate.incCount(o);
+			ret = true;
+		}
+		else if ((uint32_t)o->getRefCount()==o->storedmembercount && o != parent)
+		{
+			if (o->countAllCylicMemberReferences(gcstate))
 			{
-				gcstate.incCount(o);
+				auto itc = gcstate.checkedobjects.find(o);
+				(*itc).second.hasmember=true;
 				ret = true;
 			}
-			else if ((uint32_t)o->getRefCount()==o->storedmembercount && o != parent)
-			{
-				if (o->countAllCylicMemberReferences(gcstate))
-				{
-					auto itc = gcstate.checkedobjects.find(o);
-					(*itc).second.hasmember=true;
-					ret = true;
-				}
-			}
-			if (parent == gcstate.startobj)
-			{
-				gcstate.ancestors.clear();
-				gcstate.ancestors.insert(parent);
-			}
 		}
+		if (parent == gcstate.startobj)
+		{
+			gcstate.ancestors.clear();
+			gcstate.ancestors.insert(parent);
+		}
+	}
+	return ret;
+}
+
+bool variables_map::countCylicMemberReferences(garbagecollectorstate& gcstate, ASObject* parent)
+{
+	gcstate.ancestors.insert(parent);
+	bool ret = false;
+	for (auto itv = shapeValues.cbegin(); itv != shapeValues.cend(); itv++)
+	{
+		if (countCylicMemberReference(gcstate,parent,asAtomHandler::getObject(*itv)))
+			ret = true;
+	}
+	auto it=Variables.cbegin();
+	while(it!=Variables.cend())
+	{
+		if (it->second.isrefcounted && countCylicMemberReference(gcstate,parent,asAtomHandler::getObject(it->second.var)))
+			ret = true;
 		it++;
 	}
 	return ret;
@@ -2239,6 +2371,7 @@ bool ASObject::AVM1HandleMouseEventStandard(ASObject *dispobj,MouseEvent *e)
 
 void ASObject::AVM1UpdateAllBindings(DisplayObject* target, ASWorker* wrk)
 {
+	Variables.ensureMap();
 	auto it = Variables.Variables.begin();
 	while (it != Variables.Variables.end())
 	{
@@ -2253,6 +2386,7 @@ void ASObject::AVM1UpdateAllBindings(DisplayObject* target, ASWorker* wrk)
 
 void ASObject::copyValues(ASObject *target,ASWorker* wrk)
 {
+	Variables.ensureMap();
 	auto it = Variables.Variables.begin();
 	while (it != Variables.Variables.end())
 	{
@@ -2299,6 +2433,7 @@ uint32_t variables_map::findInstanceSlotByMultiname(multiname* name,SystemState*
 
 variable* variables_map::getValueAt(unsigned int index)
 {
+	ensureMap();
 	//TODO: CHECK behaviour on overridden methods
 	if(index<Variables.size())
 	{
@@ -2317,6 +2452,13 @@ variable* variables_map::getValueAt(unsigned int index)
 
 void ASObject::getValueAt(asAtom &ret,int index)
 {
+	if (Variables.shape)
+	{
+		assert_and_throw(uint32_t(index) < Variables.size());
+		ret = Variables.getShapeValue(index);
+		ASATOM_INCREF(ret);
+		return;
+	}
 	variable* obj=Variables.getValueAt(index);
 	assert_and_throw(obj);
 	if(asAtomHandler::isValid(obj->getter))
@@ -2336,6 +2478,12 @@ void ASObject::getValueAt(asAtom &ret,int index)
 
 uint32_t variables_map::getNameAt(unsigned int index) const
 {
+	if (shape)
+	{
+		if (index < shapeValues.size())
+			return shape->getNameAt(index);
+		throw RunTimeException("getNameAt out of bounds");
+	}
 	//TODO: CHECK behaviour on overridden methods
 	if(index<Variables.size())
 	{
@@ -2400,6 +2548,7 @@ void variables_map::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& s
 				std::map<const Class_base*, uint32_t>& traitsMap, bool forsharedobject, ASWorker* wrk)
 {
 	bool amf0 = out->getObjectEncoding() == OBJECT_ENCODING::AMF0;
+	ensureMap();
 	//Pairs of name, value
 	auto it=Variables.begin();
 	for(;it!=Variables.end();it++)
@@ -2509,6 +2658,7 @@ void ASObject::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& string
 	objMap.insert(make_pair(this, objMap.size()));
 
 	uint32_t traitsCount=0;
+	Variables.ensureMap();
 	const variables_map::var_iterator beginIt = Variables.Variables.begin();
 	const variables_map::var_iterator endIt = Variables.Variables.end();
 	//Check if the class traits has been already serialized to send it by reference
@@ -2630,25 +2780,35 @@ ASObject *ASObject::describeType(ASWorker* wrk) const
 	return XML::createFromNode(wrk,root);
 }
 
-tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+static void appendJSONKey(JSONWriter& out, const tiny_string& name, const tiny_string& spaces, bool bfirst)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (!bfirst)
+		out.append(',');
+	out.appendIndent(spaces,spaces.numBytes());
+	out.append('\"');
+	out.append(name);
+	out.append('\"');
+	out.append(':');
+	if (!spaces.empty())
+		out.append(' ');
+}
+
+void ASObject::toJSON(JSONWriter& out, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+{
+	if (call_toJSON(out,path,replacer,spaces,filter))
+		return;
 
-	tiny_string newline = (spaces.empty() ? "" : "\n");
 	if (this->isPrimitive())
 	{
 		switch(this->type)
 		{
 			case T_STRING:
 			{
-				res = this->toString().toQuotedString();
+				out.appendQuoted(this->toString());
 				break;
 			}
 			case T_UNDEFINED:
-				res += "null";
+				out.append("null");
 				break;
 			case T_NUMBER:
 			case T_INTEGER:
@@ -2656,22 +2816,23 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 			{
 				tiny_string s = this->toString();
 				if (s == "Infinity" || s == "-Infinity" || s == "NaN")
-					res += "null";
+					out.append("null");
 				else
-					res += s;
+					out.append(s);
 				break;
 			}
 			default:
-				res += this->toString();
+				out.append(this->toString());
 				break;
 		}
 	}
 	else
 	{
-		res += "{";
+		out.append('{');
 		
 		// 
 		std::vector<uint32_t> tmp;
+		Variables.ensureMap();
 		variables_map::var_iterator beginIt = Variables.Variables.begin();
 		variables_map::var_iterator endIt = Variables.Variables.end();
 		variables_map::var_iterator varIt = beginIt;
@@ -2683,6 +2844,7 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 		std::sort(tmp.begin(),tmp.end());
 		bool bfirst = true;
 		bool bObjectVars = true;
+		tiny_string childspaces = spaces+spaces;
 		path.push_back(this);
 		auto tmpIt = tmp.begin();
 		while (tmpIt != tmp.end())
@@ -2708,87 +2870,82 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 				continue;
 			if(varIt->second.ns.hasEmptyName() && (asAtomHandler::isValid(varIt->second.getter) || asAtomHandler::isValid(varIt->second.var)))
 			{
-				ASObject* v = nullptr;
-				bool newobj = false;
+				asAtom value = asAtomHandler::invalidAtom;
 				if (asAtomHandler::isValid(varIt->second.var))
-				{
-					asAtom tmp = varIt->second.var;
-					newobj = !asAtomHandler::isObject(varIt->second.var); // variable is not a pointer to an ASObject, so toObject() will create a temporary ASObject that has to be decreffed after usage
-					v = asAtomHandler::toObject(tmp,getInstanceWorker());
-				}
+					value = varIt->second.var;
 				else if (asAtomHandler::isValid(varIt->second.getter))
 				{
 					asAtom t=asAtomHandler::fromObject(this);
-					asAtom res=asAtomHandler::invalidAtom;
-					asAtomHandler::callFunction(varIt->second.getter,getInstanceWorker(),res,t,NULL,0,false);
-					newobj = !asAtomHandler::isObject(res); // result is not a pointer to an ASObject, so toObject() will create a temporary ASObject that has to be decreffed after usage
-					asAtom tmp = res;
-					v=asAtomHandler::toObject(tmp,getInstanceWorker());
+					asAtomHandler::callFunction(varIt->second.getter,getInstanceWorker(),value,t,NULL,0,false);
 				}
-				if(v && v->getObjectType() != T_UNDEFINED && varIt->second.isenumerable)
+				if (!asAtomHandler::isObject(value) && asAtomHandler::isInvalid(replacer))
 				{
-					// check for cylic reference
-					if (v->getObjectType() != T_UNDEFINED &&
-						v->getObjectType() != T_NULL &&
-						v->getObjectType() != T_BOOLEAN &&
-						std::find(path.begin(),path.end(), v) != path.end())
-					{
-						createError<TypeError>(getInstanceWorker(), kJSONCyclicStructure);
-						return res;
-					}
-					if (asAtomHandler::isValid(replacer))
+					// values that are not pointers to an ASObject are written without creating a temporary ASObject
+					if (!asAtomHandler::isUndefined(value) && varIt->second.isenumerable
+						&& (filter.empty() || filter.find(tiny_string(" ")+getSystemState()->getStringFromUniqueId(varIt->first)+" ") != tiny_string::npos))
 					{
-						if (!bfirst)
-							res += ",";
-						res += newline+spaces;
-						res += "\"";
-						res += getSystemState()->getStringFromUniqueId(varIt->first);
-						res += "\"";
-						res += ":";
-						if (!spaces.empty())
-							res += " ";
-						asAtom params[2];
-						
-						params[0] = asAtomHandler::fromStringID(varIt->first);
-						params[1] = asAtomHandler::fromObject(v);
-						ASATOM_INCREF(params[1]);
-						asAtom funcret=asAtomHandler::invalidAtom;
-						asAtomHandler::callFunction(replacer,getInstanceWorker(),funcret,asAtomHandler::nullAtom, params, 2,true);
-						if (asAtomHandler::isValid(funcret))
+						appendJSONKey(out,getSystemState()->getStringFromUniqueId(varIt->first),spaces,bfirst);
+						if (!out.appendPrimitive(value))
 						{
-							res += asAtomHandler::toString(funcret,getInstanceWorker());
-							ASATOM_DECREF(funcret);
+							ASObject* v = asAtomHandler::toObject(value,getInstanceWorker());
+							v->toJSON(out,path,replacer,childspaces,filter);
+							v->decRef();
 						}
-						else
-							res += v->toJSON(path,replacer,spaces+spaces,filter);
 						bfirst = false;
 					}
-					else if (filter.empty() || filter.find(tiny_string(" ")+getSystemState()->getStringFromUniqueId(varIt->first)+" ") != tiny_string::npos)
+				}
+				else
+				{
+					bool newobj = !asAtomHandler::isObject(value); // variable is not a pointer to an ASObject, so toObject() will create a temporary ASObject that has to be decreffed after usage
+					ASObject* v = asAtomHandler::toObject(value,getInstanceWorker());
+					if(v && v->getObjectType() != T_UNDEFINED && varIt->second.isenumerable)
 					{
-						if (!bfirst)
-							res += ",";
-						res += newline+spaces;
-						res += "\"";
-						res += getSystemState()->getStringFromUniqueId(varIt->first);
-						res += "\"";
-						res += ":";
-						if (!spaces.empty())
-							res += " ";
-						res += v->toJSON(path,replacer,spaces+spaces,filter);
-						bfirst = false;
+						// check for cylic reference
+						if (v->getObjectType() != T_UNDEFINED &&
+							v->getObjectType() != T_NULL &&
+							v->getObjectType() != T_BOOLEAN &&
+							std::find(path.begin(),path.end(), v) != path.end())
+						{
+							createError<TypeError>(getInstanceWorker(), kJSONCyclicStructure);
+							return;
+						}
+						if (asAtomHandler::isValid(replacer))
+						{
+							appendJSONKey(out,getSystemState()->getStringFromUniqueId(varIt->first),spaces,bfirst);
+							asAtom params[2];
+							
+							params[0] = asAtomHandler::fromStringID(varIt->first);
+							params[1] = asAtomHandler::fromObject(v);
+							ASATOM_INCREF(params[1]);
+							asAtom funcret=asAtomHandler::invalidAtom;
+							asAtomHandler::callFunction(replacer,getInstanceWorker(),funcret,asAtomHandler::nullAtom, params, 2,true);
+							if (asAtomHandler::isValid(funcret))
+							{
+								out.append(asAtomHandler::toString(funcret,getInstanceWorker()));
+								ASATOM_DECREF(funcret);
+							}
+							else
+								v->toJSON(out,path,replacer,childspaces,filter);
+							bfirst = false;
+						}
+						else if (filter.empty() || filter.find(tiny_string(" ")+getSystemState()->getStringFromUniqueId(varIt->first)+" ") != tiny_string::npos)
+						{
+							appendJSONKey(out,getSystemState()->getStringFromUniqueId(varIt->first),spaces,bfirst);
+							v->toJSON(out,path,replacer,childspaces,filter);
+							bfirst = false;
+						}
 					}
-				}
 
-				if (newobj)
-					v->decRef();
+					if (newobj)
+						v->decRef();
+				}
 				if (!bfirst)
-					res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
+					out.appendIndent(spaces,spaces.numBytes()/2);
 			}
 		}
-		res += "}";
+		out.append('}');
 		path.pop_back();
 	}
-	return res;
 }
 
 bool ASObject::hasprop_prototype()
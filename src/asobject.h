@@ -21,6 +21,7 @@
 #define ASOBJECT_H 1
 
 #include "swftypes.h"
+#include "object_shape.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <limits>
@@ -274,6 +275,7 @@ class IFunction;
 template<class T> class Class;
 class Class_base;
 class ByteArray;
+class JSONWriter;
 class Loader;
 class Type;
 class ABCContext;
@@ -678,9 +680,59 @@ public:
 	uint32_t slotcount;
 	// indicates if this map was initialized with no variables with non-primitive values
 	bool cloneable;
-	variables_map():slotcount(0),cloneable(true)
+	/*
+	 * Objects created by newObject store their dynamic properties in a shared
+	 * shape and the values in shapeValues, in the order of the shape.
+	 * All these properties are public, enumerable and untyped. Anything the
+	 * shape can not express converts the object to the map, Variables is
+	 * empty as long as shape is set
+	 */
+	ObjectShape* shape;
+	std::vector<asAtom> shapeValues;
+	variables_map():slotcount(0),cloneable(true),shape(nullptr)
+	{
+	}
+	// starts storing the dynamic properties in a shape, the map has to be empty
+	FORCE_INLINE void initShape(uint32_t capacity)
+	{
+		assert(Variables.empty() && !shape);
+		shape = ObjectShape::getRoot();
+		shapeValues.reserve(capacity);
+		ObjectShape::objectCreated();
+	}
+	// moves the properties of the shape into the map
+	void convertShape();
+	// converting the storage does not change any property, so it is done from const methods as well
+	FORCE_INLINE void ensureMap() const
 	{
+		if (shape)
+			const_cast<variables_map*>(this)->convertShape();
 	}
+	// position of the property in the shape or -1
+	FORCE_INLINE int32_t findShapeSlot(SystemState* sys, const multiname& mname) const
+	{
+		if (mname.isEmpty())
+			return -1;
+		uint32_t name=mname.name_type == multiname::NAME_STRING ? mname.name_s_id : mname.normalizedNameId(sys);
+		int32_t slot = shape->find(name);
+		if (slot < 0 || mname.ns.empty() || mname.hasEmptyNS)
+			return slot;
+		// all properties in a shape are in the empty namespace
+		for (auto it = mname.ns.cbegin(); it != mname.ns.cend(); it++)
+		{
+			if (it->hasEmptyName())
+				return slot;
+		}
+		return -1;
+	}
+	FORCE_INLINE asAtom getShapeValue(uint32_t slot) const
+	{
+		return shapeValues[slot];
+	}
+	// adds a new property to the shape, the reference of v is taken over. Returns false if the shape is full
+	bool addShapeVar(uint32_t nameId, asAtom& v);
+	// same as variable::setVar for the property at slot
+	void setShapeVar(uint32_t slot, asAtom& v);
 	/**
 	   Find a variable in the map
 
@@ -699,6 +751,12 @@ public:
 	{
 		if (mname.isEmpty())
 			return nullptr;
+		if (shape)
+		{
+			if (findShapeSlot(sys,mname) < 0)
+				return nullptr;
+			ensureMap();
+		}
 		uint32_t name=mname.name_type == multiname::NAME_STRING ? mname.name_s_id : mname.normalizedNameId(sys);
 		bool noNS = mname.ns.empty(); // no Namespace in multiname means we don't care about the namespace and take the first match
 		const_var_iterator ret=Variables.find(name);
@@ -738,6 +796,12 @@ public:
 	{
 		if (mname.isEmpty())
 			return nullptr;
+		if (shape)
+		{
+			if (findShapeSlot(sys,mname) < 0)
+				return nullptr;
+			convertShape();
+		}
 		uint32_t name=mname.name_type == multiname::NAME_STRING ? mname.name_s_id : mname.normalizedNameId(sys);
 		bool noNS = mname.ns.empty(); // no Namespace in multiname means we don't care about the namespace and take the first match
 
@@ -818,7 +882,7 @@ public:
 	}
 	FORCE_INLINE  unsigned int size() const
 	{
-		return Variables.size();
+		return shape ? shapeValues.size() : Variables.size();
 	}
 	uint32_t getNameAt(unsigned int i) const;
 	variable* getValueAt(unsigned int i);
@@ -834,6 +898,8 @@ public:
 	bool cloneInstance(variables_map& map);
 	void removeAllDeclaredProperties();
 	bool countCylicMemberReferences(garbagecollectorstate& gcstate, ASObject* parent);
+private:
+	bool countCylicMemberReference(garbagecollectorstate& gcstate, ASObject* parent, ASObject* o);
 };
 
 enum METHOD_TYPE { NORMAL_METHOD=0, SETTER_METHOD=1, GETTER_METHOD=2 };
@@ -1252,7 +1318,8 @@ public:
 	void call_valueOf(asAtom &ret);
 	bool has_toString();
 	void call_toString(asAtom &ret);
-	tiny_string call_toJSON(bool &ok, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter);
+	// returns false if the object has no toJSON method
+	bool call_toJSON(JSONWriter& out, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter);
 
 	/* Helper function for calling getClass()->getQualifiedClassName() */
 	virtual tiny_string getClassName() const;
@@ -1299,7 +1366,7 @@ public:
 
 	virtual ASObject *describeType(ASWorker* wrk) const;
 
-	virtual tiny_string toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter);
+	virtual void toJSON(JSONWriter& out, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter);
 	/* returns true if the current object is of type T */
 	template<class T> bool is() const { 
 		LOG(LOG_INFO,"dynamic cast:"<<this->getClassName());
@@ -1371,6 +1438,7 @@ FORCE_INLINE void variables_map::setSlotNoCoerce(unsigned int n, asAtom o)
 }
 FORCE_INLINE void variables_map::setDynamicVarNoCheck(uint32_t nameID,asAtom& v)
 {
+	ensureMap();
 	var_iterator inserted=Variables.insert(Variables.cbegin(),
 			make_pair(nameID,variable(DYNAMIC_TRAIT,nsNameAndKind())));
 	ASObject* o = asAtomHandler::getObject(v);
@@ -21,6 +21,7 @@
 #include "backends/audio.h"
 #include "backends/config.h"
 #include "platforms/engineutils.h"
+#include "platforms/fastpaths.h"
 #include <iostream>
 #include "logger.h"
 #include <sys/time.h>
@@ -29,6 +30,37 @@
 using namespace lightspark;
 using namespace std;
 
+AudioRingBuffer::AudioRingBuffer(uint32_t capacity):mask(0),readPos(0),writePos(0)
+{
+	uint32_t size=1;
+	while(size<capacity)
+		size<<=1;
+	data.resize(size);
+	mask=size-1;
+}
+
+uint32_t AudioRingBuffer::write(const float* src, uint32_t count)
+{
+	uint32_t w=writePos.load(std::memory_order_relaxed);
+	count=min(count,freeSpace());
+	uint32_t first=min(count,uint32_t(data.size())-(w&mask));
+	memcpy(data.data()+(w&mask),src,first*sizeof(float));
+	memcpy(data.data(),src+first,(count-first)*sizeof(float));
+	writePos.store(w+count,std::memory_order_release);
+	return count;
+}
+
+uint32_t AudioRingBuffer::read(float* dest, uint32_t count)
+{
+	uint32_t r=readPos.load(std::memory_order_relaxed);
+	count=min(count,available());
+	uint32_t first=min(count,uint32_t(data.size())-(r&mask));
+	memcpy(dest,data.data()+(r&mask),first*sizeof(float));
+	memcpy(dest+first,data.data(),(count-first)*sizeof(float));
+	readPos.store(r+count,std::memory_order_release);
+	return count;
+}
+
 uint32_t AudioStream::getPlayedTime()
 {
 	uint32_t ret;
@@ -122,12 +154,31 @@ bool AudioStream::getIsDone() const
 	return ACQUIRE_READ(isdone);
 }
 
+void AudioStream::fillOutput()
+{
+	float buf[AUDIO_MIXER_BLOCKSIZE*2];
+	while (true)
+	{
+		uint32_t len=min(output.freeSpace(),uint32_t(AUDIO_MIXER_BLOCKSIZE*2))*sizeof(float);
+		if (!len)
+			break;
+		uint32_t ret=decoder->copyFrameF32(buf,len);
+		if (!ret)
+			break;
+		output.write(buf,ret/sizeof(float));
+	}
+}
+
 AudioStream::~AudioStream()
 {
 }
 
-AudioManager::AudioManager(EngineData *engine):muteAllStreams(false),audio_available(false),mixeropened(0),engineData(engine),device(0)
+AudioManager::AudioManager(EngineData *engine):muteAllStreams(false),audio_available(false),mixeropened(0),engineData(engine)
+	,mixerOutput(nullptr),mixerThread(nullptr),feederThread(nullptr),mixerRunning(false),mixingStreams(false),outputSampleRate(0),resampleStep(0x10000),resamplePos(0)
+	,wavUnpaced(false),framesMixed(0),mixingTime(0),underruns(0),device(0)
 {
+	for (uint32_t i = 0; i < AUDIO_MIXER_CHANNELS; i++)
+		mixerChannels[i].store(nullptr);
 	audio_available = engine->audio_ManagerInit();
 	mixeropened = 0;
 }
@@ -154,9 +205,17 @@ void AudioManager::removeStream(AudioStream *s)
 {
 	streamMutex.lock();
 	streams.remove(s);
-	s->deinit();
-	delete s;
-	if (streams.empty())
+	if (s->mixerSlot >= 0 && s->getDecoder()->isFlushed() && !s->ispaused() && s->output.available())
+	{
+		//Let the mixer play what is left in the buffer of a stream that was played until its end,
+		//the feeder thread releases it when it is drained
+		s->decoder=nullptr;
+		closingStreams.push_back(s);
+	}
+	else
+		releaseStream(s);
+	//When rendering to a file the mixer keeps running, so that silence is recorded too
+	if (streams.empty() && closingStreams.empty() && !wavFile.is_open())
 	{
 		streamMutex.unlock();
 		managerMutex.lock();
@@ -169,6 +228,19 @@ void AudioManager::removeStream(AudioStream *s)
 		
 }
 
+void AudioManager::releaseStream(AudioStream* s)
+{
+	if (s->mixerSlot >= 0)
+	{
+		//Wait until the mixer doesn't read from the stream anymore
+		mixerChannels[s->mixerSlot].store(nullptr);
+		while (mixingStreams.load())
+			compat_msleep(1);
+	}
+	s->deinit();
+	delete s;
+}
+
 void AudioManager::stopAllSounds()
 {
 	// use temporary list of producers to avoid deadlock, as threadAbort() leads to removeStream();
@@ -211,16 +283,252 @@ AudioStream* AudioManager::createStream(AudioDecoder* decoder, bool startpaused,
 		delete stream;
 		return nullptr;
 	}
+	if (mixerThread)
+	{
+		for (uint32_t i = 0; i < AUDIO_MIXER_CHANNELS && stream->mixerSlot < 0; i++)
+		{
+			if (!mixerChannels[i].load())
+				stream->mixerSlot = i;
+		}
+		if (stream->mixerSlot < 0)
+		{
+			LOG(LOG_ERROR,"audio mixer: no free channel");
+			stream->deinit();
+			delete stream;
+			return nullptr;
+		}
+	}
 	if (startpaused)
 		stream->pause();
 	else
 		stream->hasStarted=true;
 	streams.push_back(stream);
+	if (stream->mixerSlot >= 0)
+		mixerChannels[stream->mixerSlot].store(stream);
 
 	return stream;
 }
 
 
+bool AudioManager::startMixer(uint32_t sampleRate, const tiny_string& wavfile, bool unpaced)
+{
+	assert(!mixerThread);
+	outputSampleRate=sampleRate;
+	//The decoders resample to the engine sample rate, the device may have chosen a different one
+	resampleStep=(uint64_t(engineData->audio_getSampleRate())<<16)/sampleRate;
+	resamplePos=0;
+	mixedFrames.clear();
+	framesMixed=0;
+	mixingTime=0;
+	underruns=0;
+	if (!wavfile.empty())
+	{
+		wavFile.open(wavfile.raw_buf(), ios::out|ios::binary|ios::trunc);
+		if (!wavFile.is_open())
+		{
+			LOG(LOG_ERROR,"audio mixer: unable to open " << wavfile);
+			return false;
+		}
+		writeWAVHeader();
+		wavUnpaced=unpaced;
+	}
+	else
+		mixerOutput=new AudioRingBuffer(AUDIO_MIXER_BUFFERSIZE*2);
+	RELEASE_WRITE(mixerRunning,true);
+	mixerThread=SDL_CreateThread(mixerWorker,"AudioMixer",this);
+	feederThread=SDL_CreateThread(feederWorker,"AudioFeeder",this);
+	LOG(LOG_INFO,"audio mixer started at " << sampleRate << " Hz, "
+		<< (wavFile.is_open() ? "rendering to "+string(wavfile.raw_buf())+(wavUnpaced ? " unpaced" : "") : "buffer latency "+to_string(AUDIO_MIXER_BUFFERSIZE*1000/sampleRate)+" ms"));
+	return true;
+}
+
+void AudioManager::stopMixer()
+{
+	if (!mixerThread)
+		return;
+	RELEASE_WRITE(mixerRunning,false);
+	SDL_WaitThread(mixerThread,nullptr);
+	mixerThread=nullptr;
+	SDL_WaitThread(feederThread,nullptr);
+	feederThread=nullptr;
+	{
+		Locker l(streamMutex);
+		for (auto it = closingStreams.begin(); it != closingStreams.end(); it++)
+			releaseStream(*it);
+		closingStreams.clear();
+	}
+	if (wavFile.is_open())
+	{
+		writeWAVHeader();
+		wavFile.close();
+	}
+	delete mixerOutput;
+	mixerOutput=nullptr;
+	LOG(LOG_INFO,"audio mixer: " << framesMixed << " frames (" << framesMixed*1000/outputSampleRate << " ms) mixed in "
+		<< mixingTime/1000 << " ms cpu time, " << underruns << " underruns");
+}
+
+void AudioManager::readMixedSamples(float* dest, uint32_t count)
+{
+	uint32_t read=mixerOutput ? mixerOutput->read(dest,count) : 0;
+	if (read<count)
+	{
+		memset(dest+read,0,(count-read)*sizeof(float));
+		if (mixerThread)
+			ATOMIC_INCREMENT(underruns);
+	}
+}
+
+int AudioManager::mixerWorker(void* d)
+{
+	AudioManager* th=(AudioManager*)d;
+	SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+	vector<float> block(AUDIO_MIXER_BLOCKSIZE*2);
+	uint64_t start=compat_msectiming();
+	while(ACQUIRE_READ(th->mixerRunning))
+	{
+		if (th->wavFile.is_open())
+		{
+			//The streams are fed in real time, so rendering to a file is paced by the clock,
+			//unpaced rendering also mixes ahead of it as long as every playing stream has samples
+			uint64_t due=(compat_msectiming()-start)*th->outputSampleRate/1000;
+			uint32_t needed=((uint64_t(AUDIO_MIXER_BLOCKSIZE)*th->resampleStep)>>16)+2;
+			while(th->framesMixed+AUDIO_MIXER_BLOCKSIZE<=due || (th->wavUnpaced && th->streamsReady(needed)))
+			{
+				th->mixBlock(block.data(),AUDIO_MIXER_BLOCKSIZE);
+				th->wavFile.write((const char*)block.data(),block.size()*sizeof(float));
+			}
+		}
+		else
+		{
+			while(th->mixerOutput->freeSpace()>=block.size())
+			{
+				th->mixBlock(block.data(),AUDIO_MIXER_BLOCKSIZE);
+				th->mixerOutput->write(block.data(),block.size());
+			}
+		}
+		compat_msleep(AUDIO_MIXER_INTERVAL);
+	}
+	return 0;
+}
+
+int AudioManager::feederWorker(void* d)
+{
+	AudioManager* th=(AudioManager*)d;
+	while(ACQUIRE_READ(th->mixerRunning))
+	{
+		th->feedStreams();
+		compat_msleep(AUDIO_MIXER_INTERVAL);
+	}
+	return 0;
+}
+
+void AudioManager::feedStreams()
+{
+	Locker l(streamMutex);
+	for (auto it = streams.begin(); it != streams.end(); it++)
+	{
+		if (!(*it)->ispaused() && (*it)->mixerSlot >= 0)
+			(*it)->fillOutput();
+	}
+	for (auto it = closingStreams.begin(); it != closingStreams.end();)
+	{
+		if ((*it)->output.available())
+			it++;
+		else
+		{
+			releaseStream(*it);
+			it = closingStreams.erase(it);
+		}
+	}
+}
+
+bool AudioManager::streamsReady(uint32_t frames)
+{
+	//Only called by the mixer thread, a stream may be removed concurrently so mixingStreams is set as in mixStreams
+	bool ready=false;
+	mixingStreams.store(true);
+	for (uint32_t i = 0; i < AUDIO_MIXER_CHANNELS; i++)
+	{
+		AudioStream* s = mixerChannels[i].load();
+		if (!s || s->ispaused())
+			continue;
+		if (s->output.available() < frames*2)
+		{
+			ready=false;
+			break;
+		}
+		ready=true;
+	}
+	mixingStreams.store(false);
+	return ready;
+}
+
+void AudioManager::mixBlock(float* dest, uint32_t frames)
+{
+	uint64_t t=compat_get_thread_cputime_us();
+	if (resampleStep==0x10000)
+		mixStreams(dest,frames);
+	else
+	{
+		//mixedFrames keeps the frames at the decoders rate that are still needed for interpolation
+		uint32_t needed=((resamplePos+uint64_t(frames-1)*resampleStep)>>16)+2;
+		uint32_t have=mixedFrames.size()/2;
+		if (needed>have)
+		{
+			mixedFrames.resize(needed*2);
+			mixStreams(mixedFrames.data()+have*2,needed-have);
+		}
+		resamplePos=fastResampleStereoF32(mixedFrames.data(),dest,frames,resamplePos,resampleStep);
+		uint32_t consumed=min(uint32_t(resamplePos>>16),needed);
+		mixedFrames.erase(mixedFrames.begin(),mixedFrames.begin()+consumed*2);
+		resamplePos-=uint64_t(consumed)<<16;
+	}
+	framesMixed+=frames;
+	mixingTime+=compat_get_thread_cputime_us()-t;
+}
+
+void AudioManager::mixStreams(float* dest, uint32_t frames)
+{
+	memset(dest,0,frames*2*sizeof(float));
+	streamFrames.resize(frames*2);
+	//removeStream waits for mixingStreams to be cleared before the stream is deleted
+	mixingStreams.store(true);
+	for (uint32_t i = 0; i < AUDIO_MIXER_CHANNELS; i++)
+	{
+		AudioStream* s = mixerChannels[i].load();
+		if (!s || s->ispaused())
+			continue;
+		s->startMixing();
+		uint32_t readcount = s->output.read(streamFrames.data(),frames*2);
+		float volume=s->getVolume();
+		fastMixStereoF32(dest,streamFrames.data(),readcount/2,volume*s->getPanning()[0],volume*s->getPanning()[1]);
+	}
+	mixingStreams.store(false);
+}
+
+void AudioManager::writeWAVHeader()
+{
+	//32 bit float stereo, the sizes are filled in when the mixer is stopped
+	auto le32=[this](uint32_t v) { char b[4]={char(v),char(v>>8),char(v>>16),char(v>>24)}; wavFile.write(b,4); };
+	auto le16=[this](uint16_t v) { char b[2]={char(v),char(v>>8)}; wavFile.write(b,2); };
+	uint32_t datasize=framesMixed*2*sizeof(float);
+	wavFile.seekp(0);
+	wavFile.write("RIFF",4);
+	le32(36+datasize);
+	wavFile.write("WAVEfmt ",8);
+	le32(16);
+	le16(3); // WAVE_FORMAT_IEEE_FLOAT
+	le16(2);
+	le32(outputSampleRate);
+	le32(outputSampleRate*2*sizeof(float));
+	le16(2*sizeof(float));
+	le16(32);
+	wavFile.write("data",4);
+	le32(datasize);
+	wavFile.seekp(0,ios::end);
+}
+
 AudioManager::~AudioManager()
 {
 	if (mixeropened)
@@ -24,14 +24,47 @@
 #include "compat.h"
 #include "backends/decoder.h"
 #include <iostream>
+#include <fstream>
 #include <unordered_set>
 #include <SDL2/SDL.h>
 
+//Frames mixed in one go by the mixer thread
+#define AUDIO_MIXER_BLOCKSIZE 256
+//Capacity of the buffer between the mixer thread and the audio device, in frames
+#define AUDIO_MIXER_BUFFERSIZE 1024
+//Milliseconds the mixer thread sleeps between two checks of the output buffer
+#define AUDIO_MIXER_INTERVAL 2
+//Capacity of the buffer between the decoder of a stream and the mixer thread, in frames
+#define AUDIO_STREAM_BUFFERSIZE 2048
+//Maximum number of streams mixed at the same time
+#define AUDIO_MIXER_CHANNELS 64
+
 namespace lightspark
 {
 class AudioStream;
 class EngineData;
 
+/*
+ * Ring buffer of float samples without any locking, it is safe as long as
+ * there is exactly one producer and one consumer thread
+ */
+class AudioRingBuffer
+{
+private:
+	std::vector<float> data;
+	uint32_t mask;
+	//Free running counters, only the producer writes writePos and only the consumer writes readPos
+	std::atomic<uint32_t> readPos;
+	std::atomic<uint32_t> writePos;
+public:
+	//capacity is rounded up to a power of two
+	AudioRingBuffer(uint32_t capacity);
+	uint32_t available() const { return writePos.load(std::memory_order_acquire)-readPos.load(std::memory_order_relaxed); }
+	uint32_t freeSpace() const { return data.size()-(writePos.load(std::memory_order_relaxed)-readPos.load(std::memory_order_acquire)); }
+	uint32_t write(const float* src, uint32_t count);
+	uint32_t read(float* dest, uint32_t count);
+};
+
 class AudioManager
 {
 	friend class AudioStream;
@@ -40,6 +73,47 @@ private:
 	bool audio_available;
 	int mixeropened;
 	EngineData* engineData;
+	/*
+	 * The internal mixer: the feeder thread moves the decoded samples of every
+	 * stream into the ring buffer of the stream, it is the only thread of the
+	 * mixer that takes streamMutex or touches the decoders.
+	 * The mixer thread mixes the ring buffers of the streams registered in
+	 * mixerChannels into mixerOutput without taking any lock, the audio device
+	 * only reads from mixerOutput.
+	 * When rendering to a WAV file the mixed blocks are written to wavFile instead
+	 */
+	AudioRingBuffer* mixerOutput;
+	SDL_Thread* mixerThread;
+	SDL_Thread* feederThread;
+	ACQUIRE_RELEASE_FLAG(mixerRunning);
+	std::atomic<AudioStream*> mixerChannels[AUDIO_MIXER_CHANNELS];
+	//Set while the mixer thread reads from the streams in mixerChannels
+	std::atomic<bool> mixingStreams;
+	/*
+	 * Removed streams that still have samples to play, they are detached from
+	 * their decoder and the feeder thread releases them once drained, protected by streamMutex
+	 */
+	std::list<AudioStream*> closingStreams;
+	uint32_t outputSampleRate;
+	//Resampling from the decoders sample rate to outputSampleRate, as 16.16 fixed point
+	uint32_t resampleStep;
+	uint64_t resamplePos;
+	std::vector<float> mixedFrames;
+	std::vector<float> streamFrames;
+	std::ofstream wavFile;
+	//Mix the WAV file whenever the streams have enough samples, without waiting for the clock
+	bool wavUnpaced;
+	uint64_t framesMixed;
+	uint64_t mixingTime;
+	ATOMIC_INT32(underruns);
+	static int mixerWorker(void* d);
+	static int feederWorker(void* d);
+	void feedStreams();
+	void releaseStream(AudioStream* s);
+	bool streamsReady(uint32_t frames);
+	void mixStreams(float* dest, uint32_t frames);
+	void mixBlock(float* dest, uint32_t frames);
+	void writeWAVHeader();
 public:
 	Mutex streamMutex;
 	Mutex managerMutex;
@@ -47,12 +121,23 @@ public:
 	SDL_AudioDeviceID device;
 	AudioManager(EngineData* engine);
 
+	/*
+	 * Starts the mixer thread producing samples at the given rate,
+	 * if wavfile is not empty the output is written to it instead of being read by readMixedSamples,
+	 * unpaced only applies to the WAV file
+	 */
+	bool startMixer(uint32_t sampleRate, const tiny_string& wavfile, bool unpaced=false);
+	void stopMixer();
+	//Called by the audio device, it never blocks, missing samples are filled with silence
+	void readMixedSamples(float* dest, uint32_t count);
+
 	AudioStream *createStream(AudioDecoder *decoder, bool startpaused, IThreadJob *producer, int grouptag, uint32_t playedTime, double volume);
 
 	void toggleMuteAll() { muteAllStreams ? unmuteAll() : muteAll(); }
 	bool allMuted() { return muteAllStreams; }
 	void muteAll();
 	void unmuteAll();
+	//A stream played until its end keeps playing its buffered samples, the decoder may be deleted when this returns
 	void removeStream(AudioStream* s);
 	void stopAllSounds();
 	~AudioManager();
@@ -77,13 +162,17 @@ private:
 	uint64_t playedtime;
 	struct timeval starttime;
 	int mixer_channel;
+	//Samples moved out of the decoder by the feeder thread and read by the mixer thread
+	AudioRingBuffer output;
+	int mixerSlot;
+	void fillOutput();
 public:
 	uint8_t* audiobuffer;
 	bool init(double volume);
 	void deinit();
 	void startMixing();
 	AudioStream(AudioManager* _manager,IThreadJob* _producer, int _grouptag,uint64_t _playedtime):manager(_manager),decoder(nullptr),producer(_producer),grouptag(_grouptag)
-	  ,hasStarted(false),isPaused(true),mixingStarted(false),isdone(false),curvolume(1.0),unmutevolume(1.0),panning{1.0,1.0},playedtime(_playedtime),mixer_channel(-1),audiobuffer(nullptr)
+	  ,hasStarted(false),isPaused(true),mixingStarted(false),isdone(false),curvolume(1.0),unmutevolume(1.0),panning{1.0,1.0},playedtime(_playedtime),mixer_channel(-1),output(AUDIO_STREAM_BUFFERSIZE*2),mixerSlot(-1),audiobuffer(nullptr)
 	{
 	}
 
@@ -84,8 +84,9 @@ Config::Config():
 	systemConfigDirectories(g_get_system_config_dirs()),userConfigDirectory(g_get_user_config_dir()),
 	//DEFAULT SETTINGS
 	defaultCacheDirectory((string) g_get_user_cache_dir() + G_DIR_SEPARATOR_S + "lightspark"),
-	cacheDirectory(defaultCacheDirectory),cachePrefix("cache"),
-	renderingEnabled(true)
+	cacheDirectory(defaultCacheDirectory),cachePrefix("cache"),swfCache(false),swfCacheMaxSize(256),
+	renderingEnabled(true),tiledRendering(true),partialRedraw(true),drawBatching(true),threadPoolSize(0),parallelParsing(true),
+	lazyBitmapDecoding(true),bitmapMemoryBudget(256),lazyXML(true),frameSnapshotInterval(32)
 {
 #ifdef _WIN32
 	const char* exePath = getExectuablePath();
@@ -205,12 +206,49 @@ void Config::handleEntry()
 	//Rendering
 	if(group == "rendering" && key == "enabled")
 		renderingEnabled = atoi(value.c_str());
+	else if(group == "rendering" && key == "tiled")
+		tiledRendering = atoi(value.c_str());
+	else if(group == "rendering" && key == "partialredraw")
+		partialRedraw = atoi(value.c_str());
+	else if(group == "rendering" && key == "batching")
+		drawBatching = atoi(value.c_str());
 	//Cache directory
 	else if(group == "cache" && key == "directory")
 		cacheDirectory = value;
 	//Cache prefix
 	else if(group == "cache" && key == "prefix")
 		cachePrefix = value;
+	//Cache of decompressed swf files
+	else if(group == "cache" && key == "swf")
+		swfCache = atoi(value.c_str());
+	else if(group == "cache" && key == "swfmaxsize")
+		swfCacheMaxSize = atoi(value.c_str());
+	//Thread pool size
+	else if(group == "threads" && key == "poolsize")
+	{
+		//Negative values use one thread per CPU, more than 4 threads per CPU are not useful
+		int32_t size = atoi(value.c_str());
+		int32_t maxsize = 4*g_get_num_processors();
+		if (size < 0 || size > maxsize)
+		{
+			LOG(LOG_ERROR,"Invalid thread pool size " << value << ", using " << (size < 0 ? 0 : maxsize));
+			size = size < 0 ? 0 : maxsize;
+		}
+		threadPoolSize = size;
+	}
+	else if(group == "threads" && key == "parallelparsing")
+		parallelParsing = atoi(value.c_str());
+	//Bitmaps
+	else if(group == "bitmaps" && key == "lazydecoding")
+		lazyBitmapDecoding = atoi(value.c_str());
+	else if(group == "bitmaps" && key == "memorybudget")
+		bitmapMemoryBudget = atoi(value.c_str());
+	//XML
+	else if(group == "xml" && key == "lazy")
+		lazyXML = atoi(value.c_str());
+	//Timeline
+	else if(group == "timeline" && key == "snapshotinterval")
+		frameSnapshotInterval = atoi(value.c_str());
 	else
 		LOG(LOG_ERROR,"Invalid entry encountered in configuration file" << ": '" << group << "/" << key << "'='" << value << "'");
 }
@@ -44,6 +44,10 @@ namespace lightspark
 		std::string cacheDirectory;
 		//Specifies what prefix the cache files should have, default="cache"
 		std::string cachePrefix;
+		//Specifies if decompressed swf files should be kept in the cache directory for faster startup
+		bool swfCache;
+		//Specifies the size in MB of the swf cache, the least recently used files are removed when it is exceeded, 0 = unlimited
+		uint32_t swfCacheMaxSize;
 		//Specifies the filename including full path of the gnash executable
 		std::string gnashPath;
 		//Specifies the directory where the app can store files
@@ -51,6 +55,24 @@ namespace lightspark
 
 		//Specifies if rendering should be done
 		bool renderingEnabled;
+		//Specifies if large shapes should be rasterized in parallel bands on the thread pool
+		bool tiledRendering;
+		//Specifies if only the changed parts of the stage should be rendered again
+		bool partialRedraw;
+		//Specifies if consecutive draws with the same texture and state should be submitted together
+		bool drawBatching;
+		//Specifies the number of threads in the thread pools, 0 = one thread per CPU
+		uint32_t threadPoolSize;
+		//Specifies if shapes and fonts of a swf file should be parsed in parallel
+		bool parallelParsing;
+		//Specifies if embedded bitmaps are decoded on first use instead of while parsing
+		bool lazyBitmapDecoding;
+		//Specifies the memory in MB available for decoded embedded bitmaps, 0 = unlimited
+		uint32_t bitmapMemoryBudget;
+		//Specifies if the nodes of parsed XML objects are created on first access
+		bool lazyXML;
+		//Specifies every how many frames the display list of a timeline is saved for seeking, 0 = disabled
+		uint32_t frameSnapshotInterval;
 		Config();
 		~Config();
 	public:
@@ -59,11 +81,22 @@ namespace lightspark
 
 		const std::string& getCacheDirectory() const { return cacheDirectory; }
 		const std::string& getCachePrefix() const { return cachePrefix; }
+		bool isSWFCacheEnabled() const { return swfCache; }
+		uint32_t getSWFCacheMaxSize() const { return swfCacheMaxSize; }
 		const std::string& getDataDirectory() const { return dataDirectory; }
 		
 		const std::string& getGnashPath() const { return gnashPath; }
 
 		bool isRenderingEnabled() const { return renderingEnabled; }
+		bool isTiledRenderingEnabled() const { return tiledRendering; }
+		bool isPartialRedrawEnabled() const { return partialRedraw; }
+		bool isDrawBatchingEnabled() const { return drawBatching; }
+		uint32_t getThreadPoolSize() const { return threadPoolSize; }
+		bool isParallelParsingEnabled() const { return parallelParsing; }
+		bool isLazyBitmapDecodingEnabled() const { return lazyBitmapDecoding; }
+		uint32_t getBitmapMemoryBudget() const { return bitmapMemoryBudget; }
+		bool isLazyXMLEnabled() const { return lazyXML; }
+		uint32_t getFrameSnapshotInterval() const { return frameSnapshotInterval; }
 	};
 }
 
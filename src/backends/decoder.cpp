@@ -58,14 +58,14 @@ bool VideoDecoder::setSize(uint32_t w, uint32_t h)
 #ifdef _WIN32
 		if (decodedframebuffer)
 			_aligned_free(decodedframebuffer);
-		decodedframebuffer = (uint8_t*)_aligned_malloc(frameWidth*frameHeight*4, 16);
+		decodedframebuffer = (uint8_t*)_aligned_malloc(((frameWidth+15)&0xfffffff0)*frameHeight*4, 16);
 		if (!decodedframebuffer) {
 			LOG(LOG_ERROR, "posix_memalign could not allocate memory");
 		}
 #else
 		if (decodedframebuffer)
 			free(decodedframebuffer);
-		if(posix_memalign((void **)&decodedframebuffer, 16, frameWidth*frameHeight*4)) {
+		if(posix_memalign((void **)&decodedframebuffer, 16, ((frameWidth+15)&0xfffffff0)*frameHeight*4)) {
 			LOG(LOG_ERROR, "posix_memalign could not allocate memory");
 		}
 #endif
@@ -166,11 +166,15 @@ bool FFMpegVideoDecoder::fillDataAndCheckValidity()
 }
 
 FFMpegVideoDecoder::FFMpegVideoDecoder(LS_VIDEO_CODEC codecId, uint8_t* initdata, uint32_t datalen, double frameRateHint, DefineVideoStreamTag *tag):
-	ownedContext(true),curBuffer(0),codecContext(nullptr),streamingbuffers(FFMPEGVIDEODECODERBUFFERSIZE),embeddedbuffers(2),curBufferOffset(0),embeddedvideotag(tag)
+	ownedContext(true),curBuffer(0),codecContext(nullptr),streamingbuffers(FFMPEGVIDEODECODERBUFFERSIZE),embeddedbuffers(2),convertedbuffers(FFMPEGVIDEOCONVERTEDBUFFERSIZE),
+	converterThread(nullptr),sys(getSys()),converterRunning(false),textureRequested(false),bgraRequested(false),framesQueued(0),skipUntilFrame(0),framesConverted(0),
+	curBufferOffset(0),embeddedvideotag(tag)
 {
 	//The tag is the header, initialize decoding
 	switchCodec(codecId, initdata, datalen, frameRateHint);
 	frameIn=av_frame_alloc();
+	if (!tag)
+		startConverter();
 	// immediately decode 1 frame to obtain size:
 	// 'define stream' tag information not always correct + cannot resize during an 'upload' call
 	if (tag)
@@ -261,9 +265,12 @@ void FFMpegVideoDecoder::switchCodec(LS_VIDEO_CODEC codecId, uint8_t *initdata,
 }
 #if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
 FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecParameters* codecPar, double frameRateHint):
-	ownedContext(true),curBuffer(0),codecContext(nullptr),streamingbuffers(FFMPEGVIDEODECODERBUFFERSIZE),embeddedbuffers(2),curBufferOffset(0),embeddedvideotag(nullptr)
+	ownedContext(true),curBuffer(0),codecContext(nullptr),streamingbuffers(FFMPEGVIDEODECODERBUFFERSIZE),embeddedbuffers(2),convertedbuffers(FFMPEGVIDEOCONVERTEDBUFFERSIZE),
+	converterThread(nullptr),sys(getSys()),converterRunning(false),textureRequested(false),bgraRequested(false),framesQueued(0),skipUntilFrame(0),framesConverted(0),
+	curBufferOffset(0),embeddedvideotag(nullptr)
 {
 	status=INIT;
+	startConverter();
 #ifdef HAVE_AVCODEC_ALLOC_CONTEXT3
 	codecContext=avcodec_alloc_context3(nullptr);
 #else
@@ -305,9 +312,12 @@ FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecParameters* codecPar, double frame
 }
 #else
 FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecContext* _c, double frameRateHint):
-	ownedContext(false),curBuffer(0),codecContext(_c),curBufferOffset(0),embeddedvideotag(nullptr)
+	ownedContext(false),curBuffer(0),codecContext(_c),streamingbuffers(FFMPEGVIDEODECODERBUFFERSIZE),embeddedbuffers(2),convertedbuffers(FFMPEGVIDEOCONVERTEDBUFFERSIZE),
+	converterThread(nullptr),sys(getSys()),converterRunning(false),textureRequested(false),bgraRequested(false),framesQueued(0),skipUntilFrame(0),framesConverted(0),
+	curBufferOffset(0),embeddedvideotag(nullptr)
 {
 	frameIn=av_frame_alloc();
+	startConverter();
 	status=INIT;
 	//The tag is the header, initialize decoding
 	switch(codecContext->codec_id)
@@ -343,6 +353,11 @@ FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecContext* _c, double frameRateHint)
 FFMpegVideoDecoder::~FFMpegVideoDecoder()
 {
 	while(fenceCount);
+	if (converterThread)
+	{
+		RELEASE_WRITE(converterRunning,false);
+		SDL_WaitThread(converterThread,nullptr);
+	}
 	avcodec_close(codecContext);
 	if(ownedContext)
 		av_free(codecContext);
@@ -358,20 +373,39 @@ void FFMpegVideoDecoder::setSize(uint32_t w, uint32_t h)
 {
 	if(VideoDecoder::setSize(w,h))
 	{
-		//Discard all the frames
-		while(discardFrame());
-	
 		//As the size changed, reset the buffer
 		uint32_t bufferSize=frameWidth*frameHeight/**4*/;
 		if (embeddedvideotag)
+		{
+			Locker l(buffersMutex);
+			//Discard all the frames
+			while(discardFrame());
 			embeddedbuffers.regen(YUVBufferGenerator(bufferSize,this->codecContext->pix_fmt==AV_PIX_FMT_YUVA420P, this->codecContext->pix_fmt!=AV_PIX_FMT_BGRA));
+		}
 		else
+		{
+			//Stop the converter and discard all decoded and converted frames
+			Locker lc(convertMutex);
+			Locker l(buffersMutex);
+			while(!streamingbuffers.isEmpty())
+			{
+				//The converter may hold the count of the front frame for a moment
+				if(streamingbuffers.nonBlockingPopFront())
+				{
+					framesConverted++;
+					framesdropped++;
+				}
+			}
+			while(discardFrame());
 			streamingbuffers.regen(YUVBufferGenerator(bufferSize,this->codecContext->pix_fmt==AV_PIX_FMT_YUVA420P, this->codecContext->pix_fmt!=AV_PIX_FMT_BGRA));
+			convertedbuffers.regen(ConvertedBufferGenerator(((frameWidth+15)&0xfffffff0)*frameHeight*4,frameWidth*frameHeight*4));
+		}
 	}
 }
 
 uint32_t FFMpegVideoDecoder::skipUntil(uint32_t time)
 {
+	Locker l(buffersMutex);
 	uint32_t ret=0;
 	if (embeddedvideotag)
 	{
@@ -387,11 +421,12 @@ uint32_t FFMpegVideoDecoder::skipUntil(uint32_t time)
 	}
 	else
 	{
+		//Frames that are not converted yet are skipped on the next call
 		while(1)
 		{
-			if(streamingbuffers.isEmpty())
+			if(convertedbuffers.isEmpty())
 				break;
-			if(streamingbuffers.front().time>=time)
+			if(convertedbuffers.front().time>=time)
 				break;
 			discardFrame();
 			ret++;
@@ -401,39 +436,94 @@ uint32_t FFMpegVideoDecoder::skipUntil(uint32_t time)
 }
 void FFMpegVideoDecoder::skipAll()
 {
-	while(!streamingbuffers.isEmpty())
-		discardFrame();
-	while(!embeddedbuffers.isEmpty())
-		discardFrame();
+	Locker l(buffersMutex);
+	if (embeddedvideotag)
+	{
+		while(!embeddedbuffers.isEmpty())
+			discardFrame();
+	}
+	else
+	{
+		//The decoded frames are dropped by the converter thread, which is the only consumer of streamingbuffers
+		skipUntilFrame=framesQueued.load();
+		while(!convertedbuffers.isEmpty())
+			discardFrame();
+	}
 }
 
 bool FFMpegVideoDecoder::discardFrame()
 {
+	Locker l(buffersMutex);
 	//We don't want ot block if no frame is available
-	if (embeddedvideotag)
+	bool ret=embeddedvideotag ? embeddedbuffers.nonBlockingPopFront() : convertedbuffers.nonBlockingPopFront();
+	checkFlushed();
+	framesdropped++;
+	return ret;
+}
+
+void FFMpegVideoDecoder::checkFlushed()
+{
+	if(!flushing || status==FLUSHED) //End of our work
+		return;
+	if(embeddedvideotag ? embeddedbuffers.isEmpty() : (streamingbuffers.isEmpty() && convertedbuffers.isEmpty()))
 	{
-		bool ret=embeddedbuffers.nonBlockingPopFront();
-		if(flushing && embeddedbuffers.isEmpty()) //End of our work
-		{
-			status=FLUSHED;
-			flushed.signal();
-		}
-		framesdropped++;
-	
-		return ret;
+		status=FLUSHED;
+		flushed.signal();
 	}
-	else
+}
+
+void FFMpegVideoDecoder::startConverter()
+{
+	RELEASE_WRITE(converterRunning,true);
+	converterThread=SDL_CreateThread(converterWorker,"VideoConverter",this);
+}
+
+int FFMpegVideoDecoder::converterWorker(void* d)
+{
+	FFMpegVideoDecoder* th=(FFMpegVideoDecoder*)d;
+	//Large frames are converted in bands on the thread pool
+	setTLSSys(th->sys);
+	while(ACQUIRE_READ(th->converterRunning))
 	{
-		bool ret=streamingbuffers.nonBlockingPopFront();
-		if(flushing && streamingbuffers.isEmpty()) //End of our work
-		{
-			status=FLUSHED;
-			flushed.signal();
-		}
+		if(!th->streamingbuffers.waitNotEmpty(VIDEO_CONVERTER_TIMEOUT))
+			continue;
+		th->convertFrame();
+	}
+	return 0;
+}
+
+bool FFMpegVideoDecoder::convertFrame()
+{
+	Locker lc(convertMutex);
+	//The frames may have been discarded by a size change
+	if(streamingbuffers.isEmpty())
+		return false;
+	if(framesConverted-skipUntilFrame < 0)
+	{
+		Locker l(buffersMutex);
+		streamingbuffers.nonBlockingPopFront();
+		framesConverted++;
 		framesdropped++;
-	
-		return ret;
+		checkFlushed();
+		return false;
 	}
+	//Waits for a free converted buffer, if none gets free the frame is converted on the next call
+	ConvertedBuffer* out=convertedbuffers.acquireLast(VIDEO_CONVERTER_TIMEOUT);
+	if(!out)
+		return false;
+	const YUVBuffer& cur=streamingbuffers.front();
+	out->hasTexture=ACQUIRE_READ(textureRequested);
+	out->hasBGRA=ACQUIRE_READ(bgraRequested);
+	if(out->hasTexture)
+		convertToTexture(cur,out->texture);
+	if(out->hasBGRA)
+		convertToBGRA(cur,out->bgra,frameWidth*4);
+	out->time=cur.time;
+	Locker l(buffersMutex);
+	convertedbuffers.commitLast();
+	streamingbuffers.nonBlockingPopFront();
+	framesConverted++;
+	return true;
 }
 
 bool FFMpegVideoDecoder::decodeData(uint8_t* data, uint32_t datalen, uint32_t time)
@@ -622,7 +712,10 @@ void FFMpegVideoDecoder::copyFrameToBuffers(const AVFrame* frameIn, uint32_t tim
 	if (embeddedvideotag)
 		embeddedbuffers.commitLast();
 	else
+	{
 		streamingbuffers.commitLast();
+		framesQueued++;
+	}
 }
 
 uint8_t* FFMpegVideoDecoder::upload(bool refresh)
@@ -630,6 +723,7 @@ uint8_t* FFMpegVideoDecoder::upload(bool refresh)
 	assert_and_throw(decodedframebuffer);
 	if (!refresh)
 		return decodedframebuffer;
+	Locker l(buffersMutex);
 	if (embeddedvideotag) // on embedded video we decode the frames during upload
 	{
 		if (currentframe < lastframe)
@@ -649,35 +743,105 @@ uint8_t* FFMpegVideoDecoder::upload(bool refresh)
 		}
 		if(embeddedbuffers.isEmpty())
 			return decodedframebuffer;
+		convertToTexture(embeddedbuffers.front(),decodedframebuffer);
+		return decodedframebuffer;
 	}
-	else
-	{
-		if(streamingbuffers.isEmpty())
-			return decodedframebuffer;
-	}
-	//At least a frame is available
-	YUVBuffer* cur=embeddedvideotag ? &embeddedbuffers.front() : &streamingbuffers.front();
+	//The frame has been converted by the converter thread
+	RELEASE_WRITE(textureRequested,true);
+	if(!convertedbuffers.isEmpty() && convertedbuffers.front().hasTexture)
+		memcpy(decodedframebuffer,convertedbuffers.front().texture,((frameWidth+15)&0xfffffff0)*frameHeight*4);
+	return decodedframebuffer;
+}
+
+void FFMpegVideoDecoder::convertToTexture(const YUVBuffer& cur, uint8_t* dest)
+{
 	if (codecContext->pix_fmt==AV_PIX_FMT_BGRA)
 	{
-		memcpy(decodedframebuffer,cur->ch[0],frameWidth*frameHeight*4);
+		memcpy(dest,cur.ch[0],frameWidth*frameHeight*4);
+		return;
 	}
-	else
-	{
-		fastYUV420ChannelsToYUV0Buffer(cur->ch[0],cur->ch[1],cur->ch[2],decodedframebuffer,frameWidth,frameHeight);
-		if (codecContext->pix_fmt==AV_PIX_FMT_YUVA420P)
+	uint32_t texw= (frameWidth+15)&0xfffffff0;
+	//Large frames are packed in bands of even rows on the thread pool, so that a band never starts in the middle of a chroma row
+	uint32_t bandheight=std::max(uint32_t(VIDEO_CONVERSION_MIN_BANDHEIGHT),(frameHeight/VIDEO_CONVERSION_MAX_BANDS+1)&~1u);
+	uint32_t bandcount=(frameHeight+bandheight-1)/bandheight;
+	bool hasAlpha=codecContext->pix_fmt==AV_PIX_FMT_YUVA420P;
+	getSys()->runParallel(bandcount,[&](uint32_t band)
+	{
+		uint32_t first=band*bandheight;
+		uint32_t last=std::min(first+bandheight,frameHeight);
+		fastYUV420ChannelsToYUV0Buffer(cur.ch[0]+first*frameWidth,cur.ch[1]+(first/2)*(frameWidth/2),cur.ch[2]+(first/2)*(frameWidth/2),
+				dest+first*texw*4,frameWidth,last-first);
+		if (hasAlpha)
 		{
-			uint32_t texw= (frameWidth+15)&0xfffffff0;
-			for(uint32_t i=0;i<frameHeight;i++)
+			for(uint32_t i=first;i<last;i++)
 			{
 				for(uint32_t j=0;j<frameWidth;j++)
 				{
 					uint32_t pixelCoordFull=i*texw+j;
-					decodedframebuffer[pixelCoordFull*4+3]=cur->ch[3][i*frameWidth+j];
+					dest[pixelCoordFull*4+3]=cur.ch[3][i*frameWidth+j];
 				}
 			}
 		}
+	});
+}
+
+void FFMpegVideoDecoder::convertToBGRA(const YUVBuffer& cur, uint8_t* dest, uint32_t stride)
+{
+	if (codecContext->pix_fmt==AV_PIX_FMT_BGRA)
+	{
+		//The frame has already been converted to RGBA by copyFrameToBuffers
+		for(uint32_t i=0;i<frameHeight;i++)
+		{
+			const uint8_t* src=cur.ch[0]+i*frameWidth*4;
+			uint8_t* dst=dest+i*stride;
+			for(uint32_t j=0;j<frameWidth;j++)
+			{
+				uint32_t alpha=src[j*4+3];
+				dst[j*4  ]=(src[j*4+2]*alpha+127)/255;
+				dst[j*4+1]=(src[j*4+1]*alpha+127)/255;
+				dst[j*4+2]=(src[j*4  ]*alpha+127)/255;
+				dst[j*4+3]=alpha;
+			}
+		}
+		return;
 	}
-	return decodedframebuffer;
+	const uint8_t* a=codecContext->pix_fmt==AV_PIX_FMT_YUVA420P ? cur.ch[3] : nullptr;
+	uint32_t bandheight=std::max(uint32_t(VIDEO_CONVERSION_MIN_BANDHEIGHT),(frameHeight/VIDEO_CONVERSION_MAX_BANDS+1)&~1u);
+	uint32_t bandcount=(frameHeight+bandheight-1)/bandheight;
+	getSys()->runParallel(bandcount,[&](uint32_t band)
+	{
+		uint32_t first=band*bandheight;
+		uint32_t last=std::min(first+bandheight,frameHeight);
+		fastYUV420ToBGRA(cur.ch[0]+first*frameWidth,cur.ch[1]+(first/2)*(frameWidth/2),cur.ch[2]+(first/2)*(frameWidth/2),
+				a ? a+first*frameWidth : nullptr,dest+first*stride,frameWidth,last-first,frameWidth,frameWidth/2,frameWidth,stride);
+	});
+}
+
+bool FFMpegVideoDecoder::copyFrameBGRA(uint8_t* dest, uint32_t stride)
+{
+	Locker l(buffersMutex);
+	if (embeddedvideotag)
+	{
+		if(embeddedbuffers.isEmpty())
+			return false;
+		convertToBGRA(embeddedbuffers.front(),dest,stride);
+		return true;
+	}
+	//Frames converted before the first call have no BGRA data, they are not shown
+	RELEASE_WRITE(bgraRequested,true);
+	if(convertedbuffers.isEmpty() || !convertedbuffers.front().hasBGRA)
+		return false;
+	const uint8_t* src=convertedbuffers.front().bgra;
+	for(uint32_t i=0;i<frameHeight;i++)
+		memcpy(dest+i*stride,src+i*frameWidth*4,frameWidth*4);
+	return true;
+}
+
+void FFMpegVideoDecoder::ConvertedBufferGenerator::init(ConvertedBuffer& buf) const
+{
+	buf.cleanup();
+	aligned_malloc((void**)&buf.texture, 16, textureSize);
+	aligned_malloc((void**)&buf.bgra, 16, bgraSize);
 }
 
 void FFMpegVideoDecoder::YUVBufferGenerator::init(YUVBuffer& buf) const
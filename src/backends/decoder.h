@@ -77,6 +77,7 @@ public:
 };
 class NetStream;
 class EngineData;
+class SystemState;
 
 class Decoder
 {
@@ -92,6 +93,10 @@ public:
 	{
 		return status>=VALID;
 	}
+	bool isFlushed() const
+	{
+		return status==FLUSHED;
+	}
 	virtual void setFlushing()=0;
 	void waitFlushed()
 	{
@@ -136,6 +141,11 @@ public:
 	bool isUploading() { return fenceCount; }
 	void setVideoFrameToDecode(uint32_t frame) { currentframe=frame; }
 	void clearFrameBuffer();
+	/*
+		Converts the current frame to premultiplied BGRA (the cairo ARGB32 format) for software rendering
+		@return false if no frame is available
+	*/
+	virtual bool copyFrameBGRA(uint8_t* dest, uint32_t stride) { return false; }
 protected:
 	TextureChunk videoTexture;
 	uint32_t frameWidth;
@@ -176,6 +186,13 @@ public:
 };
 #ifdef ENABLE_LIBAVCODEC
 #define FFMPEGVIDEODECODERBUFFERSIZE 80
+//Decoded frames are converted on a separate thread into a queue of FFMPEGVIDEOCONVERTEDBUFFERSIZE frames ready for upload
+#define FFMPEGVIDEOCONVERTEDBUFFERSIZE 8
+//The converter thread checks every VIDEO_CONVERTER_TIMEOUT ms if it has to stop
+#define VIDEO_CONVERTER_TIMEOUT 50
+//Frames are converted in up to VIDEO_CONVERSION_MAX_BANDS bands of at least VIDEO_CONVERSION_MIN_BANDHEIGHT rows on the thread pool
+#define VIDEO_CONVERSION_MAX_BANDS 8
+#define VIDEO_CONVERSION_MIN_BANDHEIGHT 128
 class FFMpegVideoDecoder: public VideoDecoder
 {
 private:
@@ -228,15 +245,78 @@ private:
 		YUVBufferGenerator(uint32_t b, bool _hasalpha, bool _haschannels):bufferSize(b),hasAlpha(_hasalpha),hasChannels(_haschannels){}
 		void init(YUVBuffer& buf) const;
 	};
+	/*
+	   A frame converted by the converter thread, texture holds the data returned by upload(),
+	   bgra the premultiplied BGRA frame for copyFrameBGRA(). Only the formats requested so far are filled.
+	*/
+	class ConvertedBuffer
+	{
+	ConvertedBuffer(const ConvertedBuffer&); /* no impl */
+	ConvertedBuffer& operator=(const ConvertedBuffer&); /* no impl */
+	public:
+		uint8_t* texture;
+		uint8_t* bgra;
+		bool hasTexture;
+		bool hasBGRA;
+		uint32_t time;
+		ConvertedBuffer():texture(nullptr),bgra(nullptr),hasTexture(false),hasBGRA(false),time(0){}
+		void init()
+		{
+			texture=nullptr;
+			bgra=nullptr;
+			hasTexture=false;
+			hasBGRA=false;
+		}
+		void cleanup()
+		{
+			if(texture)
+				aligned_free(texture);
+			if(bgra)
+				aligned_free(bgra);
+			init();
+		}
+	};
+	class ConvertedBufferGenerator
+	{
+	private:
+		uint32_t textureSize;
+		uint32_t bgraSize;
+	public:
+		ConvertedBufferGenerator(uint32_t t, uint32_t b):textureSize(t),bgraSize(b){}
+		void init(ConvertedBuffer& buf) const;
+	};
 	bool ownedContext;
 	uint32_t curBuffer;
 	AVCodecContext* codecContext;
 	BlockingCircularQueue<YUVBuffer> streamingbuffers;
 	BlockingCircularQueue<YUVBuffer> embeddedbuffers;
+	//Only used for streams, embedded video frames are decoded and converted during upload
+	BlockingCircularQueue<ConvertedBuffer> convertedbuffers;
+	//Protects the consumer side of the queues, the front frame is read by the render thread and the VM thread
+	Mutex buffersMutex;
+	//Held by the converter thread while it converts a frame, so the buffers can be resized
+	Mutex convertMutex;
+	SDL_Thread* converterThread;
+	SystemState* sys;
+	ACQUIRE_RELEASE_FLAG(converterRunning);
+	ACQUIRE_RELEASE_FLAG(textureRequested);
+	ACQUIRE_RELEASE_FLAG(bgraRequested);
+	//Decoded frames before skipUntilFrame are dropped by the converter (set by skipAll)
+	ATOMIC_INT32(framesQueued);
+	ATOMIC_INT32(skipUntilFrame);
+	int32_t framesConverted;
 	AVFrame* frameIn;
 	void copyFrameToBuffers(const AVFrame* frameIn, uint32_t time);
 	void setSize(uint32_t w, uint32_t h);
 	bool fillDataAndCheckValidity();
+	void startConverter();
+	static int converterWorker(void* d);
+	//Converts the front decoded frame, returns false if no frame could be converted
+	bool convertFrame();
+	void convertToTexture(const YUVBuffer& cur, uint8_t* dest);
+	void convertToBGRA(const YUVBuffer& cur, uint8_t* dest, uint32_t stride);
+	//Must be called with buffersMutex held
+	void checkFlushed();
 	uint32_t curBufferOffset;
 	DefineVideoStreamTag* embeddedvideotag;
 public:
@@ -259,25 +339,12 @@ public:
 	bool discardFrame() override;
 	uint32_t skipUntil(uint32_t time) override;
 	void skipAll() override;
+	bool copyFrameBGRA(uint8_t* dest, uint32_t stride) override;
 	void setFlushing() override
 	{
+		Locker l(buffersMutex);
 		flushing=true;
-		if (embeddedvideotag)
-		{
-			if(embeddedbuffers.isEmpty())
-			{
-				status=FLUSHED;
-				flushed.signal();
-			}
-		}
-		else
-		{
-			if(streamingbuffers.isEmpty())
-			{
-				status=FLUSHED;
-				flushed.signal();
-			}
-		}
+		checkFlushed();
 	}
 	//ITextureUploadable interface
 	uint8_t* upload(bool refresh) override;
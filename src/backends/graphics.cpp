@@ -18,6 +18,7 @@
 **************************************************************************/
 
 #include <cassert>
+#include <limits>
 
 #include "swf.h"
 #include "abc.h"
@@ -67,10 +68,12 @@ TextureChunk& TextureChunk::operator=(const TextureChunk& r)
 	uint32_t blocksW=(width+CHUNKSIZE_REAL-1)/CHUNKSIZE_REAL;
 	uint32_t blocksH=(height+CHUNKSIZE_REAL-1)/CHUNKSIZE_REAL;
 	texId=r.texId;
+	allocatedChunks=r.allocatedChunks;
 	if(r.chunks)
 	{
-		chunks=new uint32_t[blocksW*blocksH];
-		memcpy(chunks, r.chunks, blocksW*blocksH*4);
+		uint32_t numberOfChunks=allocatedChunks ? allocatedChunks : blocksW*blocksH;
+		chunks=new uint32_t[numberOfChunks];
+		memcpy(chunks, r.chunks, numberOfChunks*4);
 	}
 	else
 		chunks=nullptr;
@@ -93,6 +96,7 @@ void TextureChunk::makeEmpty()
 	width=0;
 	height=0;
 	texId=0;
+	allocatedChunks=0;
 	if (chunks)
 		delete[] chunks;
 	chunks=nullptr;
@@ -106,6 +110,7 @@ bool TextureChunk::resizeIfLargeEnough(uint32_t w, uint32_t h)
 		getSys()->getRenderThread()->releaseTexture(*this);
 		delete[] chunks;
 		chunks=nullptr;
+		allocatedChunks=0;
 		width=w;
 		height=h;
 		return true;
@@ -567,8 +572,66 @@ cairo_surface_t* CairoRenderer::allocateSurface(uint8_t*& buf)
 	return cairo_image_surface_create_for_data(buf, CAIRO_FORMAT_ARGB32, width, height, cairoWidthStride);
 }
 
+//Surfaces smaller than this are always rendered in the calling thread
+#define TILED_RENDERING_MIN_PIXELS (512*512)
+#define TILED_RENDERING_MIN_BANDHEIGHT 64
+
+void CairoTokenRenderer::drawBand(uint8_t* data, int32_t stride, int32_t y, int32_t h, const cairo_matrix_t& matrix)
+{
+	cairo_surface_t* band=cairo_image_surface_create_for_data(data+y*stride, CAIRO_FORMAT_ARGB32, width, h, stride);
+	//Move the band to its position on the full surface, so all bands share the same coordinate space
+	cairo_surface_set_device_offset(band, 0, -y);
+	cairo_t* cr=cairo_create(band);
+	cairo_surface_destroy(band);
+	cairo_set_matrix(cr, &matrix);
+	cairo_set_antialias(cr,smoothing ? CAIRO_ANTIALIAS_DEFAULT : CAIRO_ANTIALIAS_NONE);
+	cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+	cairo_set_fill_rule(cr, CAIRO_FILL_RULE_EVEN_ODD);
+	cairoPathFromTokens(cr, tokens, scaleFactor, false,isMask,xstart,ystart);
+	cairo_destroy(cr);
+}
+
+bool CairoTokenRenderer::executeDrawTiled(cairo_t* cr)
+{
+	if(!Config::getConfig()->isTiledRenderingEnabled() || width*height<TILED_RENDERING_MIN_PIXELS || getSys()==nullptr)
+		return false;
+	//Hard masks are applied as clip on cr, which can't be transferred to the bands
+	for(uint32_t i=0;i<masks.size();i++)
+	{
+		if(masks[i].maskMode == HARD_MASK)
+			return false;
+	}
+	cairo_surface_t* target=cairo_get_target(cr);
+	if(cairo_surface_get_type(target)!=CAIRO_SURFACE_TYPE_IMAGE)
+		return false;
+	uint32_t threads=getSys()->getJobThreadCount();
+	if(threads<2)
+		return false;
+
+	int32_t bandheight=std::max(TILED_RENDERING_MIN_BANDHEIGHT,int32_t((height+threads*2-1)/(threads*2)));
+	int32_t bandcount=(height+bandheight-1)/bandheight;
+	if(bandcount<2)
+		return false;
+	cairo_matrix_t matrix;
+	cairo_get_matrix(cr,&matrix);
+
+	//Make sure everything done on cr so far (cleaning the surface) is in the buffer
+	cairo_surface_flush(target);
+	uint8_t* data=cairo_image_surface_get_data(target);
+	int32_t stride=cairo_image_surface_get_stride(target);
+	getSys()->runParallel(bandcount,[&](uint32_t band)
+	{
+		int32_t y=band*bandheight;
+		drawBand(data,stride,y,std::min(bandheight,height-y),matrix);
+	});
+	cairo_surface_mark_dirty(target);
+	return true;
+}
+
 void CairoTokenRenderer::executeDraw(cairo_t* cr)
 {
+	if(executeDrawTiled(cr))
+		return;
 	cairo_set_antialias(cr,smoothing ? CAIRO_ANTIALIAS_DEFAULT : CAIRO_ANTIALIAS_NONE);
 	cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 	cairo_set_fill_rule(cr, CAIRO_FILL_RULE_EVEN_ODD);
@@ -666,37 +729,76 @@ bool CairoRenderer::isCachedSurfaceUsable(const DisplayObject* o) const
 		&& abs(yscale / tex->yContentScale) < 2);
 }
 
-bool CairoTokenRenderer::hitTest(const tokensVector& tokens, float scaleFactor, number_t x, number_t y)
+void CairoTokenRenderer::flattenTokens(const tokensVector& tokens, float scaleFactor, std::vector<FlattenedPath>& paths)
 {
+	paths.clear();
 	cairo_surface_t* cairoSurface=cairo_image_surface_create_for_data(nullptr, CAIRO_FORMAT_ARGB32, 0, 0, 0);
 
 	int starttoken=0;
-	bool ret=false;
-	bool empty=true;
 	while (starttoken >=0)
 	{
 		// loop over all paths of the tokenvector separately
 		cairo_t *cr=cairo_create(cairoSurface);
 		cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 		cairo_set_fill_rule(cr, CAIRO_FILL_RULE_EVEN_ODD);
-		empty=cairoPathFromTokens(cr, tokens, scaleFactor, true,true,0,0,&starttoken);
+		bool empty=cairoPathFromTokens(cr, tokens, scaleFactor, true,true,0,0,&starttoken);
 		if(!empty)
 		{
-			/* reset the matrix so x and y are not scaled
-			 * by the current cairo transformation
+			/* reset the matrix so the points are returned in local coordinates
+			 * and not in the scaled coordinates of the current cairo transformation
 			 */
 			cairo_identity_matrix(cr);
-			ret=cairo_in_fill(cr, x, y);
-			if (ret)
+			cairo_path_t* path=cairo_copy_path_flat(cr);
+			FlattenedPath flat;
+			flat.xmin=flat.ymin=std::numeric_limits<number_t>::infinity();
+			flat.xmax=flat.ymax=-std::numeric_limits<number_t>::infinity();
+			for (int i=0;i<path->num_data;i+=path->data[i].header.length)
 			{
-				cairo_destroy(cr);
-				break;
+				cairo_path_data_t* d=&path->data[i];
+				switch (d->header.type)
+				{
+					case CAIRO_PATH_MOVE_TO:
+						flat.subpaths.push_back(flat.points.size());
+						//fall through
+					case CAIRO_PATH_LINE_TO:
+						flat.points.push_back(Vector2f(d[1].point.x,d[1].point.y));
+						flat.xmin=std::min(flat.xmin,d[1].point.x);
+						flat.xmax=std::max(flat.xmax,d[1].point.x);
+						flat.ymin=std::min(flat.ymin,d[1].point.y);
+						flat.ymax=std::max(flat.ymax,d[1].point.y);
+						break;
+					default:
+						// flattened paths have no curves, and all subpaths are treated as closed anyway
+						break;
+				}
 			}
+			cairo_path_destroy(path);
+			if (!flat.points.empty())
+				paths.push_back(flat);
 		}
 		cairo_destroy(cr);
 	}
 	cairo_surface_destroy(cairoSurface);
-	return ret;
+}
+
+bool FlattenedPath::contains(number_t x, number_t y) const
+{
+	if (x<xmin || x>xmax || y<ymin || y>ymax)
+		return false;
+	bool inside=false;
+	for (uint32_t s=0;s<subpaths.size();s++)
+	{
+		uint32_t first=subpaths[s];
+		uint32_t end=s+1<subpaths.size() ? subpaths[s+1] : points.size();
+		for (uint32_t i=first,j=end-1;i<end;j=i++)
+		{
+			const Vector2f& p1=points[i];
+			const Vector2f& p2=points[j];
+			if ((p1.y>y) != (p2.y>y) && x < (p2.x-p1.x)*(y-p1.y)/(p2.y-p1.y)+p1.x)
+				inside=!inside;
+		}
+	}
+	return inside;
 }
 
 void CairoTokenRenderer::applyCairoMask(cairo_t* cr,int32_t xOffset,int32_t yOffset) const
@@ -1009,6 +1111,8 @@ void CairoPangoRenderer::applyCairoMask(cairo_t* cr, int32_t xOffset, int32_t yO
 
 AsyncDrawJob::AsyncDrawJob(IDrawable* d, _R<DisplayObject> o):drawable(d),owner(o),surfaceBytes(nullptr),uploadNeeded(false),isBufferOwner(true)
 {
+	// rendering has to be done before the next frame, so it is executed before other jobs
+	highPriority=true;
 }
 
 AsyncDrawJob::~AsyncDrawJob()
@@ -1065,6 +1169,9 @@ TextureChunk& AsyncDrawJob::getTexture()
 	/* This is called in the render thread,
 	 * so we need no locking for surface */
 	CachedSurface& surface=owner->cachedSurface;
+	RenderThread* rt=owner->getSystemState()->getRenderThread();
+	// the old and the new position of the surface have to be redrawn
+	rt->addDirtySurface(surface);
 	uint32_t width=drawable->getWidth();
 	uint32_t height=drawable->getHeight();
 	//Verify that the texture is large enough
@@ -1074,7 +1181,7 @@ TextureChunk& AsyncDrawJob::getTexture()
 		surface.isChunkOwner=true;
 	}
 	if(!surface.tex->resizeIfLargeEnough(width, height))
-		*surface.tex=owner->getSystemState()->getRenderThread()->allocateTexture(width, height,false);
+		*surface.tex=rt->allocateTexture(width, height,false);
 	if (!surface.wasUpdated) // surface may have already been changed by DisplayObject::updateCachedSurface() before it was uploaded
 	{
 		surface.xOffset=drawable->getXOffset();
@@ -1102,6 +1209,7 @@ TextureChunk& AsyncDrawJob::getTexture()
 		surface.isValid=true;
 		surface.isInitialized=true;
 	}
+	rt->addDirtySurface(surface);
 	return *surface.tex;
 }
 
@@ -55,6 +55,11 @@ private:
 	 */
 	uint32_t* chunks = nullptr;
 	uint32_t texId = 0;
+	/*
+	 * Number of blocks allocated for this chunk, kept separately from width and height
+	 * as resizeIfLargeEnough may shrink the chunk without releasing any block
+	 */
+	uint32_t allocatedChunks = 0;
 	TextureChunk(uint32_t w, uint32_t h);
 public:
 	TextureChunk() {}
@@ -324,6 +329,20 @@ public:
 			uint32_t height, size_t* dataSize, size_t* stride, bool frompng);
 };
 
+/*
+ * One path of a tokensVector (everything between two fill or line style changes),
+ * flattened to polygons. Used for hit testing without cairo.
+ */
+struct FlattenedPath
+{
+	number_t xmin,xmax,ymin,ymax;
+	std::vector<Vector2f> points;
+	// index of the first point of every subpath, the subpaths are implicitly closed
+	std::vector<uint32_t> subpaths;
+	// even-odd point in polygon test, like cairo_in_fill with CAIRO_FILL_RULE_EVEN_ODD
+	bool contains(number_t x, number_t y) const;
+};
+
 class CairoTokenRenderer : public CairoRenderer
 {
 private:
@@ -341,6 +360,16 @@ private:
 	void applyCairoMask(cairo_t* cr, int32_t offsetX, int32_t offsetY) const override;
 	number_t xstart;
 	number_t ystart;
+	/*
+	 * Splits the target surface of cr into horizontal bands that are rasterized
+	 * concurrently on the thread pool. Returns false if the surface is not
+	 * suitable for tiled rendering, in that case nothing has been drawn.
+	 */
+	bool executeDrawTiled(cairo_t* cr);
+	/*
+	 * Renders the rows [y,y+h) of the ARGB32 buffer data
+	 */
+	void drawBand(uint8_t* data, int32_t stride, int32_t y, int32_t h, const cairo_matrix_t& matrix);
 public:
 	/*
 	   CairoTokenRenderer constructor
@@ -364,14 +393,14 @@ public:
 			float _redOffset, float _greenOffset, float _blueOffset, float _alphaOffset,
 			SMOOTH_MODE _smoothing,number_t _xstart, number_t _ystart);
 	/*
-	   Hit testing helper. Uses cairo to find if a point in inside the shape
+	   Hit testing helper. Uses cairo to flatten the paths of the shape into polygons,
+	   the result can be tested with FlattenedPath::contains
 
-	   @param tokens The tokens of the shape being tested
+	   @param tokens The tokens of the shape
 	   @param scaleFactor The scale factor to be applied
-	   @param x The X in local coordinates
-	   @param y The Y in local coordinates
+	   @param paths The flattened paths in local coordinates
 	*/
-	static bool hitTest(const tokensVector& tokens, float scaleFactor, number_t x, number_t y);
+	static void flattenTokens(const tokensVector& tokens, float scaleFactor, std::vector<FlattenedPath>& paths);
 };
 struct textline
 {
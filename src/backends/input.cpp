@@ -514,6 +514,10 @@ bool InputThread::handleKeyboardShortcuts(const SDL_KeyboardEvent *keyevent)
 			handled = true;
 			m_sys->showProfilingData=!m_sys->showProfilingData;
 			break;
+		case SDLK_r:
+			handled = true;
+			m_sys->showDirtyRects=!m_sys->showDirtyRects;
+			break;
 		case SDLK_m:
 			handled = true;
 			m_sys->audioManager->toggleMuteAll();
@@ -767,7 +767,16 @@ void LocalDownloader::execute()
 			notifyOwnerAboutBytesLoaded();
 			notifyOwnerAboutBytesTotal();
 		}
-		//Otherwise we follow the normal procedure
+		//Otherwise map the file and let the cache reference the mapping
+		else if (!dataGenerationMode && dynamic_cast<MemoryStreamCache *>(cache.getPtr()) &&
+			 static_cast<MemoryStreamCache *>(cache.getPtr())->useMappedFile(url))
+		{
+			length = cache->getReceivedLength();
+			LOG(LOG_INFO, "NET: LocalDownloader::execute: mapped " << length << " bytes of local file: " << url.raw_buf());
+			notifyOwnerAboutBytesLoaded();
+			notifyOwnerAboutBytesTotal();
+		}
+		//If the file can't be mapped we follow the normal procedure
 		else {
 			std::ifstream file;
 			file.open(url.raw_buf(), std::ios::in|std::ios::binary);
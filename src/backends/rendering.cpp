@@ -22,6 +22,7 @@
 #include "parsing/textfile.h"
 #include "backends/rendering.h"
 #include "backends/input.h"
+#include "backends/config.h"
 #include "compat.h"
 #include <sstream>
 #include <unistd.h>
@@ -31,6 +32,9 @@
 #	include <windows.h>
 #endif
 
+//Time (in ms) an empty texture page is kept before its GL texture is deleted
+#define TEXTURE_EVICTION_DELAY 10000
+
 using namespace lightspark;
 using namespace std;
 
@@ -58,9 +62,11 @@ void RenderThread::wait()
 
 RenderThread::RenderThread(SystemState* s):GLRenderContext(),
 	m_sys(s),status(CREATED),
-	prevUploadJob(nullptr),
+	prevUploadJob(nullptr),evictedTextures(0),lastTextureEvictionCheck(0),frameDrawCalls(0),frameTexturedDraws(0),
 	renderNeeded(false),uploadNeeded(false),resizeNeeded(false),newTextureNeeded(false),event(0),newWidth(0),newHeight(0),scaleX(1),scaleY(1),
-	offsetX(0),offsetY(0),tempBufferAcquired(false),frameCount(0),secsCount(0),initialized(0),refreshNeeded(false),screenshotneeded(false),inSettings(false),canrender(false),
+	offsetX(0),offsetY(0),tempBufferAcquired(false),frameCount(0),secsCount(0),
+	stageFramebuffer(0),stageTextureID(0),stageDepthRenderBuffer(UINT32_MAX),stageStencilRenderBuffer(UINT32_MAX),stageFramebufferValid(false),stageBackground(0,0,0),
+	initialized(0),refreshNeeded(false),screenshotneeded(false),inSettings(false),canrender(false),
 	cairoTextureContextSettings(nullptr),cairoTextureContext(nullptr)
 {
 	LOG(LOG_INFO,"RenderThread this=" << this);
@@ -92,12 +98,16 @@ RenderThread::~RenderThread()
 
 void RenderThread::handleNewTexture()
 {
-	//Find if any largeTexture is not initialized
+	//Find if any largeTexture is not initialized, evicted pages are skipped until chunks are allocated on them again
 	Locker l(mutexLargeTexture);
 	for(uint32_t i=0;i<largeTextures.size();i++)
 	{
-		if(largeTextures[i].id==(uint32_t)-1)
+		if(largeTextures[i].needsGLTexture)
+		{
+			assert(largeTextures[i].id==(uint32_t)-1);
 			largeTextures[i].id=allocateNewGLTexture();
+			largeTextures[i].needsGLTexture=false;
+		}
 	}
 	newTextureNeeded=false;
 }
@@ -111,6 +121,7 @@ void RenderThread::finalizeUpload()
 	u->contentScale(tex.xContentScale, tex.yContentScale);
 	u->contentOffset(tex.xOffset, tex.yOffset);
 	loadChunkBGRA(tex, w, h, u->upload(false));
+	uploadedTextures.insert(tex.chunks);
 	u->uploadFence();
 	prevUploadJob=nullptr;
 }
@@ -221,6 +232,12 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 	}
 	if(newTextureNeeded)
 		handleNewTexture();
+	evictUnusedTextures(profile);
+	if (profile)
+	{
+		profile->setCounter("draw calls",frameDrawCalls);
+		profile->setCounter("textured draws",frameTexturedDraws);
+	}
 
 	if(prevUploadJob)
 		finalizeUpload();
@@ -514,12 +531,14 @@ void RenderThread::commonGLDeinit()
 	engineData->exec_glFrontFace(false);
 	for(uint32_t i=0;i<largeTextures.size();i++)
 	{
-		engineData->exec_glDeleteTextures(1,&largeTextures[i].id);
+		if(largeTextures[i].id!=(uint32_t)-1)
+			engineData->exec_glDeleteTextures(1,&largeTextures[i].id);
 		delete[] largeTextures[i].bitmap;
 	}
 	engineData->exec_glDeleteTextures(1, &cairoTextureID);
 	engineData->exec_glDeleteTextures(1, &cairoTextureIDSettings);
 	engineData->exec_glDeleteTextures(1, &maskTextureID);
+	engineData->exec_glDeleteTextures(1, &stageTextureID);
 }
 
 void RenderThread::commonGLInit(int width, int height)
@@ -576,6 +595,10 @@ void RenderThread::commonGLInit(int width, int height)
 	maskframebuffer = engineData->exec_glGenFramebuffer();
 	engineData->exec_glGenTextures(1, &maskTextureID);
 
+	// create framebuffer for partial redraws of the stage
+	stageFramebuffer = engineData->exec_glGenFramebuffer();
+	engineData->exec_glGenTextures(1, &stageTextureID);
+
 	if(handleGLErrors())
 	{
 		LOG(LOG_ERROR,"GL errors during initialization");
@@ -615,6 +638,41 @@ void RenderThread::commonGLResize()
 	engineData->exec_glViewport(0,0,windowWidth,windowHeight);
 	engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
 	engineData->exec_glActiveTexture_GL_TEXTURE0(0);
+
+	// setup stage framebuffer, NanoVG needs a stencil buffer
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(stageTextureID);
+	engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(stageFramebuffer);
+	engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_NEAREST();
+	engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_NEAREST();
+	engineData->exec_glTexImage2D_GL_TEXTURE_2D_GL_UNSIGNED_BYTE(0, windowWidth,windowHeight, 0, nullptr,true);
+	engineData->exec_glFramebufferTexture2D_GL_FRAMEBUFFER(stageTextureID);
+	if (stageDepthRenderBuffer == UINT32_MAX)
+		stageDepthRenderBuffer = engineData->exec_glGenRenderbuffer();
+	if (engineData->supportPackedDepthStencil)
+	{
+		engineData->exec_glBindRenderbuffer(stageDepthRenderBuffer);
+		engineData->exec_glRenderbufferStorage_GL_RENDERBUFFER_GL_DEPTH_STENCIL(windowWidth,windowHeight);
+		engineData->exec_glFramebufferRenderbuffer_GL_FRAMEBUFFER_GL_DEPTH_STENCIL_ATTACHMENT(stageDepthRenderBuffer);
+	}
+	else
+	{
+		if (stageStencilRenderBuffer == UINT32_MAX)
+			stageStencilRenderBuffer = engineData->exec_glGenRenderbuffer();
+		engineData->exec_glBindRenderbuffer(stageDepthRenderBuffer);
+		engineData->exec_glRenderbufferStorage_GL_RENDERBUFFER_GL_DEPTH_COMPONENT16(windowWidth,windowHeight);
+		engineData->exec_glBindRenderbuffer(stageStencilRenderBuffer);
+		engineData->exec_glRenderbufferStorage_GL_RENDERBUFFER_GL_STENCIL_INDEX8(windowWidth,windowHeight);
+		engineData->exec_glFramebufferRenderbuffer_GL_FRAMEBUFFER_GL_DEPTH_ATTACHMENT(stageDepthRenderBuffer);
+		engineData->exec_glFramebufferRenderbuffer_GL_FRAMEBUFFER_GL_STENCIL_ATTACHMENT(stageStencilRenderBuffer);
+	}
+	engineData->exec_glBindRenderbuffer(0);
+	engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
+	stageFramebufferValid=false;
+	viewOffsetX=offsetX;
+	viewOffsetY=offsetY;
+	viewWidth=windowWidth;
+	viewHeight=windowHeight;
+
 	engineData->exec_glBindTexture_GL_TEXTURE_2D(0);
 	engineData->exec_glDisable_GL_DEPTH_TEST();
 	engineData->exec_glDisable_GL_STENCIL_TEST();
@@ -766,10 +824,14 @@ void RenderThread::plotProfilingData()
 bool RenderThread::coreRendering()
 {
 	Locker l(mutexRendering);
-	engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
+	// Stage3D renders directly to the window, so there are no partial redraws in that case
+	bool partial = Config::getConfig()->isPartialRedrawEnabled() && !m_sys->stage->renderStage3D();
+	renderframebuffer = partial ? stageFramebuffer : 0;
+	engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(renderframebuffer);
 	engineData->exec_glFrontFace(false);
-	engineData->exec_glDrawBuffer_GL_BACK();
-	if (!m_sys->stage->renderStage3D()) // no need to clear the backbuffer when using Stage3D
+	if (!partial)
+		engineData->exec_glDrawBuffer_GL_BACK();
+	if (!m_sys->stage->renderStage3D() && !partial) // no need to clear the backbuffer when using Stage3D
 	{
 		//Clear the back buffer
 		RGB bg=m_sys->mainClip->getBackground();
@@ -779,9 +841,29 @@ bool RenderThread::coreRendering()
 	engineData->exec_glUseProgram(gpu_program);
 	lsglLoadIdentity();
 	setMatrixUniform(LSGL_MODELVIEW);
+	batchDraws = Config::getConfig()->isDrawBatchingEnabled();
+	drawCalls=0;
+	texturedDraws=0;
 
-	bool ret = m_sys->stage->Render(*this);
+	bool ret;
+	if (partial)
+	{
+		ret = renderDirtyRegions();
+		presentStageFramebuffer();
+		if (m_sys->showDirtyRects)
+			plotDirtyRects();
+	}
+	else
+	{
+		ret = m_sys->stage->Render(*this);
+		flushBatch();
+		// the content of the stage framebuffer is outdated now
+		stageFramebufferValid=false;
+		lastDrawRecords.clear();
+	}
 
+	frameDrawCalls=drawCalls;
+	frameTexturedDraws=texturedDraws;
 	if(m_sys->showProfilingData)
 		plotProfilingData();
 
@@ -789,6 +871,177 @@ bool RenderThread::coreRendering()
 	return ret;
 }
 
+void RenderThread::addDirtySurface(const CachedSurface& surface)
+{
+	if (!surface.isValid || !surface.tex || !surface.tex->isValid())
+		return;
+	addDirtyRect(pendingDirtyRects,computeDirtyRect(*surface.tex,surface.matrix));
+}
+
+bool RenderThread::renderDirtyRegions()
+{
+	DirtyRect view(0,0,windowWidth,windowHeight);
+	RGB bg=m_sys->mainClip->getBackground();
+	std::vector<DirtyRect> dirty;
+	if (!stageFramebufferValid || bg.Red != stageBackground.Red || bg.Green != stageBackground.Green || bg.Blue != stageBackground.Blue)
+		dirty.push_back(view);
+	else
+	{
+		dirty.swap(pendingDirtyRects);
+		// the content of these textures changed, so the region they were drawn to last time is dirty
+		for (auto it = lastDrawRecords.begin(); it != lastDrawRecords.end(); it++)
+		{
+			if (it->content && uploadedTextures.count(it->content))
+				addDirtyRect(dirty,it->rect);
+		}
+	}
+	pendingDirtyRects.clear();
+	uploadedTextures.clear();
+	stageBackground=bg;
+
+	// the first pass records all draws, so it is done even if nothing is known to be dirty
+	drawRecords.clear();
+	recordDraws=true;
+	bool ret = renderStageClipped(dirty.empty() ? DirtyRect() : dirty.front());
+	recordDraws=false;
+
+	// find the changes that were not reported by comparing the draws with the ones of the last frame
+	// skip the draws that are the same at the start and the end of both lists
+	size_t first=0;
+	size_t endcur=drawRecords.size();
+	size_t endlast=lastDrawRecords.size();
+	while (first < endcur && first < endlast && drawRecords[first]==lastDrawRecords[first])
+		first++;
+	while (endcur > first && endlast > first && drawRecords[endcur-1]==lastDrawRecords[endlast-1])
+	{
+		endcur--;
+		endlast--;
+	}
+	detectedDirtyRects.clear();
+	auto addDetected = [&](const DirtyRect& r)
+	{
+		for (auto it = dirty.begin(); it != dirty.end(); it++)
+		{
+			if (it->contains(r))
+				return;
+		}
+		addDirtyRect(detectedDirtyRects,r);
+	};
+	for (size_t i = first; i < endcur; i++)
+		addDetected(drawRecords[i].rect);
+	for (size_t i = first; i < endlast; i++)
+		addDetected(lastDrawRecords[i].rect);
+
+	renderedDirtyRects.clear();
+	for (auto it = dirty.begin(); it != dirty.end(); it++)
+	{
+		if (it != dirty.begin())
+			ret |= renderStageClipped(*it);
+		renderedDirtyRects.push_back(*it);
+	}
+	for (auto it = detectedDirtyRects.begin(); it != detectedDirtyRects.end(); it++)
+		ret |= renderStageClipped(*it);
+	lastDrawRecords.swap(drawRecords);
+	stageFramebufferValid=true;
+	return ret;
+}
+
+bool RenderThread::renderStageClipped(const DirtyRect& r)
+{
+	clipping=true;
+	clipRect=r;
+	engineData->exec_glScissor(r.xmin,r.ymin,r.xmax-r.xmin,r.ymax-r.ymin);
+	if (!r.isEmpty())
+	{
+		RGB bg=m_sys->mainClip->getBackground();
+		engineData->exec_glClearColor(bg.Red/255.0F,bg.Green/255.0F,bg.Blue/255.0F,1);
+		engineData->exec_glClear_GL_COLOR_BUFFER_BIT();
+	}
+	lsglLoadIdentity();
+	setMatrixUniform(LSGL_MODELVIEW);
+	bool ret = m_sys->stage->Render(*this);
+	flushBatch();
+	engineData->exec_glDisable_GL_SCISSOR_TEST();
+	clipping=false;
+	return ret;
+}
+
+//Copy the stage framebuffer to the window
+void RenderThread::presentStageFramebuffer()
+{
+	renderframebuffer=0;
+	engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
+	engineData->exec_glDrawBuffer_GL_BACK();
+	lsglLoadIdentity();
+	lsglScalef(1.0f,-1.0f,1);
+	lsglTranslatef(-offsetX,(windowHeight-offsetY)*(-1.0f),0);
+	setMatrixUniform(LSGL_MODELVIEW);
+
+	// 4.0: copy the texels unmodified
+	engineData->exec_glUniform1f(directUniform, 4.0);
+	engineData->exec_glUniform1f(maskUniform, 0);
+	engineData->exec_glUniform1f(yuvUniform, 0);
+	engineData->exec_glUniform1f(alphaUniform, 1);
+	engineData->exec_glUniform4f(colortransMultiplyUniform, 1.0,1.0,1.0,1.0);
+	engineData->exec_glUniform4f(colortransAddUniform, 0.0,0.0,0.0,0.0);
+	engineData->exec_glBlendFunc(BLEND_ONE,BLEND_ZERO);
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(stageTextureID);
+
+	float vertex_coords[] = {0,0, float(windowWidth),0, 0,float(windowHeight), float(windowWidth),float(windowHeight)};
+	float texture_coords[] = {0,0, 1,0, 0,1, 1,1};
+	engineData->exec_glVertexAttribPointer(VERTEX_ATTRIB, 0, vertex_coords,FLOAT_2);
+	engineData->exec_glVertexAttribPointer(TEXCOORD_ATTRIB, 0, texture_coords,FLOAT_2);
+	engineData->exec_glEnableVertexAttribArray(VERTEX_ATTRIB);
+	engineData->exec_glEnableVertexAttribArray(TEXCOORD_ATTRIB);
+	engineData->exec_glDrawArrays_GL_TRIANGLE_STRIP(0, 4);
+	engineData->exec_glDisableVertexAttribArray(VERTEX_ATTRIB);
+	engineData->exec_glDisableVertexAttribArray(TEXCOORD_ATTRIB);
+
+	engineData->exec_glBlendFunc(BLEND_ONE,BLEND_ONE_MINUS_SRC_ALPHA);
+	engineData->exec_glUniform1f(directUniform, 0);
+}
+
+//Outline the regions rendered in this frame, red for reported changes, yellow for changes found by comparing the draws
+void RenderThread::plotDirtyRects()
+{
+	lsglLoadIdentity();
+	lsglScalef(1.0f,-1.0f,1);
+	lsglTranslatef(-offsetX,(windowHeight-offsetY)*(-1.0f),0);
+	setMatrixUniform(LSGL_MODELVIEW);
+	engineData->exec_glUniform1f(directUniform, 1);
+
+	std::vector<float> vertex_coords;
+	std::vector<float> color_coords;
+	auto addOutline = [&](const DirtyRect& r, float red, float green)
+	{
+		float x1=r.xmin+0.5f,y1=r.ymin+0.5f,x2=r.xmax-0.5f,y2=r.ymax-0.5f;
+		float lines[] = {x1,y1, x2,y1, x2,y1, x2,y2, x2,y2, x1,y2, x1,y2, x1,y1};
+		vertex_coords.insert(vertex_coords.end(),lines,lines+16);
+		for (int i=0;i<8;i++)
+		{
+			color_coords.push_back(red);
+			color_coords.push_back(green);
+			color_coords.push_back(0);
+			color_coords.push_back(1);
+		}
+	};
+	for (auto it = renderedDirtyRects.begin(); it != renderedDirtyRects.end(); it++)
+		addOutline(*it,1,0);
+	for (auto it = detectedDirtyRects.begin(); it != detectedDirtyRects.end(); it++)
+		addOutline(*it,1,1);
+	if (!vertex_coords.empty())
+	{
+		engineData->exec_glVertexAttribPointer(VERTEX_ATTRIB, 0, vertex_coords.data(),FLOAT_2);
+		engineData->exec_glVertexAttribPointer(COLOR_ATTRIB, 0, color_coords.data(),FLOAT_4);
+		engineData->exec_glEnableVertexAttribArray(VERTEX_ATTRIB);
+		engineData->exec_glEnableVertexAttribArray(COLOR_ATTRIB);
+		engineData->exec_glDrawArrays_GL_LINES(0, vertex_coords.size()/2);
+		engineData->exec_glDisableVertexAttribArray(VERTEX_ATTRIB);
+		engineData->exec_glDisableVertexAttribArray(COLOR_ATTRIB);
+	}
+	engineData->exec_glUniform1f(directUniform, 0);
+}
+
 //Renders the error message which caused the VM to stop.
 void RenderThread::renderErrorPage(RenderThread *th, bool standalone)
 {
@@ -910,17 +1163,77 @@ void RenderThread::tickFence()
 
 void RenderThread::releaseTexture(const TextureChunk& chunk)
 {
-	uint32_t blocksW=(chunk.width+CHUNKSIZE-1)/CHUNKSIZE;
-	uint32_t blocksH=(chunk.height+CHUNKSIZE-1)/CHUNKSIZE;
-	uint32_t numberOfBlocks=blocksW*blocksH;
+	if(!chunk.chunks || chunk.allocatedChunks==0)
+		return;
+	uint32_t blockPerSide=largeTextureSize/CHUNKSIZE;
 	Locker l(mutexLargeTexture);
 	LargeTexture& tex=largeTextures[chunk.texId];
-	for(uint32_t i=0;i<numberOfBlocks;i++)
+	for(uint32_t i=0;i<chunk.allocatedChunks;i++)
 	{
 		uint32_t bitOffset=chunk.chunks[i];
 		assert(tex.bitmap[bitOffset/8]&(1<<(bitOffset%8)));
 		tex.bitmap[bitOffset/8]^=(1<<(bitOffset%8));
 	}
+	tex.freeBlocks+=chunk.allocatedChunks;
+	//Lower the skyline of the touched columns down to the topmost used block
+	for(uint32_t i=0;i<chunk.allocatedChunks;i++)
+	{
+		uint32_t column=chunk.chunks[i]%blockPerSide;
+		uint16_t& top=tex.skyline[column];
+		while(top>0)
+		{
+			uint32_t bitOffset=(top-1)*blockPerSide+column;
+			if(tex.bitmap[bitOffset/8]&(1<<(bitOffset%8)))
+				break;
+			top--;
+		}
+	}
+	if(tex.freeBlocks==blockPerSide*blockPerSide)
+		tex.lastUsed=compat_msectiming();
+}
+
+void RenderThread::evictUnusedTextures(ThreadProfile* profile)
+{
+	uint64_t now=compat_msectiming();
+	if(now-lastTextureEvictionCheck<1000)
+		return;
+	lastTextureEvictionCheck=now;
+	uint32_t blockPerSide=largeTextureSize/CHUNKSIZE;
+	uint32_t residentPages=0;
+	uint32_t freeBlocks=0;
+	uint32_t holes=0;
+	{
+		Locker l(mutexLargeTexture);
+		//Keep the first page around, it will almost surely be needed again
+		for(uint32_t i=0;i<largeTextures.size();i++)
+		{
+			LargeTexture& tex=largeTextures[i];
+			if(tex.id==(uint32_t)-1)
+				continue;
+			if(i>0 && tex.freeBlocks==blockPerSide*blockPerSide && now-tex.lastUsed>TEXTURE_EVICTION_DELAY)
+			{
+				//The bitmap is kept, so that texture ids stay stable, the GL texture is created again when needed
+				engineData->exec_glDeleteTextures(1,&tex.id);
+				tex.id=(uint32_t)-1;
+				evictedTextures++;
+				continue;
+			}
+			residentPages++;
+			freeBlocks+=tex.freeBlocks;
+			uint32_t aboveSkyline=0;
+			for(uint32_t j=0;j<blockPerSide;j++)
+				aboveSkyline+=blockPerSide-tex.skyline[j];
+			holes+=tex.freeBlocks-aboveSkyline;
+		}
+	}
+	if(!profile)
+		return;
+	profile->setCounter("texture pages",residentPages);
+	profile->setCounter("texture blocks used",residentPages*blockPerSide*blockPerSide-freeBlocks);
+	profile->setCounter("texture blocks free",freeBlocks);
+	//Free blocks below the skyline can only be reused by sparse allocations or by the slower hole search
+	profile->setCounter("texture fragmentation %",freeBlocks ? holes*100/freeBlocks : 0);
+	profile->setCounter("texture pages evicted",evictedTextures);
 }
 
 uint32_t RenderThread::allocateNewGLTexture() const
@@ -948,97 +1261,107 @@ RenderThread::LargeTexture& RenderThread::allocateNewTexture()
 	//Signal that a new texture is needed
 	newTextureNeeded=true;
 	//Let's allocate the bitmap for the texture blocks, minumum block size is CHUNKSIZE
-	uint32_t bitmapSize=(largeTextureSize/CHUNKSIZE)*(largeTextureSize/CHUNKSIZE)/8;
+	uint32_t blockPerSide=largeTextureSize/CHUNKSIZE;
+	uint32_t bitmapSize=(blockPerSide*blockPerSide+7)/8;
 	uint8_t* bitmap=new uint8_t[bitmapSize];
 	memset(bitmap,0,bitmapSize);
-	largeTextures.emplace_back(bitmap);
+	largeTextures.emplace_back(bitmap,blockPerSide);
 	return largeTextures.back();
 }
 
-bool RenderThread::allocateChunkOnTextureCompact(LargeTexture& tex, TextureChunk& ret, uint32_t blocksW, uint32_t blocksH)
+bool RenderThread::findFreeRectOnTexture(const LargeTexture& tex, uint32_t blocksW, uint32_t blocksH, uint32_t& x, uint32_t& y) const
 {
-	//Find a contiguos set of blocks
-	uint32_t start;
+	//Look for a free rectangle in the holes below the skyline, rows never wrap around
 	uint32_t blockPerSide=largeTextureSize/CHUNKSIZE;
-	uint32_t bitmapSize=blockPerSide*blockPerSide;
-	for(start=0;start<bitmapSize;start++)
+	for(y=0;y+blocksH<=blockPerSide;y++)
 	{
-		bool badRect=false;
-		//TODO: correct rect lookup
-		for(uint32_t i=0;i<blocksH;i++)
+		for(x=0;x+blocksW<=blockPerSide;x++)
 		{
-			for(uint32_t j=0;j<blocksW;j++)
+			bool badRect=false;
+			for(uint32_t i=0;i<blocksH && !badRect;i++)
 			{
-				uint32_t bitOffset=start+i*blockPerSide+j;
-				if(bitOffset>=bitmapSize)
-				{
-					badRect=true;
-					break;
-				}
-				if(tex.bitmap[bitOffset/8]&(1<<(bitOffset%8)))
+				for(uint32_t j=0;j<blocksW;j++)
 				{
-					badRect=true;
-					break;
+					uint32_t bitOffset=(y+i)*blockPerSide+x+j;
+					if(tex.bitmap[bitOffset/8]&(1<<(bitOffset%8)))
+					{
+						badRect=true;
+						//No rectangle can start before the used block
+						x+=j;
+						break;
+					}
 				}
 			}
-			if(badRect)
-				break;
+			if(!badRect)
+				return true;
+		}
+	}
+	return false;
+}
+
+bool RenderThread::allocateChunkOnTextureCompact(LargeTexture& tex, TextureChunk& ret, uint32_t blocksW, uint32_t blocksH)
+{
+	uint32_t blockPerSide=largeTextureSize/CHUNKSIZE;
+	if(tex.freeBlocks<blocksW*blocksH || blocksW>blockPerSide || blocksH>blockPerSide)
+		return false;
+	//Bottom-left skyline placement: use the span of columns with the lowest top
+	uint32_t startX=UINT32_MAX;
+	uint32_t startY=UINT32_MAX;
+	for(uint32_t x=0;x+blocksW<=blockPerSide;x++)
+	{
+		uint32_t y=0;
+		for(uint32_t j=0;j<blocksW;j++)
+			y=std::max<uint32_t>(y,tex.skyline[x+j]);
+		if(y+blocksH<=blockPerSide && y<startY)
+		{
+			startX=x;
+			startY=y;
 		}
-		if(!badRect)
-			break;
 	}
-	if(start==bitmapSize)
+	if(startX==UINT32_MAX && !findFreeRectOnTexture(tex, blocksW, blocksH, startX, startY))
 		return false;
 	//Now set all those blocks are used
 	for(uint32_t i=0;i<blocksH;i++)
 	{
 		for(uint32_t j=0;j<blocksW;j++)
 		{
-			uint32_t bitOffset=start+i*blockPerSide+j;
+			uint32_t bitOffset=(startY+i)*blockPerSide+startX+j;
+			assert((tex.bitmap[bitOffset/8]&(1<<(bitOffset%8)))==0);
 			tex.bitmap[bitOffset/8]|=1<<(bitOffset%8);
 			ret.chunks[i*blocksW+j]=bitOffset;
 		}
 	}
+	for(uint32_t j=0;j<blocksW;j++)
+		tex.skyline[startX+j]=std::max<uint16_t>(tex.skyline[startX+j],startY+blocksH);
+	tex.freeBlocks-=blocksW*blocksH;
 	return true;
 }
 
 bool RenderThread::allocateChunkOnTextureSparse(LargeTexture& tex, TextureChunk& ret, uint32_t blocksW, uint32_t blocksH)
 {
 	//Allocate a sparse set of texture chunks
+	uint32_t needed=blocksW*blocksH;
+	if(tex.freeBlocks<needed)
+		return false;
 	uint32_t found=0;
 	uint32_t blockPerSide=largeTextureSize/CHUNKSIZE;
 	uint32_t bitmapSize=blockPerSide*blockPerSide;
-	//TODO: use the already allocated array
-	uint32_t* tmp=new uint32_t[blocksW*blocksH];
-	for(uint32_t i=0;i<bitmapSize;i++)
+	//Scanning from the first row fills the holes below the skyline first
+	for(uint32_t i=0;i<bitmapSize && found<needed;i++)
 	{
 		if((tex.bitmap[i/8]&(1<<(i%8)))==0)
 		{
 			tex.bitmap[i/8]|=1<<(i%8);
-			tmp[found]=i;
+			ret.chunks[found]=i;
 			found++;
-			if(found==(blocksW*blocksH))
-				break;
-		}
-	}
-	if(found<blocksW*blocksH)
-	{
-		//This is considered the unfrequent case
-		for(uint32_t i=0;i<found;i++)
-		{
-			uint32_t bitOffset=tmp[i];
-			assert(tex.bitmap[bitOffset/8]&(1<<(bitOffset%8)));
-			tex.bitmap[bitOffset/8]^=(1<<(bitOffset%8));
+			uint16_t& top=tex.skyline[i%blockPerSide];
+			top=std::max<uint16_t>(top,i/blockPerSide+1);
 		}
-		delete[] tmp;
-		return false;
-	}
-	else
-	{
-		delete[] ret.chunks;
-		ret.chunks=tmp;
-		return true;
 	}
+	//freeBlocks guarantees that enough blocks are available
+	assert(found==needed);
+	tex.freeBlocks-=needed;
+	return true;
 }
 
 TextureChunk RenderThread::allocateTexture(uint32_t w, uint32_t h, bool compact)
@@ -1056,19 +1379,25 @@ TextureChunk RenderThread::allocateTexture(uint32_t w, uint32_t h, bool compact)
 		if(compact)
 		{
 			if(allocateChunkOnTextureCompact(largeTextures[index], ret, blocksW, blocksH))
-			{
-				ret.texId=index;
-				return ret;
-			}
+				break;
 		}
 		else
 		{
 			if(allocateChunkOnTextureSparse(largeTextures[index], ret, blocksW, blocksH))
-			{
-				ret.texId=index;
-				return ret;
-			}
+				break;
+		}
+	}
+	if(index<largeTextures.size())
+	{
+		//The GL texture of this page may have been evicted
+		if(largeTextures[index].id==(uint32_t)-1)
+		{
+			largeTextures[index].needsGLTexture=true;
+			newTextureNeeded=true;
 		}
+		ret.texId=index;
+		ret.allocatedChunks=blocksW*blocksH;
+		return ret;
 	}
 	//No place found, allocate a new one and try on that
 	LargeTexture& tex=allocateNewTexture();
@@ -1084,7 +1413,10 @@ TextureChunk RenderThread::allocateTexture(uint32_t w, uint32_t h, bool compact)
 		ret.makeEmpty();
 	}
 	else
+	{
 		ret.texId=index;
+		ret.allocatedChunks=blocksW*blocksH;
+	}
 	return ret;
 }
 
@@ -24,6 +24,7 @@
 #include "timer.h"
 #include <SDL2/SDL.h>
 #include <sys/time.h>
+#include <unordered_set>
 #ifdef _WIN32
 #	include <windef.h>
 #endif
@@ -52,6 +53,17 @@ private:
 	LargeTexture& allocateNewTexture();
 	bool allocateChunkOnTextureCompact(LargeTexture& tex, TextureChunk& ret, uint32_t blocksW, uint32_t blocksH);
 	bool allocateChunkOnTextureSparse(LargeTexture& tex, TextureChunk& ret, uint32_t blocksW, uint32_t blocksH);
+	bool findFreeRectOnTexture(const LargeTexture& tex, uint32_t blocksW, uint32_t blocksH, uint32_t& x, uint32_t& y) const;
+	/*
+	 * Deletes the GL textures of pages that have been empty for a while
+	 * and publishes the atlas occupancy counters on the profile
+	 */
+	void evictUnusedTextures(ThreadProfile* profile);
+	uint32_t evictedTextures;
+	uint64_t lastTextureEvictionCheck;
+	// draw statistics of the last frame, shown in the profiling overlay
+	uint32_t frameDrawCalls;
+	uint32_t frameTexturedDraws;
 	//Possible events to be handled
 	//TODO: pad to avoid false sharing on the cache lines
 	volatile bool renderNeeded;
@@ -90,6 +102,33 @@ private:
 	*/
 	bool coreRendering();
 	void plotProfilingData();
+
+	/* Partial redraw
+	 * The stage is rendered into stageFramebuffer, only the parts that changed since the last frame
+	 * are rendered again and the framebuffer is copied to the window afterwards
+	 */
+	uint32_t stageFramebuffer;
+	uint32_t stageTextureID;
+	uint32_t stageDepthRenderBuffer;
+	uint32_t stageStencilRenderBuffer;
+	bool stageFramebufferValid;
+	RGB stageBackground;
+	std::vector<DrawRecord> lastDrawRecords;
+	// regions reported by updated surfaces since the last frame
+	std::vector<DirtyRect> pendingDirtyRects;
+	// textures uploaded since the last frame
+	std::unordered_set<const void*> uploadedTextures;
+	// regions rendered in the last frame, for the debug overlay
+	std::vector<DirtyRect> renderedDirtyRects;
+	std::vector<DirtyRect> detectedDirtyRects;
+	/*
+		Renders the changed parts of the stage into stageFramebuffer
+		returns true if at least one of the displayobjects on the stage couldn't be rendered
+	*/
+	bool renderDirtyRegions();
+	bool renderStageClipped(const DirtyRect& r);
+	void presentStageFramebuffer();
+	void plotDirtyRects();
 	Semaphore initialized;
 	volatile bool refreshNeeded;
 	Mutex mutexRefreshSurfaces;
@@ -122,6 +161,11 @@ public:
 	bool doRender(ThreadProfile *profile=nullptr, Chronometer *chronometer=nullptr);
 	void generateScreenshot();
 	bool isStarted() const { return status == STARTED; }
+	/**
+	 * @brief marks the region currently covered by a cachedSurface as changed,
+	 * has to be called from the render thread before and after the surface is modified
+	 */
+	void addDirtySurface(const CachedSurface& surface);
 	/**
 	 * @brief updates the arguments of a cachedSurface without recreating the texture
 	 * @param d IDrawable containing the new values
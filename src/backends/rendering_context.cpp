@@ -125,7 +125,136 @@ const CachedSurface& GLRenderContext::getCachedSurface(const DisplayObject* d) c
 	return d->cachedSurface;
 }
 
+DirtyRect DirtyRect::united(const DirtyRect& r) const
+{
+	if (isEmpty())
+		return r;
+	if (r.isEmpty())
+		return *this;
+	return DirtyRect(min(xmin,r.xmin),min(ymin,r.ymin),max(xmax,r.xmax),max(ymax,r.ymax));
+}
+
+void GLRenderContext::addDirtyRect(std::vector<DirtyRect>& rects, const DirtyRect& r)
+{
+	if (r.isEmpty())
+		return;
+	DirtyRect cur = r;
+	// merge with all rectangles overlapping the new one, this may create new overlaps
+	bool merged=true;
+	while (merged)
+	{
+		merged=false;
+		for (auto it = rects.begin(); it != rects.end(); it++)
+		{
+			if (it->contains(cur))
+				return;
+			if (it->intersects(cur))
+			{
+				cur = cur.united(*it);
+				rects.erase(it);
+				merged=true;
+				break;
+			}
+		}
+	}
+	rects.push_back(cur);
+	// every rectangle costs a traversal of the display list, so keep only a few of them
+	while (rects.size() > 4)
+	{
+		uint32_t besti=0,bestj=1;
+		int64_t bestgrowth=INT64_MAX;
+		for (uint32_t i=0; i < rects.size(); i++)
+		{
+			for (uint32_t j=i+1; j < rects.size(); j++)
+			{
+				int64_t growth = rects[i].united(rects[j]).area()-rects[i].area()-rects[j].area();
+				if (growth < bestgrowth)
+				{
+					bestgrowth=growth;
+					besti=i;
+					bestj=j;
+				}
+			}
+		}
+		DirtyRect u = rects[besti].united(rects[bestj]);
+		rects.erase(rects.begin()+bestj);
+		rects.erase(rects.begin()+besti);
+		addDirtyRect(rects,u);
+	}
+}
+
+DirtyRect GLRenderContext::computeDirtyRect(const TextureChunk& chunk, const MATRIX& matrix) const
+{
+	// same quad as in renderpart()
+	number_t x1 = chunk.xOffset/chunk.xContentScale;
+	number_t y1 = chunk.yOffset/chunk.yContentScale;
+	number_t x2 = x1+chunk.width/chunk.xContentScale;
+	number_t y2 = y1+chunk.height/chunk.yContentScale;
+	number_t coords[8];
+	matrix.multiply2D(x1,y1,coords[0],coords[1]);
+	matrix.multiply2D(x2,y1,coords[2],coords[3]);
+	matrix.multiply2D(x1,y2,coords[4],coords[5]);
+	matrix.multiply2D(x2,y2,coords[6],coords[7]);
+	number_t minx=coords[0],maxx=coords[0],miny=coords[1],maxy=coords[1];
+	for (int i=2;i<8;i+=2)
+	{
+		minx=min(minx,coords[i]);
+		maxx=max(maxx,coords[i]);
+		miny=min(miny,coords[i+1]);
+		maxy=max(maxy,coords[i+1]);
+	}
+	DirtyRect view(0,0,viewWidth,viewHeight);
+	if (!std::isfinite(minx) || !std::isfinite(maxx) || !std::isfinite(miny) || !std::isfinite(maxy))
+		return view;
+	// the stage y axis points downwards, the window y axis upwards (see commonGLResize)
+	// add one pixel on every side for linear filtering
+	number_t wxmin = floor(minx)+viewOffsetX-1;
+	number_t wxmax = ceil(maxx)+viewOffsetX+1;
+	number_t wymin = floor(number_t(viewHeight)-viewOffsetY-maxy)-1;
+	number_t wymax = ceil(number_t(viewHeight)-viewOffsetY-miny)+1;
+	DirtyRect ret(max(number_t(view.xmin),wxmin),max(number_t(view.ymin),wymin),
+				  min(number_t(view.xmax),wxmax),min(number_t(view.ymax),wymax));
+	return ret.isEmpty() ? DirtyRect() : ret;
+}
+
+bool GLRenderContext::prepareNanoVGDraw(const void* owner, const float* params, uint32_t count, float& clipx, float& clipy, float& clipwidth, float& clipheight)
+{
+	flushBatch();
+	DirtyRect view(0,0,viewWidth,viewHeight);
+	if (recordDraws)
+	{
+		// the bounds of the shape are not known, so a change is treated as a change of the whole stage
+		DrawRecord r;
+		memset(r.params,0,sizeof(r.params));
+		r.rect = view;
+		r.content = owner;
+		memcpy(r.params,params,min(count,uint32_t(32))*sizeof(float));
+		drawRecords.push_back(r);
+	}
+	DirtyRect clip = clipping ? clipRect : view;
+	if (clip.isEmpty())
+		return false;
+	// the NanoVG y axis points downwards
+	clipx = clip.xmin;
+	clipy = float(viewHeight)-clip.ymax;
+	clipwidth = clip.xmax-clip.xmin;
+	clipheight = clip.ymax-clip.ymin;
+	return true;
+}
+
+void GLRenderContext::finishNanoVGDraw()
+{
+	if (clipping)
+		engineData->exec_glScissor(clipRect.xmin,clipRect.ymin,clipRect.xmax-clipRect.xmin,clipRect.ymax-clipRect.ymin);
+}
+
 void GLRenderContext::setProperties(AS_BLENDMODE blendmode)
+{
+	// the blend function is set when the batch using it is submitted
+	currentBlendMode=blendmode;
+}
+
+void GLRenderContext::applyBlendMode(AS_BLENDMODE blendmode)
 {
 	// TODO handle other blend modes ,maybe with shaders ? (see https://github.com/jamieowen/glsl-blend)
 	switch (blendmode)
@@ -153,37 +282,72 @@ void GLRenderContext::renderTextured(const TextureChunk& chunk, float alpha, COL
 									 float redOffset, float greenOffset, float blueOffset, float alphaOffset,
 									 bool isMask, bool hasMask, float directMode, RGB directColor, SMOOTH_MODE smooth, const MATRIX& matrix, Rectangle* scalingGrid)
 {
-	if (isMask)
+	if (recordDraws || clipping)
 	{
-		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(maskframebuffer);
-		engineData->exec_glClearColor(0,0,0,0);
-		engineData->exec_glClear_GL_COLOR_BUFFER_BIT();
-		engineData->exec_glUniform1f(maskUniform, 0);
-	}
-	else
-	{
-		engineData->exec_glUniform1f(maskUniform, hasMask ? 1 : 0);
-	}
-	if (smooth == SMOOTH_MODE::SMOOTH_NONE)
-	{
-		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_NEAREST();
-		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_NEAREST();
+		DrawRecord r;
+		memset(r.params,0,sizeof(r.params));
+		// the scaling grid may move parts of the texture outside of the quad, so assume everything is covered
+		r.rect = scalingGrid || directMode == 1.0 ? DirtyRect(0,0,viewWidth,viewHeight) : computeDirtyRect(chunk,matrix);
+		// for solid fills the content of the texture doesn't matter
+		r.content = directMode == 3.0 ? nullptr : chunk.chunks;
+		float* p = r.params;
+		*p++ = alpha;
+		*p++ = colorMode;
+		*p++ = redMultiplier;
+		*p++ = greenMultiplier;
+		*p++ = blueMultiplier;
+		*p++ = alphaMultiplier;
+		*p++ = redOffset;
+		*p++ = greenOffset;
+		*p++ = blueOffset;
+		*p++ = alphaOffset;
+		*p++ = isMask;
+		*p++ = hasMask;
+		*p++ = directMode;
+		*p++ = directColor.Red;
+		*p++ = directColor.Green;
+		*p++ = directColor.Blue;
+		*p++ = int(smooth);
+		*p++ = currentBlendMode;
+		*p++ = matrix.xx;
+		*p++ = matrix.yx;
+		*p++ = matrix.xy;
+		*p++ = matrix.yy;
+		*p++ = matrix.x0;
+		*p++ = matrix.y0;
+		*p++ = chunk.width;
+		*p++ = chunk.height;
+		*p++ = chunk.xOffset;
+		*p++ = chunk.yOffset;
+		*p++ = chunk.xContentScale;
+		*p++ = chunk.yContentScale;
+		if (scalingGrid)
+		{
+			*p++ = scalingGrid->x+scalingGrid->width;
+			*p++ = scalingGrid->y+scalingGrid->height;
+		}
+		if (recordDraws)
+			drawRecords.push_back(r);
+		// masks are always rendered, as the mask framebuffer is shared by all masked objects
+		if (clipping && (clipRect.isEmpty() || (!isMask && !r.rect.intersects(clipRect))))
+			return;
 	}
-	//Set color mode
-	engineData->exec_glUniform1f(yuvUniform, (colorMode==YUV_MODE)?1:0);
-	//Set alpha
-	engineData->exec_glUniform1f(alphaUniform, alpha);
-	engineData->exec_glUniform4f(colortransMultiplyUniform, redMultiplier,greenMultiplier,blueMultiplier,alphaMultiplier);
-	engineData->exec_glUniform4f(colortransAddUniform, redOffset/255.0,greenOffset/255.0,blueOffset/255.0,alphaOffset/255.0);
-	// set mode for direct coloring:
-	// 0.0:no coloring
-	// 1.0 coloring for profiling/error message (?)
-	// 2.0:set color for every non transparent pixel (used for text rendering)
-	// 3.0 set color for every pixel (renders a filled rectangle)
-	engineData->exec_glUniform1f(directUniform, directMode);
-	engineData->exec_glUniform4f(directColorUniform,float(directColor.Red)/255.0,float(directColor.Green)/255.0,float(directColor.Blue)/255.0,1.0);
-
-	engineData->exec_glBindTexture_GL_TEXTURE_2D(largeTextures[chunk.texId].id);
+	texturedDraws++;
+	// everything that is set per draw, see flushBatch()
+	float state[BATCH_STATE_SIZE] = {
+		float(hasMask), float(colorMode==YUV_MODE), alpha,
+		redMultiplier, greenMultiplier, blueMultiplier, alphaMultiplier,
+		redOffset, greenOffset, blueOffset, alphaOffset,
+		directMode, float(directColor.Red), float(directColor.Green), float(directColor.Blue),
+		float(smooth), float(currentBlendMode)
+	};
+	uint32_t texture = largeTextures[chunk.texId].id;
+	// masks are rendered to their own framebuffer, so they are never batched with other draws
+	if (isMask || !batchDraws || texture != batchTexture || batchIsMask || memcmp(state,batchState,sizeof(state)))
+		flushBatch();
+	memcpy(batchState,state,sizeof(state));
+	batchTexture=texture;
+	batchIsMask=isMask;
 	assert(chunk.getNumberOfChunks()==((chunk.width+CHUNKSIZE_REAL-1)/CHUNKSIZE_REAL)*((chunk.height+CHUNKSIZE_REAL-1)/CHUNKSIZE_REAL));
 
 	if (scalingGrid && scalingGrid->width+abs(scalingGrid->x) < chunk.width/chunk.xContentScale && scalingGrid->height+abs(scalingGrid->y) < chunk.height/chunk.yContentScale && matrix.getRotation()==0)
@@ -261,9 +425,67 @@ void GLRenderContext::renderTextured(const TextureChunk& chunk, float alpha, COL
 	else
 		renderpart(matrix,chunk,0,0,chunk.width,chunk.height,chunk.xOffset/chunk.xContentScale,chunk.yOffset/chunk.yContentScale);
 
-	if (isMask)
-		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
-	if (!smooth)
+	if (isMask || !batchDraws)
+		flushBatch();
+}
+
+void GLRenderContext::flushBatch()
+{
+	if (batchVertices.empty())
+		return;
+	const float* state = batchState;
+	bool hasMask = state[0];
+	SMOOTH_MODE smooth = SMOOTH_MODE(int(state[15]));
+	if (batchIsMask)
+	{
+		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(maskframebuffer);
+		engineData->exec_glClearColor(0,0,0,0);
+		engineData->exec_glClear_GL_COLOR_BUFFER_BIT();
+		engineData->exec_glUniform1f(maskUniform, 0);
+	}
+	else
+	{
+		engineData->exec_glUniform1f(maskUniform, hasMask ? 1 : 0);
+	}
+	applyBlendMode(AS_BLENDMODE(int(state[16])));
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(batchTexture);
+	if (smooth == SMOOTH_MODE::SMOOTH_NONE)
+	{
+		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_NEAREST();
+		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_NEAREST();
+	}
+	//Set color mode
+	engineData->exec_glUniform1f(yuvUniform, state[1]);
+	//Set alpha
+	engineData->exec_glUniform1f(alphaUniform, state[2]);
+	engineData->exec_glUniform4f(colortransMultiplyUniform, state[3],state[4],state[5],state[6]);
+	engineData->exec_glUniform4f(colortransAddUniform, state[7]/255.0,state[8]/255.0,state[9]/255.0,state[10]/255.0);
+	// set mode for direct coloring:
+	// 0.0:no coloring
+	// 1.0 coloring for profiling/error message (?)
+	// 2.0:set color for every non transparent pixel (used for text rendering)
+	// 3.0 set color for every pixel (renders a filled rectangle)
+	// 4.0 copy texels unmodified (only used by RenderThread::presentStageFramebuffer)
+	engineData->exec_glUniform1f(directUniform, state[11]);
+	engineData->exec_glUniform4f(directColorUniform,state[12]/255.0,state[13]/255.0,state[14]/255.0,1.0);
+
+	// the vertices are already transformed
+	lsglLoadIdentity();
+	setMatrixUniform(LSGL_MODELVIEW);
+	engineData->exec_glVertexAttribPointer(VERTEX_ATTRIB, 0, batchVertices.data(),FLOAT_2);
+	engineData->exec_glVertexAttribPointer(TEXCOORD_ATTRIB, 0, batchTexCoords.data(),FLOAT_2);
+	engineData->exec_glEnableVertexAttribArray(VERTEX_ATTRIB);
+	engineData->exec_glEnableVertexAttribArray(TEXCOORD_ATTRIB);
+	engineData->exec_glDrawArrays_GL_TRIANGLES( 0, batchVertices.size()/2);
+	engineData->exec_glDisableVertexAttribArray(VERTEX_ATTRIB);
+	engineData->exec_glDisableVertexAttribArray(TEXCOORD_ATTRIB);
+	drawCalls++;
+	batchVertices.clear();
+	batchTexCoords.clear();
+
+	if (batchIsMask)
+		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(renderframebuffer);
+	if (smooth == SMOOTH_MODE::SMOOTH_NONE)
 	{
 		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_LINEAR();
 		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_LINEAR();
@@ -271,12 +493,6 @@ void GLRenderContext::renderTextured(const TextureChunk& chunk, float alpha, COL
 }
 void GLRenderContext::renderpart(const MATRIX& matrix, const TextureChunk& chunk, float cropleft, float croptop, float cropwidth, float cropheight,float tx,float ty)
 {
-	//Set matrix
-	float fmatrix[16];
-	matrix.get4DMatrix(fmatrix);
-	lsglLoadMatrixf(fmatrix);
-	setMatrixUniform(LSGL_MODELVIEW);
-	
 	uint32_t firstchunkhorizontal = floor(float(cropleft)/float(CHUNKSIZE_REAL));
 	uint32_t firstchunkvertical = floor(float(croptop)/float(CHUNKSIZE_REAL));
 	uint32_t lastchunkhorizontal = (cropleft+cropwidth+CHUNKSIZE_REAL-1)/CHUNKSIZE_REAL;
@@ -286,9 +502,22 @@ void GLRenderContext::renderpart(const MATRIX& matrix, const TextureChunk& chunk
 	int realchunkcount = (lastchunkhorizontal-firstchunkhorizontal)*(lastchunkvertical-firstchunkvertical);
 	//The 4 corners of each texture are specified as the vertices of 2 triangles,
 	//so there are 6 vertices per quad, two of them duplicated (the diagonal)
-	//Allocate the data on the stack to reduce heap fragmentation
-	float *vertex_coords = g_newa(float,realchunkcount*12);
-	float *texture_coords = g_newa(float,realchunkcount*12);
+	//The quads are appended to the current batch, transformed by the matrix
+	uint32_t k=batchVertices.size();
+	batchVertices.resize(k+realchunkcount*12);
+	batchTexCoords.resize(k+realchunkcount*12);
+	float *vertex_coords = batchVertices.data();
+	float *texture_coords = batchTexCoords.data();
+	auto setVertex = [&](float x, float y, float u, float v)
+	{
+		number_t wx,wy;
+		matrix.multiply2D(x,y,wx,wy);
+		vertex_coords[k] = wx;
+		vertex_coords[k+1] = wy;
+		texture_coords[k] = u;
+		texture_coords[k+1] = v;
+		k+=2;
+	};
 	
 	const uint32_t blocksPerSide=largeTextureSize/CHUNKSIZE;
 	float realchunkwidth = cropwidth;
@@ -303,7 +532,7 @@ void GLRenderContext::renderpart(const MATRIX& matrix, const TextureChunk& chunk
 	uint32_t availYForTexture=realchunkheight+topstart;
 	startY = ty;
 	float heighttoplace=realchunkheight;
-	for(uint32_t i=firstchunkvertical, k=0;i<lastchunkvertical;i++)
+	for(uint32_t i=firstchunkvertical;i<lastchunkvertical;i++)
 	{
 		float heightconsumed;
 		if (startVtop && (realchunkheight + topstart > CHUNKSIZE_REAL))
@@ -344,38 +573,13 @@ void GLRenderContext::renderpart(const MATRIX& matrix, const TextureChunk& chunk
 			widthtoplace-= widthconsumed;
 			
 			//Upper-right triangle of the quad
-			texture_coords[k] = startU;
-			texture_coords[k+1] = startV;
-			vertex_coords[k] = startX;
-			vertex_coords[k+1] = startY;
-			k+=2;
-			texture_coords[k] = endU;
-			texture_coords[k+1] = startV;
-			vertex_coords[k] = endX;
-			vertex_coords[k+1] = startY;
-			k+=2;
-			texture_coords[k] = endU;
-			texture_coords[k+1] = endV;
-			vertex_coords[k] = endX;
-			vertex_coords[k+1] = endY;
-			k+=2;
-
+			setVertex(startX,startY,startU,startV);
+			setVertex(endX,startY,endU,startV);
+			setVertex(endX,endY,endU,endV);
 			//Lower-left triangle of the quad
-			texture_coords[k] = startU;
-			texture_coords[k+1] = startV;
-			vertex_coords[k] = startX;
-			vertex_coords[k+1] = startY;
-			k+=2;
-			texture_coords[k] = endU;
-			texture_coords[k+1] = endV;
-			vertex_coords[k] = endX;
-			vertex_coords[k+1] = endY;
-			k+=2;
-			texture_coords[k] = startU;
-			texture_coords[k+1] = endV;
-			vertex_coords[k] = startX;
-			vertex_coords[k+1] = endY;
-			k+=2;
+			setVertex(startX,startY,startU,startV);
+			setVertex(endX,endY,endU,endV);
+			setVertex(startX,endY,startU,endV);
 
 			curChunk++;
 			chunkrendercount++;
@@ -386,13 +590,7 @@ void GLRenderContext::renderpart(const MATRIX& matrix, const TextureChunk& chunk
 		startVtop = 0;
 		startY = endY;
 	}
-	engineData->exec_glVertexAttribPointer(VERTEX_ATTRIB, 0, vertex_coords,FLOAT_2);
-	engineData->exec_glVertexAttribPointer(TEXCOORD_ATTRIB, 0, texture_coords,FLOAT_2);
-	engineData->exec_glEnableVertexAttribArray(VERTEX_ATTRIB);
-	engineData->exec_glEnableVertexAttribArray(TEXCOORD_ATTRIB);
-	engineData->exec_glDrawArrays_GL_TRIANGLES( 0, chunkrendercount*6);
-	engineData->exec_glDisableVertexAttribArray(VERTEX_ATTRIB);
-	engineData->exec_glDisableVertexAttribArray(TEXCOORD_ATTRIB);
+	assert(chunkrendercount==uint32_t(realchunkcount));
 }
 
 int GLRenderContext::errorCount = 0;
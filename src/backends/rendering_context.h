@@ -21,6 +21,7 @@
 #define BACKENDS_RENDERING_CONTEXT_H 1
 
 #include <stack>
+#include <cstring>
 #include "backends/graphics.h"
 #include "platforms/engineutils.h"
 
@@ -73,11 +74,43 @@ public:
 	virtual void setProperties(AS_BLENDMODE blendmode) = 0;
 };
 
+/*
+ * A rectangle in window coordinates with the origin at the bottom left (like glScissor)
+ * xmax and ymax are exclusive
+ */
+struct DirtyRect
+{
+	int32_t xmin,ymin,xmax,ymax;
+	DirtyRect():xmin(0),ymin(0),xmax(0),ymax(0) {}
+	DirtyRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2):xmin(x1),ymin(y1),xmax(x2),ymax(y2) {}
+	bool isEmpty() const { return xmin>=xmax || ymin>=ymax; }
+	int64_t area() const { return isEmpty() ? 0 : int64_t(xmax-xmin)*int64_t(ymax-ymin); }
+	bool intersects(const DirtyRect& r) const { return xmin<r.xmax && r.xmin<xmax && ymin<r.ymax && r.ymin<ymax; }
+	bool contains(const DirtyRect& r) const { return r.xmin>=xmin && r.xmax<=xmax && r.ymin>=ymin && r.ymax<=ymax; }
+	bool operator==(const DirtyRect& r) const { return xmin==r.xmin && ymin==r.ymin && xmax==r.xmax && ymax==r.ymax; }
+	DirtyRect united(const DirtyRect& r) const;
+};
+
 class GLRenderContext: public RenderContext
 {
 private:
 	static int errorCount;
 protected:
+	/*
+	 * Everything that influences the pixels produced by a single draw,
+	 * the draws of two frames are compared to find the parts of the stage that changed
+	 */
+	struct DrawRecord
+	{
+		DirtyRect rect;
+		// identifies the texture content (or the object for draws not using a texture)
+		const void* content;
+		float params[32];
+		bool operator==(const DrawRecord& r) const
+		{
+			return content==r.content && rect==r.rect && memcmp(params,r.params,sizeof(params))==0;
+		}
+	};
 	EngineData* engineData;
 	int projectionMatrixUniform;
 	int modelviewMatrixUniform;
@@ -91,6 +124,46 @@ protected:
 	int directColorUniform;
 	uint32_t maskframebuffer;
 	uint32_t maskTextureID;
+	// the framebuffer the stage is currently rendered to
+	uint32_t renderframebuffer;
+
+	/* Partial redraw */
+	// window size and offset of the stage inside the window
+	int32_t viewOffsetX;
+	int32_t viewOffsetY;
+	uint32_t viewWidth;
+	uint32_t viewHeight;
+	// if set, every draw is appended to drawRecords
+	bool recordDraws;
+	std::vector<DrawRecord> drawRecords;
+	// if set, draws outside of clipRect are skipped
+	bool clipping;
+	DirtyRect clipRect;
+	AS_BLENDMODE currentBlendMode;
+	DirtyRect computeDirtyRect(const TextureChunk& chunk, const MATRIX& matrix) const;
+	/*
+	 * Adds r to the list of rectangles, overlapping rectangles are merged and
+	 * the list is kept short by merging the closest rectangles
+	 */
+	static void addDirtyRect(std::vector<DirtyRect>& rects, const DirtyRect& r);
+
+	/* Draw batching */
+	/*
+	 * Consecutive draws using the same texture and the same state are collected,
+	 * their vertices are transformed on the CPU and submitted with a single draw call
+	 */
+	bool batchDraws;
+	static const uint32_t BATCH_STATE_SIZE=17;
+	// the uniforms, blend mode and smoothing of the collected draws
+	float batchState[BATCH_STATE_SIZE];
+	uint32_t batchTexture;
+	bool batchIsMask;
+	std::vector<float> batchVertices;
+	std::vector<float> batchTexCoords;
+	// statistics for the current frame
+	uint32_t drawCalls;
+	uint32_t texturedDraws;
+	void applyBlendMode(AS_BLENDMODE blendmode);
 
 	/* Textures */
 	Mutex mutexLargeTexture;
@@ -100,7 +173,17 @@ protected:
 	public:
 		uint32_t id;
 		uint8_t* bitmap;
-		LargeTexture(uint8_t* b):id(-1),bitmap(b){}
+		/*
+		 * Skyline of the used blocks: every block of column i at row skyline[i]
+		 * or above is free. Blocks below it may be free too (holes).
+		 */
+		std::vector<uint16_t> skyline;
+		uint32_t freeBlocks;
+		// Time (in ms) when the last chunk on this texture was released
+		uint64_t lastUsed;
+		// Set when chunks are allocated on a page without GL texture, evicted pages stay without one until then
+		bool needsGLTexture;
+		LargeTexture(uint8_t* b, uint32_t blocksPerSide):id(-1),bitmap(b),skyline(blocksPerSide,0),freeBlocks(blocksPerSide*blocksPerSide),lastUsed(0),needsGLTexture(true){}
 		~LargeTexture(){/*delete[] bitmap;*/}
 	};
 	std::vector<LargeTexture> largeTextures;
@@ -113,7 +196,9 @@ public:
 	 * Uploads the current matrix as the specified type.
 	 */
 	void setMatrixUniform(LSGL_MATRIX m) const;
-	GLRenderContext() : RenderContext(GL),engineData(nullptr), largeTextureSize(0)
+	GLRenderContext() : RenderContext(GL),engineData(nullptr),maskframebuffer(0),maskTextureID(0),renderframebuffer(0),
+		viewOffsetX(0),viewOffsetY(0),viewWidth(0),viewHeight(0),recordDraws(false),clipping(false),
+		currentBlendMode(BLENDMODE_NORMAL),batchDraws(true),batchTexture(0),batchIsMask(false),drawCalls(0),texturedDraws(0),largeTextureSize(0)
 	{
 	}
 	void SetEngineData(EngineData* data) { engineData = data;}
@@ -130,6 +215,22 @@ public:
 	 */
 	const CachedSurface& getCachedSurface(const DisplayObject* obj) const override;
 	void setProperties(AS_BLENDMODE blendmode) override;
+	/**
+	 * Has to be called before drawing with NanoVG, params contains everything that influences the result of the draw.
+	 * Returns false if the draw can be skipped because no part of the stage is redrawn.
+	 * Otherwise the region that is redrawn is returned in NanoVG coordinates, the draw has to be restricted
+	 * to it with nvgScissor, as NanoVG disables the scissor test
+	 */
+	bool prepareNanoVGDraw(const void* owner, const float* params, uint32_t count, float& clipx, float& clipy, float& clipwidth, float& clipheight);
+	/**
+	 * Has to be called after drawing with NanoVG, restores the scissor test for the redrawn region
+	 */
+	void finishNanoVGDraw();
+	/**
+	 * Submits the collected draws, has to be called before changing any GL state
+	 * outside of renderTextured
+	 */
+	void flushBatch();
 
 	/* Utility */
 	bool handleGLErrors() const;
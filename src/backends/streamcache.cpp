@@ -90,24 +90,33 @@ void StreamCache::append(const unsigned char* buffer, size_t length)
 class lightspark::MemoryChunk {
 public:
 	MemoryChunk(size_t len);
+	// Chunk referencing memory owned by someone else, it is already full
+	MemoryChunk(unsigned char* external, size_t len);
 	~MemoryChunk();
 	unsigned char * const buffer;
 	const size_t capacity;
 	ACQUIRE_RELEASE_VARIABLE(size_t, used);
+	const bool owned;
 };
 
 MemoryChunk::MemoryChunk(size_t len) :
-	buffer(new unsigned char[len]), capacity(len), used(0)
+	buffer(new unsigned char[len]), capacity(len), used(0), owned(true)
+{
+}
+
+MemoryChunk::MemoryChunk(unsigned char* external, size_t len) :
+	buffer(external), capacity(len), used(len), owned(false)
 {
 }
 
 MemoryChunk::~MemoryChunk()
 {
-	delete[] buffer;
+	if (owned)
+		delete[] buffer;
 }
 
 MemoryStreamCache::MemoryStreamCache(SystemState* _sys):StreamCache(_sys),
-	writeChunk(nullptr), nextChunkSize(0)
+	writeChunk(nullptr), mappedFile(nullptr), nextChunkSize(0)
 {
 }
 
@@ -115,6 +124,34 @@ MemoryStreamCache::~MemoryStreamCache()
 {
 	for (auto it=chunks.begin(); it!=chunks.end(); ++it)
 		delete *it;
+	if (mappedFile)
+		g_mapped_file_unref(mappedFile);
+}
+
+bool MemoryStreamCache::useMappedFile(const tiny_string& filename)
+{
+	GMappedFile* mapping = g_mapped_file_new(filename.raw_buf(), FALSE, nullptr);
+	if (!mapping)
+		return false;
+
+	size_t length = g_mapped_file_get_length(mapping);
+	{
+		Locker locker(chunkListMutex);
+		assert(chunks.empty());
+		mappedFile = mapping;
+		// empty files have no contents
+		if (length > 0)
+		{
+			writeChunk = new MemoryChunk((unsigned char*)g_mapped_file_get_contents(mapping), length);
+			chunks.push_back(writeChunk);
+		}
+	}
+	{
+		Locker locker(stateMutex);
+		receivedLength = length;
+	}
+	sys->sendMainSignal();
+	return true;
 }
 
 // Rounds val up to the next multiple of pow(2, s).
@@ -339,6 +376,19 @@ streampos MemoryStreamCache::Reader::seekpos(streampos pos, std::ios_base::openm
 	return -1;
 }
 
+const uint8_t* MemoryStreamCache::Reader::readMapped(size_t len, GMappedFile*& mapping)
+{
+	// the mapping is the only chunk, so the get area covers all of
+	// it once something has been read
+	if (!buffer->mappedFile || gptr() == nullptr || (size_t)(egptr() - gptr()) < len)
+		return nullptr;
+
+	const uint8_t* ret = (const uint8_t*)gptr();
+	setg(eback(), gptr() + len, egptr());
+	mapping = g_mapped_file_ref(buffer->mappedFile);
+	return ret;
+}
+
 /**
  * Get the position of the read cursor in the (virtual) downloaded data.
  */
@@ -527,11 +577,38 @@ streamsize FileStreamCache::Reader::xsgetn(char* s, streamsize n)
 
 streamsize lsfilereader::xsgetn(char *s, streamsize n)
 {
+	if (mappedFile)
+	{
+		// the get area covers the whole mapping
+		streamsize available = std::min<streamsize>(n, egptr() - gptr());
+		memcpy(s, gptr(), available);
+		setg(eback(), gptr() + available, egptr());
+		return available;
+	}
 	return SDL_RWread(filehandler,s,1,n);
 }
 
 streampos lsfilereader::seekoff(streamoff off, ios_base::seekdir way, ios_base::openmode which)
 {
+	if (mappedFile)
+	{
+		streamoff pos;
+		switch (way)
+		{
+			case ios_base::beg:
+				pos = off;
+				break;
+			case ios_base::cur:
+				pos = (gptr() - eback()) + off;
+				break;
+			case ios_base::end:
+				pos = (egptr() - eback()) + off;
+				break;
+			default:
+				return streampos(streamoff(-1));
+		}
+		return seekpos(pos, which);
+	}
 	if (!filehandler)
 	{
 		LOG(LOG_ERROR,"lsfilereader without file");
@@ -553,6 +630,13 @@ streampos lsfilereader::seekoff(streamoff off, ios_base::seekdir way, ios_base::
 
 streampos lsfilereader::seekpos(streampos pos, ios_base::openmode)
 {
+	if (mappedFile)
+	{
+		if (pos < 0 || pos > egptr() - eback())
+			return streampos(streamoff(-1));
+		setg(eback(), eback() + (streamoff)pos, egptr());
+		return pos;
+	}
 	if (!filehandler)
 	{
 		LOG(LOG_ERROR,"lsfilereader without file");
@@ -561,9 +645,16 @@ streampos lsfilereader::seekpos(streampos pos, ios_base::openmode)
 	return SDL_RWseek(filehandler,pos,RW_SEEK_SET);
 }
 
-lsfilereader::lsfilereader(const char *filepath)
+lsfilereader::lsfilereader(const char *filepath):filehandler(nullptr)
 {
-	filehandler = SDL_RWFromFile(filepath, "rb");
+	mappedFile = g_mapped_file_new(filepath, FALSE, nullptr);
+	if (mappedFile)
+	{
+		char* data = g_mapped_file_get_contents(mappedFile);
+		setg(data, data, data + g_mapped_file_get_length(mappedFile));
+	}
+	else
+		filehandler = SDL_RWFromFile(filepath, "rb");
 }
 
 lsfilereader::~lsfilereader()
@@ -571,4 +662,18 @@ lsfilereader::~lsfilereader()
 	if (filehandler)
 		SDL_RWclose(filehandler);
 	filehandler=nullptr;
+	if (mappedFile)
+		g_mapped_file_unref(mappedFile);
+	mappedFile=nullptr;
+}
+
+const uint8_t* lsfilereader::readMapped(size_t len, GMappedFile*& mapping)
+{
+	if (!mappedFile || (size_t)(egptr() - gptr()) < len)
+		return nullptr;
+
+	const uint8_t* ret = (const uint8_t*)gptr();
+	setg(eback(), gptr() + len, egptr());
+	mapping = g_mapped_file_ref(mappedFile);
+	return ret;
 }
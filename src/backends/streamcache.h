@@ -102,6 +102,22 @@ public:
 	virtual void openForWriting() = 0;
 };
 
+/*
+ * Implemented by streambufs that read from memory mapped files, lets
+ * parsers keep references to the mapped data instead of copying it.
+ */
+class DLL_PUBLIC IMappedStreamBuf
+{
+public:
+	virtual ~IMappedStreamBuf() {}
+	// Returns a pointer to the next len bytes and skips them, or
+	// nullptr if they can't be referenced directly. On success
+	// mapping is set to a new reference to the GMappedFile
+	// containing the bytes, the caller must release it with
+	// g_mapped_file_unref when the bytes are not needed anymore.
+	virtual const uint8_t* readMapped(size_t len, GMappedFile*& mapping)=0;
+};
+
 class MemoryChunk;
 
 /*
@@ -109,7 +125,7 @@ class MemoryChunk;
  */
 class DLL_PUBLIC MemoryStreamCache : public StreamCache {
 private:
-	class DLL_LOCAL Reader : public std::streambuf {
+	class DLL_LOCAL Reader : public std::streambuf, public IMappedStreamBuf {
 	private:
 		_R<MemoryStreamCache> buffer;
 		// The chunk that is currently being read
@@ -127,6 +143,7 @@ private:
 		std::streampos getOffset() const;
 	public:
 		Reader(_R<MemoryStreamCache> b);
+		const uint8_t* readMapped(size_t len, GMappedFile*& mapping) override;
 	};
 
 	// Stream is stored into a sequence of memory chunks. The
@@ -138,6 +155,8 @@ private:
 
 	// The last chunk, the next write will happen here (writer thread)
 	MemoryChunk *writeChunk;
+	// Set by useMappedFile, the mapping is then the only chunk
+	GMappedFile* mappedFile;
 
 	// Variables controlling the memory allocation
 	size_t nextChunkSize;
@@ -157,6 +176,11 @@ public:
 	std::streambuf *createReader() override;
 	
 	void openForWriting() override;
+
+	// Use the contents of a local file without copying them. Must
+	// be called before append(). Returns false if the file can't
+	// be mapped.
+	bool useMappedFile(const tiny_string& filename);
 };
 
 /*
@@ -205,10 +229,12 @@ public:
 
 // simple wrapper to use SDL_RWops as input for istream
 // to let SDL deal with unicode filenames on windows
-class DLL_PUBLIC lsfilereader: public std::filebuf
+// the file is memory mapped if possible, SDL is only used as a fallback
+class DLL_PUBLIC lsfilereader: public std::filebuf, public IMappedStreamBuf
 {
 private:
 	SDL_RWops* filehandler;
+	GMappedFile* mappedFile;
 protected:
 	std::streamsize xsgetn(char* s, std::streamsize n) override;
 	std::streampos seekoff(std::streamoff off, std::ios_base::seekdir way, std::ios_base::openmode which) override;
@@ -216,6 +242,7 @@ protected:
 public:
 	lsfilereader(const char* filepath);
 	~lsfilereader();
+	const uint8_t* readMapped(size_t len, GMappedFile*& mapping) override;
 };
 
 }
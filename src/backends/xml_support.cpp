@@ -32,14 +32,15 @@ const pugi::xml_node XMLBase::buildFromString(const tiny_string& str,
 										pugi::xml_parse_result* parseresult)
 {
 	tiny_string buf = quirkEncodeNull(removeWhitespace(str));
+	xmldoc = std::make_shared<pugi::xml_document>();
 	if (buf.numBytes() > 0 && buf.charAt(0) == '<')
 	{
-		pugi::xml_parse_result res = xmldoc.load_buffer((void*)buf.raw_buf(),buf.numBytes(),xmlparsemode);
+		pugi::xml_parse_result res = xmldoc->load_buffer((void*)buf.raw_buf(),buf.numBytes(),xmlparsemode);
 		if (parseresult)
 		{
 			// error handling is done in the caller
 			*parseresult = res;
-			return xmldoc.root();
+			return xmldoc->root();
 		}
 		switch (res.status)
 		{
@@ -73,10 +74,10 @@ const pugi::xml_node XMLBase::buildFromString(const tiny_string& str,
 	}
 	else
 	{
-		pugi::xml_node n = xmldoc.append_child(pugi::node_pcdata);
+		pugi::xml_node n = xmldoc->append_child(pugi::node_pcdata);
 		n.set_value(str.raw_buf());
 	}
-	return xmldoc.root();
+	return xmldoc->root();
 }
 const tiny_string XMLBase::encodeToXML(const tiny_string value, bool bIsAttribute)
 {
@@ -21,6 +21,7 @@
 #define BACKENDS_XML_SUPPORT_H 1
 
 #include "tiny_string.h"
+#include <memory>
 #include <3rdparty/pugixml/src/pugixml.hpp>
 namespace lightspark
 {
@@ -33,7 +34,8 @@ class XMLBase
 {
 protected:
 	//The parser will destroy the document and all the childs on destruction
-	pugi::xml_document xmldoc;
+	//XML nodes that are materialized lazily share the document of their root
+	std::shared_ptr<pugi::xml_document> xmldoc;
 	// if parseresult is not null, this method will not throw an exception on invalid xml
 	const pugi::xml_node buildFromString(const tiny_string& str,
 										unsigned int xmlparsemode,
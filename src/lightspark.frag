@@ -21,6 +21,11 @@ const mat3 YUVtoRGB = mat3(1.164383, 1.164383, 1.164383, //First column
 void main()
 {
 	vec4 vbase = texture2D(g_tex1,ls_TexCoords[0].xy);
+	// copy the texel unmodified (used to copy the stage framebuffer to the window)
+	if (direct == 4.0) {
+		gl_FragColor = vbase;
+		return;
+	}
 	// discard everything that doesn't fit the mask
 	if (mask != 0.0 && texture2D(g_tex2,ls_TexCoords[1].xy).a == 0.0)
 		discard;
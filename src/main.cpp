@@ -330,14 +330,13 @@ int main(int argc, char* argv[])
 	char* fileName=nullptr;
 	char* url=nullptr;
 	char* paramsFileName=nullptr;
-#ifdef PROFILING_SUPPORT
 	char* profilingFileName=nullptr;
-#endif
 	char *HTTPcookie=nullptr;
 	SecurityManager::SANDBOXTYPE sandboxType=SecurityManager::LOCAL_WITH_FILE;
 	bool useInterpreter=true;
 	bool useFastInterpreter=false;
 	bool useJit=false;
+	bool useFastRegExp=false;
 	bool ignoreUnhandledExceptions = false;
 	bool startInFullScreenMode=false;
 	double startscalefactor=1.0;
@@ -372,6 +371,8 @@ int main(int argc, char* argv[])
 			useFastInterpreter=true;
 		else if(strcmp(argv[i],"-j")==0 || strcmp(argv[i],"--enable-jit")==0)
 			useJit=true;
+		else if(strcmp(argv[i],"-fr")==0 || strcmp(argv[i],"--enable-fast-regexp")==0)
+			useFastRegExp=true;
 		else if(strcmp(argv[i],"-ne")==0 || strcmp(argv[i],"--ignore-unhandled-exceptions")==0)
 			ignoreUnhandledExceptions=true;
 		else if(strcmp(argv[i],"-fs")==0 || strcmp(argv[i],"--fullscreen")==0)
@@ -420,7 +421,6 @@ int main(int argc, char* argv[])
 			tiny_string ext = argv[i];
 			extensions.push_back(ext);
 		}
-#ifdef PROFILING_SUPPORT
 		else if(strcmp(argv[i],"-o")==0 || 
 			strcmp(argv[i],"--profiling-output")==0)
 		{
@@ -432,7 +432,6 @@ int main(int argc, char* argv[])
 			}
 			profilingFileName=argv[i];
 		}
-#endif
 		else if(strcmp(argv[i],"-s")==0 || 
 			strcmp(argv[i],"--security-sandbox")==0)
 		{
@@ -464,6 +463,28 @@ int main(int argc, char* argv[])
 		{
 			EngineData::enablerendering = false;
 		}
+		else if(strcmp(argv[i],"--render-audio-to-wav")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=nullptr;
+				break;
+			}
+			EngineData::audiowavfile=argv[i];
+		}
+		else if(strcmp(argv[i],"--render-audio-rate")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=nullptr;
+				break;
+			}
+			EngineData::audiowavrate=max(8000,min(192000,atoi(argv[i])));
+		}
+		else if(strcmp(argv[i],"--render-audio-unpaced")==0)
+			EngineData::audiowavunpaced=true;
 		
 		else if(strcmp(argv[i],"--HTTP-cookies")==0)
 		{
@@ -490,15 +511,12 @@ int main(int argc, char* argv[])
 	if(fileName==nullptr)
 	{
 		LOG(LOG_ERROR, "Usage: " << argv[0] << " [--url|-u http://loader.url/file.swf]" <<
-			" [--disable-interpreter|-ni] [--enable-fast-interpreter|-fi]" <<
-#ifdef LLVM_ENABLED
+			" [--disable-interpreter|-ni] [--enable-fast-interpreter|-fi] [--enable-fast-regexp|-fr]" <<
 			" [--enable-jit|-j]" <<
-#endif
 			" [--log-level|-l 0-4] [--parameters-file|-p params-file] [--security-sandbox|-s sandbox]" <<
 			" [--exit-on-error] [--HTTP-cookies cookie] [--air] [--avmplus] [--disable-rendering]" <<
-#ifdef PROFILING_SUPPORT
+			" [--render-audio-to-wav wav-file] [--render-audio-rate sample-rate] [--render-audio-unpaced]" <<
 			" [--profiling-output|-o profiling-file]" <<
-#endif
 			" [--ignore-unhandled-exceptions|-ne]"
 			" [--fullscreen|-fs]"
 			" [--scale|-sc]"
@@ -579,14 +597,13 @@ int main(int argc, char* argv[])
 	sys->useInterpreter=useInterpreter;
 	sys->useFastInterpreter=useFastInterpreter;
 	sys->useJit=useJit;
+	sys->useFastRegExp=useFastRegExp;
 	sys->ignoreUnhandledExceptions=ignoreUnhandledExceptions;
 	sys->exitOnError=exitOnError;
 	if(paramsFileName)
 		sys->parseParametersFromFile(paramsFileName);
-#ifdef PROFILING_SUPPORT
 	if(profilingFileName)
 		sys->setProfilingOutput(profilingFileName);
-#endif
 	if(HTTPcookie)
 		sys->setCookies(HTTPcookie);
 
@@ -0,0 +1,93 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "object_shape.h"
+#include "asobject.h"
+#include "logger.h"
+
+using namespace std;
+using namespace lightspark;
+
+std::atomic<uint64_t> ObjectShape::shapeCount(0);
+std::atomic<uint64_t> ObjectShape::objectCount(0);
+std::atomic<uint64_t> ObjectShape::convertedCount(0);
+std::atomic<uint64_t> ObjectShape::releasedCount(0);
+std::atomic<uint64_t> ObjectShape::releasedProperties(0);
+
+ObjectShape::ObjectShape()
+{
+}
+
+ObjectShape::ObjectShape(ObjectShape* p, uint32_t nameId):names(p->names)
+{
+	names.push_back(nameId);
+	if (names.size() > OBJECTSHAPE_LINEAR_SEARCH)
+	{
+		index.reserve(names.size());
+		for (uint32_t i = 0; i < names.size(); i++)
+			index.insert(make_pair(names[i],i));
+	}
+	shapeCount.fetch_add(1,std::memory_order_relaxed);
+}
+
+ObjectShape::~ObjectShape()
+{
+	for (auto it = transitions.begin(); it != transitions.end(); it++)
+		delete it->second;
+}
+
+ObjectShape* ObjectShape::getRoot()
+{
+	static ObjectShape root;
+	return &root;
+}
+
+ObjectShape* ObjectShape::addProperty(uint32_t nameId)
+{
+	assert(find(nameId) < 0);
+	if (names.size() >= OBJECTSHAPE_MAX_PROPERTIES)
+		return nullptr;
+	Locker l(transitionsMutex);
+	auto it = transitions.find(nameId);
+	if (it != transitions.end())
+		return it->second;
+	ObjectShape* s = new ObjectShape(this,nameId);
+	transitions.insert(make_pair(nameId,s));
+	return s;
+}
+
+void ObjectShape::logStatistics()
+{
+	uint64_t objects = objectCount.load(std::memory_order_relaxed);
+	if (objects == 0)
+		return;
+	uint64_t released = releasedCount.load(std::memory_order_relaxed);
+	uint64_t properties = releasedProperties.load(std::memory_order_relaxed);
+	uint64_t flatBytes = 0;
+	uint64_t mapBytes = 0;
+	if (released)
+	{
+		// values plus the vector and shape pointer, compared to the hash nodes (value, next pointer and cached hash) and buckets of a map
+		flatBytes = (properties*sizeof(asAtom)+released*(sizeof(std::vector<asAtom>)+sizeof(ObjectShape*)))/released;
+		mapBytes = (properties*(sizeof(variables_map::mapType::value_type)+2*sizeof(void*)+sizeof(void*)))/released;
+	}
+	LOG(LOG_INFO,"object shapes: " << shapeCount.load(std::memory_order_relaxed) << " shapes, " << objects << " objects created with a shape, "
+		<< convertedCount.load(std::memory_order_relaxed) << " converted to a map, " << released << " released with a shape holding "
+		<< (released ? properties/released : 0) << " properties and " << flatBytes << " bytes on average (" << mapBytes << " bytes as a map)");
+}
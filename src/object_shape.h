@@ -0,0 +1,94 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef OBJECT_SHAPE_H
+#define OBJECT_SHAPE_H 1
+
+#include "compat.h"
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include "threading.h"
+
+namespace lightspark
+{
+
+/*
+ * Shared layout of the dynamic properties of plain objects (hidden class).
+ * A shape is the ordered list of property names, objects with the same
+ * properties added in the same order share the same shape and only store
+ * the values in a flat array indexed by the position of the name.
+ * Shapes form a tree rooted at the empty shape, adding a property follows
+ * (or creates) the transition to the child shape. Shapes are never released
+ * before the program ends, so objects can keep plain pointers to them.
+ */
+class ObjectShape
+{
+private:
+	// objects with more properties are converted to a variables map
+	#define OBJECTSHAPE_MAX_PROPERTIES 32
+	// shapes with more properties use a hash index instead of a linear scan
+	#define OBJECTSHAPE_LINEAR_SEARCH 8
+	std::vector<uint32_t> names;
+	std::unordered_map<uint32_t,uint32_t> index;
+	Mutex transitionsMutex;
+	std::unordered_map<uint32_t,ObjectShape*> transitions;
+	ObjectShape(ObjectShape* p, uint32_t nameId);
+	ObjectShape();
+	~ObjectShape();
+	// statistics
+	static std::atomic<uint64_t> shapeCount;
+	static std::atomic<uint64_t> objectCount;
+	static std::atomic<uint64_t> convertedCount;
+	static std::atomic<uint64_t> releasedCount;
+	static std::atomic<uint64_t> releasedProperties;
+public:
+	static ObjectShape* getRoot();
+	FORCE_INLINE uint32_t size() const { return names.size(); }
+	FORCE_INLINE uint32_t getNameAt(uint32_t i) const { return names[i]; }
+	// returns the position of the property or -1
+	FORCE_INLINE int32_t find(uint32_t nameId) const
+	{
+		if (names.size() <= OBJECTSHAPE_LINEAR_SEARCH)
+		{
+			for (uint32_t i = 0; i < names.size(); i++)
+			{
+				if (names[i]==nameId)
+					return i;
+			}
+			return -1;
+		}
+		auto it = index.find(nameId);
+		return it==index.end() ? -1 : int32_t(it->second);
+	}
+	// returns the shape with nameId appended or nullptr if the shape is full
+	ObjectShape* addProperty(uint32_t nameId);
+	// memory report, every object is counted when it is created, when it is converted to a map and when it is destroyed
+	static void objectCreated() { objectCount.fetch_add(1,std::memory_order_relaxed); }
+	static void objectConverted() { convertedCount.fetch_add(1,std::memory_order_relaxed); }
+	static void objectReleased(uint32_t properties)
+	{
+		releasedCount.fetch_add(1,std::memory_order_relaxed);
+		releasedProperties.fetch_add(properties,std::memory_order_relaxed);
+	}
+	static void logStatistics();
+};
+
+}
+#endif /* OBJECT_SHAPE_H */
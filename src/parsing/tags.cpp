@@ -47,6 +47,7 @@
 #include "scripting/flash/filters/flashfilters.h"
 #include "backends/audio.h"
 #include "backends/rendering.h"
+#include "backends/config.h"
 
 #undef RGB
 
@@ -65,7 +66,100 @@ using namespace lightspark;
 uint8_t* JPEGTablesTag::JPEGTables = nullptr;
 int JPEGTablesTag::tableSize = 0;
 
-Tag* TagFactory::readTag(RootMovieClip* root, DefineSpriteTag *sprite)
+bool TagFactory::canParseDeferred(uint32_t tagType)
+{
+	switch(tagType)
+	{
+		case 2: // DefineShape
+		case 10: // DefineFont
+		case 22: // DefineShape2
+		case 32: // DefineShape3
+		case 46: // DefineMorphShape
+		case 48: // DefineFont2
+		case 75: // DefineFont3
+		case 83: // DefineShape4
+		case 84: // DefineMorphShape2
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool TagFactory::dependsOnDictionary(uint32_t tagType)
+{
+	switch(tagType)
+	{
+		case 13: // DefineFontInfo
+		case 40: // NameCharacter
+		case 56: // ExportAssets
+			return true;
+		default:
+			return false;
+	}
+}
+
+void TagFactory::parsePendingTag(PendingTag& pending, RootMovieClip* root)
+{
+	bytes_buf buf(pending.data.data(),pending.data.size());
+	istream in(&buf);
+	in.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
+	RECORDHEADER& h=pending.header;
+	try
+	{
+		switch(h.getTagType())
+		{
+			case 2:
+				pending.tag=new DefineShapeTag(h,in,root);
+				break;
+			case 10:
+				pending.tag=new DefineFontTag(h,in,root);
+				break;
+			case 13:
+				pending.tag=new DefineFontInfoTag(h,in,root);
+				break;
+			case 22:
+				pending.tag=new DefineShape2Tag(h,in,root);
+				break;
+			case 32:
+				pending.tag=new DefineShape3Tag(h,in,root);
+				break;
+			case 40:
+				pending.tag=new NameCharacterTag(h,in,root);
+				break;
+			case 46:
+				pending.tag=new DefineMorphShapeTag(h,in,root);
+				break;
+			case 48:
+				pending.tag=new DefineFont2Tag(h,in,root);
+				break;
+			case 56:
+				pending.tag=new ExportAssetsTag(h,in,root);
+				break;
+			case 75:
+				pending.tag=new DefineFont3Tag(h,in,root);
+				break;
+			case 83:
+				pending.tag=new DefineShape4Tag(h,in,root);
+				break;
+			case 84:
+				pending.tag=new DefineMorphShape2Tag(h,in,root);
+				break;
+			default:
+				assert(false);
+		}
+		unsigned int actualLen=in.tellg();
+		if(actualLen<pending.data.size())
+			LOG(LOG_ERROR,"Error while reading tag " << h.getTagType() << ". Size=" << actualLen << " expected: " << pending.data.size());
+	}
+	catch(...)
+	{
+		pending.error=std::current_exception();
+	}
+	pending.data.clear();
+	pending.data.shrink_to_fit();
+}
+
+Tag* TagFactory::readTag(RootMovieClip* root, DefineSpriteTag *sprite, PendingTag* pending)
 {
 	RECORDHEADER h;
 
@@ -91,6 +185,21 @@ Tag* TagFactory::readTag(RootMovieClip* root, DefineSpriteTag *sprite)
 		unsigned int expectedLen=h.getLength();
 		unsigned int start=f.tellg();
 		LOG(LOG_TRACE,"Reading tag type: " << h.getTagType() << " at byte " << start << " with length " << expectedLen << " bytes");
+		if(pending && (canParseDeferred(h.getTagType()) || dependsOnDictionary(h.getTagType())))
+		{
+			if (datatag)
+			{
+				LOG(LOG_NOT_IMPLEMENTED,"additionaldatag (type 253) found, but not used in subsequent tag:"<<h.getTagType());
+				delete datatag;
+			}
+			pending->header=h;
+			pending->sequential=!canParseDeferred(h.getTagType());
+			pending->data.resize(expectedLen);
+			f.read((char*)pending->data.data(),expectedLen);
+			firstTag=false;
+			root->loaderInfo->setBytesLoaded(f.tellg());
+			return nullptr;
+		}
 		switch(h.getTagType())
 		{
 			case 0:
@@ -341,6 +450,12 @@ void RemoveObject2Tag::execute(DisplayObjectContainer* parent,bool inskipping)
 	parent->deleteLegacyChildAt(LEGACY_DEPTH_START+Depth,inskipping);
 }
 
+DISPLAYLIST_CHANGE RemoveObject2Tag::getDisplayListChange(int32_t& depth, uint32_t& characterId, uint32_t& properties) const
+{
+	depth = LEGACY_DEPTH_START+Depth;
+	return DISPLAYLIST_REMOVE;
+}
+
 SetBackgroundColorTag::SetBackgroundColorTag(RECORDHEADER h, std::istream& in):ControlTag(h)
 {
 	in >> BackgroundColor;
@@ -822,7 +937,6 @@ DefineFontTag::DefineFontTag(RECORDHEADER h, std::istream& in, RootMovieClip* ro
 		in >> t;
 		GlyphShapeTable.push_back(t);
 	}
-	root->registerEmbeddedFont("",this);
 }
 
 void DefineFontTag::fillTextTokens(tokensVector &tokens, const tiny_string text, int fontpixelsize, const list<FILLSTYLE>& fillstyleColor, int32_t leading, int32_t startposx, int32_t startposy)
@@ -1001,7 +1115,6 @@ DefineFont2Tag::DefineFont2Tag(RECORDHEADER h, std::istream& in, RootMovieClip*
 	}
 	//TODO: implmented Kerning support
 	ignore(in,KerningCount*4);
-	root->registerEmbeddedFont(getFontname(),this);
 }
 
 void DefineFont2Tag::fillTextTokens(tokensVector &tokens, const tiny_string text, int fontpixelsize, const list<FILLSTYLE>& fillstyleColor, int32_t leading, int32_t startposx, int32_t startposy)
@@ -1220,8 +1333,6 @@ DefineFont3Tag::DefineFont3Tag(RECORDHEADER h, std::istream& in, RootMovieClip*
 	}
 	//TODO: implment Kerning support
 	ignore(in,KerningCount* (FontFlagsWideCodes ? 6 : 4));
-	root->registerEmbeddedFont(getFontname(),this);
-
 }
 
 void DefineFont3Tag::fillTextTokens(tokensVector &tokens, const tiny_string text, int fontpixelsize, const list<FILLSTYLE>& fillstyleColor, int32_t leading, int32_t startposx, int32_t startposy)
@@ -1297,37 +1408,150 @@ ASObject* DefineFont4Tag::instance(Class_base* c)
 	return ret;
 }
 
+namespace
+{
+// decodes a lazily decoded bitmap on the thread pool before it is first rendered
+class BitmapDecodeJob: public IThreadJob
+{
+private:
+	_NR<BitmapContainer> bitmap;
+public:
+	BitmapDecodeJob(_NR<BitmapContainer> b):bitmap(b) {}
+	void execute() override
+	{
+		bitmap->getDataSize();
+	}
+	void jobFence() override
+	{
+		delete this;
+	}
+};
+}
+
 BitmapTag::BitmapTag(RECORDHEADER h,RootMovieClip* root):DictionaryTag(h,root),bitmap(_MR(new BitmapContainer(root->getSystemState()->tagsMemory)))
 {
 }
 
 BitmapTag::~BitmapTag()
 {
+	detachBitmap();
 	bitmap.reset();
 }
 
+void BitmapTag::detachBitmap()
+{
+	// bitmaps still used elsewhere must not be decoded from this tag after it is gone
+	if(!bitmap->isLastRef())
+		bitmap->detachLazySource();
+}
+
 _NR<BitmapContainer> BitmapTag::getBitmap() const {
+	BitmapBudget* budget=BitmapBudget::getBudget();
+	Locker l(budget->mutex);
+	budget->touch(bitmap.getPtr());
 	return bitmap;
 }
-void BitmapTag::loadBitmap(uint8_t* inData, int datasize, const uint8_t *tablesData, int tablesLen)
+void BitmapTag::loadBitmap(BitmapContainer* b, const uint8_t* inData, int datasize, const uint8_t *tablesData, int tablesLen)
 {
+	// the decoders don't modify the input
+	uint8_t* d=const_cast<uint8_t*>(inData);
 	if (datasize < 4)
 		return;
 	else if((inData[0]&0x80) && inData[1]=='P' && inData[2]=='N' && inData[3]=='G')
-		bitmap->fromPNG(inData,datasize);
+		b->fromPNG(d,datasize);
 	else if(inData[0]==0xff && inData[1]==0xd8 && inData[2]==0xff)
-		bitmap->fromJPEG(inData,datasize,tablesData,tablesLen);
+		b->fromJPEG(d,datasize,tablesData,tablesLen);
 	else if(inData[0]=='G' && inData[1]=='I' && inData[2]=='F' && inData[3]=='8')
-		bitmap->fromGIF(inData,datasize,loadedFrom->getSystemState());
+		b->fromGIF(d,datasize,loadedFrom->getSystemState());
 	else if(inData[0]==0xff && inData[1]==0xd9)
 		// I've found swf files with broken jpegs that start with the jpeg "end of file" magic bytes and two times the "begin of file" magic bytes
 		// so we just ignore the first 4 bytes
 		// TODO check if libjpeg has a better common way to deal with invalid headers
-		loadBitmap(inData+4, datasize-4, tablesData, tablesLen);
+		loadBitmap(b, inData+4, datasize-4, tablesData, tablesLen);
 	else
 		LOG(LOG_ERROR,"unknown image format for ID "<<getId());
 }
-DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int version, RootMovieClip* root):BitmapTag(h,root),BitmapColorTableSize(0)
+
+bool BitmapTag::readImageSize(const uint8_t* inData, int datasize, int32_t& w, int32_t& h)
+{
+	if (datasize < 4)
+		return false;
+	if((inData[0]&0x80) && inData[1]=='P' && inData[2]=='N' && inData[3]=='G')
+	{
+		// the IHDR chunk always comes first
+		if (datasize < 24 || memcmp(inData+12,"IHDR",4))
+			return false;
+		w=(inData[16]<<24)|(inData[17]<<16)|(inData[18]<<8)|inData[19];
+		h=(inData[20]<<24)|(inData[21]<<16)|(inData[22]<<8)|inData[23];
+		return w>0 && h>0;
+	}
+	if(inData[0]=='G' && inData[1]=='I' && inData[2]=='F' && inData[3]=='8')
+	{
+		if (datasize < 10)
+			return false;
+		w=inData[6]|(inData[7]<<8);
+		h=inData[8]|(inData[9]<<8);
+		return w>0 && h>0;
+	}
+	if(inData[0]!=0xff || (inData[1]!=0xd8 && inData[1]!=0xd9))
+		return false;
+	// walk the jpeg markers up to the start of frame, this also skips the broken
+	// "end of file" + "begin of file" headers handled in loadBitmap
+	int pos=0;
+	while (pos+1 < datasize)
+	{
+		if (inData[pos]!=0xff)
+			return false;
+		uint8_t marker=inData[pos+1];
+		pos+=2;
+		if (marker==0xff)
+		{
+			// fill byte
+			pos--;
+			continue;
+		}
+		// markers without payload
+		if (marker==0xd8 || marker==0xd9 || marker==0x01 || (marker>=0xd0 && marker<=0xd7))
+			continue;
+		if (pos+2 > datasize)
+			return false;
+		int length=(inData[pos]<<8)|inData[pos+1];
+		bool isSOF=marker>=0xc0 && marker<=0xcf && marker!=0xc4 && marker!=0xc8 && marker!=0xcc;
+		if (isSOF)
+		{
+			if (pos+7 > datasize)
+				return false;
+			h=(inData[pos+3]<<8)|inData[pos+4];
+			w=(inData[pos+5]<<8)|inData[pos+6];
+			return w>0 && h>0;
+		}
+		if (marker==0xda)
+			return false;
+		pos+=length;
+	}
+	return false;
+}
+
+void BitmapTag::setupDecoding(int32_t w, int32_t h)
+{
+	if(Config::getConfig()->isLazyBitmapDecodingEnabled() && w>0 && h>0)
+		bitmap->setLazySource(this,w,h);
+	else
+	{
+		decodeBitmap(bitmap.getPtr());
+		imageData.clear();
+		imageData.shrink_to_fit();
+		tablesData.clear();
+		tablesData.shrink_to_fit();
+	}
+}
+
+void BitmapTag::decodeBitmap(BitmapContainer* b)
+{
+	loadBitmap(b,imageData.data(),imageData.size(),tablesData.empty() ? nullptr : tablesData.data(),tablesData.size());
+}
+
+DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int v, RootMovieClip* root):BitmapTag(h,root),BitmapColorTableSize(0),version(v)
 {
 	int dest=in.tellg();
 	dest+=h.getLength();
@@ -1336,11 +1560,25 @@ DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int ve
 	if(BitmapFormat==LOSSLESS_BITMAP_PALETTE)
 		in >> BitmapColorTableSize;
 
-	string cData;
 	size_t cSize = dest-in.tellg(); //rest of this tag
-	cData.resize(cSize);
-	in.read(&cData[0], cSize);
-	istringstream cDataStream(cData);
+	imageData.resize(cSize);
+	in.read((char*)imageData.data(), cSize);
+	if (BitmapFormat == LOSSLESS_BITMAP_RGB15 ||
+	    BitmapFormat == LOSSLESS_BITMAP_RGB24 ||
+	    BitmapFormat == LOSSLESS_BITMAP_PALETTE)
+		setupDecoding(BitmapWidth, BitmapHeight);
+	else
+		LOG(LOG_NOT_IMPLEMENTED,"DefineBitsLossless(2)Tag with unsupported BitmapFormat " << BitmapFormat);
+}
+
+DefineBitsLosslessTag::~DefineBitsLosslessTag()
+{
+	detachBitmap();
+}
+
+void DefineBitsLosslessTag::decodeBitmap(BitmapContainer* b)
+{
+	istringstream cDataStream(string((const char*)imageData.data(),imageData.size()));
 	zlib_filter zf(cDataStream.rdbuf());
 	istream zfstream(&zf);
 
@@ -1360,7 +1598,7 @@ DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int ve
 		else
 			format = BitmapContainer::ARGB32;
 
-		bitmap->fromRGB(inData, BitmapWidth, BitmapHeight, format);
+		b->fromRGB(inData, BitmapWidth, BitmapHeight, format);
 	}
 	else if (BitmapFormat == LOSSLESS_BITMAP_PALETTE)
 	{
@@ -1384,13 +1622,9 @@ DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int ve
 
 		uint8_t *palette = inData;
 		uint8_t *pixelData = inData + paletteBPP*numColors;
-		bitmap->fromPalette(pixelData, BitmapWidth, BitmapHeight, stride, palette, numColors, paletteBPP);
+		b->fromPalette(pixelData, BitmapWidth, BitmapHeight, stride, palette, numColors, paletteBPP);
 		delete[] inData;
 	}
-	else
-	{
-		LOG(LOG_NOT_IMPLEMENTED,"DefineBitsLossless(2)Tag with unsupported BitmapFormat " << BitmapFormat);
-	}
 }
 
 ASObject* BitmapTag::instance(Class_base* c)
@@ -1398,35 +1632,39 @@ ASObject* BitmapTag::instance(Class_base* c)
 	//Flex imports bitmaps using BitmapAsset as the base class, which is derived from bitmap
 	//Also BitmapData is used in the wild though, so support both cases
 
+	_NR<BitmapContainer> b=getBitmap();
+	if(b->schedulePrefetch())
+		loadedFrom->getSystemState()->addJob(new BitmapDecodeJob(b));
+
 	Class_base* realClass=(c)?c:bindedTo;
 	Class_base* classRet = nullptr;
 	if (loadedFrom->usesActionScript3)
 	{
 		classRet = Class<BitmapData>::getClass(loadedFrom->getSystemState());
 		if(!realClass)
-			return new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),classRet, bitmap);
+			return new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),classRet, b);
 		if(realClass->isSubClass(Class<Bitmap>::getClass(realClass->getSystemState())))
 		{
-			BitmapData* ret=new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),classRet, bitmap);
+			BitmapData* ret=new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),classRet, b);
 			Bitmap* bitmapRet= new (realClass->memoryAccount) Bitmap(loadedFrom->getInstanceWorker(),realClass,_MR(ret));
 			return bitmapRet;
 		}
 		else
-			return new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),realClass, bitmap);
+			return new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),realClass, b);
 	}
 	else
 	{
 		classRet = Class<AVM1BitmapData>::getClass(loadedFrom->getSystemState());
 		if(!realClass)
-			return new (classRet->memoryAccount) AVM1BitmapData(loadedFrom->getInstanceWorker(),classRet, bitmap);
+			return new (classRet->memoryAccount) AVM1BitmapData(loadedFrom->getInstanceWorker(),classRet, b);
 		if(realClass->isSubClass(Class<AVM1Bitmap>::getClass(realClass->getSystemState())))
 		{
-			AVM1BitmapData* ret=new (classRet->memoryAccount) AVM1BitmapData(loadedFrom->getInstanceWorker(),classRet, bitmap);
+			AVM1BitmapData* ret=new (classRet->memoryAccount) AVM1BitmapData(loadedFrom->getInstanceWorker(),classRet, b);
 			Bitmap* bitmapRet= new (realClass->memoryAccount) AVM1Bitmap(loadedFrom->getInstanceWorker(),realClass,_MR(ret));
 			return bitmapRet;
 		}
 		else
-			return new (classRet->memoryAccount) AVM1BitmapData(loadedFrom->getInstanceWorker(),realClass, bitmap);
+			return new (classRet->memoryAccount) AVM1BitmapData(loadedFrom->getInstanceWorker(),realClass, b);
 	}
 
 	if(realClass->isSubClass(Class<BitmapData>::getClass(realClass->getSystemState())))
@@ -1434,7 +1672,7 @@ ASObject* BitmapTag::instance(Class_base* c)
 		classRet = realClass;
 	}
 
-	return new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),classRet, bitmap);
+	return new (classRet->memoryAccount) BitmapData(loadedFrom->getInstanceWorker(),classRet, b);
 }
 
 DefineTextTag::DefineTextTag(RECORDHEADER h, istream& in, RootMovieClip* root,int v):DictionaryTag(h,root),version(v)
@@ -2011,6 +2249,32 @@ void PlaceObject2Tag::execute(DisplayObjectContainer* parent, bool inskipping)
 	}
 }
 
+DISPLAYLIST_CHANGE PlaceObject2Tag::getDisplayListChange(int32_t& depth, uint32_t& characterId, uint32_t& properties) const
+{
+	if(!PlaceFlagHasCharacter && !PlaceFlagMove)
+		return DISPLAYLIST_NONE;
+	depth = LEGACY_DEPTH_START+Depth;
+	characterId = CharacterId;
+	properties = 0;
+	if (PlaceFlagHasMatrix)
+		properties |= PLACE_MATRIX;
+	if (PlaceFlagHasColorTransform)
+		properties |= PLACE_COLORTRANSFORM;
+	// placing a character always resets the ratio
+	if (PlaceFlagHasRatio || PlaceFlagHasCharacter)
+		properties |= PLACE_RATIO;
+	if (PlaceFlagHasClipDepth)
+		properties |= PLACE_CLIPDEPTH;
+	// the name is also reset if the tag doesn't move the object
+	if (PlaceFlagHasName || !PlaceFlagMove)
+		properties |= PLACE_NAME;
+	if (PlaceFlagHasClipAction)
+		properties |= PLACE_CLIPACTIONS;
+	if (!PlaceFlagHasCharacter)
+		return DISPLAYLIST_MODIFY;
+	return PlaceFlagMove ? DISPLAYLIST_REPLACE : DISPLAYLIST_PLACE;
+}
+
 PlaceObject2Tag::PlaceObject2Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root, AdditionalDataTag *datatag):DisplayListTag(h),ClipActions(root->version,datatag),placedTag(nullptr)
 {
 	LOG(LOG_TRACE,"PlaceObject2");
@@ -2149,6 +2413,20 @@ void PlaceObject3Tag::setProperties(DisplayObject *obj, DisplayObjectContainer *
 	obj->setFilters(this->SurfaceFilterList);
 }
 
+DISPLAYLIST_CHANGE PlaceObject3Tag::getDisplayListChange(int32_t& depth, uint32_t& characterId, uint32_t& properties) const
+{
+	DISPLAYLIST_CHANGE res = PlaceObject2Tag::getDisplayListChange(depth,characterId,properties);
+	if (res == DISPLAYLIST_NONE)
+		return res;
+	// cacheAsBitmap and the filters are always set
+	properties |= PLACE_CACHEASBITMAP | PLACE_FILTERS;
+	if (PlaceFlagHasBlendMode)
+		properties |= PLACE_BLENDMODE;
+	if (PlaceFlagHasVisible)
+		properties |= PLACE_VISIBLE;
+	return res;
+}
+
 void SetBackgroundColorTag::execute(RootMovieClip* root) const
 {
 	root->setBackground(BackgroundColor);
@@ -2421,15 +2699,30 @@ void DefineVideoStreamTag::setFrameData(VideoFrameTag* tag)
 	frames[tag->getFrameNumber()]=tag;
 }
 
-DefineBinaryDataTag::DefineBinaryDataTag(RECORDHEADER h,std::istream& s,RootMovieClip* root):DictionaryTag(h,root)
+DefineBinaryDataTag::DefineBinaryDataTag(RECORDHEADER h,std::istream& s,RootMovieClip* root):DictionaryTag(h,root),mappedFile(nullptr)
 {
 	LOG(LOG_TRACE,"DefineBinaryDataTag");
 	int size=h.getLength();
 	s >> Tag >> Reserved;
 	size -= sizeof(Tag)+sizeof(Reserved);
-	bytes=new uint8_t[size];
 	len=size;
-	s.read((char*)bytes,size);
+	//Reference the data directly if the swf is a mapped local file
+	IMappedStreamBuf* mapped=dynamic_cast<IMappedStreamBuf*>(s.rdbuf());
+	bytes=mapped ? mapped->readMapped(size,mappedFile) : nullptr;
+	if(bytes==nullptr)
+	{
+		uint8_t* data=new uint8_t[size];
+		s.read((char*)data,size);
+		bytes=data;
+	}
+}
+
+DefineBinaryDataTag::~DefineBinaryDataTag()
+{
+	if(mappedFile)
+		g_mapped_file_unref(mappedFile);
+	else
+		delete[] bytes;
 }
 
 ASObject* DefineBinaryDataTag::instance(Class_base* c)
@@ -2764,14 +3057,17 @@ DefineBitsTag::DefineBitsTag(RECORDHEADER h, std::istream& in,RootMovieClip* roo
 		LOG(LOG_ERROR, "Malformed SWF file: JPEGTable was expected before DefineBits");
 		// try to continue anyway
 	}
+	else
+		tablesData.assign(JPEGTablesTag::getJPEGTables(),JPEGTablesTag::getJPEGTables()+JPEGTablesTag::getJPEGTableSize());
 
 	in >> CharacterId;
 	//Read image data
 	int dataSize=Header.getLength()-2;
-	uint8_t *inData=new(nothrow) uint8_t[dataSize];
-	in.read((char*)inData,dataSize);
-	loadBitmap(inData,dataSize,JPEGTablesTag::getJPEGTables(),JPEGTablesTag::getJPEGTableSize());
-	delete[] inData;
+	imageData.resize(dataSize);
+	in.read((char*)imageData.data(),dataSize);
+	int32_t width=0,height=0;
+	readImageSize(imageData.data(),dataSize,width,height);
+	setupDecoding(width,height);
 }
 
 DefineBitsJPEG2Tag::DefineBitsJPEG2Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root):BitmapTag(h,root)
@@ -2780,61 +3076,72 @@ DefineBitsJPEG2Tag::DefineBitsJPEG2Tag(RECORDHEADER h, std::istream& in, RootMov
 	in >> CharacterId;
 	//Read image data
 	int dataSize=Header.getLength()-2;
-	uint8_t* inData=new(nothrow) uint8_t[dataSize];
-	in.read((char*)inData,dataSize);
-	loadBitmap(inData,dataSize);
-	delete[] inData;
+	imageData.resize(dataSize);
+	in.read((char*)imageData.data(),dataSize);
+	int32_t width=0,height=0;
+	readImageSize(imageData.data(),dataSize,width,height);
+	setupDecoding(width,height);
 }
 
-DefineBitsJPEG3Tag::DefineBitsJPEG3Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root):BitmapTag(h,root),alphaData(NULL)
+DefineBitsJPEG3Tag::DefineBitsJPEG3Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root):BitmapTag(h,root)
 {
 	LOG(LOG_TRACE,"DefineBitsJPEG3Tag Tag");
 	UI32_SWF dataSize;
 	in >> CharacterId >> dataSize;
 	//Read image data
-	uint8_t* inData=new(nothrow) uint8_t[dataSize];
-	in.read((char*)inData,dataSize);
-
-	loadBitmap(inData,dataSize);
-	delete[] inData;
+	imageData.resize(dataSize);
+	in.read((char*)imageData.data(),dataSize);
 
 	//Read alpha data (if any)
 	int alphaSize=Header.getLength()-dataSize-6;
 	if(alphaSize>0) //If less that 0 the consistency check on tag size will stop later
 	{
-		//Create a zlib filter
-		string alphaData;
 		alphaData.resize(alphaSize);
-		in.read(&alphaData[0], alphaSize);
-		istringstream alphaStream(alphaData);
-		zlib_filter zf(alphaStream.rdbuf());
-		istream zfstream(&zf);
-		zfstream.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
-
-		vector<char> alphaDataUncompressed;
-		alphaDataUncompressed.resize(bitmap->getHeight()*bitmap->getWidth());
-		
-		//Catch the exception if the stream ends
-		try
-		{
-			zfstream.read(alphaDataUncompressed.data(),bitmap->getHeight()*bitmap->getWidth());
-		}
-		catch(std::exception& e)
-		{
-			LOG(LOG_ERROR, "Exception while parsing Alpha data in DefineBitsJPEG3");
-		}
-		uint8_t* d = bitmap->getData();
-		//Set alpha
-		for(int32_t i=0;i<bitmap->getHeight()*bitmap->getWidth();i++)
-		{
-			d[i*4+3]=alphaDataUncompressed[i];
-		}
+		in.read((char*)alphaData.data(), alphaSize);
 	}
+	int32_t width=0,height=0;
+	readImageSize(imageData.data(),dataSize,width,height);
+	setupDecoding(width,height);
+	if(!bitmap->isDecoded())
+		return;
+	alphaData.clear();
+	alphaData.shrink_to_fit();
 }
 
 DefineBitsJPEG3Tag::~DefineBitsJPEG3Tag()
 {
-	delete[] alphaData;
+	detachBitmap();
+}
+
+void DefineBitsJPEG3Tag::decodeBitmap(BitmapContainer* b)
+{
+	BitmapTag::decodeBitmap(b);
+	if(alphaData.empty() || b->isEmpty())
+		return;
+	//Create a zlib filter
+	istringstream alphaStream(string((const char*)alphaData.data(),alphaData.size()));
+	zlib_filter zf(alphaStream.rdbuf());
+	istream zfstream(&zf);
+	zfstream.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
+
+	vector<char> alphaDataUncompressed;
+	alphaDataUncompressed.resize(b->getHeight()*b->getWidth());
+
+	//Catch the exception if the stream ends
+	try
+	{
+		zfstream.read(alphaDataUncompressed.data(),b->getHeight()*b->getWidth());
+	}
+	catch(std::exception& e)
+	{
+		LOG(LOG_ERROR, "Exception while parsing Alpha data in DefineBitsJPEG3");
+	}
+	uint8_t* d = b->getData();
+	//Set alpha
+	for(int32_t i=0;i<b->getHeight()*b->getWidth();i++)
+	{
+		d[i*4+3]=alphaDataUncompressed[i];
+	}
 }
 
 DefineSceneAndFrameLabelDataTag::DefineSceneAndFrameLabelDataTag(RECORDHEADER h, std::istream& in):ControlTag(h)
@@ -23,10 +23,12 @@
 #include "compat.h"
 #include <vector>
 #include <iostream>
+#include <exception>
 #include "swftypes.h"
 #include "backends/geometry.h"
 #include "backends/decoder.h"
 #include "scripting/flash/display/flashdisplay.h"
+#include "scripting/flash/display/BitmapContainer.h"
 
 namespace lightspark
 {
@@ -62,12 +64,26 @@ public:
 	TAGTYPE getType() const override { return END_TAG; }
 };
 
+/*
+ * How a tag changes the legacy child at a depth, used to build the display list snapshots of timelines
+ */
+enum DISPLAYLIST_CHANGE { DISPLAYLIST_NONE=0, DISPLAYLIST_PLACE, DISPLAYLIST_REPLACE, DISPLAYLIST_MODIFY, DISPLAYLIST_REMOVE };
+// properties of a legacy child that are set by a PlaceObject tag
+enum PLACE_PROPERTY { PLACE_MATRIX=0x01, PLACE_COLORTRANSFORM=0x02, PLACE_RATIO=0x04, PLACE_CLIPDEPTH=0x08, PLACE_NAME=0x10,
+					  PLACE_CLIPACTIONS=0x20, PLACE_BLENDMODE=0x40, PLACE_VISIBLE=0x80, PLACE_CACHEASBITMAP=0x100, PLACE_FILTERS=0x200 };
+
 class DisplayListTag: public Tag
 {
 public:
 	DisplayListTag(RECORDHEADER h):Tag(h){}
 	TAGTYPE getType() const override { return DISPLAY_LIST_TAG; }
 	virtual void execute(DisplayObjectContainer* parent,bool inskipping) =0;
+	/*
+	 * returns how the tag changes the legacy display list when the frame is skipped,
+	 * depth is set to the changed depth, characterId to the placed character and
+	 * properties to the PLACE_PROPERTY flags set by the tag
+	 */
+	virtual DISPLAYLIST_CHANGE getDisplayListChange(int32_t& depth, uint32_t& characterId, uint32_t& properties) const { return DISPLAYLIST_NONE; }
 };
 
 class DictionaryTag: public Tag
@@ -353,6 +369,7 @@ private:
 public:
 	RemoveObject2Tag(RECORDHEADER h, std::istream& in);
 	void execute(DisplayObjectContainer* parent,bool inskipping) override;
+	DISPLAYLIST_CHANGE getDisplayListChange(int32_t& depth, uint32_t& characterId, uint32_t& properties) const override;
 };
 
 class PlaceObject2Tag: public DisplayListTag
@@ -381,6 +398,7 @@ public:
 	uint32_t NameID;
 	PlaceObject2Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root, AdditionalDataTag* datatag);
 	void execute(DisplayObjectContainer* parent,bool inskipping) override;
+	DISPLAYLIST_CHANGE getDisplayListChange(int32_t& depth, uint32_t& characterId, uint32_t& properties) const override;
 };
 
 class PlaceObject3Tag: public PlaceObject2Tag
@@ -403,6 +421,7 @@ private:
 public:
 	PlaceObject3Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root);
 	void setProperties(DisplayObject* obj, DisplayObjectContainer* parent) const override;
+	DISPLAYLIST_CHANGE getDisplayListChange(int32_t& depth, uint32_t& characterId, uint32_t& properties) const override;
 };
 
 class FrameLabelTag: public Tag
@@ -464,11 +483,13 @@ class DefineBinaryDataTag: public DictionaryTag
 private:
 	UI16_SWF Tag;
 	UI32_SWF Reserved;
-	uint8_t* bytes;
+	const uint8_t* bytes;
 	uint32_t len;
+	// set when bytes point into a memory mapped file
+	GMappedFile* mappedFile;
 public:
 	DefineBinaryDataTag(RECORDHEADER h,std::istream& s,RootMovieClip* root);
-	~DefineBinaryDataTag() { delete[] bytes; }
+	~DefineBinaryDataTag();
 	int getId() const override {return Tag;}
 	ASObject* instance(Class_base* c=nullptr) override;
 };
@@ -661,16 +682,25 @@ public:
 
 class BitmapContainer;
 
-class BitmapTag: public DictionaryTag
+class BitmapTag: public DictionaryTag, public IBitmapSource
 {
 protected:
 	_NR<BitmapContainer> bitmap;
-	void loadBitmap(uint8_t* inData, int datasize, const uint8_t *tablesData=nullptr, int tablesLen=0);
+	//The still encoded image, kept until the bitmap is decoded on demand
+	std::vector<uint8_t> imageData;
+	std::vector<uint8_t> tablesData;
+	void loadBitmap(BitmapContainer* b, const uint8_t* inData, int datasize, const uint8_t *tablesData=nullptr, int tablesLen=0);
+	/* Defers decoding until the bitmap is used if the size of the image is known, otherwise decodes it now */
+	void setupDecoding(int32_t w, int32_t h);
+	/* Has to be called by the destructors of subclasses overriding decodeBitmap */
+	void detachBitmap();
+	static bool readImageSize(const uint8_t* inData, int datasize, int32_t& w, int32_t& h);
 public:
 	BitmapTag(RECORDHEADER h,RootMovieClip* root);
 	~BitmapTag();
 	ASObject* instance(Class_base* c=nullptr) override;
 	_NR<BitmapContainer> getBitmap() const;
+	void decodeBitmap(BitmapContainer* b) override;
 };
 
 class JPEGTablesTag: public Tag
@@ -692,10 +722,13 @@ private:
 	UI16_SWF BitmapWidth;
 	UI16_SWF BitmapHeight;
 	UI8 BitmapColorTableSize;
-	//ZlibBitmapData;
+	int version;
+	//ZlibBitmapData is kept in imageData
 public:
 	DefineBitsLosslessTag(RECORDHEADER h, std::istream& in, int version, RootMovieClip* root);
+	~DefineBitsLosslessTag();
 	int getId() const override { return CharacterId; }
+	void decodeBitmap(BitmapContainer* b) override;
 };
 
 class DefineBitsTag: public BitmapTag
@@ -720,11 +753,13 @@ class DefineBitsJPEG3Tag: public BitmapTag
 {
 private:
 	UI16_SWF CharacterId;
-	uint8_t* alphaData;
+	//zlib compressed alpha channel
+	std::vector<uint8_t> alphaData;
 public:
 	DefineBitsJPEG3Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root);
 	~DefineBitsJPEG3Tag();
 	int getId() const override { return CharacterId; }
+	void decodeBitmap(BitmapContainer* b) override;
 };
 
 class DefineScalingGridTag: public ControlTag
@@ -908,18 +943,47 @@ public:
 	NameCharacterTag(RECORDHEADER h, std::istream& in, RootMovieClip *root);
 };
 
+// limits for the tags read ahead to be parsed in parallel
+#define PARSE_BATCH_MAXTAGS 64
+#define PARSE_BATCH_MAXBYTES (4*1024*1024)
+
+/*
+ * A tag that has been read from the file but not parsed yet, see TagFactory::readTag
+ */
+struct PendingTag
+{
+	RECORDHEADER header;
+	std::vector<uint8_t> data;
+	Tag* tag;
+	// set if parsing the tag failed, rethrown when the tag is processed
+	std::exception_ptr error;
+	// set if the tag looks up preceding shapes or fonts in the dictionary, it is parsed on the parse thread
+	// after all tags before it have been added to the dictionary
+	bool sequential;
+	PendingTag():tag(nullptr),sequential(false) {}
+};
+
 class TagFactory
 {
 private:
 	std::istream& f;
 	bool firstTag;
+	// tags that only depend on tags preceding them through the dictionary
+	static bool canParseDeferred(uint32_t tagType);
+	// tags that look up shapes or fonts preceding them in the dictionary during construction
+	static bool dependsOnDictionary(uint32_t tagType);
 public:
 	TagFactory(std::istream& in):f(in),firstTag(true){}
 	/**
 	 * The RootMovieClip that is the owner of the content.
 	 * It is needed to solve references to other tags during construction
+	 * If pending is not null, tags that can be parsed on any thread are only read
+	 * into pending and nullptr is returned, they have to be parsed by parsePendingTag.
+	 * The same is done for tags that depend on the dictionary, pending->sequential is set for them
 	 */
-	Tag* readTag(RootMovieClip* root,DefineSpriteTag* sprite=nullptr);
+	Tag* readTag(RootMovieClip* root,DefineSpriteTag* sprite=nullptr,PendingTag* pending=nullptr);
+	/* Parses a tag read by readTag, may be called concurrently for different tags */
+	static void parsePendingTag(PendingTag& pending, RootMovieClip* root);
 };
 
 
@@ -62,6 +62,9 @@ SDL_Thread* EngineData::mainLoopThread = nullptr;
 bool EngineData::mainthread_running = false;
 bool EngineData::sdl_needinit = true;
 bool EngineData::enablerendering = true;
+tiny_string EngineData::audiowavfile;
+uint32_t EngineData::audiowavrate = 0;
+bool EngineData::audiowavunpaced = false;
 SDL_Cursor* EngineData::handCursor = nullptr;
 Semaphore EngineData::mainthread_initialized(0);
 EngineData::EngineData() : contextmenu(nullptr),contextmenurenderer(nullptr),sdleventtickjob(nullptr),incontextmenu(false),incontextmenupreparing(false),widget(nullptr),nvgcontext(nullptr), width(0), height(0),needrenderthread(true),supportPackedDepthStencil(false),hasExternalFontRenderer(false),
@@ -1420,56 +1423,9 @@ void EngineData::exec_glStencilFunc_GL_ALWAYS()
 
 void audioCallback(void * userdata, uint8_t * stream, int len)
 {
+	//All the mixing is done by the mixer thread of the AudioManager, this never blocks
 	AudioManager* manager = (AudioManager*)userdata;
-
-    SDL_memset(stream, 0, len);
-
-	{
-		Locker l(manager->streamMutex);
-		for (auto it = manager->streams.begin(); it != manager->streams.end(); it++)
-		{
-			AudioStream* s = (*it);
-			if (s->ispaused())
-				continue;
-			s->startMixing();
-			const float fmaxvolume = 1.0f / ((float)SDL_MIX_MAXVOLUME);
-			const float fvolume = (float)s->getVolume()*(float)SDL_MIX_MAXVOLUME;
-			uint32_t readcount = 0;
-			uint8_t* buf = new uint8_t[len];
-			while (readcount < ((uint32_t)len))
-			{
-				uint32_t ret = s->getDecoder()->copyFrameF32((float *)(buf+readcount), ((uint32_t)len)-readcount);
-				if (!ret)
-					break;
-				float* src32=(float *)(buf+readcount);
-				float* dst32=(float *)(stream+readcount);
-				readcount += ret;
-
-				float src1, src2;
-				double dst_sample;
-
-				const double max_audioval = 3.402823466e+38F;
-				const double min_audioval = -3.402823466e+38F;
-				int curpanning=0;
-				while (ret)
-				{
-					src1 = *src32 * fvolume * fmaxvolume * s->getPanning()[curpanning];
-					curpanning = 1-curpanning;
-					src2 = *dst32;
-					src32++;
-					dst_sample = ((double)src1) + ((double)src2);
-					if (dst_sample > max_audioval) {
-						dst_sample = max_audioval;
-					} else if (dst_sample < min_audioval) {
-						dst_sample = min_audioval;
-					}
-					*(dst32++) = (float)dst_sample;
-					ret-=4;
-				}
-			}
-			delete[] buf;
-		}
-    }
+	manager->readMixedSamples((float*)stream,len/sizeof(float));
 }
 
 int EngineData::audio_StreamInit(AudioStream* s)
@@ -1487,6 +1443,9 @@ void EngineData::audio_StreamDeinit(int channel)
 
 bool EngineData::audio_ManagerInit()
 {
+	//Rendering to a file does not need an audio device
+	if (!audiowavfile.empty())
+		return true;
 	bool sdl_available = false;
 	if (SDL_WasInit(0)) // some part of SDL already was initialized
 		sdl_available = !SDL_InitSubSystem ( SDL_INIT_AUDIO );
@@ -1503,11 +1462,15 @@ void EngineData::audio_ManagerCloseMixer(AudioManager* manager)
 		SDL_CloseAudioDevice(manager->device);
 		manager->device=0;
 	}
+	manager->stopMixer();
 }
 
 bool EngineData::audio_ManagerOpenMixer(AudioManager* manager)
 {
+	if (!audiowavfile.empty())
+		return manager->startMixer(audiowavrate ? audiowavrate : audio_getSampleRate(),audiowavfile,audiowavunpaced);
 	SDL_AudioSpec spec;
+	SDL_AudioSpec obtained;
 	spec.freq=audio_getSampleRate();
 	spec.format=AUDIO_F32SYS;
 	spec.channels = 2;
@@ -1515,14 +1478,24 @@ bool EngineData::audio_ManagerOpenMixer(AudioManager* manager)
 	spec.callback = audioCallback;
 	spec.userdata = manager;
 
-	manager->device = SDL_OpenAudioDevice(nullptr, 0, &spec, nullptr, 0);
-	if (manager->device != 0)
-		SDL_PauseAudioDevice(manager->device, 0);
-	return manager->device!=0;
+	//Let the device keep its native rate, the mixer resamples to it
+	manager->device = SDL_OpenAudioDevice(nullptr, 0, &spec, &obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+	if (manager->device == 0)
+		return false;
+	if (!manager->startMixer(obtained.freq,""))
+	{
+		SDL_CloseAudioDevice(manager->device);
+		manager->device=0;
+		return false;
+	}
+	SDL_PauseAudioDevice(manager->device, 0);
+	return true;
 }
 
 void EngineData::audio_ManagerDeinit()
 {
+	if (!audiowavfile.empty())
+		return;
 	SDL_QuitSubSystem ( SDL_INIT_AUDIO );
 	if (!SDL_WasInit(0))
 		SDL_Quit ();
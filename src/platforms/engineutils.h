@@ -180,6 +180,12 @@ public:
 
 	static bool sdl_needinit;
 	static bool enablerendering;
+	//When set, the mixed audio is written to this WAV file instead of being played
+	static tiny_string audiowavfile;
+	//Sample rate of the WAV file, 0 uses the decoders sample rate
+	static uint32_t audiowavrate;
+	//When set, the WAV file is mixed as fast as the streams deliver samples instead of in real time
+	static bool audiowavunpaced;
 	static bool mainthread_running;
 	static Semaphore mainthread_initialized;
 	static bool startSDLMain();
@@ -39,5 +39,76 @@ namespace lightspark
 */
 void fastYUV420ChannelsToYUV0Buffer(uint8_t* y, uint8_t* u, uint8_t* v, uint8_t* out, uint32_t width, uint32_t height);
 
+/**
+	Conversion of YUV420 (BT.601, limited range) planes to premultiplied BGRA (the cairo ARGB32 format)
+
+	@param y Planar Y buffer
+	@param u Planar U buffer, subsampled by 2 in both directions
+	@param v Planar V buffer, subsampled by 2 in both directions
+	@param a Planar alpha buffer (YUVA420), nullptr for opaque frames
+	@param out Destination BGRA buffer
+	@param width Frame width in pixels
+	@param height Frame height in pixels
+	@param yStride Bytes per row of the Y buffer
+	@param uvStride Bytes per row of the U and V buffers
+	@param aStride Bytes per row of the alpha buffer
+	@param outStride Bytes per row of the destination buffer
+	@param No alignment is required
+*/
+void fastYUV420ToBGRA(const uint8_t* y, const uint8_t* u, const uint8_t* v, const uint8_t* a, uint8_t* out, uint32_t width, uint32_t height,
+		uint32_t yStride, uint32_t uvStride, uint32_t aStride, uint32_t outStride);
+
+/**
+	Horizontal pass of the box blur used by the bitmap filters
+
+	@param data ARGB32 buffer, it is blurred in place
+	@param width Buffer width in pixels
+	@param firstRow First row to be blurred
+	@param lastRow The row after the last row to be blurred
+	@param radius Blur radius in pixels
+	@param mul Multiplier applied to the sum of the pixels in the window
+	@param shift Right shift applied after the multiplication
+*/
+void fastBlurRows(uint8_t* data, int32_t width, int32_t firstRow, int32_t lastRow, int32_t radius, int32_t mul, int32_t shift);
+
+/**
+	Vertical pass of the box blur used by the bitmap filters
+
+	@param data ARGB32 buffer, it is blurred in place
+	@param width Buffer width in pixels
+	@param height Buffer height in pixels
+	@param firstColumn First column to be blurred
+	@param lastColumn The column after the last column to be blurred
+	@param radius Blur radius in pixels
+	@param mul Multiplier applied to the sum of the pixels in the window
+	@param shift Right shift applied after the multiplication
+	@param lastIteration The color channels are clamped to 255 instead of truncated in the last iteration
+*/
+void fastBlurColumns(uint8_t* data, int32_t width, int32_t height, int32_t firstColumn, int32_t lastColumn, int32_t radius, int32_t mul, int32_t shift, bool lastIteration);
+
+/**
+	Mixing of interleaved stereo float samples, dest+=src*gain
+
+	@param dest Buffer the samples are added to
+	@param src Samples to be mixed
+	@param frames Number of stereo frames
+	@param left Gain of the left channel
+	@param right Gain of the right channel
+	@param No alignment is required
+*/
+void fastMixStereoF32(float* dest, const float* src, uint32_t frames, float left, float right);
+
+/**
+	Linear interpolating resampler for interleaved stereo float samples
+
+	@param src Source frames, the frame after the last interpolated position must be available
+	@param dest Destination buffer
+	@param frames Number of frames to produce
+	@param pos Position of the first produced frame in src, as 16.16 fixed point
+	@param step Distance in src between two produced frames, as 16.16 fixed point
+	@return The position of the frame following the last produced one
+*/
+uint64_t fastResampleStereoF32(const float* src, float* dest, uint32_t frames, uint64_t pos, uint32_t step);
+
 };
 #endif /* PLATFORMS_FASTPATHS_H */
@@ -19,6 +19,10 @@
 
 #include "platforms/fastpaths.h"
 #include <cinttypes>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <immintrin.h>
 
 extern "C"
 {
@@ -38,3 +42,540 @@ void lightspark::fastYUV420ChannelsToYUV0Buffer(uint8_t* y, uint8_t* u, uint8_t*
 	else
 		fastYUV420ChannelsToYUV0Buffer_SSE2Unaligned(y,u,v,out,width,height);
 }
+
+/*
+ * The blur kernels work on the 4 channels of a pixel as 32 bit integers.
+ * They use exactly the same integer arithmetic as the scalar version in
+ * slowpaths_generic.cpp, so the results are identical.
+ * The stacks are std::vector<int32_t> accessed with unaligned loads, as
+ * std::vector does not guarantee the alignment of vector types.
+ */
+namespace
+{
+
+bool hasAVX2()
+{
+	static bool ret=__builtin_cpu_supports("avx2");
+	return ret;
+}
+
+//SSE2 has no 32 bit multiplication, so multiply even and odd lanes to 64 bit and combine the low halves
+__attribute__((target("sse2"))) inline __m128i mullo32(__m128i a, __m128i b)
+{
+	__m128i even=_mm_mul_epu32(a,b);
+	__m128i odd=_mm_mul_epu32(_mm_srli_epi64(a,32),_mm_srli_epi64(b,32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even,_MM_SHUFFLE(0,0,2,0)),_mm_shuffle_epi32(odd,_MM_SHUFFLE(0,0,2,0)));
+}
+
+__attribute__((target("sse2"))) inline __m128i loadPixel(const uint8_t* p)
+{
+	int32_t v;
+	memcpy(&v,p,4);
+	__m128i zero=_mm_setzero_si128();
+	return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v),zero),zero);
+}
+
+template<int N>
+__attribute__((target("sse2"))) inline void loadPixels(const uint8_t* p, __m128i* v)
+{
+	if(N==1)
+	{
+		v[0]=loadPixel(p);
+		return;
+	}
+	__m128i zero=_mm_setzero_si128();
+	__m128i b=_mm_loadu_si128((const __m128i*)p);
+	__m128i lo=_mm_unpacklo_epi8(b,zero);
+	__m128i hi=_mm_unpackhi_epi8(b,zero);
+	v[0]=_mm_unpacklo_epi16(lo,zero);
+	v[1]=_mm_unpackhi_epi16(lo,zero);
+	v[2]=_mm_unpacklo_epi16(hi,zero);
+	v[3]=_mm_unpackhi_epi16(hi,zero);
+}
+
+//Values must be in [0,32767], the conversion to bytes saturates
+template<int N>
+__attribute__((target("sse2"))) inline void storePixels(uint8_t* p, const __m128i* v)
+{
+	if(N==1)
+	{
+		__m128i w=_mm_packs_epi32(v[0],v[0]);
+		int32_t r=_mm_cvtsi128_si32(_mm_packus_epi16(w,w));
+		memcpy(p,&r,4);
+		return;
+	}
+	__m128i w0=_mm_packs_epi32(v[0],v[1]);
+	__m128i w1=_mm_packs_epi32(v[2],v[3]);
+	_mm_storeu_si128((__m128i*)p,_mm_packus_epi16(w0,w1));
+}
+
+__attribute__((target("sse2"))) void blurRowsSSE2(uint8_t* data, int32_t width, int32_t firstRow, int32_t lastRow, int32_t radius, int32_t mul, int32_t shift)
+{
+	int32_t div=radius*2+1;
+	int32_t w1=width-1;
+	std::vector<int32_t> stack(div*4);
+	__m128i* st=(__m128i*)stack.data();
+	__m128i m=_mm_set1_epi32(mul);
+	__m128i sh=_mm_cvtsi32_si128(shift);
+	__m128i bytemask=_mm_set1_epi32(0xff);
+	for(int32_t row=firstRow;row<lastRow;row++)
+	{
+		uint8_t* px=data+row*width*4;
+		__m128i first=loadPixel(px);
+		__m128i sum=mullo32(first,_mm_set1_epi32(radius+1));
+		int32_t s=0;
+		for(int32_t i=0;i<radius+2;i++)
+		{
+			_mm_storeu_si128(st+s,first);
+			if(++s==div)
+				s=0;
+		}
+		for(int32_t i=1;i<=radius;i++)
+		{
+			__m128i v=loadPixel(px+std::min(i,w1)*4);
+			sum=_mm_add_epi32(sum,v);
+			_mm_storeu_si128(st+s,v);
+			if(++s==div)
+				s=0;
+		}
+		s=0;
+		for(int32_t x=0;x<width;x++)
+		{
+			__m128i out=_mm_and_si128(_mm_srl_epi32(mullo32(sum,m),sh),bytemask);
+			storePixels<1>(px+x*4,&out);
+			__m128i v=loadPixel(px+std::min(x+radius+1,w1)*4);
+			sum=_mm_add_epi32(sum,_mm_sub_epi32(v,_mm_loadu_si128(st+s)));
+			_mm_storeu_si128(st+s,v);
+			if(++s==div)
+				s=0;
+		}
+	}
+}
+
+//Blurs N adjacent columns at once
+template<int N>
+__attribute__((target("sse2"))) void blurColumnsSSE2(uint8_t* data, int32_t width, int32_t height, int32_t firstColumn, int32_t lastColumn, int32_t radius, int32_t mul, int32_t shift, bool lastIteration)
+{
+	int32_t div=radius*2+1;
+	int32_t h1=height-1;
+	int32_t stride=width*4;
+	std::vector<int32_t> stack(div*4*N);
+	__m128i* st=(__m128i*)stack.data();
+	__m128i m=_mm_set1_epi32(mul);
+	__m128i sh=_mm_cvtsi32_si128(shift);
+	__m128i zero=_mm_setzero_si128();
+	__m128i colormask=_mm_set_epi32(0,-1,-1,-1);
+	//in the last iteration the colors are clamped by storePixels, but alpha is still truncated
+	__m128i truncatemask=lastIteration ? _mm_set_epi32(0xff,-1,-1,-1) : _mm_set1_epi32(0xff);
+	__m128i v[N];
+	__m128i sum[N];
+	for(int32_t x=firstColumn;x<lastColumn;x+=N)
+	{
+		uint8_t* px=data+x*4;
+		loadPixels<N>(px,v);
+		for(int j=0;j<N;j++)
+		{
+			sum[j]=mullo32(v[j],_mm_set1_epi32(radius+1));
+			for(int32_t i=0;i<radius+1;i++)
+				_mm_storeu_si128(st+i*N+j,v[j]);
+		}
+		int32_t s=radius+1;
+		int32_t yp=1;
+		for(int32_t i=1;i<=radius;i++)
+		{
+			loadPixels<N>(px+yp*stride,v);
+			for(int j=0;j<N;j++)
+			{
+				sum[j]=_mm_add_epi32(sum[j],v[j]);
+				_mm_storeu_si128(st+s*N+j,v[j]);
+			}
+			if(++s==div)
+				s=0;
+			if(i<h1)
+				yp++;
+		}
+		s=0;
+		for(int32_t y=0;y<height;y++)
+		{
+			for(int j=0;j<N;j++)
+			{
+				__m128i out=_mm_srl_epi32(mullo32(sum[j],m),sh);
+				//clear the colors of pixels with alpha 0
+				__m128i transparent=_mm_cmpeq_epi32(_mm_shuffle_epi32(out,_MM_SHUFFLE(3,3,3,3)),zero);
+				out=_mm_andnot_si128(_mm_and_si128(transparent,colormask),out);
+				v[j]=_mm_and_si128(out,truncatemask);
+			}
+			storePixels<N>(px+y*stride,v);
+			loadPixels<N>(px+std::min(y+radius+1,h1)*stride,v);
+			for(int j=0;j<N;j++)
+			{
+				sum[j]=_mm_add_epi32(sum[j],_mm_sub_epi32(v[j],_mm_loadu_si128(st+s*N+j)));
+				_mm_storeu_si128(st+s*N+j,v[j]);
+			}
+			if(++s==div)
+				s=0;
+		}
+	}
+}
+
+//Loads 8 pixels, every register holds one pixel in each 128 bit lane
+__attribute__((target("avx2"))) inline void loadPixelsAVX2(const uint8_t* p, __m256i* v)
+{
+	__m256i zero=_mm256_setzero_si256();
+	__m256i b=_mm256_loadu_si256((const __m256i*)p);
+	__m256i lo=_mm256_unpacklo_epi8(b,zero);
+	__m256i hi=_mm256_unpackhi_epi8(b,zero);
+	v[0]=_mm256_unpacklo_epi16(lo,zero);
+	v[1]=_mm256_unpackhi_epi16(lo,zero);
+	v[2]=_mm256_unpacklo_epi16(hi,zero);
+	v[3]=_mm256_unpackhi_epi16(hi,zero);
+}
+
+//Blurs 8 adjacent columns at once
+__attribute__((target("avx2"))) void blurColumnsAVX2(uint8_t* data, int32_t width, int32_t height, int32_t firstColumn, int32_t lastColumn, int32_t radius, int32_t mul, int32_t shift, bool lastIteration)
+{
+	int32_t div=radius*2+1;
+	int32_t h1=height-1;
+	int32_t stride=width*4;
+	std::vector<int32_t> stack(div*4*8);
+	__m256i* st=(__m256i*)stack.data();
+	__m256i m=_mm256_set1_epi32(mul);
+	__m128i sh=_mm_cvtsi32_si128(shift);
+	__m256i zero=_mm256_setzero_si256();
+	__m256i colormask=_mm256_set_epi32(0,-1,-1,-1,0,-1,-1,-1);
+	__m256i truncatemask=lastIteration ? _mm256_set_epi32(0xff,-1,-1,-1,0xff,-1,-1,-1) : _mm256_set1_epi32(0xff);
+	__m256i v[4];
+	__m256i sum[4];
+	for(int32_t x=firstColumn;x<lastColumn;x+=8)
+	{
+		uint8_t* px=data+x*4;
+		loadPixelsAVX2(px,v);
+		for(int j=0;j<4;j++)
+		{
+			sum[j]=_mm256_mullo_epi32(v[j],_mm256_set1_epi32(radius+1));
+			for(int32_t i=0;i<radius+1;i++)
+				_mm256_storeu_si256(st+i*4+j,v[j]);
+		}
+		int32_t s=radius+1;
+		int32_t yp=1;
+		for(int32_t i=1;i<=radius;i++)
+		{
+			loadPixelsAVX2(px+yp*stride,v);
+			for(int j=0;j<4;j++)
+			{
+				sum[j]=_mm256_add_epi32(sum[j],v[j]);
+				_mm256_storeu_si256(st+s*4+j,v[j]);
+			}
+			if(++s==div)
+				s=0;
+			if(i<h1)
+				yp++;
+		}
+		s=0;
+		for(int32_t y=0;y<height;y++)
+		{
+			for(int j=0;j<4;j++)
+			{
+				__m256i out=_mm256_srl_epi32(_mm256_mullo_epi32(sum[j],m),sh);
+				__m256i transparent=_mm256_cmpeq_epi32(_mm256_shuffle_epi32(out,_MM_SHUFFLE(3,3,3,3)),zero);
+				out=_mm256_andnot_si256(_mm256_and_si256(transparent,colormask),out);
+				v[j]=_mm256_and_si256(out,truncatemask);
+			}
+			__m256i w0=_mm256_packs_epi32(v[0],v[1]);
+			__m256i w1=_mm256_packs_epi32(v[2],v[3]);
+			_mm256_storeu_si256((__m256i*)(px+y*stride),_mm256_packus_epi16(w0,w1));
+			loadPixelsAVX2(px+std::min(y+radius+1,h1)*stride,v);
+			for(int j=0;j<4;j++)
+			{
+				sum[j]=_mm256_add_epi32(sum[j],_mm256_sub_epi32(v[j],_mm256_loadu_si256(st+s*4+j)));
+				_mm256_storeu_si256(st+s*4+j,v[j]);
+			}
+			if(++s==div)
+				s=0;
+		}
+	}
+}
+
+/*
+ * The YUV to BGRA kernels use the same fixed point BT.601 coefficients
+ * as the scalar version in slowpaths_generic.cpp. The 32 bit sums are
+ * computed with madd on (luma,rounding) and (U,V) pairs, so every
+ * channel needs just two multiply-adds.
+ */
+inline int32_t pair16(int16_t lo, int16_t hi)
+{
+	return int32_t(uint32_t(uint16_t(lo))|(uint32_t(uint16_t(hi))<<16));
+}
+
+inline void yuvToBGRAScalar(const uint8_t* yrow, const uint8_t* urow, const uint8_t* vrow, const uint8_t* arow, uint8_t* outrow, uint32_t first, uint32_t last)
+{
+	for(uint32_t j=first;j<last;j++)
+	{
+		int32_t c=int32_t(yrow[j])-16;
+		int32_t d=int32_t(urow[j/2])-128;
+		int32_t e=int32_t(vrow[j/2])-128;
+		int32_t alpha=arow ? arow[j] : 0xff;
+		int32_t rgb[3]={(298*c+516*d+128)>>8, (298*c-100*d-208*e+128)>>8, (298*c+409*e+128)>>8};
+		for(int k=0;k<3;k++)
+		{
+			int32_t x=std::min(std::max(rgb[k],0),255);
+			int32_t t=x*alpha+128;
+			outrow[j*4+k]=(t+(t>>8))>>8;
+		}
+		outrow[j*4+3]=alpha;
+	}
+}
+
+//Computes 4 channel values as 16 bit integers clamped to [0,255], premultiplied by alpha if needed
+template<bool hasAlpha>
+__attribute__((target("sse2"))) inline __m128i yuvChannelSSE2(__m128i cyLo, __m128i cyHi, __m128i deLo, __m128i deHi, __m128i coeff, __m128i alpha)
+{
+	__m128i lo=_mm_srai_epi32(_mm_add_epi32(cyLo,_mm_madd_epi16(deLo,coeff)),8);
+	__m128i hi=_mm_srai_epi32(_mm_add_epi32(cyHi,_mm_madd_epi16(deHi,coeff)),8);
+	__m128i x=_mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(lo,hi),_mm_setzero_si128()),_mm_set1_epi16(255));
+	if(hasAlpha)
+	{
+		//Exact division by 255 with rounding, the sums fit in unsigned 16 bit
+		__m128i t=_mm_add_epi16(_mm_mullo_epi16(x,alpha),_mm_set1_epi16(128));
+		x=_mm_srli_epi16(_mm_add_epi16(t,_mm_srli_epi16(t,8)),8);
+	}
+	return x;
+}
+
+template<bool hasAlpha>
+__attribute__((target("sse2"))) uint32_t yuvRowToBGRASSE2(const uint8_t* yrow, const uint8_t* urow, const uint8_t* vrow, const uint8_t* arow, uint8_t* outrow, uint32_t width)
+{
+	const __m128i zero=_mm_setzero_si128();
+	const __m128i lumaCoeff=_mm_set1_epi32(pair16(298,128));
+	const __m128i rCoeff=_mm_set1_epi32(pair16(0,409));
+	const __m128i gCoeff=_mm_set1_epi32(pair16(-100,-208));
+	const __m128i bCoeff=_mm_set1_epi32(pair16(516,0));
+	uint32_t j=0;
+	for(;j+8<=width;j+=8)
+	{
+		int32_t u4,v4;
+		memcpy(&u4,urow+j/2,4);
+		memcpy(&v4,vrow+j/2,4);
+		__m128i c=_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(yrow+j)),zero),_mm_set1_epi16(16));
+		__m128i u=_mm_unpacklo_epi8(_mm_cvtsi32_si128(u4),zero);
+		__m128i v=_mm_unpacklo_epi8(_mm_cvtsi32_si128(v4),zero);
+		__m128i d=_mm_sub_epi16(_mm_unpacklo_epi16(u,u),_mm_set1_epi16(128));
+		__m128i e=_mm_sub_epi16(_mm_unpacklo_epi16(v,v),_mm_set1_epi16(128));
+		__m128i cyLo=_mm_madd_epi16(_mm_unpacklo_epi16(c,_mm_set1_epi16(1)),lumaCoeff);
+		__m128i cyHi=_mm_madd_epi16(_mm_unpackhi_epi16(c,_mm_set1_epi16(1)),lumaCoeff);
+		__m128i deLo=_mm_unpacklo_epi16(d,e);
+		__m128i deHi=_mm_unpackhi_epi16(d,e);
+		__m128i a=hasAlpha ? _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(arow+j)),zero) : _mm_set1_epi16(255);
+		__m128i r=yuvChannelSSE2<hasAlpha>(cyLo,cyHi,deLo,deHi,rCoeff,a);
+		__m128i g=yuvChannelSSE2<hasAlpha>(cyLo,cyHi,deLo,deHi,gCoeff,a);
+		__m128i b=yuvChannelSSE2<hasAlpha>(cyLo,cyHi,deLo,deHi,bCoeff,a);
+		__m128i bg=_mm_or_si128(b,_mm_slli_epi16(g,8));
+		__m128i ra=_mm_or_si128(r,_mm_slli_epi16(a,8));
+		_mm_storeu_si128((__m128i*)(outrow+j*4),_mm_unpacklo_epi16(bg,ra));
+		_mm_storeu_si128((__m128i*)(outrow+j*4+16),_mm_unpackhi_epi16(bg,ra));
+	}
+	return j;
+}
+
+template<bool hasAlpha>
+__attribute__((target("avx2"))) inline __m256i yuvChannelAVX2(__m256i cyLo, __m256i cyHi, __m256i deLo, __m256i deHi, __m256i coeff, __m256i alpha)
+{
+	__m256i lo=_mm256_srai_epi32(_mm256_add_epi32(cyLo,_mm256_madd_epi16(deLo,coeff)),8);
+	__m256i hi=_mm256_srai_epi32(_mm256_add_epi32(cyHi,_mm256_madd_epi16(deHi,coeff)),8);
+	//The unpacks and the pack all work inside 128 bit lanes, so the pixel order is preserved
+	__m256i x=_mm256_min_epi16(_mm256_max_epi16(_mm256_packs_epi32(lo,hi),_mm256_setzero_si256()),_mm256_set1_epi16(255));
+	if(hasAlpha)
+	{
+		__m256i t=_mm256_add_epi16(_mm256_mullo_epi16(x,alpha),_mm256_set1_epi16(128));
+		x=_mm256_srli_epi16(_mm256_add_epi16(t,_mm256_srli_epi16(t,8)),8);
+	}
+	return x;
+}
+
+__attribute__((target("avx2"))) inline __m256i loadChromaAVX2(const uint8_t* p)
+{
+	__m128i c=_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)p));
+	//Every chroma sample covers two horizontal pixels
+	__m256i dup=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(c,c)),_mm_unpackhi_epi16(c,c),1);
+	return _mm256_sub_epi16(dup,_mm256_set1_epi16(128));
+}
+
+template<bool hasAlpha>
+__attribute__((target("avx2"))) uint32_t yuvRowToBGRAAVX2(const uint8_t* yrow, const uint8_t* urow, const uint8_t* vrow, const uint8_t* arow, uint8_t* outrow, uint32_t width)
+{
+	const __m256i one=_mm256_set1_epi16(1);
+	const __m256i lumaCoeff=_mm256_set1_epi32(pair16(298,128));
+	const __m256i rCoeff=_mm256_set1_epi32(pair16(0,409));
+	const __m256i gCoeff=_mm256_set1_epi32(pair16(-100,-208));
+	const __m256i bCoeff=_mm256_set1_epi32(pair16(516,0));
+	uint32_t j=0;
+	for(;j+16<=width;j+=16)
+	{
+		__m256i c=_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(yrow+j))),_mm256_set1_epi16(16));
+		__m256i d=loadChromaAVX2(urow+j/2);
+		__m256i e=loadChromaAVX2(vrow+j/2);
+		__m256i cyLo=_mm256_madd_epi16(_mm256_unpacklo_epi16(c,one),lumaCoeff);
+		__m256i cyHi=_mm256_madd_epi16(_mm256_unpackhi_epi16(c,one),lumaCoeff);
+		__m256i deLo=_mm256_unpacklo_epi16(d,e);
+		__m256i deHi=_mm256_unpackhi_epi16(d,e);
+		__m256i a=hasAlpha ? _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(arow+j))) : _mm256_set1_epi16(255);
+		__m256i r=yuvChannelAVX2<hasAlpha>(cyLo,cyHi,deLo,deHi,rCoeff,a);
+		__m256i g=yuvChannelAVX2<hasAlpha>(cyLo,cyHi,deLo,deHi,gCoeff,a);
+		__m256i b=yuvChannelAVX2<hasAlpha>(cyLo,cyHi,deLo,deHi,bCoeff,a);
+		__m256i bg=_mm256_or_si256(b,_mm256_slli_epi16(g,8));
+		__m256i ra=_mm256_or_si256(r,_mm256_slli_epi16(a,8));
+		__m256i lo=_mm256_unpacklo_epi16(bg,ra);
+		__m256i hi=_mm256_unpackhi_epi16(bg,ra);
+		_mm256_storeu_si256((__m256i*)(outrow+j*4),_mm256_permute2x128_si256(lo,hi,0x20));
+		_mm256_storeu_si256((__m256i*)(outrow+j*4+32),_mm256_permute2x128_si256(lo,hi,0x31));
+	}
+	return j;
+}
+
+__attribute__((target("sse2"))) uint32_t mixStereoSSE2(float* dest, const float* src, uint32_t frames, float left, float right)
+{
+	const __m128 gain=_mm_setr_ps(left,right,left,right);
+	uint32_t i=0;
+	for(;i+2<=frames;i+=2)
+		_mm_storeu_ps(dest+i*2,_mm_add_ps(_mm_loadu_ps(dest+i*2),_mm_mul_ps(_mm_loadu_ps(src+i*2),gain)));
+	return i;
+}
+
+__attribute__((target("avx2"))) uint32_t mixStereoAVX2(float* dest, const float* src, uint32_t frames, float left, float right)
+{
+	const __m256 gain=_mm256_setr_ps(left,right,left,right,left,right,left,right);
+	uint32_t i=0;
+	for(;i+4<=frames;i+=4)
+		_mm256_storeu_ps(dest+i*2,_mm256_add_ps(_mm256_loadu_ps(dest+i*2),_mm256_mul_ps(_mm256_loadu_ps(src+i*2),gain)));
+	return i;
+}
+
+//The resamplers advance pos past the produced frames
+__attribute__((target("sse2"))) uint32_t resampleStereoSSE2(const float* src, float* dest, uint32_t frames, uint64_t& pos, uint32_t step)
+{
+	//Two destination frames per iteration, each stereo frame is loaded as a 64 bit pair
+	const __m128 scale=_mm_set1_ps(1.0f/65536.0f);
+	uint32_t i=0;
+	for(;i+2<=frames;i+=2)
+	{
+		uint64_t pos1=pos+step;
+		const float* s0=src+(pos>>16)*2;
+		const float* s1=src+(pos1>>16)*2;
+		__m128 a=_mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64*)s0),(const __m64*)s1);
+		__m128 b=_mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64*)(s0+2)),(const __m64*)(s1+2));
+		__m128 f=_mm_mul_ps(_mm_setr_ps(pos&0xffff,pos&0xffff,pos1&0xffff,pos1&0xffff),scale);
+		_mm_storeu_ps(dest+i*2,_mm_add_ps(a,_mm_mul_ps(_mm_sub_ps(b,a),f)));
+		pos=pos1+step;
+	}
+	return i;
+}
+
+__attribute__((target("avx2"))) inline __m256 loadStereoPairs(const float* s0, const float* s1, const float* s2, const float* s3)
+{
+	__m128 lo=_mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64*)s0),(const __m64*)s1);
+	__m128 hi=_mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64*)s2),(const __m64*)s3);
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(lo),hi,1);
+}
+
+__attribute__((target("avx2"))) uint32_t resampleStereoAVX2(const float* src, float* dest, uint32_t frames, uint64_t& pos, uint32_t step)
+{
+	//Four destination frames per iteration
+	const __m256 scale=_mm256_set1_ps(1.0f/65536.0f);
+	uint32_t i=0;
+	for(;i+4<=frames;i+=4)
+	{
+		uint64_t pos1=pos+step;
+		uint64_t pos2=pos1+step;
+		uint64_t pos3=pos2+step;
+		const float* s0=src+(pos>>16)*2;
+		const float* s1=src+(pos1>>16)*2;
+		const float* s2=src+(pos2>>16)*2;
+		const float* s3=src+(pos3>>16)*2;
+		__m256 a=loadStereoPairs(s0,s1,s2,s3);
+		__m256 b=loadStereoPairs(s0+2,s1+2,s2+2,s3+2);
+		__m256 f=_mm256_mul_ps(_mm256_setr_ps(pos&0xffff,pos&0xffff,pos1&0xffff,pos1&0xffff,
+				pos2&0xffff,pos2&0xffff,pos3&0xffff,pos3&0xffff),scale);
+		_mm256_storeu_ps(dest+i*2,_mm256_add_ps(a,_mm256_mul_ps(_mm256_sub_ps(b,a),f)));
+		pos=pos3+step;
+	}
+	return i;
+}
+
+template<bool hasAlpha>
+void yuvToBGRA(const uint8_t* y, const uint8_t* u, const uint8_t* v, const uint8_t* a, uint8_t* out, uint32_t width, uint32_t height,
+		uint32_t yStride, uint32_t uvStride, uint32_t aStride, uint32_t outStride)
+{
+	bool avx2=hasAVX2();
+	for(uint32_t i=0;i<height;i++)
+	{
+		const uint8_t* yrow=y+i*yStride;
+		const uint8_t* urow=u+(i/2)*uvStride;
+		const uint8_t* vrow=v+(i/2)*uvStride;
+		const uint8_t* arow=hasAlpha ? a+i*aStride : nullptr;
+		uint8_t* outrow=out+i*outStride;
+		uint32_t j=0;
+		if(avx2)
+			j=yuvRowToBGRAAVX2<hasAlpha>(yrow,urow,vrow,arow,outrow,width);
+		j+=yuvRowToBGRASSE2<hasAlpha>(yrow+j,urow+j/2,vrow+j/2,hasAlpha ? arow+j : nullptr,outrow+j*4,width-j);
+		yuvToBGRAScalar(yrow,urow,vrow,arow,outrow,j,width);
+	}
+}
+
+}
+
+void lightspark::fastBlurRows(uint8_t* data, int32_t width, int32_t firstRow, int32_t lastRow, int32_t radius, int32_t mul, int32_t shift)
+{
+	blurRowsSSE2(data,width,firstRow,lastRow,radius,mul,shift);
+}
+
+void lightspark::fastBlurColumns(uint8_t* data, int32_t width, int32_t height, int32_t firstColumn, int32_t lastColumn, int32_t radius, int32_t mul, int32_t shift, bool lastIteration)
+{
+	int32_t x=firstColumn;
+	if(hasAVX2())
+	{
+		int32_t end=x+((lastColumn-x)&~7);
+		blurColumnsAVX2(data,width,height,x,end,radius,mul,shift,lastIteration);
+		x=end;
+	}
+	int32_t end=x+((lastColumn-x)&~3);
+	blurColumnsSSE2<4>(data,width,height,x,end,radius,mul,shift,lastIteration);
+	blurColumnsSSE2<1>(data,width,height,end,lastColumn,radius,mul,shift,lastIteration);
+}
+
+void lightspark::fastYUV420ToBGRA(const uint8_t* y, const uint8_t* u, const uint8_t* v, const uint8_t* a, uint8_t* out, uint32_t width, uint32_t height,
+		uint32_t yStride, uint32_t uvStride, uint32_t aStride, uint32_t outStride)
+{
+	if(a)
+		yuvToBGRA<true>(y,u,v,a,out,width,height,yStride,uvStride,aStride,outStride);
+	else
+		yuvToBGRA<false>(y,u,v,a,out,width,height,yStride,uvStride,aStride,outStride);
+}
+
+void lightspark::fastMixStereoF32(float* dest, const float* src, uint32_t frames, float left, float right)
+{
+	uint32_t i=0;
+	if(hasAVX2())
+		i=mixStereoAVX2(dest,src,frames,left,right);
+	i+=mixStereoSSE2(dest+i*2,src+i*2,frames-i,left,right);
+	for(;i<frames;i++)
+	{
+		dest[i*2]+=src[i*2]*left;
+		dest[i*2+1]+=src[i*2+1]*right;
+	}
+}
+
+uint64_t lightspark::fastResampleStereoF32(const float* src, float* dest, uint32_t frames, uint64_t pos, uint32_t step)
+{
+	uint32_t i=0;
+	if(hasAVX2())
+		i=resampleStereoAVX2(src,dest,frames,pos,step);
+	i+=resampleStereoSSE2(src,dest+i*2,frames-i,pos,step);
+	for(;i<frames;i++,pos+=step)
+	{
+		const float* s=src+(pos>>16)*2;
+		float f=(pos&0xffff)*(1.0f/65536.0f);
+		dest[i*2]=s[0]+(s[2]-s[0])*f;
+		dest[i*2+1]=s[1]+(s[3]-s[1])*f;
+	}
+	return pos;
+}
@@ -19,6 +19,8 @@
 
 #include "platforms/fastpaths.h"
 #include <inttypes.h>
+#include <algorithm>
+#include <vector>
 
 void lightspark::fastYUV420ChannelsToYUV0Buffer(uint8_t* y, uint8_t* u, uint8_t* v, uint8_t* out, uint32_t width, uint32_t height)
 {
@@ -37,3 +39,161 @@ void lightspark::fastYUV420ChannelsToYUV0Buffer(uint8_t* y, uint8_t* u, uint8_t*
 	}
 }
 
+void lightspark::fastYUV420ToBGRA(const uint8_t* y, const uint8_t* u, const uint8_t* v, const uint8_t* a, uint8_t* out, uint32_t width, uint32_t height,
+		uint32_t yStride, uint32_t uvStride, uint32_t aStride, uint32_t outStride)
+{
+	for(uint32_t i=0;i<height;i++)
+	{
+		const uint8_t* yrow=y+i*yStride;
+		const uint8_t* urow=u+(i/2)*uvStride;
+		const uint8_t* vrow=v+(i/2)*uvStride;
+		const uint8_t* arow=a ? a+i*aStride : nullptr;
+		uint8_t* outrow=out+i*outStride;
+		for(uint32_t j=0;j<width;j++)
+		{
+			int32_t c=int32_t(yrow[j])-16;
+			int32_t d=int32_t(urow[j/2])-128;
+			int32_t e=int32_t(vrow[j/2])-128;
+			int32_t alpha=arow ? arow[j] : 0xff;
+			int32_t rgb[3]={(298*c+516*d+128)>>8, (298*c-100*d-208*e+128)>>8, (298*c+409*e+128)>>8};
+			for(int k=0;k<3;k++)
+			{
+				int32_t x=std::min(std::max(rgb[k],0),255);
+				//Exact division by 255 with rounding
+				int32_t t=x*alpha+128;
+				outrow[j*4+k]=(t+(t>>8))>>8;
+			}
+			outrow[j*4+3]=alpha;
+		}
+	}
+}
+
+void lightspark::fastBlurRows(uint8_t* data, int32_t width, int32_t firstRow, int32_t lastRow, int32_t radius, int32_t mul, int32_t shift)
+{
+	int32_t div=radius*2+1;
+	int32_t w1=width-1;
+	std::vector<int32_t> stack(div*4);
+	for(int32_t row=firstRow;row<lastRow;row++)
+	{
+		uint8_t* px=data+row*width*4;
+		int32_t sum[4];
+		for(int c=0;c<4;c++)
+			sum[c]=(radius+1)*px[c];
+		//radius+2 entries of the stack are initialized with the first pixel, this matches the original stack blur
+		int32_t s=0;
+		for(int32_t i=0;i<radius+2;i++)
+		{
+			for(int c=0;c<4;c++)
+				stack[s*4+c]=px[c];
+			if(++s==div)
+				s=0;
+		}
+		for(int32_t i=1;i<=radius;i++)
+		{
+			uint8_t* p=px+std::min(i,w1)*4;
+			for(int c=0;c<4;c++)
+				sum[c]+=(stack[s*4+c]=p[c]);
+			if(++s==div)
+				s=0;
+		}
+		s=0;
+		for(int32_t x=0;x<width;x++)
+		{
+			for(int c=0;c<4;c++)
+				px[x*4+c]=uint32_t(sum[c]*mul)>>shift;
+			uint8_t* p=px+std::min(x+radius+1,w1)*4;
+			for(int c=0;c<4;c++)
+			{
+				sum[c]+=p[c]-stack[s*4+c];
+				stack[s*4+c]=p[c];
+			}
+			if(++s==div)
+				s=0;
+		}
+	}
+}
+
+//Blurs N adjacent columns at once, walking through the rows once for all of them is much more cache friendly
+template<int N>
+static void blurColumns(uint8_t* data, int32_t width, int32_t height, int32_t firstColumn, int32_t lastColumn, int32_t radius, int32_t mul, int32_t shift, bool lastIteration)
+{
+	int32_t div=radius*2+1;
+	int32_t h1=height-1;
+	int32_t stride=width*4;
+	std::vector<int32_t> stack(div*4*N);
+	for(int32_t x=firstColumn;x<lastColumn;x+=N)
+	{
+		uint8_t* px=data+x*4;
+		int32_t sum[4*N];
+		for(int c=0;c<4*N;c++)
+		{
+			sum[c]=(radius+1)*px[c];
+			for(int32_t i=0;i<radius+1;i++)
+				stack[i*4*N+c]=px[c];
+		}
+		int32_t s=radius+1;
+		int32_t yp=1;
+		for(int32_t i=1;i<=radius;i++)
+		{
+			uint8_t* p=px+yp*stride;
+			for(int c=0;c<4*N;c++)
+				sum[c]+=(stack[s*4*N+c]=p[c]);
+			if(++s==div)
+				s=0;
+			if(i<h1)
+				yp++;
+		}
+		s=0;
+		for(int32_t y=0;y<height;y++)
+		{
+			uint8_t* out=px+y*stride;
+			for(int j=0;j<N;j++)
+			{
+				uint32_t a=uint32_t(sum[j*4+3]*mul)>>shift;
+				out[j*4+3]=a;
+				for(int c=j*4;c<j*4+3;c++)
+				{
+					uint32_t v=a>0 ? uint32_t(sum[c]*mul)>>shift : 0;
+					out[c]=lastIteration && v>255 ? 255 : v;
+				}
+			}
+			uint8_t* p=px+std::min(y+radius+1,h1)*stride;
+			int32_t* st=&stack[s*4*N];
+			for(int c=0;c<4*N;c++)
+			{
+				sum[c]+=p[c]-st[c];
+				st[c]=p[c];
+			}
+			if(++s==div)
+				s=0;
+		}
+	}
+}
+
+void lightspark::fastBlurColumns(uint8_t* data, int32_t width, int32_t height, int32_t firstColumn, int32_t lastColumn, int32_t radius, int32_t mul, int32_t shift, bool lastIteration)
+{
+	int32_t end=firstColumn+((lastColumn-firstColumn)&~3);
+	blurColumns<4>(data,width,height,firstColumn,end,radius,mul,shift,lastIteration);
+	blurColumns<1>(data,width,height,end,lastColumn,radius,mul,shift,lastIteration);
+}
+
+void lightspark::fastMixStereoF32(float* dest, const float* src, uint32_t frames, float left, float right)
+{
+	for(uint32_t i=0;i<frames;i++)
+	{
+		dest[i*2]+=src[i*2]*left;
+		dest[i*2+1]+=src[i*2+1]*right;
+	}
+}
+
+uint64_t lightspark::fastResampleStereoF32(const float* src, float* dest, uint32_t frames, uint64_t pos, uint32_t step)
+{
+	for(uint32_t i=0;i<frames;i++,pos+=step)
+	{
+		const float* s=src+(pos>>16)*2;
+		float f=(pos&0xffff)*(1.0f/65536.0f);
+		dest[i*2]=s[0]+(s[2]-s[0])*f;
+		dest[i*2+1]=s[1]+(s[3]-s[1])*f;
+	}
+	return pos;
+}
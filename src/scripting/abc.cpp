@@ -815,7 +815,8 @@ int ABCVm::getEventQueueSize()
 
 void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
 {
-	if (dispatcher && dispatcher->is<DisplayObject>() && event->type == "enterFrame" && (
+	uint32_t eventId = event->getSystemState()->getUniqueStringId(event->type);
+	if (dispatcher && dispatcher->is<DisplayObject>() && eventId == BUILTIN_STRINGS::STRING_ENTERFRAME && (
 				(dispatcher->is<RootMovieClip>() && dispatcher->as<RootMovieClip>()->isWaitingForParser()) || // RootMovieClip is not yet completely parsed
 				(dispatcher->as<DisplayObject>()->legacy && !dispatcher->as<DisplayObject>()->isOnStage()))) // it seems that enterFrame event is only executed for DisplayObjects that are on stage or added from ActionScript
 		return;
@@ -844,8 +845,9 @@ void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
 	*/
 	//This is to take care of rollOver/Out
 	bool doTarget = true;
-	//capture phase
-	if(dispatcher->classdef && dispatcher->classdef->isSubClass(Class<DisplayObject>::getClass(dispatcher->getSystemState())))
+	//capture phase, frame events are only dispatched to their target
+	bool isFrameEvent = eventId >= BUILTIN_STRINGS::STRING_ENTERFRAME && eventId <= BUILTIN_STRINGS::STRING_RENDER;
+	if(!isFrameEvent && dispatcher->classdef && dispatcher->classdef->isSubClass(Class<DisplayObject>::getClass(dispatcher->getSystemState())))
 	{
 		event->eventPhase = EventPhase::CAPTURING_PHASE;
 		//We fetch the relatedObject in the case of rollOver/Out
@@ -922,7 +924,7 @@ void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
 				break;
 			(*i)->incRef();
 			event->currentTarget=_MNR(*i);
-			(*i)->handleEvent(event);
+			(*i)->handleEvent(event,eventId);
 			event->currentTarget=NullRef;
 		}
 	}
@@ -935,7 +937,7 @@ void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
 		{
 			dispatcher->incRef();
 			event->currentTarget=_MNR(dispatcher);
-			dispatcher->handleEvent(event);
+			dispatcher->handleEvent(event,eventId);
 			event->currentTarget=NullRef;
 		}
 	}
@@ -951,7 +953,7 @@ void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
 				break;
 			(*i)->incRef();
 			event->currentTarget=_MNR(*i);
-			(*i)->handleEvent(event);
+			(*i)->handleEvent(event,eventId);
 			event->currentTarget=NullRef;
 		}
 	}
@@ -960,7 +962,7 @@ void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
 	{
 		dispatcher->getSystemState()->stage->incRef();
 		event->currentTarget=_MR(dispatcher->getSystemState()->stage);
-		dispatcher->getSystemState()->stage->handleEvent(event);
+		dispatcher->getSystemState()->stage->handleEvent(event,eventId);
 		event->currentTarget=NullRef;
 		if(!event->defaultPrevented)
 			dispatcher->getSystemState()->stage->defaultEventBehavior(event);
@@ -308,6 +308,30 @@ public:
 struct BasicBlock;
 struct InferenceData;
 
+/*
+ * Low overhead sampling profiler for the interpreter, usable in release builds.
+ * A tick job requests a sample at regular intervals, the interpreter loop checks
+ * the request and records the AS3 call stack of the current worker, followed by
+ * the position of exec_pos in the code of the innermost function as "@offset".
+ * The stacks are written in the folded format used by flamegraph.pl
+ */
+class SamplingProfiler: public ITickJob
+{
+private:
+	Mutex mutex;
+	std::map<std::string,uint64_t> stacks;
+	uint64_t samplecount;
+	void addSample(call_context* context);
+public:
+	SamplingProfiler():samplecount(0) {}
+	// set by the tick job, checked by the interpreter before every instruction
+	static ACQUIRE_RELEASE_FLAG(sampleRequested);
+	static void takeSample(call_context* context);
+	void tick() override;
+	void tickFence() override {}
+	void save(const tiny_string& filename);
+};
+
 class ABCVm
 {
 friend class ABCContext;
@@ -1334,6 +1358,90 @@ private:
 	static void abc_getfuncscopeobject(call_context* context);
 	static void abc_getfuncscopeobject_localresult(call_context* context);
 
+	// type specialized opcodes for int (_ii) and Number (_dd) operands
+	static void abc_iflt_ii_constant_constant(call_context* context);
+	static void abc_iflt_ii_local_constant(call_context* context);
+	static void abc_iflt_ii_constant_local(call_context* context);
+	static void abc_iflt_ii_local_local(call_context* context);
+	static void abc_ifle_ii_constant_constant(call_context* context);
+	static void abc_ifle_ii_local_constant(call_context* context);
+	static void abc_ifle_ii_constant_local(call_context* context);
+	static void abc_ifle_ii_local_local(call_context* context);
+	static void abc_ifgt_ii_constant_constant(call_context* context);
+	static void abc_ifgt_ii_local_constant(call_context* context);
+	static void abc_ifgt_ii_constant_local(call_context* context);
+	static void abc_ifgt_ii_local_local(call_context* context);
+	static void abc_ifge_ii_constant_constant(call_context* context);
+	static void abc_ifge_ii_local_constant(call_context* context);
+	static void abc_ifge_ii_constant_local(call_context* context);
+	static void abc_ifge_ii_local_local(call_context* context);
+	static void abc_iflt_dd_constant_constant(call_context* context);
+	static void abc_iflt_dd_local_constant(call_context* context);
+	static void abc_iflt_dd_constant_local(call_context* context);
+	static void abc_iflt_dd_local_local(call_context* context);
+	static void abc_ifle_dd_constant_constant(call_context* context);
+	static void abc_ifle_dd_local_constant(call_context* context);
+	static void abc_ifle_dd_constant_local(call_context* context);
+	static void abc_ifle_dd_local_local(call_context* context);
+	static void abc_ifgt_dd_constant_constant(call_context* context);
+	static void abc_ifgt_dd_local_constant(call_context* context);
+	static void abc_ifgt_dd_constant_local(call_context* context);
+	static void abc_ifgt_dd_local_local(call_context* context);
+	static void abc_ifge_dd_constant_constant(call_context* context);
+	static void abc_ifge_dd_local_constant(call_context* context);
+	static void abc_ifge_dd_constant_local(call_context* context);
+	static void abc_ifge_dd_local_local(call_context* context);
+	static void abc_ifnlt_dd_constant_constant(call_context* context);
+	static void abc_ifnlt_dd_local_constant(call_context* context);
+	static void abc_ifnlt_dd_constant_local(call_context* context);
+	static void abc_ifnlt_dd_local_local(call_context* context);
+	static void abc_ifnle_dd_constant_constant(call_context* context);
+	static void abc_ifnle_dd_local_constant(call_context* context);
+	static void abc_ifnle_dd_constant_local(call_context* context);
+	static void abc_ifnle_dd_local_local(call_context* context);
+	static void abc_ifngt_dd_constant_constant(call_context* context);
+	static void abc_ifngt_dd_local_constant(call_context* context);
+	static void abc_ifngt_dd_constant_local(call_context* context);
+	static void abc_ifngt_dd_local_local(call_context* context);
+	static void abc_ifnge_dd_constant_constant(call_context* context);
+	static void abc_ifnge_dd_local_constant(call_context* context);
+	static void abc_ifnge_dd_constant_local(call_context* context);
+	static void abc_ifnge_dd_local_local(call_context* context);
+	static void abc_lessthan_ii_constant_constant_localresult(call_context* context);
+	static void abc_lessthan_ii_local_constant_localresult(call_context* context);
+	static void abc_lessthan_ii_constant_local_localresult(call_context* context);
+	static void abc_lessthan_ii_local_local_localresult(call_context* context);
+	static void abc_lessthan_dd_constant_constant_localresult(call_context* context);
+	static void abc_lessthan_dd_local_constant_localresult(call_context* context);
+	static void abc_lessthan_dd_constant_local_localresult(call_context* context);
+	static void abc_lessthan_dd_local_local_localresult(call_context* context);
+	static void abc_add_ii_constant_constant_localresult(call_context* context);
+	static void abc_add_ii_local_constant_localresult(call_context* context);
+	static void abc_add_ii_constant_local_localresult(call_context* context);
+	static void abc_add_ii_local_local_localresult(call_context* context);
+	static void abc_subtract_ii_constant_constant_localresult(call_context* context);
+	static void abc_subtract_ii_local_constant_localresult(call_context* context);
+	static void abc_subtract_ii_constant_local_localresult(call_context* context);
+	static void abc_subtract_ii_local_local_localresult(call_context* context);
+	static void abc_multiply_ii_constant_constant_localresult(call_context* context);
+	static void abc_multiply_ii_local_constant_localresult(call_context* context);
+	static void abc_multiply_ii_constant_local_localresult(call_context* context);
+	static void abc_multiply_ii_local_local_localresult(call_context* context);
+	static void abc_add_dd_constant_constant_localresult(call_context* context);
+	static void abc_add_dd_local_constant_localresult(call_context* context);
+	static void abc_add_dd_constant_local_localresult(call_context* context);
+	static void abc_add_dd_local_local_localresult(call_context* context);
+	static void abc_subtract_dd_constant_constant_localresult(call_context* context);
+	static void abc_subtract_dd_local_constant_localresult(call_context* context);
+	static void abc_subtract_dd_constant_local_localresult(call_context* context);
+	static void abc_subtract_dd_local_local_localresult(call_context* context);
+	static void abc_multiply_dd_constant_constant_localresult(call_context* context);
+	static void abc_multiply_dd_local_constant_localresult(call_context* context);
+	static void abc_multiply_dd_constant_local_localresult(call_context* context);
+	static void abc_multiply_dd_local_local_localresult(call_context* context);
+	static void abc_inclocal_ii(call_context* context);
+	static void abc_declocal_ii(call_context* context);
+
 	static void abc_invalidinstruction(call_context* context);
 
 public:
@@ -1372,6 +1480,9 @@ public:
 	static void clearOpcodeCounters();
 	
 	static void preloadFunction(SyntheticFunction *function,ASWorker* wrk);
+	// baseline jit, returns false if the method can't be compiled and has to be interpreted
+	static bool jitFunction(method_info* mi);
+	static void releaseJitFunction(method_body_info* body);
 	static ASObject* executeFunctionFast(const SyntheticFunction* function, call_context* context, ASObject *caller);
 	static void optimizeFunction(SyntheticFunction* function);
 	static void verifyBranch(std::set<uint32_t>& pendingBlock,std::map<uint32_t,BasicBlock>& basicBlocks,
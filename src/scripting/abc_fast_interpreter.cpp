@@ -73,6 +73,8 @@ ASObject* ABCVm::executeFunctionFast(const SyntheticFunction* function, call_con
 		uint8_t opcode=code[instructionPointer];
 		//Save ip for exception handling in SyntheticFunction::callImpl
 		context->exec_pos = mi->body->preloadedcode.data()+instructionPointer;
+		if (USUALLY_FALSE(ACQUIRE_READ(SamplingProfiler::sampleRequested)))
+			SamplingProfiler::takeSample(context);
 		instructionPointer++;
 		const OpcodeData* data=reinterpret_cast<const OpcodeData*>(code+instructionPointer);
 
@@ -139,6 +139,8 @@ void ABCVm::executeFunction(call_context* context)
 		uint32_t c = opcodecounter[context->exec_pos->func];
 		opcodecounter[context->exec_pos->func] = c+1;
 #endif
+		if (USUALLY_FALSE(ACQUIRE_READ(SamplingProfiler::sampleRequested)))
+			SamplingProfiler::takeSample(context);
 		// context->exec_pos points to the current instruction, every abc_function has to make sure
 		// it points to the next valid instruction after execution
 		context->exec_pos->func(context);
@@ -1098,6 +1100,99 @@ abc_function ABCVm::abcfunctions[]={
 	abc_sxi16_constant_localresult,
 	abc_sxi16_local_localresult,
 
+	abc_iflt_ii_constant_constant, // 0x378 ABC_OP_OPTIMZED_IFLT_II
+	abc_iflt_ii_local_constant,
+	abc_iflt_ii_constant_local,
+	abc_iflt_ii_local_local,
+	abc_ifle_ii_constant_constant, // 0x37c ABC_OP_OPTIMZED_IFLE_II
+	abc_ifle_ii_local_constant,
+	abc_ifle_ii_constant_local,
+	abc_ifle_ii_local_local,
+	abc_ifgt_ii_constant_constant, // 0x380 ABC_OP_OPTIMZED_IFGT_II
+	abc_ifgt_ii_local_constant,
+	abc_ifgt_ii_constant_local,
+	abc_ifgt_ii_local_local,
+	abc_ifge_ii_constant_constant, // 0x384 ABC_OP_OPTIMZED_IFGE_II
+	abc_ifge_ii_local_constant,
+	abc_ifge_ii_constant_local,
+	abc_ifge_ii_local_local,
+
+	abc_iflt_dd_constant_constant, // 0x388 ABC_OP_OPTIMZED_IFLT_DD
+	abc_iflt_dd_local_constant,
+	abc_iflt_dd_constant_local,
+	abc_iflt_dd_local_local,
+	abc_ifle_dd_constant_constant, // 0x38c ABC_OP_OPTIMZED_IFLE_DD
+	abc_ifle_dd_local_constant,
+	abc_ifle_dd_constant_local,
+	abc_ifle_dd_local_local,
+	abc_ifgt_dd_constant_constant, // 0x390 ABC_OP_OPTIMZED_IFGT_DD
+	abc_ifgt_dd_local_constant,
+	abc_ifgt_dd_constant_local,
+	abc_ifgt_dd_local_local,
+	abc_ifge_dd_constant_constant, // 0x394 ABC_OP_OPTIMZED_IFGE_DD
+	abc_ifge_dd_local_constant,
+	abc_ifge_dd_constant_local,
+	abc_ifge_dd_local_local,
+	abc_ifnlt_dd_constant_constant, // 0x398 ABC_OP_OPTIMZED_IFNLT_DD
+	abc_ifnlt_dd_local_constant,
+	abc_ifnlt_dd_constant_local,
+	abc_ifnlt_dd_local_local,
+	abc_ifnle_dd_constant_constant, // 0x39c ABC_OP_OPTIMZED_IFNLE_DD
+	abc_ifnle_dd_local_constant,
+	abc_ifnle_dd_constant_local,
+	abc_ifnle_dd_local_local,
+	abc_ifngt_dd_constant_constant, // 0x3a0 ABC_OP_OPTIMZED_IFNGT_DD
+	abc_ifngt_dd_local_constant,
+	abc_ifngt_dd_constant_local,
+	abc_ifngt_dd_local_local,
+	abc_ifnge_dd_constant_constant, // 0x3a4 ABC_OP_OPTIMZED_IFNGE_DD
+	abc_ifnge_dd_local_constant,
+	abc_ifnge_dd_constant_local,
+	abc_ifnge_dd_local_local,
+
+	abc_lessthan_ii_constant_constant_localresult, // 0x3a8 ABC_OP_OPTIMZED_LESSTHAN_II
+	abc_lessthan_ii_local_constant_localresult,
+	abc_lessthan_ii_constant_local_localresult,
+	abc_lessthan_ii_local_local_localresult,
+	abc_lessthan_dd_constant_constant_localresult, // 0x3ac ABC_OP_OPTIMZED_LESSTHAN_DD
+	abc_lessthan_dd_local_constant_localresult,
+	abc_lessthan_dd_constant_local_localresult,
+	abc_lessthan_dd_local_local_localresult,
+
+	abc_add_ii_constant_constant_localresult, // 0x3b0 ABC_OP_OPTIMZED_ADD_II
+	abc_add_ii_local_constant_localresult,
+	abc_add_ii_constant_local_localresult,
+	abc_add_ii_local_local_localresult,
+	abc_subtract_ii_constant_constant_localresult, // 0x3b4 ABC_OP_OPTIMZED_SUBTRACT_II
+	abc_subtract_ii_local_constant_localresult,
+	abc_subtract_ii_constant_local_localresult,
+	abc_subtract_ii_local_local_localresult,
+	abc_multiply_ii_constant_constant_localresult, // 0x3b8 ABC_OP_OPTIMZED_MULTIPLY_II
+	abc_multiply_ii_local_constant_localresult,
+	abc_multiply_ii_constant_local_localresult,
+	abc_multiply_ii_local_local_localresult,
+	abc_add_dd_constant_constant_localresult, // 0x3bc ABC_OP_OPTIMZED_ADD_DD
+	abc_add_dd_local_constant_localresult,
+	abc_add_dd_constant_local_localresult,
+	abc_add_dd_local_local_localresult,
+	abc_subtract_dd_constant_constant_localresult, // 0x3c0 ABC_OP_OPTIMZED_SUBTRACT_DD
+	abc_subtract_dd_local_constant_localresult,
+	abc_subtract_dd_constant_local_localresult,
+	abc_subtract_dd_local_local_localresult,
+	abc_multiply_dd_constant_constant_localresult, // 0x3c4 ABC_OP_OPTIMZED_MULTIPLY_DD
+	abc_multiply_dd_local_constant_localresult,
+	abc_multiply_dd_constant_local_localresult,
+	abc_multiply_dd_local_local_localresult,
+
+	abc_inclocal_ii, // 0x3c8 ABC_OP_OPTIMZED_INCLOCAL_II
+	abc_declocal_ii, // 0x3c9 ABC_OP_OPTIMZED_DECLOCAL_II
+
+	abc_invalidinstruction,
+	abc_invalidinstruction,
+	abc_invalidinstruction,
+	abc_invalidinstruction,
+	abc_invalidinstruction,
+	abc_invalidinstruction,
 	abc_invalidinstruction,
 	abc_invalidinstruction,
 	abc_invalidinstruction,
@@ -1118,7 +1213,10 @@ struct preloadedcodebuffer
 	bool cachedslot1;
 	bool cachedslot2;
 	bool cachedslot3;
-	preloadedcodebuffer(uint32_t d=0):pcode(),opcode(d),operator_start(d),operator_setslot(UINT32_MAX),cachedslot1(false),cachedslot2(false),cachedslot3(false){}
+	// both operands are known to be int (or numeric) values, so the opcode can be replaced by a type specialized version
+	bool intoperands;
+	bool numberoperands;
+	preloadedcodebuffer(uint32_t d=0):pcode(),opcode(d),operator_start(d),operator_setslot(UINT32_MAX),cachedslot1(false),cachedslot2(false),cachedslot3(false),intoperands(false),numberoperands(false){}
 };
 struct preloadstate
 {
@@ -1377,6 +1475,28 @@ struct operands
 #define ABC_OP_OPTIMZED_SXI1 0x0000036c
 #define ABC_OP_OPTIMZED_SXI8 0x00000370
 #define ABC_OP_OPTIMZED_SXI16 0x00000374
+#define ABC_OP_OPTIMZED_IFLT_II 0x00000378
+#define ABC_OP_OPTIMZED_IFLE_II 0x0000037c
+#define ABC_OP_OPTIMZED_IFGT_II 0x00000380
+#define ABC_OP_OPTIMZED_IFGE_II 0x00000384
+#define ABC_OP_OPTIMZED_IFLT_DD 0x00000388
+#define ABC_OP_OPTIMZED_IFLE_DD 0x0000038c
+#define ABC_OP_OPTIMZED_IFGT_DD 0x00000390
+#define ABC_OP_OPTIMZED_IFGE_DD 0x00000394
+#define ABC_OP_OPTIMZED_IFNLT_DD 0x00000398
+#define ABC_OP_OPTIMZED_IFNLE_DD 0x0000039c
+#define ABC_OP_OPTIMZED_IFNGT_DD 0x000003a0
+#define ABC_OP_OPTIMZED_IFNGE_DD 0x000003a4
+#define ABC_OP_OPTIMZED_LESSTHAN_II 0x000003a8
+#define ABC_OP_OPTIMZED_LESSTHAN_DD 0x000003ac
+#define ABC_OP_OPTIMZED_ADD_II 0x000003b0
+#define ABC_OP_OPTIMZED_SUBTRACT_II 0x000003b4
+#define ABC_OP_OPTIMZED_MULTIPLY_II 0x000003b8
+#define ABC_OP_OPTIMZED_ADD_DD 0x000003bc
+#define ABC_OP_OPTIMZED_SUBTRACT_DD 0x000003c0
+#define ABC_OP_OPTIMZED_MULTIPLY_DD 0x000003c4
+#define ABC_OP_OPTIMZED_INCLOCAL_II 0x000003c8
+#define ABC_OP_OPTIMZED_DECLOCAL_II 0x000003c9
 
 void skipjump(preloadstate& state,uint8_t& b,memorystream& code,uint32_t& pos,bool jumpInCode)
 {
@@ -2514,6 +2634,67 @@ bool setupInstructionOneArgumentNoResult(preloadstate& state,int operator_start,
 	}
 	return hasoperands;
 }
+void setTypedOperands(preloadstate& state,Class_base* op1type,Class_base* op2type)
+{
+	Class_base* c_int = Class<Integer>::getRef(state.mi->context->root->getSystemState()).getPtr();
+	Class_base* c_uint = Class<UInteger>::getRef(state.mi->context->root->getSystemState()).getPtr();
+	Class_base* c_number = Class<Number>::getRef(state.mi->context->root->getSystemState()).getPtr();
+	bool op1numeric = op1type == c_int || op1type == c_uint || op1type == c_number;
+	bool op2numeric = op2type == c_int || op2type == c_uint || op2type == c_number;
+#ifdef LIGHTSPARK_64
+	// int values are only guaranteed to be stored directly in the atom on 64bit systems
+	state.preloadedcode.back().intoperands = op1type == c_int && op2type == c_int;
+#endif
+	state.preloadedcode.back().numberoperands = op1numeric && op2numeric && (op1type == c_number || op2type == c_number);
+}
+uint32_t getTypedOpcode(const preloadedcodebuffer& buf)
+{
+	if (buf.intoperands)
+	{
+		switch (buf.opcode)
+		{
+			case ABC_OP_OPTIMZED_INCLOCAL_I:
+				return ABC_OP_OPTIMZED_INCLOCAL_II;
+			case ABC_OP_OPTIMZED_DECLOCAL_I:
+				return ABC_OP_OPTIMZED_DECLOCAL_II;
+		}
+	}
+	if (!buf.intoperands && !buf.numberoperands)
+		return buf.opcode;
+	// all specialized opcodes have the same order of operand variants as the generic opcodes
+	uint32_t variant = buf.opcode & 0x3;
+	switch (buf.opcode & ~0x3)
+	{
+		case ABC_OP_OPTIMZED_IFLT:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_IFLT_II : ABC_OP_OPTIMZED_IFLT_DD)+variant;
+		case ABC_OP_OPTIMZED_IFLE:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_IFLE_II : ABC_OP_OPTIMZED_IFLE_DD)+variant;
+		case ABC_OP_OPTIMZED_IFGT:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_IFGT_II : ABC_OP_OPTIMZED_IFGT_DD)+variant;
+		case ABC_OP_OPTIMZED_IFGE:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_IFGE_II : ABC_OP_OPTIMZED_IFGE_DD)+variant;
+		// the _ii opcodes fall back to the generic opcode they replace, so the negated comparisons
+		// can't reuse the reversed _ii opcodes, the _dd opcodes read int values directly, too
+		case ABC_OP_OPTIMZED_IFNLT:
+			return ABC_OP_OPTIMZED_IFNLT_DD+variant;
+		case ABC_OP_OPTIMZED_IFNLE:
+			return ABC_OP_OPTIMZED_IFNLE_DD+variant;
+		case ABC_OP_OPTIMZED_IFNGT:
+			return ABC_OP_OPTIMZED_IFNGT_DD+variant;
+		case ABC_OP_OPTIMZED_IFNGE:
+			return ABC_OP_OPTIMZED_IFNGE_DD+variant;
+		case ABC_OP_OPTIMZED_LESSTHAN+4:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_LESSTHAN_II : ABC_OP_OPTIMZED_LESSTHAN_DD)+variant;
+		case ABC_OP_OPTIMZED_ADD+4:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_ADD_II : ABC_OP_OPTIMZED_ADD_DD)+variant;
+		case ABC_OP_OPTIMZED_SUBTRACT+4:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_SUBTRACT_II : ABC_OP_OPTIMZED_SUBTRACT_DD)+variant;
+		case ABC_OP_OPTIMZED_MULTIPLY+4:
+			return (buf.intoperands ? ABC_OP_OPTIMZED_MULTIPLY_II : ABC_OP_OPTIMZED_MULTIPLY_DD)+variant;
+		default:
+			return buf.opcode;
+	}
+}
 bool setupInstructionTwoArgumentsNoResult(preloadstate& state,int operator_start,int opcode,memorystream& code)
 {
 	bool hasoperands = false;
@@ -2528,8 +2709,12 @@ bool setupInstructionTwoArgumentsNoResult(preloadstate& state,int operator_start
 		// optimized opcodes are in order CONSTANT/CONSTANT, LOCAL/CONSTANT, CONSTANT/LOCAL, LOCAL/LOCAL
 		state.preloadedcode.emplace_back();
 		(--it)->fillCode(state,1,state.preloadedcode.size()-1,true,&operator_start);
+		Class_base* op2type = it->objtype;
 		(--it)->fillCode(state,0,state.preloadedcode.size()-1,true,&operator_start);
+		Class_base* op1type = it->objtype;
 		state.preloadedcode.back().pcode.func = ABCVm::abcfunctions[operator_start];
+		state.preloadedcode.back().opcode = operator_start;
+		setTypedOperands(state,op1type,op2type);
 		state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 		state.operandlist.pop_back();
 		state.operandlist.pop_back();
@@ -2697,6 +2882,7 @@ bool setupInstructionTwoArguments(preloadstate& state,int operator_start,int opc
 		state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 		state.operandlist.pop_back();
 		state.operandlist.pop_back();
+		setTypedOperands(state,op1type,op2type);
 		switch (operator_start)
 		{
 			case ABC_OP_OPTIMZED_ADD:
@@ -3172,6 +3358,7 @@ void setupInstructionIncDecInteger(preloadstate& state,memorystream& code,std::v
 			state.preloadedcode.push_back(opcode == 0xc0 ? ABC_OP_OPTIMZED_INCLOCAL_I : ABC_OP_OPTIMZED_DECLOCAL_I); //inclocal_i/declocal_i
 			state.preloadedcode.back().pcode.arg1_uint = t;
 			state.preloadedcode.back().pcode.arg2_uint = 1;
+			setTypedOperands(state,state.operandlist.back().objtype,state.operandlist.back().objtype);
 			state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 			if (code.readbyte() == 0x63) //setlocal
 				code.readbyte();
@@ -4214,6 +4401,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					state.preloadedcode.push_back(ABC_OP_OPTIMZED_INCLOCAL_I);
 					state.preloadedcode.back().pcode.arg1_uint = t;
 					state.preloadedcode.back().pcode.arg2_uint = 1;
+					if (t < state.localtypes.size())
+						setTypedOperands(state,state.localtypes[t],state.localtypes[t]);
 					state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 					setOperandModified(state,OP_LOCAL,t);
 					clearOperands(state,true,&lastlocalresulttype);
@@ -4229,6 +4418,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					state.preloadedcode.push_back(ABC_OP_OPTIMZED_DECLOCAL_I);
 					state.preloadedcode.back().pcode.arg1_uint = t;
 					state.preloadedcode.back().pcode.arg2_uint = 1;
+					if (t < state.localtypes.size())
+						setTypedOperands(state,state.localtypes[t],state.localtypes[t]);
 					state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 					setOperandModified(state,OP_LOCAL,t);
 					clearOperands(state,true,&lastlocalresulttype);
@@ -7890,6 +8081,10 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 		mi->body->preloadedcode.push_back((*itc).pcode);
 		if (!mi->body->preloadedcode[mi->body->preloadedcode.size()-1].func)
 			mi->body->preloadedcode[mi->body->preloadedcode.size()-1].func = ABCVm::abcfunctions[itc->opcode];
+		// replace generic arithmetic and comparison opcodes with versions that skip all type checks for int/Number operands
+		uint32_t typedopcode = getTypedOpcode(*itc);
+		if (typedopcode != itc->opcode)
+			mi->body->preloadedcode[mi->body->preloadedcode.size()-1].func = ABCVm::abcfunctions[typedopcode];
 		// adjust cached local slots to localresultcount
 		if ((*itc).cachedslot1)
 			mi->body->preloadedcode[mi->body->preloadedcode.size()-1].local_pos1+= mi->body->getReturnValuePos()+1+mi->body->localresultcount;
@@ -7898,6 +8093,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 		if ((*itc).cachedslot3)
 			mi->body->preloadedcode[mi->body->preloadedcode.size()-1].local3.pos+= mi->body->getReturnValuePos()+1+mi->body->localresultcount;
 	}
+	mi->body->propertycaches.resize(mi->body->preloadedcode.size());
 	if (activationobject)
 		activationobject->decRef();
 }
@@ -0,0 +1,608 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+/*
+ * Baseline JIT for x86-64
+ *
+ * The preloaded code of a method is translated into a sequence of native calls to the
+ * abc_function of every instruction, so the dispatch loop of ABCVm::executeFunction is removed
+ * for straight-line code. After every call the generated code checks if the function
+ * returned or threw an exception and if exec_pos points to the next instruction.
+ * If exec_pos was changed (branches, instructions using more than one preloadedcodedata),
+ * the next instruction is found by an indirect jump through a table of all instructions.
+ * Unconditional jumps, nops, get/setlocal of primitive values and int and Number arithmetic
+ * with a local result are generated inline, with a call of the abc_function as slow path.
+ *
+ * The generated code keeps the call_context in rbx and the address of the return value in r12.
+ * Unwind information is registered for every method, so C++ exceptions can pass through the generated code.
+ */
+
+#include "scripting/abc.h"
+#include "scripting/abcutils.h"
+#include "scripting/toplevel/Number.h"
+#include "swf.h"
+#include <cstddef>
+#include <cstring>
+
+// the generated code uses the System V calling convention, instruction level profiling is not supported
+#if defined(__x86_64__) && defined(__linux__) && !defined(PROFILING_SUPPORT)
+#define LIGHTSPARK_BASELINE_JIT
+#endif
+
+#ifdef LIGHTSPARK_BASELINE_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+
+extern "C" void __register_frame(void*);
+extern "C" void __deregister_frame(void*);
+#endif
+
+using namespace std;
+using namespace lightspark;
+
+#ifdef LIGHTSPARK_BASELINE_JIT
+
+static_assert(sizeof(preloadedcodedata)==32, "the baseline jit expects preloadedcodedata to have a size of 32 bytes");
+static_assert(sizeof(asAtom)==8, "the baseline jit expects asAtom to have a size of 8 bytes");
+
+// methods with more instructions are not compiled
+#define JIT_MAX_INSTRUCTIONS 0x10000
+#define JIT_RDX 2
+
+namespace
+{
+class JitAssembler
+{
+public:
+	// special jump targets, all other targets are instruction indices
+	enum { LABEL_DISPATCH=-1, LABEL_EXIT=-2 };
+	vector<uint8_t> code;
+	// position of the rel32 and the jump target
+	vector<pair<uint32_t,int32_t>> fixups;
+	void emit(std::initializer_list<uint8_t> b)
+	{
+		code.insert(code.end(),b);
+	}
+	void imm32(int32_t v)
+	{
+		uint8_t b[4];
+		memcpy(b,&v,4);
+		code.insert(code.end(),b,b+4);
+	}
+	void imm64(uint64_t v)
+	{
+		uint8_t b[8];
+		memcpy(b,&v,8);
+		code.insert(code.end(),b,b+8);
+	}
+	void movRaxImm(uint64_t v) { emit({0x48,0xb8}); imm64(v); }
+	void movRcxImm(uint64_t v) { emit({0x48,0xb9}); imm64(v); }
+	// mov rax,[rbx+disp]
+	void movRaxFromContext(int32_t disp) { emit({0x48,0x8b,0x83}); imm32(disp); }
+	// mov [rbx+disp],rax
+	void movRaxToContext(int32_t disp) { emit({0x48,0x89,0x83}); imm32(disp); }
+	// cmp qword [rbx+disp],0
+	void cmpContextZero(int32_t disp) { emit({0x48,0x83,0xbb}); imm32(disp); emit({0x00}); }
+	// cmp qword [r12],0
+	void cmpReturnValueZero() { emit({0x49,0x83,0x3c,0x24,0x00}); }
+	void callFunction(uint64_t f)
+	{
+		emit({0x48,0x89,0xdf}); // mov rdi,rbx
+		movRaxImm(f);
+		emit({0xff,0xd0}); // call rax
+	}
+	void jump(uint8_t opcode, int32_t target)
+	{
+		if (opcode == 0xe9)
+			emit({0xe9});
+		else
+			emit({0x0f,opcode});
+		fixups.push_back(make_pair(code.size(),target));
+		imm32(0);
+	}
+	void jmp(int32_t target) { jump(0xe9,target); }
+	void jne(int32_t target) { jump(0x85,target); }
+	void jae(int32_t target) { jump(0x83,target); }
+	// jumps forward inside the code of an instruction, the target is set by bind()
+	size_t jumpForward(uint8_t opcode)
+	{
+		if (opcode == 0xe9)
+			emit({0xe9});
+		else
+			emit({0x0f,opcode});
+		imm32(0);
+		return code.size()-4;
+	}
+	size_t jmpForward() { return jumpForward(0xe9); }
+	size_t jeForward() { return jumpForward(0x84); }
+	size_t jneForward() { return jumpForward(0x85); }
+	void bind(size_t pos)
+	{
+		int32_t rel = code.size()-(pos+4);
+		memcpy(&code[pos],&rel,4);
+	}
+	// mov reg,[rbx+disp] and mov [rbx+disp],reg, reg is one of rax..rdi
+	void movRegFromContext(uint8_t reg, int32_t disp) { emit({0x48,0x8b,uint8_t(0x83|(reg<<3))}); imm32(disp); }
+	void movRegToContext(uint8_t reg, int32_t disp) { emit({0x48,0x89,uint8_t(0x83|(reg<<3))}); imm32(disp); }
+	// rcx = value of local pos (through localslots)
+	void loadLocalSlot(uint32_t pos)
+	{
+		movRaxFromContext(offsetof(call_context,localslots));
+		emit({0x48,0x8b,0x88}); imm32(pos*sizeof(asAtom*)); // mov rcx,[rax+disp]
+		emit({0x48,0x8b,0x09}); // mov rcx,[rcx]
+	}
+	// rcx = value of a constant atom
+	void loadConstant(const asAtom* c)
+	{
+		movRcxImm((uint64_t)c);
+		emit({0x48,0x8b,0x09}); // mov rcx,[rcx]
+	}
+	// jumps to the returned position if the atom in rcx is an object
+	size_t jumpIfObject()
+	{
+		emit({0xf6,0xc1,ATOMTYPE_OBJECT_BIT}); // test cl,ATOMTYPE_OBJECT_BIT
+		return jneForward();
+	}
+	// sets exec_pos to a constant instruction address
+	void setExecPos(const preloadedcodedata* p)
+	{
+		movRaxImm((uint64_t)p);
+		movRaxToContext(offsetof(call_context,exec_pos));
+	}
+	// leaves the generated code if the function returned or an exception was thrown
+	void checkExit()
+	{
+		cmpContextZero(offsetof(call_context,exceptionthrown));
+		jne(LABEL_EXIT);
+		cmpReturnValueZero();
+		jne(LABEL_EXIT);
+	}
+	// calls the abc_function of an instruction and continues with the next one if exec_pos points to it
+	void callInstruction(const preloadedcodedata* instr, const preloadedcodedata* next)
+	{
+		callFunction((uint64_t)instr->func);
+		checkExit();
+		movRaxFromContext(offsetof(call_context,exec_pos));
+		movRcxImm((uint64_t)next);
+		emit({0x48,0x39,0xc8}); // cmp rax,rcx
+		jne(LABEL_DISPATCH);
+	}
+};
+
+// stores the atom in rcx in local i if the old value is not an object and i is not the argument array
+void storeLocal(JitAssembler& a, uint32_t i, vector<size_t>& slow)
+{
+	a.movRaxFromContext(offsetof(call_context,locals));
+	a.emit({0xf6,0x80}); a.imm32(i*sizeof(asAtom)); a.emit({ATOMTYPE_OBJECT_BIT}); // test byte [rax+disp],ATOMTYPE_OBJECT_BIT
+	slow.push_back(a.jneForward());
+	a.emit({0x81,0xbb}); a.imm32(offsetof(call_context,argarrayposition)); a.imm32(i); // cmp dword [rbx+argarrayposition],i
+	slow.push_back(a.jeForward());
+	a.emit({0x48,0x89,0x88}); a.imm32(i*sizeof(asAtom)); // mov [rax+disp],rcx
+}
+
+// offset of the RefCountable part of an ASObject, ASObject has more than one base class
+int32_t refCountableOffset()
+{
+	// the pointer is only adjusted, never dereferenced
+	const uintptr_t p = 0x1000;
+	return int32_t(uintptr_t(static_cast<RefCountable*>(reinterpret_cast<ASObject*>(p)))-p);
+}
+
+// Number arithmetic done inline, the operands are locals (through localslots) or constants
+struct JitNumberOperation
+{
+	abc_function func;
+	uint8_t sseop; // second opcode byte of addsd/subsd/mulsd
+	bool local1;
+	bool local2;
+};
+
+// converts the atom in rcx to a double in xmm0 or xmm1, jumps to the slow path if it is not an int or float Number
+void loadNumberOperand(JitAssembler& a, uint8_t xmm, vector<size_t>& slow)
+{
+	a.emit({0x89,0xca}); // mov edx,ecx
+	a.emit({0x83,0xe2,0x07}); // and edx,7
+	a.emit({0x83,0xfa,ATOM_INTEGER}); // cmp edx,ATOM_INTEGER
+	size_t notint = a.jneForward();
+	a.emit({0x48,0xc1,0xf9,0x03}); // sar rcx,3
+	a.emit({0xf2,0x48,0x0f,0x2a,uint8_t(0xc1|(xmm<<3))}); // cvtsi2sd xmm,rcx
+	size_t done1 = a.jmpForward();
+	a.bind(notint);
+	a.emit({0x83,0xfa,ATOM_UINTEGER}); // cmp edx,ATOM_UINTEGER
+	size_t notuint = a.jneForward();
+	a.emit({0x48,0xc1,0xe9,0x03}); // shr rcx,3
+	a.emit({0xf2,0x48,0x0f,0x2a,uint8_t(0xc1|(xmm<<3))}); // cvtsi2sd xmm,rcx
+	size_t done2 = a.jmpForward();
+	a.bind(notuint);
+	a.emit({0x83,0xfa,ATOM_NUMBERPTR}); // cmp edx,ATOM_NUMBERPTR
+	slow.push_back(a.jneForward());
+	a.emit({0x48,0x83,0xe1,0xf8}); // and rcx,-8
+	a.emit({0x80,0xb9}); a.imm32(offsetof(Number,isfloat)); a.emit({0x00}); // cmp byte [rcx+isfloat],0
+	slow.push_back(a.jeForward());
+	a.emit({0xf2,0x0f,0x10,uint8_t(0x81|(xmm<<3))}); a.imm32(offsetof(Number,dval)); // movsd xmm,[rcx+dval]
+	a.bind(done1);
+	a.bind(done2);
+}
+
+// minimal .eh_frame content describing the constant stack frame of the generated code
+void writeUnwindInfo(vector<uint8_t>& out, uint64_t codestart, uint64_t codesize)
+{
+	auto u32 = [&out](uint32_t v) { uint8_t b[4]; memcpy(b,&v,4); out.insert(out.end(),b,b+4); };
+	auto u64 = [&out](uint64_t v) { uint8_t b[8]; memcpy(b,&v,8); out.insert(out.end(),b,b+8); };
+	auto pad = [&out](size_t start) { while ((out.size()-start)%8) out.push_back(0x00); /* DW_CFA_nop */ };
+	auto setlength = [&out](size_t start) { uint32_t len = out.size()-start-4; memcpy(&out[start],&len,4); };
+
+	// CIE
+	size_t ciestart = out.size();
+	u32(0);
+	u32(0); // CIE id
+	out.push_back(1); // version
+	out.insert(out.end(),{'z','R',0});
+	out.push_back(1); // code alignment
+	out.push_back(0x78); // data alignment -8
+	out.push_back(16); // return address register
+	out.push_back(1); // augmentation data length
+	out.push_back(0x00); // DW_EH_PE_absptr
+	out.insert(out.end(),{0x0c,0x07,0x08}); // DW_CFA_def_cfa rsp+8
+	out.insert(out.end(),{0x90,0x01}); // DW_CFA_offset rip,cfa-8
+	pad(ciestart);
+	setlength(ciestart);
+
+	// FDE, the prologue pushes rbx and r12 and reserves 8 bytes for stack alignment
+	// the unwinder only sees the generated code at call sites, so the state after the prologue is valid for the whole range
+	size_t fdestart = out.size();
+	u32(0);
+	u32(out.size()-ciestart); // CIE pointer
+	u64(codestart);
+	u64(codesize);
+	out.push_back(0); // augmentation data length
+	out.insert(out.end(),{0x0e,0x20}); // DW_CFA_def_cfa_offset 32
+	out.insert(out.end(),{0x83,0x02}); // DW_CFA_offset rbx,cfa-16
+	out.insert(out.end(),{0x8c,0x03}); // DW_CFA_offset r12,cfa-24
+	pad(fdestart);
+	setlength(fdestart);
+
+	u32(0); // terminator
+}
+}
+
+bool ABCVm::jitFunction(method_info* mi)
+{
+	method_body_info* body = mi->body;
+	if (body->jitcode || body->jitfailed)
+		return body->jitcode != nullptr;
+	body->jitfailed = true;
+	uint32_t count = body->preloadedcode.size();
+	if (count == 0 || count > JIT_MAX_INSTRUCTIONS)
+		return false;
+	const preloadedcodedata* base = body->preloadedcode.data();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (base[i].func == nullptr)
+			return false;
+	}
+
+	static const abc_function getlocalfuncs[4] = { abc_getlocal_0, abc_getlocal_1, abc_getlocal_2, abc_getlocal_3 };
+	static const abc_function setlocalfuncs[4] = { abc_setlocal_0, abc_setlocal_1, abc_setlocal_2, abc_setlocal_3 };
+	static const JitNumberOperation numberops[] = {
+		{ abc_add_dd_constant_constant_localresult, 0x58, false, false },
+		{ abc_add_dd_local_constant_localresult, 0x58, true, false },
+		{ abc_add_dd_constant_local_localresult, 0x58, false, true },
+		{ abc_add_dd_local_local_localresult, 0x58, true, true },
+		{ abc_subtract_dd_constant_constant_localresult, 0x5c, false, false },
+		{ abc_subtract_dd_local_constant_localresult, 0x5c, true, false },
+		{ abc_subtract_dd_constant_local_localresult, 0x5c, false, true },
+		{ abc_subtract_dd_local_local_localresult, 0x5c, true, true },
+		{ abc_multiply_dd_constant_constant_localresult, 0x59, false, false },
+		{ abc_multiply_dd_local_constant_localresult, 0x59, true, false },
+		{ abc_multiply_dd_constant_local_localresult, 0x59, false, true },
+		{ abc_multiply_dd_local_local_localresult, 0x59, true, true },
+	};
+	// the generated code checks isLastRef() of the result Number
+	const int32_t refcountoffset = refCountableOffset()+RefCountable::getRefCountOffset();
+	const int32_t constantoffset = refCountableOffset()+RefCountable::getConstantOffset();
+
+	JitAssembler a;
+	vector<uint32_t> blocks(count);
+	uint32_t labeldispatch;
+	uint32_t labelexit;
+	uint32_t labelsample;
+
+	// prologue
+	a.emit({0x53}); // push rbx
+	a.emit({0x41,0x54}); // push r12
+	a.emit({0x48,0x83,0xec,0x08}); // sub rsp,8
+	a.emit({0x48,0x89,0xfb}); // mov rbx,rdi
+	a.movRaxFromContext(offsetof(call_context,locals));
+	a.emit({0x4c,0x8d,0xa0}); // lea r12,[rax+disp]
+	a.imm32(body->getReturnValuePos()*sizeof(asAtom));
+	a.checkExit();
+	a.jmp(JitAssembler::LABEL_DISPATCH);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		blocks[i] = a.code.size();
+		const preloadedcodedata* instr = base+i;
+		const preloadedcodedata* next = base+i+1;
+		if (instr->func == abc_nop || instr->func == abc_label)
+		{
+			a.setExecPos(next);
+			continue;
+		}
+		if (instr->func == abc_jump && int64_t(i)+instr->arg3_int >= 0 && int64_t(i)+instr->arg3_int < count)
+		{
+			int32_t target = i+instr->arg3_int;
+			a.setExecPos(base+target);
+			// backwards jumps go through the dispatcher to let the sampling profiler see loops
+			a.jmp(target > int32_t(i) ? target : int32_t(JitAssembler::LABEL_DISPATCH));
+			continue;
+		}
+		if (instr->func == abc_add_i_local_local_localresult)
+		{
+			// fast path of abc_add_i_local_local_localresult for ints, falls back to the call if it fails
+			a.movRaxFromContext(offsetof(call_context,localslots));
+			a.emit({0x48,0x8b,0x88}); a.imm32(instr->local_pos1*sizeof(asAtom*)); // mov rcx,[rax+disp]
+			a.emit({0x48,0x8b,0x09}); // mov rcx,[rcx]
+			a.emit({0x48,0x8b,0x90}); a.imm32(instr->local_pos2*sizeof(asAtom*)); // mov rdx,[rax+disp]
+			a.emit({0x48,0x8b,0x12}); // mov rdx,[rdx]
+			a.emit({0x48,0x8b,0xb0}); a.imm32(instr->local3.pos*sizeof(asAtom*)); // mov rsi,[rax+disp]
+			a.emit({0x4c,0x8b,0x06}); // mov r8,[rsi]
+			a.emit({0x48,0x89,0xcf}); // mov rdi,rcx
+			a.emit({0x48,0x09,0xd7}); // or rdi,rdx
+			a.emit({0x49,0xb9}); a.imm64(0xc000000000000007ULL); // mov r9,imm64
+			a.emit({0x4c,0x21,0xcf}); // and rdi,r9
+			a.emit({0x48,0x83,0xff,ATOM_INTEGER}); // cmp rdi,ATOM_INTEGER
+			size_t slow1 = a.jneForward();
+			a.emit({0x49,0xf7,0xc0}); a.imm32(ATOMTYPE_OBJECT_BIT); // test r8,ATOMTYPE_OBJECT_BIT
+			size_t slow2 = a.jneForward();
+			a.emit({0x48,0x8d,0x4c,0x11,uint8_t(-ATOM_INTEGER)}); // lea rcx,[rcx+rdx-ATOM_INTEGER]
+			a.emit({0x48,0x89,0x0e}); // mov [rsi],rcx
+			a.setExecPos(next);
+			size_t fastend = a.jmpForward();
+			a.bind(slow1);
+			a.bind(slow2);
+			a.callInstruction(instr,next);
+			a.bind(fastend);
+			continue;
+		}
+		int32_t getlocal = -1;
+		if (instr->func == abc_getlocal)
+			getlocal = instr->arg3_uint;
+		for (uint32_t n = 0; n < 4; n++)
+		{
+			if (instr->func == getlocalfuncs[n])
+				getlocal = n;
+		}
+		if (getlocal >= 0)
+		{
+			// push a local that is not an object, no reference counting needed
+			a.movRaxFromContext(offsetof(call_context,locals));
+			a.emit({0x48,0x8b,0x88}); a.imm32(getlocal*sizeof(asAtom)); // mov rcx,[rax+disp]
+			size_t slow1 = a.jumpIfObject();
+			a.movRegFromContext(JIT_RDX,offsetof(call_context,stackp));
+			a.emit({0x48,0x3b,0x93}); a.imm32(offsetof(call_context,max_stackp)); // cmp rdx,[rbx+max_stackp]
+			size_t slow2 = a.jeForward();
+			a.emit({0x48,0x89,0x0a}); // mov [rdx],rcx
+			a.emit({0x48,0x83,0xc2,sizeof(asAtom)}); // add rdx,8
+			a.movRegToContext(JIT_RDX,offsetof(call_context,stackp));
+			a.setExecPos(next);
+			size_t fastend = a.jmpForward();
+			a.bind(slow1);
+			a.bind(slow2);
+			a.callInstruction(instr,next);
+			a.bind(fastend);
+			continue;
+		}
+		int32_t setlocal = -1;
+		if (instr->func == abc_setlocal)
+			setlocal = instr->arg3_uint;
+		for (uint32_t n = 0; n < 4; n++)
+		{
+			if (instr->func == setlocalfuncs[n])
+				setlocal = n;
+		}
+		if (setlocal >= 0 && setlocal < body->getReturnValuePos())
+		{
+			// pop into a local, only if neither the new nor the old value are objects
+			vector<size_t> slow;
+			a.movRegFromContext(JIT_RDX,offsetof(call_context,stackp));
+			a.emit({0x48,0x3b,0x93}); a.imm32(offsetof(call_context,stack)); // cmp rdx,[rbx+stack]
+			slow.push_back(a.jeForward());
+			a.emit({0x48,0x8b,0x4a,uint8_t(-int8_t(sizeof(asAtom)))}); // mov rcx,[rdx-8]
+			slow.push_back(a.jumpIfObject());
+			storeLocal(a,setlocal,slow);
+			a.emit({0x48,0x83,0xea,sizeof(asAtom)}); // sub rdx,8
+			a.movRegToContext(JIT_RDX,offsetof(call_context,stackp));
+			a.setExecPos(next);
+			size_t fastend = a.jmpForward();
+			for (auto it = slow.begin(); it != slow.end(); it++)
+				a.bind(*it);
+			a.callInstruction(instr,next);
+			a.bind(fastend);
+			continue;
+		}
+		if (instr->func == abc_setlocal_local || instr->func == abc_setlocal_constant)
+		{
+			vector<size_t> slow;
+			if (instr->func == abc_setlocal_local)
+				a.loadLocalSlot(instr->local_pos1);
+			else
+				a.loadConstant(instr->arg1_constant);
+			slow.push_back(a.jumpIfObject());
+			storeLocal(a,instr->arg3_uint,slow);
+			a.setExecPos(next);
+			size_t fastend = a.jmpForward();
+			for (auto it = slow.begin(); it != slow.end(); it++)
+				a.bind(*it);
+			a.callInstruction(instr,next);
+			a.bind(fastend);
+			continue;
+		}
+		const JitNumberOperation* numberop = nullptr;
+		for (uint32_t n = 0; n < sizeof(numberops)/sizeof(JitNumberOperation); n++)
+		{
+			if (instr->func == numberops[n].func)
+				numberop = numberops+n;
+		}
+		if (numberop && !(instr->local3.flags & ABC_OP_FORCEINT))
+		{
+			// Number arithmetic, the result is stored in place if the result local holds a Number that is not used elsewhere
+			vector<size_t> slow;
+			if (numberop->local1)
+				a.loadLocalSlot(instr->local_pos1);
+			else
+				a.loadConstant(instr->arg1_constant);
+			loadNumberOperand(a,0,slow);
+			if (numberop->local2)
+				a.loadLocalSlot(instr->local_pos2);
+			else
+				a.loadConstant(instr->arg2_constant);
+			loadNumberOperand(a,1,slow);
+			a.loadLocalSlot(instr->local3.pos);
+			a.emit({0x89,0xca}); // mov edx,ecx
+			a.emit({0x83,0xe2,0x07}); // and edx,7
+			a.emit({0x83,0xfa,ATOM_NUMBERPTR}); // cmp edx,ATOM_NUMBERPTR
+			slow.push_back(a.jneForward());
+			a.emit({0x48,0x83,0xe1,0xf8}); // and rcx,-8
+			a.emit({0x80,0xb9}); a.imm32(constantoffset); a.emit({0x00}); // cmp byte [rcx+isConstant],0
+			slow.push_back(a.jneForward());
+			a.emit({0x83,0xb9}); a.imm32(refcountoffset); a.emit({0x01}); // cmp dword [rcx+ref_count],1
+			slow.push_back(a.jneForward());
+			a.emit({0xf2,0x0f,numberop->sseop,0xc1}); // addsd/subsd/mulsd xmm0,xmm1
+			a.emit({0xf2,0x0f,0x11,0x81}); a.imm32(offsetof(Number,dval)); // movsd [rcx+dval],xmm0
+			a.emit({0xc6,0x81}); a.imm32(offsetof(Number,isfloat)); a.emit({0x01}); // mov byte [rcx+isfloat],1
+			a.setExecPos(next);
+			size_t fastend = a.jmpForward();
+			for (auto it = slow.begin(); it != slow.end(); it++)
+				a.bind(*it);
+			a.callInstruction(instr,next);
+			a.bind(fastend);
+			continue;
+		}
+		a.callInstruction(instr,next);
+	}
+	a.jmp(JitAssembler::LABEL_DISPATCH);
+
+	// dispatcher, jumps to the instruction at exec_pos
+	labeldispatch = a.code.size();
+	a.movRaxImm((uint64_t)&SamplingProfiler::sampleRequested);
+	a.emit({0x80,0x38,0x00}); // cmp byte [rax],0
+	size_t sample = a.code.size();
+	a.emit({0x75,0x00}); // jne sample
+	size_t dispatchnosample = a.code.size();
+	a.movRaxFromContext(offsetof(call_context,exec_pos));
+	a.movRcxImm((uint64_t)base);
+	a.emit({0x48,0x29,0xc8}); // sub rax,rcx
+	a.emit({0x48,0xc1,0xe8,0x05}); // shr rax,5
+	a.emit({0x48,0x3d}); a.imm32(count); // cmp rax,count
+	a.jae(JitAssembler::LABEL_EXIT);
+	size_t tableaddress = a.code.size()+2;
+	a.movRcxImm(0); // address of the jump table, filled in below
+	a.emit({0xff,0x24,0xc1}); // jmp [rcx+rax*8]
+	labelsample = a.code.size();
+	a.code[sample+1] = labelsample-(sample+2);
+	a.callFunction((uint64_t)&SamplingProfiler::takeSample);
+	a.emit({0xe9}); a.imm32(int32_t(dispatchnosample)-int32_t(a.code.size()+4));
+
+	// epilogue
+	labelexit = a.code.size();
+	a.emit({0x48,0x83,0xc4,0x08}); // add rsp,8
+	a.emit({0x41,0x5c}); // pop r12
+	a.emit({0x5b}); // pop rbx
+	a.emit({0xc3}); // ret
+
+	for (auto it = a.fixups.begin(); it != a.fixups.end(); it++)
+	{
+		uint32_t target;
+		if (it->second == JitAssembler::LABEL_DISPATCH)
+			target = labeldispatch;
+		else if (it->second == JitAssembler::LABEL_EXIT)
+			target = labelexit;
+		else
+			target = blocks[it->second];
+		int32_t rel = int32_t(target)-int32_t(it->first+4);
+		memcpy(&a.code[it->first],&rel,4);
+	}
+
+	// layout: code, jump table, unwind information
+	size_t codesize = (a.code.size()+7)&~size_t(7);
+	size_t tablesize = count*sizeof(uint64_t);
+	size_t pagesize = sysconf(_SC_PAGESIZE);
+	vector<uint8_t> unwind;
+	writeUnwindInfo(unwind,0,0);
+	size_t memsize = (codesize+tablesize+unwind.size()+pagesize-1)&~(pagesize-1);
+	void* mem = mmap(nullptr,memsize,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+	if (mem == MAP_FAILED)
+	{
+		LOG(LOG_ERROR,"jit: unable to allocate memory");
+		return false;
+	}
+	uint8_t* codestart = (uint8_t*)mem;
+	uint64_t* table = (uint64_t*)(codestart+codesize);
+	uint8_t* unwindstart = codestart+codesize+tablesize;
+	uint64_t tableptr = (uint64_t)table;
+	memcpy(&a.code[tableaddress],&tableptr,8);
+	memcpy(codestart,a.code.data(),a.code.size());
+	for (uint32_t i = 0; i < count; i++)
+		table[i] = (uint64_t)(codestart+blocks[i]);
+	unwind.clear();
+	writeUnwindInfo(unwind,(uint64_t)codestart,a.code.size());
+	memcpy(unwindstart,unwind.data(),unwind.size());
+	if (mprotect(mem,memsize,PROT_READ|PROT_EXEC) != 0)
+	{
+		LOG(LOG_ERROR,"jit: unable to make memory executable");
+		munmap(mem,memsize);
+		return false;
+	}
+	__register_frame(unwindstart);
+
+	body->jitmemory = mem;
+	body->jitmemorysize = memsize;
+	body->jitunwindinfo = unwindstart;
+	body->jitcode = (abc_function)codestart;
+	body->jitfailed = false;
+	LOG(LOG_CALLS,"jit: compiled method with "<<count<<" instructions into "<<a.code.size()<<" bytes");
+	return true;
+}
+
+void ABCVm::releaseJitFunction(method_body_info* body)
+{
+	if (body->jitmemory == nullptr)
+		return;
+	__deregister_frame(body->jitunwindinfo);
+	munmap(body->jitmemory,body->jitmemorysize);
+	body->jitmemory = nullptr;
+	body->jitunwindinfo = nullptr;
+	body->jitcode = nullptr;
+}
+
+#else
+
+bool ABCVm::jitFunction(method_info* mi)
+{
+	// no baseline jit available for this platform, the interpreter is used
+	mi->body->jitfailed = true;
+	return false;
+}
+
+void ABCVm::releaseJitFunction(method_body_info* body)
+{
+}
+
+#endif
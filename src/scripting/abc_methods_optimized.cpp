@@ -23,6 +23,7 @@
 #include "scripting/abcutils.h"
 #include "scripting/class.h"
 #include "scripting/toplevel/ASString.h"
+#include "scripting/toplevel/Number.h"
 #include "scripting/toplevel/RegExp.h"
 #include "scripting/toplevel/Vector.h"
 #include "parsing/streams.h"
@@ -2066,6 +2067,81 @@ void ABCVm::abc_getlex_localresult(call_context* context)
 	}
 	++(context->exec_pos);
 }
+// returns the declared instance variable cached for the class of obj at this instruction, or nullptr
+FORCE_INLINE variable* getCachedPropertyVar(call_context* context,preloadedcodedata* instrptr,ASObject* obj)
+{
+	const propertycache& pc = context->mi->body->getPropertyCache(instrptr);
+	uint32_t slotid = pc.find(obj->getClass(),context->sys->propertyCacheEpoch);
+	if (slotid && slotid <= obj->numSlots())
+		return obj->getSlotVar(slotid);
+	return nullptr;
+}
+// adds the class of obj to the inline cache of this instruction if name refers to a plain declared instance variable
+// otherwise the cache is disabled for this instruction to avoid repeated lookups
+static void cachePropertyVar(call_context* context,preloadedcodedata* instrptr,ASObject* obj,multiname* name)
+{
+	propertycache& pc = context->mi->body->getPropertyCache(instrptr);
+	int32_t epoch = context->sys->propertyCacheEpoch;
+	if (pc.megamorphic && pc.epoch == epoch)
+		return;
+	Class_base* cls = obj->getClass();
+	// objects with special property handling (Array, Proxy, Class, XML...) have their own object types
+	if (cls == nullptr
+			|| obj->getObjectType() != T_OBJECT
+			|| name->name_type != multiname::NAME_STRING
+			|| !name->isStatic
+			|| name->isAttribute)
+	{
+		pc.disable(epoch);
+		return;
+	}
+	bool isborrowed=false;
+	variable* v = obj->findVariableByMultiname(*name,cls,nullptr,&isborrowed,false,context->worker);
+	if (v == nullptr
+			|| isborrowed
+			|| v->kind != DECLARED_TRAIT
+			|| v->slotid == 0
+			|| asAtomHandler::isValid(v->getter)
+			|| asAtomHandler::isValid(v->setter)
+			|| v->slotid > obj->numSlots()
+			|| obj->getSlotVar(v->slotid) != v)
+	{
+		pc.disable(epoch);
+		return;
+	}
+	LOG_CALL("caching property "<<*name<<" "<<cls->toDebugString()<<" slot "<<v->slotid);
+	pc.add(cls,v->slotid,epoch);
+}
+FORCE_INLINE bool getPropertyFromCache(call_context* context,preloadedcodedata* instrptr,ASObject* obj,asAtom& prop)
+{
+	variable* v = getCachedPropertyVar(context,instrptr,obj);
+	if (v == nullptr)
+		return false;
+	prop = v->var;
+	ASATOM_INCREF(prop);
+	return true;
+}
+// behaves like ASObject::setVariableByMultiname for declared instance variables
+FORCE_INLINE bool setPropertyFromCache(call_context* context,preloadedcodedata* instrptr,ASObject* obj,asAtom& value,bool* alreadyset)
+{
+	variable* v = getCachedPropertyVar(context,instrptr,obj);
+	if (v == nullptr)
+		return false;
+	LOG_CALL("setProperty from cache "<<obj->toDebugString()<<" slot "<<v->slotid);
+	if (alreadyset)
+	{
+		if (value.uintval == v->var.uintval)
+			*alreadyset = true;
+		else
+		{
+			v->setVar(context->worker,value);
+			*alreadyset = value.uintval != v->var.uintval; // setVar may coerce the object into a new instance, so we need to check if decRef is necessary
+		}
+	}
+	else
+		v->setVar(context->worker,value);
+	return true;
+}
 void ABCVm::abc_setPropertyStaticName(call_context* context)
 {
 	multiname* name=context->exec_pos->cachedmultiname2;
@@ -2091,13 +2167,18 @@ void ABCVm::abc_setPropertyStaticName(call_context* context)
 	}
 	ASObject* o = asAtomHandler::toObject(*obj,context->worker);
 	bool alreadyset=false;
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyFromCache(context,context->exec_pos,o,*value,&alreadyset))
+	{
+		multiname* simplesettername = nullptr;
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		else if (!context->exceptionthrown)
+			cachePropertyVar(context,context->exec_pos,o,name);
+	}
 	if (alreadyset)
 		ASATOM_DECREF_POINTER(value);
 	ASATOM_DECREF_POINTER(obj);
@@ -2127,13 +2208,18 @@ void ABCVm::abc_setPropertyStaticName_constant_constant(call_context* context)
 	}
 
 	ASObject* o = asAtomHandler::toObject(*obj,context->worker);
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyFromCache(context,instrptr,o,*value,nullptr))
+	{
+		multiname* simplesettername = nullptr;
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		else if (!context->exceptionthrown)
+			cachePropertyVar(context,instrptr,o,name);
+	}
 	++(context->exec_pos);
 }
 void ABCVm::abc_setPropertyStaticName_local_constant(call_context* context)
@@ -2160,13 +2246,18 @@ void ABCVm::abc_setPropertyStaticName_local_constant(call_context* context)
 	}
 	ASObject* o = asAtomHandler::toObject(*obj,context->worker);
 	o->incRef(); // this is neccessary for reference counting in case of exception thrown in setVariableByMultiname
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyFromCache(context,instrptr,o,*value,nullptr))
+	{
+		multiname* simplesettername = nullptr;
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		else if (!context->exceptionthrown)
+			cachePropertyVar(context,instrptr,o,name);
+	}
 	o->decRef(); // this is neccessary for reference counting in case of exception thrown in setVariableByMultiname
 	++(context->exec_pos);
 }
@@ -2195,13 +2286,18 @@ void ABCVm::abc_setPropertyStaticName_constant_local(call_context* context)
 	ASObject* o = asAtomHandler::toObject(*obj,context->worker);
 	ASATOM_INCREF_POINTER(value);
 	bool alreadyset=false;
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyFromCache(context,instrptr,o,*value,&alreadyset))
+	{
+		multiname* simplesettername = nullptr;
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		else if (!context->exceptionthrown)
+			cachePropertyVar(context,instrptr,o,name);
+	}
 	if (alreadyset)
 		ASATOM_DECREF_POINTER(value);
 	++(context->exec_pos);
@@ -2232,13 +2328,18 @@ void ABCVm::abc_setPropertyStaticName_local_local(call_context* context)
 	o->incRef(); // this is neccessary for reference counting in case of exception thrown in setVariableByMultiname
 	ASATOM_INCREF_POINTER(value);
 	bool alreadyset=false;
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyFromCache(context,instrptr,o,*value,&alreadyset))
+	{
+		multiname* simplesettername = nullptr;
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		else if (!context->exceptionthrown)
+			cachePropertyVar(context,instrptr,o,name);
+	}
 	if (alreadyset)
 		ASATOM_DECREF_POINTER(value);
 	o->decRef(); // this is neccessary for reference counting in case of exception thrown in setVariableByMultiname
@@ -3197,6 +3298,7 @@ void ABCVm::abc_getPropertyStaticName_constant(call_context* context)
 	ASObject* obj= asAtomHandler::toObject(*instrptr->arg1_constant,context->worker);
 	LOG_CALL( "getProperty_sc " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
+	getPropertyFromCache(context,instrptr,obj,prop);
 	if(asAtomHandler::isInvalid(prop))
 	{
 		bool isgetter = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
@@ -3216,6 +3318,8 @@ void ABCVm::abc_getPropertyStaticName_constant(call_context* context)
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
+		else if (asAtomHandler::isValid(prop))
+			cachePropertyVar(context,instrptr,obj,name);
 	}
 	if(checkPropertyException(obj,name,prop))
 		return;
@@ -3241,6 +3345,7 @@ void ABCVm::abc_getPropertyStaticName_local(call_context* context)
 	{
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->worker);
 		LOG_CALL( "getProperty_sl " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
+		getPropertyFromCache(context,instrptr,obj,prop);
 		if(asAtomHandler::isInvalid(prop))
 		{
 			bool isgetter = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
@@ -3260,6 +3365,8 @@ void ABCVm::abc_getPropertyStaticName_local(call_context* context)
 				}
 				LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 			}
+			else if (asAtomHandler::isValid(prop))
+				cachePropertyVar(context,instrptr,obj,name);
 		}
 		if(checkPropertyException(obj,name,prop))
 			return;
@@ -3275,6 +3382,7 @@ void ABCVm::abc_getPropertyStaticName_constant_localresult(call_context* context
 	ASObject* obj= asAtomHandler::toObject(*instrptr->arg1_constant,context->worker,true);
 	LOG_CALL( "getProperty_scl " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
+	getPropertyFromCache(context,instrptr,obj,prop);
 	if(asAtomHandler::isInvalid(prop))
 	{
 		GET_VARIABLE_RESULT getvarres = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker);
@@ -3295,6 +3403,8 @@ void ABCVm::abc_getPropertyStaticName_constant_localresult(call_context* context
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
+		else if (asAtomHandler::isValid(prop))
+			cachePropertyVar(context,instrptr,obj,name);
 	}
 	if(checkPropertyException(obj,name,prop))
 		return;
@@ -3321,38 +3431,7 @@ void ABCVm::abc_getPropertyStaticName_local_localresult(call_context* context)
 	{
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->worker);
 		asAtom prop=asAtomHandler::invalidAtom;
-// TODO caching doesn't work until we find a way to detect if obj is a reused object
-// that has been destroyed since the last call
-//		if (((context->exec_pos->data&ABC_OP_NOTCACHEABLE) == 0)
-//				&& ((obj->is<Class_base>() && obj->as<Class_base>()->isSealed) ||
-//					(obj->getClass()
-//					 && (obj->getClass()->isSealed
-//						 || (obj->getClass() == Class<Array>::getRef(obj->getSystemState()).getPtr())))))
-//		{
-//			variable* v = obj->findVariableByMultiname(*name,obj->getClass());
-//			if (v)
-//			{
-//				context->exec_pos->data |= ABC_OP_CACHED;
-//				context->exec_pos->cachedvar2=v;
-//				context->exec_pos->cacheobj1=obj;
-//				if (asAtomHandler::isValid(v->getter))
-//				{
-//					asAtomHandler::set(prop,v->getter);
-//					//Call the getter
-//					LOG_CALL("Calling the getter for " << *name << " on " << obj->toDebugString());
-//					assert(asAtomHandler::isFunction(prop));
-//					IFunction* f = asAtomHandler::as<IFunction>(prop);
-//					ASObject* closure = asAtomHandler::getClosure(prop);
-//					f->callGetter(prop,closure ? closure : obj);
-//					LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
-//				}
-//				else
-//				{
-//					asAtomHandler::set(prop,v->var);
-//					ASATOM_INCREF(prop);
-//				}
-//			}
-//		}
+		getPropertyFromCache(context,instrptr,obj,prop);
 		if(asAtomHandler::isInvalid(prop))
 		{
 			GET_VARIABLE_RESULT getvarres = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker);
@@ -3376,6 +3455,8 @@ void ABCVm::abc_getPropertyStaticName_local_localresult(call_context* context)
 			else
 			{
 				LOG_CALL("getProperty_sll " << *name << ' ' << obj->toDebugString()<<" "<<instrptr->local3.pos<<" "<<asAtomHandler::toDebugString(prop));
+				if (asAtomHandler::isValid(prop))
+					cachePropertyVar(context,instrptr,obj,name);
 			}
 
 		}
@@ -3393,6 +3474,7 @@ void ABCVm::abc_getPropertyStaticName_localresult(call_context* context)
 	RUNTIME_STACK_POP_CREATE_ASOBJECT(context,obj);
 	LOG_CALL( "getProperty_slr " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized()<<" "<<instrptr->local3.pos);
 	asAtom prop=asAtomHandler::invalidAtom;
+	getPropertyFromCache(context,instrptr,obj,prop);
 	if(asAtomHandler::isInvalid(prop))
 	{
 		GET_VARIABLE_RESULT getvarres = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker);
@@ -3413,6 +3495,8 @@ void ABCVm::abc_getPropertyStaticName_localresult(call_context* context)
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
+		else if (asAtomHandler::isValid(prop))
+			cachePropertyVar(context,instrptr,obj,name);
 	}
 	if(checkPropertyException(obj,name,prop))
 		return;
@@ -7821,3 +7905,811 @@ void ABCVm::abc_sxi16_local_localresult(call_context* context)
 	replacelocalresult(context,instrptr->local3.pos,ret);
 	++(context->exec_pos);
 }
+
+// The following opcodes are only used if the optimizer has determined that both operands are int (_ii) or numeric (_dd) values,
+// so the operands can be read directly without any type conversion or reference counting
+// the int type of the optimizer is not exact (the result of adding two ints may be stored as uint or Number),
+// so the _ii opcodes check the atom type and use the generic opcode for anything that is not an int
+FORCE_INLINE bool isTypedInt(const asAtom& a1,const asAtom& a2)
+{
+	return asAtomHandler::isInteger(a1) && asAtomHandler::isInteger(a2);
+}
+FORCE_INLINE int32_t getTypedInt(const asAtom& a)
+{
+	// int typed operands are only used on 64bit systems, where int values are always stored directly in the atom
+	assert(asAtomHandler::isInteger(a));
+	return a.intval>>3;
+}
+FORCE_INLINE number_t getTypedNumber(const asAtom& a)
+{
+	switch (a.uintval&0x7)
+	{
+		case ATOM_INTEGER:
+			return a.intval>>3;
+		case ATOM_UINTEGER:
+			return a.uintval>>3;
+		case ATOM_NUMBERPTR:
+		{
+			Number* n = (Number*)asAtomHandler::getObjectNoCheck(a);
+			return n->isfloat ? n->dval : n->ival;
+		}
+		default:
+			return asAtomHandler::toNumber(a);
+	}
+}
+FORCE_INLINE void typedJump(call_context* context,bool cond)
+{
+	if(cond)
+		context->exec_pos += context->exec_pos->arg3_int;
+	else
+		++(context->exec_pos);
+}
+FORCE_INLINE void setTypedIntResult(call_context* context,int64_t res)
+{
+	asAtom& ret = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
+	// the localresult may still contain an object from its previous use
+	ASATOM_DECREF(ret);
+	if (context->exec_pos->local3.flags & ABC_OP_FORCEINT || (res >= -(1<<28) && res < (1<<28)))
+		asAtomHandler::setInt(ret,context->worker,int32_t(res));
+	else if (res >= 0 && res < (1<<29))
+		asAtomHandler::setUInt(ret,context->worker,res);
+	else
+		asAtomHandler::setNumber(ret,context->worker,res);
+}
+FORCE_INLINE void setTypedNumberResult(call_context* context,number_t res)
+{
+	asAtom& ret = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
+	ASObject* o = asAtomHandler::getObject(ret);
+	if (context->exec_pos->local3.flags & ABC_OP_FORCEINT)
+	{
+		asAtomHandler::setInt(ret,context->worker,res);
+		if (o)
+			o->decRef();
+	}
+	else if (asAtomHandler::replaceNumber(ret,context->worker,res) && o)
+		o->decRef();
+}
+void ABCVm::abc_iflt_ii_constant_constant(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_iflt_constant_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) < getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLT_ii_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_iflt_ii_local_constant(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_iflt_local_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLT_ii_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_iflt_ii_constant_local(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_iflt_constant_local(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) < getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLT_ii_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_iflt_ii_local_local(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_iflt_local_local(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLT_ii_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_ii_constant_constant(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_ifle_constant_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) <= getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLE_ii_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_ii_local_constant(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_ifle_local_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) <= getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLE_ii_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_ii_constant_local(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_ifle_constant_local(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) <= getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLE_ii_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_ii_local_local(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_ifle_local_local(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) <= getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLE_ii_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_ii_constant_constant(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_ifgt_constant_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) > getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGT_ii_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_ii_local_constant(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_ifgt_local_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) > getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGT_ii_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_ii_constant_local(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_ifgt_constant_local(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) > getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGT_ii_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_ii_local_local(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_ifgt_local_local(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) > getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGT_ii_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_ii_constant_constant(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_ifge_constant_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) >= getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGE_ii_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_ii_local_constant(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_ifge_local_constant(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) >= getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGE_ii_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_ii_constant_local(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_ifge_constant_local(context);
+		return;
+	}
+	bool cond=getTypedInt(*context->exec_pos->arg1_constant) >= getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGE_ii_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_ii_local_local(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_ifge_local_local(context);
+		return;
+	}
+	bool cond=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) >= getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGE_ii_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_iflt_dd_constant_constant(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) < getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLT_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_iflt_dd_local_constant(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLT_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_iflt_dd_constant_local(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) < getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLT_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_iflt_dd_local_local(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLT_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_dd_constant_constant(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) <= getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLE_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_dd_local_constant(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) <= getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifLE_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_dd_constant_local(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) <= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLE_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifle_dd_local_local(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) <= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifLE_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_dd_constant_constant(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) > getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGT_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_dd_local_constant(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) > getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGT_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_dd_constant_local(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) > getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGT_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifgt_dd_local_local(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) > getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGT_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_dd_constant_constant(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) >= getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGE_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_dd_local_constant(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) >= getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("ifGE_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_dd_constant_local(call_context* context)
+{
+	bool cond=getTypedNumber(*context->exec_pos->arg1_constant) >= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGE_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifge_dd_local_local(call_context* context)
+{
+	bool cond=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) >= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("ifGE_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnlt_dd_constant_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) < getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNLT_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnlt_dd_local_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNLT_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnlt_dd_constant_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) < getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNLT_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnlt_dd_local_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNLT_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnle_dd_constant_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) <= getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNLE_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnle_dd_local_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) <= getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNLE_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnle_dd_constant_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) <= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNLE_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnle_dd_local_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) <= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNLE_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifngt_dd_constant_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) > getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNGT_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifngt_dd_local_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) > getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNGT_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifngt_dd_constant_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) > getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNGT_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifngt_dd_local_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) > getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNGT_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnge_dd_constant_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) >= getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNGE_dd_cc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnge_dd_local_constant(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) >= getTypedNumber(*context->exec_pos->arg2_constant));
+	LOG_CALL("ifNGE_dd_lc (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnge_dd_constant_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(*context->exec_pos->arg1_constant) >= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNGE_dd_cl (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_ifnge_dd_local_local(call_context* context)
+{
+	bool cond=!(getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) >= getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
+	LOG_CALL("ifNGE_dd_ll (" << ((cond)?"taken)":"not taken)"));
+	typedJump(context,cond);
+}
+void ABCVm::abc_lessthan_ii_constant_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_lessthan_constant_constant_localresult(context);
+		return;
+	}
+	bool ret=getTypedInt(*context->exec_pos->arg1_constant) < getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("lessthan_ii_ccl "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_lessthan_ii_local_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_lessthan_local_constant_localresult(context);
+		return;
+	}
+	bool ret=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("lessthan_ii_lcl "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_lessthan_ii_constant_local_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_lessthan_constant_local_localresult(context);
+		return;
+	}
+	bool ret=getTypedInt(*context->exec_pos->arg1_constant) < getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("lessthan_ii_cll "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_lessthan_ii_local_local_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_lessthan_local_local_localresult(context);
+		return;
+	}
+	bool ret=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("lessthan_ii_lll "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_lessthan_dd_constant_constant_localresult(call_context* context)
+{
+	bool ret=getTypedNumber(*context->exec_pos->arg1_constant) < getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("lessthan_dd_ccl "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_lessthan_dd_local_constant_localresult(call_context* context)
+{
+	bool ret=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("lessthan_dd_lcl "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_lessthan_dd_constant_local_localresult(call_context* context)
+{
+	bool ret=getTypedNumber(*context->exec_pos->arg1_constant) < getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("lessthan_dd_cll "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_lessthan_dd_local_local_localresult(call_context* context)
+{
+	bool ret=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) < getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("lessthan_dd_lll "<<ret);
+
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),ret);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_ii_constant_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_add_constant_constant_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(*context->exec_pos->arg1_constant);
+	int64_t num2=getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("add_ii_ccl " << num1 << '+' << num2);
+	setTypedIntResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_ii_local_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_add_local_constant_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	int64_t num2=getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("add_ii_lcl " << num1 << '+' << num2);
+	setTypedIntResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_ii_constant_local_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_add_constant_local_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(*context->exec_pos->arg1_constant);
+	int64_t num2=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("add_ii_cll " << num1 << '+' << num2);
+	setTypedIntResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_ii_local_local_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_add_local_local_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	int64_t num2=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("add_ii_lll " << num1 << '+' << num2);
+	setTypedIntResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_ii_constant_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_subtract_constant_constant_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(*context->exec_pos->arg1_constant);
+	int64_t num2=getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("subtract_ii_ccl " << num1 << '-' << num2);
+	setTypedIntResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_ii_local_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_subtract_local_constant_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	int64_t num2=getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("subtract_ii_lcl " << num1 << '-' << num2);
+	setTypedIntResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_ii_constant_local_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_subtract_constant_local_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(*context->exec_pos->arg1_constant);
+	int64_t num2=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("subtract_ii_cll " << num1 << '-' << num2);
+	setTypedIntResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_ii_local_local_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_subtract_local_local_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	int64_t num2=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("subtract_ii_lll " << num1 << '-' << num2);
+	setTypedIntResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_ii_constant_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant))
+	{
+		abc_multiply_constant_constant_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(*context->exec_pos->arg1_constant);
+	int64_t num2=getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("multiply_ii_ccl " << num1 << '*' << num2);
+	setTypedIntResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_ii_local_constant_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant))
+	{
+		abc_multiply_local_constant_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	int64_t num2=getTypedInt(*context->exec_pos->arg2_constant);
+	LOG_CALL("multiply_ii_lcl " << num1 << '*' << num2);
+	setTypedIntResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_ii_constant_local_localresult(call_context* context)
+{
+	if (!isTypedInt(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_multiply_constant_local_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(*context->exec_pos->arg1_constant);
+	int64_t num2=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("multiply_ii_cll " << num1 << '*' << num2);
+	setTypedIntResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_ii_local_local_localresult(call_context* context)
+{
+	if (!isTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)))
+	{
+		abc_multiply_local_local_localresult(context);
+		return;
+	}
+	int64_t num1=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	int64_t num2=getTypedInt(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("multiply_ii_lll " << num1 << '*' << num2);
+	setTypedIntResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_dd_constant_constant_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(*context->exec_pos->arg1_constant);
+	number_t num2=getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("add_dd_ccl " << num1 << '+' << num2);
+	setTypedNumberResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_dd_local_constant_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	number_t num2=getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("add_dd_lcl " << num1 << '+' << num2);
+	setTypedNumberResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_dd_constant_local_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(*context->exec_pos->arg1_constant);
+	number_t num2=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("add_dd_cll " << num1 << '+' << num2);
+	setTypedNumberResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_add_dd_local_local_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	number_t num2=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("add_dd_lll " << num1 << '+' << num2);
+	setTypedNumberResult(context,num1+num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_dd_constant_constant_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(*context->exec_pos->arg1_constant);
+	number_t num2=getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("subtract_dd_ccl " << num1 << '-' << num2);
+	setTypedNumberResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_dd_local_constant_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	number_t num2=getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("subtract_dd_lcl " << num1 << '-' << num2);
+	setTypedNumberResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_dd_constant_local_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(*context->exec_pos->arg1_constant);
+	number_t num2=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("subtract_dd_cll " << num1 << '-' << num2);
+	setTypedNumberResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_subtract_dd_local_local_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	number_t num2=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("subtract_dd_lll " << num1 << '-' << num2);
+	setTypedNumberResult(context,num1-num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_dd_constant_constant_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(*context->exec_pos->arg1_constant);
+	number_t num2=getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("multiply_dd_ccl " << num1 << '*' << num2);
+	setTypedNumberResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_dd_local_constant_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	number_t num2=getTypedNumber(*context->exec_pos->arg2_constant);
+	LOG_CALL("multiply_dd_lcl " << num1 << '*' << num2);
+	setTypedNumberResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_dd_constant_local_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(*context->exec_pos->arg1_constant);
+	number_t num2=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("multiply_dd_cll " << num1 << '*' << num2);
+	setTypedNumberResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_multiply_dd_local_local_localresult(call_context* context)
+{
+	number_t num1=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	number_t num2=getTypedNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
+	LOG_CALL("multiply_dd_lll " << num1 << '*' << num2);
+	setTypedNumberResult(context,num1*num2);
+	++(context->exec_pos);
+}
+void ABCVm::abc_inclocal_ii(call_context* context)
+{
+	asAtom& a = CONTEXT_GETLOCAL(context,context->exec_pos->arg1_uint);
+	if (!asAtomHandler::isInteger(a))
+	{
+		abc_inclocal_i_optimized(context);
+		return;
+	}
+	LOG_CALL( "incLocal_ii " << context->exec_pos->arg1_uint << " "<< context->exec_pos->arg2_int);
+	int64_t res = int64_t(getTypedInt(a))+int64_t(context->exec_pos->arg2_int);
+	if (USUALLY_TRUE(res >= INT32_MIN && res <= INT32_MAX))
+		asAtomHandler::setInt(a,context->worker,int32_t(res));
+	else
+		asAtomHandler::setNumber(a,context->worker,number_t(res));
+	++context->exec_pos;
+}
+void ABCVm::abc_declocal_ii(call_context* context)
+{
+	asAtom& a = CONTEXT_GETLOCAL(context,context->exec_pos->arg1_uint);
+	if (!asAtomHandler::isInteger(a))
+	{
+		abc_declocal_i_optimized(context);
+		return;
+	}
+	LOG_CALL( "decLocal_ii " << context->exec_pos->arg1_uint << " "<< context->exec_pos->arg2_int);
+	int64_t res = int64_t(getTypedInt(a))-int64_t(context->exec_pos->arg2_int);
+	if (USUALLY_TRUE(res >= INT32_MIN && res <= INT32_MAX))
+		asAtomHandler::setInt(a,context->worker,int32_t(res));
+	else
+		asAtomHandler::setNumber(a,context->worker,number_t(res));
+	++context->exec_pos;
+}
@@ -2489,16 +2489,37 @@ void ABCVm::newObject(call_context* th, int n)
 {
 	LOG_CALL("newObject " << n);
 	ASObject* ret=Class<ASObject>::getInstanceS(th->worker);
-	//Duplicated keys overwrite the previous value
-	multiname propertyName(nullptr);
-	propertyName.name_type=multiname::NAME_STRING;
-	for(int i=0;i<n;i++)
+	if (n <= OBJECTSHAPE_MAX_PROPERTIES)
 	{
-		RUNTIME_STACK_POP_CREATE(th,value);
-		RUNTIME_STACK_POP_CREATE(th,name);
-		uint32_t nameid=asAtomHandler::toStringId(*name,th->worker);
-		ASATOM_DECREF_POINTER(name);
-		ret->setDynamicVariableNoCheck(nameid,*value);
+		ret->Variables.initShape(n);
+		//Duplicated keys overwrite the previous value
+		//The keys are popped in reverse order, so a key that is already set was defined later
+		for(int i=0;i<n;i++)
+		{
+			RUNTIME_STACK_POP_CREATE(th,value);
+			RUNTIME_STACK_POP_CREATE(th,name);
+			uint32_t nameid=asAtomHandler::toStringId(*name,th->worker);
+			ASATOM_DECREF_POINTER(name);
+			if (ret->Variables.shape->find(nameid) >= 0)
+			{
+				ASATOM_DECREF_POINTER(value);
+			}
+			else
+				ret->Variables.addShapeVar(nameid,*value);
+		}
+	}
+	else
+	{
+		ret->Variables.Variables.reserve(n);
+		//Duplicated keys overwrite the previous value
+		for(int i=0;i<n;i++)
+		{
+			RUNTIME_STACK_POP_CREATE(th,value);
+			RUNTIME_STACK_POP_CREATE(th,name);
+			uint32_t nameid=asAtomHandler::toStringId(*name,th->worker);
+			ASATOM_DECREF_POINTER(name);
+			ret->setDynamicVariableNoCheck(nameid,*value);
+		}
 	}
 
 	RUNTIME_STACK_PUSH(th,asAtomHandler::fromObject(ret));
@@ -0,0 +1,78 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "scripting/abc.h"
+#include "scripting/flash/system/flashsystem.h"
+#include <fstream>
+
+using namespace std;
+using namespace lightspark;
+
+ACQUIRE_RELEASE_FLAG(SamplingProfiler::sampleRequested);
+
+void SamplingProfiler::tick()
+{
+	RELEASE_WRITE(sampleRequested,true);
+}
+
+void SamplingProfiler::takeSample(call_context* context)
+{
+	RELEASE_WRITE(sampleRequested,false);
+	if (context->sys && context->sys->samplingProfiler)
+		context->sys->samplingProfiler->addSample(context);
+}
+
+void SamplingProfiler::addSample(call_context* context)
+{
+	ASWorker* wrk = context->worker;
+	if (!wrk)
+		return;
+	std::string stack = wrk->isPrimordial ? "main" : "worker";
+	for (uint32_t i = 0; i < wrk->cur_recursion; i++)
+	{
+		stack += ";";
+		ASObject* o = asAtomHandler::getObject(wrk->stacktrace[i].object);
+		if (o)
+			stack += o->getClassName().raw_buf();
+		else
+			stack += "global";
+		stack += "/";
+		stack += context->sys->getStringFromUniqueId(wrk->stacktrace[i].name).raw_buf();
+	}
+	//The code position of the innermost function is added as its own frame,
+	//so the samples are aggregated both per method and per instruction
+	if (context->exec_pos && context->mi && context->mi->body)
+	{
+		stack += ";@";
+		stack += to_string(context->exec_pos-context->mi->body->preloadedcode.data());
+	}
+	Locker l(mutex);
+	stacks[stack]++;
+	samplecount++;
+}
+
+void SamplingProfiler::save(const tiny_string& filename)
+{
+	Locker l(mutex);
+	ofstream f(filename.raw_buf());
+	for (auto it = stacks.begin(); it != stacks.end(); it++)
+		f << it->first << " " << it->second << endl;
+	f.close();
+	LOG(LOG_INFO,"sampling profiler: " << samplecount << " samples written to " << filename);
+}
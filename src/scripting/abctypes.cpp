@@ -18,6 +18,7 @@
 **************************************************************************/
 
 #include "scripting/abctypes.h"
+#include "scripting/abc.h"
 #include "swf.h"
 
 using namespace std;
@@ -408,4 +409,5 @@ method_body_info::~method_body_info()
 {
 	if (localsinitialvalues)
 		delete[] localsinitialvalues;
+	ABCVm::releaseJitFunction(this);
 }
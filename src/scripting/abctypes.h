@@ -29,6 +29,7 @@ class memorystream;
 namespace lightspark
 {
 struct variable;
+class Class_base;
 
 class u8
 {
@@ -305,6 +306,59 @@ struct preloadedcodedata
 	};
 	preloadedcodedata():func(nullptr),cacheobj1(nullptr),cacheobj2(nullptr),cacheobj3(nullptr) {}
 };
+
+#define PROPERTYCACHE_ENTRIES 4
+/*
+ * polymorphic inline cache for getproperty/setproperty on declared instance variables.
+ * Every instance of a class gets the same slot layout, so the slot id found for the
+ * first receiver of a class is valid for all other receivers of the same class.
+ * The cache is dropped if the epoch of the SystemState has changed since it was filled
+ */
+struct propertycache
+{
+	Class_base* cls[PROPERTYCACHE_ENTRIES];
+	uint32_t slotid[PROPERTYCACHE_ENTRIES];
+	int32_t epoch;
+	uint8_t count;
+	// set if more than PROPERTYCACHE_ENTRIES classes or a non-cacheable property were seen, the cache is not used anymore
+	bool megamorphic;
+	propertycache():epoch(0),count(0),megamorphic(false) {}
+	FORCE_INLINE uint32_t find(Class_base* c, int32_t currentepoch) const
+	{
+		if (epoch == currentepoch)
+		{
+			for (uint8_t i = 0; i < count; i++)
+			{
+				if (cls[i] == c)
+					return slotid[i];
+			}
+		}
+		return 0;
+	}
+	void add(Class_base* c, uint32_t slot, int32_t currentepoch)
+	{
+		if (epoch != currentepoch)
+		{
+			epoch = currentepoch;
+			count = 0;
+			megamorphic = false;
+		}
+		if (count == PROPERTYCACHE_ENTRIES)
+		{
+			megamorphic = true;
+			return;
+		}
+		cls[count] = c;
+		slotid[count] = slot;
+		count++;
+	}
+	void disable(int32_t currentepoch)
+	{
+		epoch = currentepoch;
+		count = 0;
+		megamorphic = true;
+	}
+};
 struct localconstantslot
 {
 	uint32_t local_pos;
@@ -313,7 +367,8 @@ struct localconstantslot
 
 struct method_body_info
 {
-	method_body_info():localresultcount(0),hit_count(0),codeStatus(ORIGINAL),localsinitialvalues(nullptr){}
+	method_body_info():localresultcount(0),hit_count(0),codeStatus(ORIGINAL),localsinitialvalues(nullptr),
+		jitcode(nullptr),jitmemory(nullptr),jitunwindinfo(nullptr),jitmemorysize(0),jitfailed(false){}
 	~method_body_info();
 	u30 method;
 	u30 max_stack;
@@ -334,8 +389,20 @@ struct method_body_info
 	// list of local/slot pairs that were optimized away
 	std::vector<localconstantslot> localconstantslots;
 	std::vector<preloadedcodedata> preloadedcode;
+	// inline caches for property access, indexed by position in preloadedcode
+	std::vector<propertycache> propertycaches;
 	asAtom* localsinitialvalues;
+	// native code generated by the baseline jit from preloadedcode
+	abc_function jitcode;
+	void* jitmemory;
+	void* jitunwindinfo;
+	size_t jitmemorysize;
+	bool jitfailed;
 	inline uint16_t getReturnValuePos() const { return returnvaluepos; }
+	inline propertycache& getPropertyCache(const preloadedcodedata* instrptr)
+	{
+		return propertycaches[instrptr-preloadedcode.data()];
+	}
 };
 
 std::istream& operator>>(std::istream& in, u8& v);
@@ -24,18 +24,76 @@
 #include "backends/rendering.h"
 #include "backends/image.h"
 #include "backends/decoder.h"
+#include "backends/config.h"
 #include "swf.h"
 
 using namespace std;
 using namespace lightspark;
 
+BitmapBudget::BitmapBudget():usedBytes(0),budget(uint64_t(Config::getConfig()->getBitmapMemoryBudget())*1024*1024)
+{
+}
+
+BitmapBudget* BitmapBudget::getBudget()
+{
+	static BitmapBudget budget;
+	return &budget;
+}
+
+void BitmapBudget::addDecoded(BitmapContainer* b)
+{
+	Locker l(mutex);
+	if(b->inBudget)
+		return;
+	b->budgetBytes=b->data.size();
+	b->budgetPosition=decoded.insert(decoded.end(),b);
+	b->inBudget=true;
+	usedBytes+=b->budgetBytes;
+	if(budget==0)
+		return;
+	// drop the least recently used bitmaps that are only referenced by their source,
+	// no new references can be taken while we hold the mutex
+	auto it=decoded.begin();
+	while(usedBytes>budget && it!=decoded.end())
+	{
+		BitmapContainer* c=*it;
+		if(c==b || c->getRefCount()!=1)
+		{
+			++it;
+			continue;
+		}
+		it=decoded.erase(it);
+		c->inBudget=false;
+		usedBytes-=c->budgetBytes;
+		c->dropDecodedData();
+	}
+}
+
+void BitmapBudget::removeDecoded(BitmapContainer* b)
+{
+	Locker l(mutex);
+	if(!b->inBudget)
+		return;
+	decoded.erase(b->budgetPosition);
+	b->inBudget=false;
+	usedBytes-=b->budgetBytes;
+}
+
+void BitmapBudget::touch(BitmapContainer* b)
+{
+	if(b->inBudget)
+		decoded.splice(decoded.end(),decoded,b->budgetPosition);
+}
+
 BitmapContainer::BitmapContainer(MemoryAccount* m):stride(0),width(0),height(0),
-	data(reporter_allocator<uint8_t>(m))
+	data(reporter_allocator<uint8_t>(m)),lazySource(nullptr),decoded(false),prefetchScheduled(false),budgetBytes(0),inBudget(false)
 {
 }
 
 BitmapContainer::~BitmapContainer()
 {
+	if(inBudget)
+		BitmapBudget::getBudget()->removeDecoded(this);
 	if (bitmaptexture.isValid())
 	{
 		RenderThread* rt = getSys()->getRenderThread();
@@ -46,8 +104,65 @@ BitmapContainer::~BitmapContainer()
 	}
 }
 
+void BitmapContainer::setLazySource(IBitmapSource* source, int32_t w, int32_t h)
+{
+	assert(data.empty());
+	lazySource=source;
+	width=w;
+	height=h;
+	stride=cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+	RELEASE_WRITE(decoded,false);
+}
+
+void BitmapContainer::detachLazySource()
+{
+	if(!lazySource)
+		return;
+	decodeIfNeeded();
+	BitmapBudget::getBudget()->removeDecoded(this);
+	lazySource=nullptr;
+}
+
+void BitmapContainer::decode()
+{
+	{
+		Locker l(decodeMutex);
+		if(ACQUIRE_READ(decoded))
+			return;
+		// decode into a plain container, the decoders use the public accessors which would try to decode this one again
+		BitmapContainer tmp(nullptr);
+		lazySource->decodeBitmap(&tmp);
+		if(tmp.width!=width || tmp.height!=height)
+			LOG(LOG_ERROR,"decoded bitmap size "<<tmp.width<<"x"<<tmp.height<<" differs from the header size "<<width<<"x"<<height);
+		width=tmp.width;
+		height=tmp.height;
+		stride=tmp.stride;
+		data.assign(tmp.data.begin(),tmp.data.end());
+		RELEASE_WRITE(decoded,true);
+	}
+	BitmapBudget::getBudget()->addDecoded(this);
+}
+
+void BitmapContainer::dropDecodedData()
+{
+	data.clear();
+	data.shrink_to_fit();
+	data_colortransformed.clear();
+	data_colortransformed.shrink_to_fit();
+	if (bitmaptexture.isValid())
+	{
+		RenderThread* rt = getSys() ? getSys()->getRenderThread() : nullptr;
+		if (rt)
+			rt->releaseTexture(bitmaptexture);
+		bitmaptexture.makeEmpty();
+	}
+	RELEASE_WRITE(decoded,false);
+	RELEASE_WRITE(prefetchScheduled,false);
+}
+
 uint8_t* BitmapContainer::getRectangleData(const RECT& sourceRect)
 {
+	decodeIfNeeded();
 	RECT clippedSourceRect;
 	clipRect(sourceRect, clippedSourceRect);
 
@@ -186,6 +301,9 @@ void BitmapContainer::fromRawData(uint8_t* data, uint32_t width, uint32_t height
 
 void BitmapContainer::clear()
 {
+	if(inBudget)
+		BitmapBudget::getBudget()->removeDecoded(this);
+	lazySource=nullptr;
 	data.clear();
 	data.shrink_to_fit();
 	stride=0;
@@ -225,6 +343,7 @@ bool BitmapContainer::checkTexture()
 
 void BitmapContainer::setAlpha(int32_t x, int32_t y, uint8_t alpha)
 {
+	decodeIfNeeded();
 	if (x < 0 || x >= width || y < 0 || y >= height)
 		return;
 
@@ -234,6 +353,7 @@ void BitmapContainer::setAlpha(int32_t x, int32_t y, uint8_t alpha)
 
 void BitmapContainer::setPixel(int32_t x, int32_t y, uint32_t color, bool setAlpha, bool ispremultiplied)
 {
+	decodeIfNeeded();
 	if (x < 0 || x >= width || y < 0 || y >= height)
 		return;
 
@@ -259,6 +379,7 @@ void BitmapContainer::setPixel(int32_t x, int32_t y, uint32_t color, bool setAlp
 
 uint32_t BitmapContainer::getPixel(int32_t x, int32_t y,bool premultiplied) const
 {
+	decodeIfNeeded();
 	if (x < 0 || x >= width || y < 0 || y >= height)
 		return 0;
 
@@ -289,6 +410,8 @@ void BitmapContainer::copyRectangle(_R<BitmapContainer> source,
 				    int32_t destX, int32_t destY,
 				    bool mergeAlpha)
 {
+	decodeIfNeeded();
+	source->decodeIfNeeded();
 	RECT clippedSourceRect;
 	int32_t clippedX;
 	int32_t clippedY;
@@ -337,6 +460,8 @@ void BitmapContainer::applyFilter(_R<BitmapContainer> source,
 				    int32_t destX, int32_t destY,
 				    BitmapFilter* filter)
 {
+	decodeIfNeeded();
+	source->decodeIfNeeded();
 	RECT clippedSourceRect;
 	int32_t clippedX;
 	int32_t clippedY;
@@ -346,6 +471,7 @@ void BitmapContainer::applyFilter(_R<BitmapContainer> source,
 
 void BitmapContainer::fillRectangle(const RECT& inputRect, uint32_t color, bool useAlpha)
 {
+	decodeIfNeeded();
 	RECT clippedRect;
 	clipRect(inputRect, clippedRect);
 
@@ -365,6 +491,7 @@ void BitmapContainer::fillRectangle(const RECT& inputRect, uint32_t color, bool
 
 bool BitmapContainer::scroll(int32_t x, int32_t y)
 {
+	decodeIfNeeded();
 	int sourceX = imax(-x, 0);
 	int sourceY = imax(-y, 0);
 
@@ -419,6 +546,7 @@ void BitmapContainer::floodFill(int32_t startX, int32_t startY, uint32_t color)
 	};
 
 	stack<LineSegment> segments;
+	decodeIfNeeded();
 
 	if (startX < 0 || startX >= width || startY < 0 || startY >= height)
 		return;
@@ -563,6 +691,7 @@ std::vector<uint32_t> BitmapContainer::getPixelVector(const RECT& inputRect) con
 {
 	RECT rect;
 	clipRect(inputRect, rect);
+	decodeIfNeeded();
 
 	std::vector<uint32_t> result;
 	if ((rect.Xmax - rect.Xmin <= 0) || (rect.Ymax - rect.Ymin <= 0))
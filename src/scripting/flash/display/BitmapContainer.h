@@ -25,13 +25,51 @@
 #include "smartrefs.h"
 #include "swftypes.h"
 #include <vector>
+#include <list>
 #include "backends/graphics.h"
+#include "threading.h"
 
 namespace lightspark
 {
 class BitmapFilter;
+class BitmapContainer;
+
+/*
+ * Provides the pixels of a lazily decoded BitmapContainer
+ */
+class IBitmapSource
+{
+public:
+	virtual ~IBitmapSource(){}
+	/* Decodes the image into b, which is an empty, not lazily decoded container */
+	virtual void decodeBitmap(BitmapContainer* b)=0;
+};
+
+/*
+ * Keeps the pixels of lazily decoded bitmaps within the configured memory budget.
+ * When the budget is exceeded the least recently used bitmaps that are only referenced
+ * by their source are dropped, they are decoded again on the next access
+ */
+class BitmapBudget
+{
+private:
+	std::list<BitmapContainer*> decoded;
+	uint64_t usedBytes;
+	uint64_t budget;
+	BitmapBudget();
+public:
+	/* New references to lazily decoded bitmaps must be taken while holding this mutex */
+	Mutex mutex;
+	static BitmapBudget* getBudget();
+	void addDecoded(BitmapContainer* b);
+	void removeDecoded(BitmapContainer* b);
+	/* Marks b as recently used, mutex must be held */
+	void touch(BitmapContainer* b);
+};
+
 class BitmapContainer : public RefCountable, public ITextureUploadable
 {
+friend class BitmapBudget;
 public:
 	enum BITMAP_FORMAT { RGB15, RGB24, RGB32, ARGB32 };
 protected:
@@ -44,16 +82,41 @@ protected:
 	std::vector<uint8_t, reporter_allocator<uint8_t>> data;
 	// buffer to contain the 
 	std::vector<uint8_t> data_colortransformed;
+	// decodes the pixels on demand if they are provided by lazySource
+	IBitmapSource* lazySource;
+	Mutex decodeMutex;
+	ACQUIRE_RELEASE_FLAG(decoded);
+	ACQUIRE_RELEASE_FLAG(prefetchScheduled);
+	// position in the list of the BitmapBudget while decoded
+	std::list<BitmapContainer*>::iterator budgetPosition;
+	uint32_t budgetBytes;
+	bool inBudget;
+	void decodeIfNeeded() const
+	{
+		if(lazySource && !ACQUIRE_READ(decoded))
+			const_cast<BitmapContainer*>(this)->decode();
+	}
+	void decode();
+	// drops the decoded pixels, called by the BitmapBudget
+	void dropDecodedData();
 	uint32_t *getDataNoBoundsChecking(int32_t x, int32_t y) const;
 public:
 	TextureChunk bitmaptexture;
 	BitmapContainer(MemoryAccount* m);
 	~BitmapContainer();
-	uint32_t getDataSize() const { return data.size(); }
-	uint8_t* getData() { return &data[0]; }
-	const uint8_t* getData() const { return &data[0]; }
+	/* The pixels will be provided by source on first access, width and height must be the size of the decoded image */
+	void setLazySource(IBitmapSource* source, int32_t w, int32_t h);
+	/* Decodes the pixels if needed and stops decoding on demand, called when the source goes away */
+	void detachLazySource();
+	bool isDecoded() const { return !lazySource || ACQUIRE_READ(decoded); }
+	/* Returns true only for the first caller since the pixels were dropped, used to schedule a single background decode */
+	bool schedulePrefetch() { return !isDecoded() && !prefetchScheduled.exchange(true); }
+	uint32_t getDataSize() const { decodeIfNeeded(); return data.size(); }
+	uint8_t* getData() { decodeIfNeeded(); return &data[0]; }
+	const uint8_t* getData() const { decodeIfNeeded(); return &data[0]; }
 	uint8_t* getDataColorTransformed() 
 	{
+		decodeIfNeeded();
 		data_colortransformed.reserve(data.size());
 		return &data_colortransformed[0];
 	}
@@ -93,7 +156,7 @@ public:
 	void floodFill(int32_t x, int32_t y, uint32_t color);
 	int getWidth() const { return width; }
 	int getHeight() const { return height; }
-	bool isEmpty() const { return data.empty(); }
+	bool isEmpty() const { decodeIfNeeded(); return data.empty(); }
 	void clear();
 
 	//ITextureUploadable interface
@@ -105,7 +105,7 @@ bool DisplayObject::Render(RenderContext& ctxt, bool force)
 
 DisplayObject::DisplayObject(ASWorker* wrk, Class_base* c):EventDispatcher(wrk,c),matrix(Class<Matrix>::getInstanceS(wrk)),tx(0),ty(0),rotation(0),
 	sx(1),sy(1),alpha(1.0),blendMode(BLENDMODE_NORMAL),isLoadedRoot(false),ismask(false),ClipDepth(0),parent(nullptr),constructed(false),useLegacyMatrix(true),
-	needsTextureRecalculation(true),textureRecalculationSkippable(false),avm1mouselistenercount(0),avm1framelistenercount(0),onStage(false),
+	needsTextureRecalculation(true),textureRecalculationSkippable(false),geometryVersion(0),avm1mouselistenercount(0),avm1framelistenercount(0),onStage(false),
 	visible(true),mask(),invalidateQueueNext(),loaderInfo(),cachedAsBitmapOf(nullptr),loadedFrom(c->getSystemState()->mainClip),hasChanged(true),legacy(false),markedForLegacyDeletion(false),cacheAsBitmap(false),
 	name(BUILTIN_STRINGS::EMPTY)
 {
@@ -115,6 +115,7 @@ DisplayObject::DisplayObject(ASWorker* wrk, Class_base* c):EventDispatcher(wrk,c
 
 void DisplayObject::markAsChanged()
 {
+	geometryVersion++;
 	if (!computeCacheAsBitmap())
 	{
 		hasChanged = true;
@@ -837,6 +838,9 @@ void DisplayObject::requestInvalidation(InvalidateQueue* q, bool forceTextureRef
 void DisplayObject::updateCachedSurface(IDrawable *d)
 {
 	// this is called only from rendering thread, so no locking done here
+	RenderThread* rt = getSystemState()->getRenderThread();
+	// the old and the new position of the surface have to be redrawn
+	rt->addDirtySurface(cachedSurface);
 	cachedSurface.xOffset=d->getXOffset();
 	cachedSurface.yOffset=d->getYOffset();
 	cachedSurface.xOffsetTransformed=d->getXOffsetTransformed();
@@ -862,6 +866,7 @@ void DisplayObject::updateCachedSurface(IDrawable *d)
 	cachedSurface.isValid=true;
 	cachedSurface.isInitialized=true;
 	cachedSurface.wasUpdated=true;
+	rt->addDirtySurface(cachedSurface);
 }
 //TODO: Fix precision issues, Adobe seems to do the matrix mult with twips and rounds the results, 
 //this way they have less pb with precision.
@@ -1519,6 +1524,7 @@ number_t DisplayObject::computeHeight()
 
 void DisplayObject::geometryChanged()
 {
+	geometryVersion++;
 	if (this->is<DisplayObjectContainer>())
 	{
 		this->as<DisplayObjectContainer>()->markBoundsRectDirtyChildren();
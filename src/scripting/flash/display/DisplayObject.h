@@ -49,6 +49,7 @@ friend class Loader;
 friend class TextField;
 friend class Shape;
 friend class Bitmap;
+friend class Video;
 friend class CairoRenderer;
 friend class Graphics;
 friend std::ostream& operator<<(std::ostream& s, const DisplayObject& r);
@@ -94,6 +95,8 @@ private:
 	bool useLegacyMatrix;
 	bool needsTextureRecalculation;
 	bool textureRecalculationSkippable;
+	// incremented by geometryChanged() and markAsChanged(), cached geometry is only valid for the version it was computed for
+	uint32_t geometryVersion;
 	void gatherMaskIDrawables(std::vector<IDrawable::MaskData>& masks);
 	std::map<uint32_t,asAtom> avm1variables;
 	std::map<uint32_t,_NR<AVM1Function>> avm1functions;
@@ -803,6 +803,10 @@ void Graphics::refreshTokens()
 		owner->tokens.canRenderToGL = tokens.canRenderToGL;
 		owner->tokens.boundsRect = tokens.boundsRect;
 		owner->owner->setNeedsTextureRecalculation(true);
+		// dorender() already called geometryChanged(), but the tokens of the owner only change now
+		owner->owner->geometryVersion++;
+		for (DisplayObjectContainer* p = owner->owner->getParent(); p; p=p->getParent())
+			p->markBoundsRectDirty();
 		needsRefresh = false;
 	}
 }
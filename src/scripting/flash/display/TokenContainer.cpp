@@ -37,6 +37,7 @@ TokenContainer::TokenContainer(DisplayObject* _o) : owner(_o)
   ,redMultiplier(1.0),greenMultiplier(1.0),blueMultiplier(1.0),alphaMultiplier(1.0)
   ,redOffset(0.0),greenOffset(0.0),blueOffset(0.0),alphaOffset(0.0)
   ,scaling(0.05),renderWithNanoVG(false)
+  ,hitTestGeometryVersion(0),hitTestTokenCount(0),hitTestScaling(0),hitTestPathsValid(false)
 {
 }
 
@@ -44,6 +45,7 @@ TokenContainer::TokenContainer(DisplayObject* _o, const tokensVector& _tokens, f
 	,redMultiplier(1.0),greenMultiplier(1.0),blueMultiplier(1.0),alphaMultiplier(1.0)
 	,redOffset(0.0),greenOffset(0.0),blueOffset(0.0),alphaOffset(0.0)
 	,scaling(_scaling),renderWithNanoVG(false)
+	,hitTestGeometryVersion(0),hitTestTokenCount(0),hitTestScaling(0),hitTestPathsValid(false)
 
 {
 	tokens.filltokens.assign(_tokens.filltokens.begin(),_tokens.filltokens.end());
@@ -60,8 +62,19 @@ bool TokenContainer::renderImpl(RenderContext& ctxt)
 		{
 			if (owner->getConcatenatedAlpha() == 0)
 				return false;
+			const MATRIX& sm = owner->cachedSurface.matrix;
+			float drawparams[] = { float(sm.xx), float(sm.yx), float(sm.xy), float(sm.yy), float(sm.x0), float(sm.y0),
+								   float(owner->cachedSurface.xOffset), float(owner->cachedSurface.yOffset),
+								   float(owner->cachedSurface.xOffsetTransformed), float(owner->cachedSurface.yOffsetTransformed),
+								   float(redMultiplier), float(greenMultiplier), float(blueMultiplier), float(alphaMultiplier),
+								   float(redOffset), float(greenOffset), float(blueOffset), float(alphaOffset),
+								   float(owner->getConcatenatedAlpha()), float(scaling), float(owner->geometryVersion), float(tokens.size()) };
+			float clipx,clipy,clipwidth,clipheight;
+			if (!((GLRenderContext&)ctxt).prepareNanoVGDraw(owner, drawparams, sizeof(drawparams)/sizeof(float), clipx, clipy, clipwidth, clipheight))
+				return false;
 			nvgResetTransform(nvgctxt);
 			nvgBeginFrame(nvgctxt, owner->getSystemState()->getRenderThread()->windowWidth, owner->getSystemState()->getRenderThread()->windowHeight, 1.0);
+			nvgScissor(nvgctxt, clipx, clipy, clipwidth, clipheight);
 			// xOffsetTransformed/yOffsetTransformed contain the offsets from the border of the window
 			nvgTranslate(nvgctxt,owner->cachedSurface.xOffsetTransformed,owner->cachedSurface.yOffsetTransformed);
 			MATRIX m = owner->cachedSurface.matrix;
@@ -262,6 +275,7 @@ bool TokenContainer::renderImpl(RenderContext& ctxt)
 			}
 			nvgClosePath(nvgctxt);
 			nvgEndFrame(nvgctxt);
+			((GLRenderContext&)ctxt).finishNanoVGDraw();
 			owner->getSystemState()->getEngineData()->exec_glStencilFunc_GL_ALWAYS();
 			owner->getSystemState()->getEngineData()->exec_glActiveTexture_GL_TEXTURE0(0);
 			owner->getSystemState()->getEngineData()->exec_glBlendFunc(BLEND_ONE,BLEND_ONE_MINUS_SRC_ALPHA);
@@ -609,12 +623,24 @@ bool TokenContainer::hitTestImpl(number_t x, number_t y) const
 	//Masks have been already checked along the way
 
 	owner->startDrawJob(); // ensure that tokens are not changed during hitTest
-	if(CairoTokenRenderer::hitTest(tokens, scaling, x, y))
+	Locker l(hitTestMutex);
+	if (!hitTestPathsValid
+		|| hitTestGeometryVersion != owner->geometryVersion
+		|| hitTestTokenCount != tokens.size()
+		|| hitTestScaling != scaling)
 	{
-		owner->endDrawJob();
-		return true;
+		CairoTokenRenderer::flattenTokens(tokens, scaling, hitTestPaths);
+		hitTestGeometryVersion = owner->geometryVersion;
+		hitTestTokenCount = tokens.size();
+		hitTestScaling = scaling;
+		hitTestPathsValid = true;
 	}
 	owner->endDrawJob();
+	for (auto it = hitTestPaths.begin(); it != hitTestPaths.end(); it++)
+	{
+		if (it->contains(x,y))
+			return true;
+	}
 	return false;
 }
 
@@ -74,6 +74,16 @@ protected:
 	bool hitTestImpl(number_t x, number_t y) const;
 	bool renderImpl(RenderContext& ctxt);
 	bool tokensEmpty() const { return tokens.empty(); }
+private:
+	/* flattened paths of the tokens for hitTestImpl, rebuilt when the
+	 * geometry of the owner has changed (see DisplayObject::geometryChanged)
+	 */
+	mutable std::vector<FlattenedPath> hitTestPaths;
+	mutable uint32_t hitTestGeometryVersion;
+	mutable uint32_t hitTestTokenCount;
+	mutable float hitTestScaling;
+	mutable bool hitTestPathsValid;
+	mutable Mutex hitTestMutex;
 };
 
 }
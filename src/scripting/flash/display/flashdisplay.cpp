@@ -20,6 +20,7 @@
 #include <list>
 
 #include "backends/security.h"
+#include "backends/config.h"
 #include "scripting/abc.h"
 #include "scripting/flash/display/flashdisplay.h"
 #include "scripting/flash/display/NativeWindow.h"
@@ -560,6 +561,9 @@ void LoaderThread::execute()
 
 	istream s(sbuf);
 	ParseThread local_pt(s,loaderInfo->applicationDomain,loaderInfo->securityDomain,loader.getPtr(),url.getParsedURL());
+	// bytes passed to loadBytes are usually generated at runtime, caching them would only fill the cache
+	if(source==URL)
+		local_pt.enableSWFCache();
 	local_pt.execute();
 
 	// Delete the bytes container (cache reader or bytes_buf)
@@ -1092,6 +1096,8 @@ ASFUNCTIONBODY_ATOM(Sprite,_setter_hitArea)
 		th->incRef();
 		th->hitArea->hitTarget = _MNR(th);
 	}
+	// the parents have to re-check if this sprite can be skipped during hit testing
+	th->geometryChanged();
 }
 
 ASFUNCTIONBODY_ATOM(Sprite,getSoundTransform)
@@ -1284,25 +1290,149 @@ bool Sprite::renderImpl(RenderContext& ctxt)
 	return ret && ret2;
 }
 
+void DisplayObjectContainer::updateHitTestIndex()
+{
+	if (!hitTestIndexDirty && hitTestBounds.size()==dynamicDisplayList.size())
+	{
+		bool changed=false;
+		for (uint32_t i=0; i < hitTestBounds.size() && !changed; i++)
+			changed = hitTestBounds[i].child != dynamicDisplayList[i];
+		if (!changed)
+			return;
+	}
+	// reset the flag first, so that changes happening during the rebuild are not lost
+	hitTestIndexDirty=false;
+	hitTestBounds.resize(dynamicDisplayList.size());
+	hitTestGrid.clear();
+	hitTestUnprunable.clear();
+	hitTestGridSize=0;
+	number_t gxmin=0,gxmax=0,gymin=0,gymax=0;
+	bool hasprunable=false;
+	for (uint32_t i=0; i < dynamicDisplayList.size(); i++)
+	{
+		DisplayObject* child = dynamicDisplayList[i];
+		HitTestBounds& b = hitTestBounds[i];
+		b.child = child;
+		b.prunable = !child->is<SimpleButton>()
+				&& !(child->is<Sprite>() && !child->as<Sprite>()->hitArea.isNull())
+				&& !(child->is<DisplayObjectContainer>() && child->as<DisplayObjectContainer>()->hasUnprunableHitTestChildren())
+				&& child->getBounds(b.xmin,b.xmax,b.ymin,b.ymax,child->getMatrix());
+		if (!b.prunable)
+		{
+			hitTestUnprunable.push_back(i);
+			continue;
+		}
+		if (hasprunable)
+		{
+			gxmin = min(gxmin,b.xmin);
+			gxmax = max(gxmax,b.xmax);
+			gymin = min(gymin,b.ymin);
+			gymax = max(gymax,b.ymax);
+		}
+		else
+		{
+			gxmin = b.xmin;
+			gxmax = b.xmax;
+			gymin = b.ymin;
+			gymax = b.ymax;
+			hasprunable=true;
+		}
+	}
+	// for a few children checking all bounds is cheaper than maintaining the grid
+	if (!hasprunable || hitTestBounds.size() < 64)
+		return;
+	hitTestGridSize = min(uint32_t(64),uint32_t(ceil(sqrt(hitTestBounds.size()/4.0))));
+	hitTestGridXmin = gxmin;
+	hitTestGridYmin = gymin;
+	hitTestGridCellWidth = max(number_t(1),(gxmax-gxmin)/hitTestGridSize);
+	hitTestGridCellHeight = max(number_t(1),(gymax-gymin)/hitTestGridSize);
+	hitTestGrid.resize(hitTestGridSize*hitTestGridSize);
+	for (uint32_t i=0; i < hitTestBounds.size(); i++)
+	{
+		const HitTestBounds& b = hitTestBounds[i];
+		if (!b.prunable)
+			continue;
+		uint32_t cx1 = min(hitTestGridSize-1,uint32_t((b.xmin-gxmin)/hitTestGridCellWidth));
+		uint32_t cx2 = min(hitTestGridSize-1,uint32_t((b.xmax-gxmin)/hitTestGridCellWidth));
+		uint32_t cy1 = min(hitTestGridSize-1,uint32_t((b.ymin-gymin)/hitTestGridCellHeight));
+		uint32_t cy2 = min(hitTestGridSize-1,uint32_t((b.ymax-gymin)/hitTestGridCellHeight));
+		for (uint32_t cy=cy1; cy <= cy2; cy++)
+		{
+			for (uint32_t cx=cx1; cx <= cx2; cx++)
+				hitTestGrid[cy*hitTestGridSize+cx].push_back(i);
+		}
+	}
+}
+
+bool DisplayObjectContainer::hasUnprunableHitTestChildren()
+{
+	Locker l(mutexDisplayList);
+	updateHitTestIndex();
+	return !hitTestUnprunable.empty();
+}
+
+void DisplayObjectContainer::getHitTestCandidates(number_t x, number_t y, std::vector<uint32_t>& candidates) const
+{
+	// merge the grid cell and the unprunable children, highest index first
+	const std::vector<uint32_t>* cell = nullptr;
+	number_t fx = (x-hitTestGridXmin)/hitTestGridCellWidth;
+	number_t fy = (y-hitTestGridYmin)/hitTestGridCellHeight;
+	if (fx >= 0 && fx <= hitTestGridSize && fy >= 0 && fy <= hitTestGridSize)
+	{
+		// the last row/column also covers the maximum edge of the grid
+		uint32_t cx = min(hitTestGridSize-1,uint32_t(fx));
+		uint32_t cy = min(hitTestGridSize-1,uint32_t(fy));
+		cell = &hitTestGrid[cy*hitTestGridSize+cx];
+	}
+	auto u = hitTestUnprunable.rbegin();
+	if (cell)
+	{
+		auto c = cell->rbegin();
+		while (c != cell->rend())
+		{
+			if (u != hitTestUnprunable.rend() && *u > *c)
+				candidates.push_back(*u++);
+			else
+				candidates.push_back(*c++);
+		}
+	}
+	while (u != hitTestUnprunable.rend())
+		candidates.push_back(*u++);
+}
+
 _NR<DisplayObject> DisplayObjectContainer::hitTestImpl(number_t x, number_t y, DisplayObject::HIT_TYPE type,bool interactiveObjectsOnly)
 {
 	_NR<DisplayObject> ret = NullRef;
 	bool hit_this=false;
 	//Test objects added at runtime, in reverse order
 	Locker l(mutexDisplayList);
-	auto j=dynamicDisplayList.rbegin();
-	for(;j!=dynamicDisplayList.rend();++j)
+	updateHitTestIndex();
+	std::vector<uint32_t> candidates;
+	if (hitTestGridSize)
+		getHitTestCandidates(x,y,candidates);
+	else
+	{
+		candidates.reserve(dynamicDisplayList.size());
+		for (uint32_t i=dynamicDisplayList.size(); i > 0; i--)
+			candidates.push_back(i-1);
+	}
+	for (auto j=candidates.begin(); j!=candidates.end(); ++j)
 	{
+		const HitTestBounds& b = hitTestBounds[*j];
+		// the point is outside of the child, so it can't be hit
+		if (b.prunable && (x < b.xmin || x > b.xmax || y < b.ymin || y > b.ymax))
+			continue;
+		DisplayObject* child = b.child;
 		//Don't check masks
-		if((*j)->isMask())
+		if(child->isMask())
 			continue;
 
-		if(!(*j)->getMatrix().isInvertible())
+		if(!child->getMatrix().isInvertible())
 			continue; /* The object is shrunk to zero size */
 
 		number_t localX, localY;
-		(*j)->getMatrix().getInverted().multiply2D(x,y,localX,localY);
-		ret=(*j)->hitTest(localX,localY,type,interactiveObjectsOnly);
+		child->getMatrix().getInverted().multiply2D(x,y,localX,localY);
+		ret=child->hitTest(localX,localY,type,interactiveObjectsOnly);
 		
 		if (!ret.isNull())
 		{
@@ -1621,6 +1751,162 @@ FrameContainer::FrameContainer():framesLoaded(0)
 
 FrameContainer::FrameContainer(const FrameContainer& f):frames(f.frames),scenes(f.scenes),framesLoaded((int)f.framesLoaded)
 {
+	// the copies share the tags of the frames, so they can share the snapshots as well
+	uint32_t interval = Config::getConfig()->getFrameSnapshotInterval();
+	if (!f.snapshots && interval)
+		f.snapshots = std::make_shared<FrameSnapshots>(interval);
+	snapshots = f.snapshots;
+}
+
+/* This runs in vm thread context, frame must be less than frames.size() */
+Frame* FrameContainer::getFrame(uint32_t frame)
+{
+	if (frameIndex.empty())
+		frameIndex.push_back(frames.begin());
+	while (frameIndex.size() <= frame)
+		frameIndex.push_back(std::next(frameIndex.back()));
+	return &(*frameIndex[frame]);
+}
+
+/* Returns the snapshot to start from if the frames from first to frame have to be executed
+ * (first is 0 if the display list was purged), or nullptr if replaying the frames is cheaper.
+ * keyframe is set to the last frame contained in the snapshot */
+const std::vector<DisplayListTag*>* FrameContainer::getSnapshot(uint32_t first, uint32_t frame, uint32_t& keyframe)
+{
+	uint32_t interval = Config::getConfig()->getFrameSnapshotInterval();
+	// the requested frame itself is not skipped, so it can't be part of the snapshot
+	if (interval == 0 || frame <= first)
+		return nullptr;
+	if (!snapshots)
+		snapshots = std::make_shared<FrameSnapshots>(interval);
+	const std::vector<DisplayListTag*>* res = snapshots->find(this,frame-1,keyframe);
+	if (!res || keyframe < first)
+		return nullptr;
+	// moving forward without a snapshot keeps the display list, only use it if it saves at least a full interval
+	if (first > 0 && keyframe+1-first < interval)
+		return nullptr;
+	return res;
+}
+
+void FrameContainer::resetFrameIndex()
+{
+	frameIndex.clear();
+	snapshots.reset();
+}
+
+void FrameSnapshots::addTag(DisplayListTag* tag)
+{
+	int32_t depth = 0;
+	uint32_t characterId = 0;
+	uint32_t properties = 0;
+	DISPLAYLIST_CHANGE change = tag->getDisplayListChange(depth,characterId,properties);
+	if (change == DISPLAYLIST_NONE)
+		return;
+	TagEntry entry = { nextSeq++, tag, properties, true };
+	auto it = depths.find(depth);
+	switch (change)
+	{
+		case DISPLAYLIST_REMOVE:
+			if (it != depths.end())
+				depths.erase(it);
+			return;
+		case DISPLAYLIST_PLACE:
+			if (it == depths.end())
+			{
+				DepthEntry& d = depths[depth];
+				d.characterId = characterId;
+				d.tags.push_back(entry);
+			}
+			else
+			{
+				// placing without moving at an occupied depth, the result depends on the current object
+				it->second.characterId = characterId;
+				it->second.tags.push_back(entry);
+			}
+			return;
+		case DISPLAYLIST_REPLACE:
+			if (it == depths.end() || (it->second.characterId != characterId
+				&& (properties & (PLACE_MATRIX|PLACE_COLORTRANSFORM)) == (PLACE_MATRIX|PLACE_COLORTRANSFORM)))
+			{
+				// the new object doesn't take anything from the replaced one
+				DepthEntry& d = depths[depth];
+				d.characterId = characterId;
+				d.tags.clear();
+				d.tags.push_back(entry);
+				return;
+			}
+			if (it->second.characterId != characterId)
+			{
+				// the new object reuses the matrix or the color transformation of the replaced one
+				it->second.characterId = characterId;
+				it->second.tags.push_back(entry);
+				return;
+			}
+			// replacing an object by the same character only modifies it
+			break;
+		case DISPLAYLIST_MODIFY:
+			if (it == depths.end())
+				return;
+			break;
+		default:
+			return;
+	}
+	// drop the modifications that are completely overwritten by this one, the first tag places the object
+	std::vector<TagEntry>& tags = it->second.tags;
+	auto t = tags.begin()+1;
+	while (t != tags.end())
+	{
+		if (!t->keep && (t->properties & ~properties) == 0)
+			t = tags.erase(t);
+		else
+			++t;
+	}
+	// clip actions are added to the object, they are never overwritten
+	entry.keep = properties & PLACE_CLIPACTIONS;
+	tags.push_back(entry);
+}
+
+void FrameSnapshots::takeSnapshot()
+{
+	std::vector<std::pair<uint32_t,DisplayListTag*>> entries;
+	for (auto it = depths.begin(); it != depths.end(); ++it)
+	{
+		for (auto t = it->second.tags.begin(); t != it->second.tags.end(); ++t)
+			entries.push_back(std::make_pair(t->seq,t->tag));
+	}
+	// execute the tags in the order of the timeline
+	std::sort(entries.begin(),entries.end());
+	snapshots.emplace_back();
+	std::vector<DisplayListTag*>& snapshot = snapshots.back();
+	snapshot.reserve(entries.size());
+	for (auto it = entries.begin(); it != entries.end(); ++it)
+		snapshot.push_back(it->second);
+}
+
+const std::vector<DisplayListTag*>* FrameSnapshots::find(FrameContainer* container, uint32_t frame, uint32_t& keyframe)
+{
+	if (frame+1 < interval)
+		return nullptr;
+	uint32_t index = (frame+1)/interval-1;
+	Locker l(mutex);
+	// the snapshots are built on demand, only from the frames the vm may access
+	uint32_t loaded = container->getFramesLoaded();
+	while (snapshots.size() <= index && nextFrame < loaded)
+	{
+		Frame* f = container->getFrame(nextFrame);
+		for (auto it = f->blueprint.begin(); it != f->blueprint.end(); ++it)
+			addTag(*it);
+		nextFrame++;
+		if (nextFrame%interval == 0)
+			takeSnapshot();
+	}
+	if (snapshots.empty())
+		return nullptr;
+	if (index >= snapshots.size())
+		index = snapshots.size()-1;
+	keyframe = (index+1)*interval-1;
+	// elements of a deque are not moved by push_back, so the snapshot can be used without the lock
+	return &snapshots[index];
 }
 
 /* This runs in parser thread context,
@@ -1695,6 +1981,7 @@ MovieClip::MovieClip(ASWorker* wrk, Class_base* c, const FrameContainer& f, uint
 bool MovieClip::destruct()
 {
 	getSystemState()->stage->removeHiddenObject(this);
+	resetFrameIndex();
 	frames.clear();
 	inAVM1Attachment=false;
 	isAVM1Loaded=false;
@@ -1729,6 +2016,7 @@ bool MovieClip::destruct()
 void MovieClip::finalize()
 {
 	getSystemState()->stage->removeHiddenObject(this);
+	resetFrameIndex();
 	frames.clear();
 	getSystemState()->stage->AVM1RemoveScriptedMovieClip(this);
 	auto it = frameScripts.begin();
@@ -2364,17 +2652,8 @@ void MovieClip::AVM1ExecuteFrameActionsFromLabel(const tiny_string &label)
 
 void MovieClip::AVM1ExecuteFrameActions(uint32_t frame)
 {
-	auto it=frames.begin();
-	uint32_t i=0;
-	while(it != frames.end() && i < frame)
-	{
-		++i;
-		++it;
-	}
-	if (it != frames.end())
-	{
-		it->AVM1executeActions(this);
-	}
+	if (frame < frames.size())
+		getFrame(frame)->AVM1executeActions(this);
 }
 
 ASFUNCTIONBODY_ATOM(MovieClip,AVM1AttachMovie)
@@ -2722,7 +3001,9 @@ void DisplayObjectContainer::sinit(Class_base* c)
 ASFUNCTIONBODY_GETTER_SETTER(DisplayObjectContainer, tabChildren)
 
 DisplayObjectContainer::DisplayObjectContainer(ASWorker* wrk, Class_base* c):InteractiveObject(wrk,c),mouseChildren(true),
-	boundsrectXmin(0),boundsrectYmin(0),boundsrectXmax(0),boundsrectYmax(0),boundsrectdirty(true),tabChildren(true)
+	boundsrectXmin(0),boundsrectYmin(0),boundsrectXmax(0),boundsrectYmax(0),boundsrectdirty(true),
+	hitTestGridXmin(0),hitTestGridYmin(0),hitTestGridCellWidth(1),hitTestGridCellHeight(1),hitTestGridSize(0),hitTestIndexDirty(true),
+	tabChildren(true)
 {
 	subtype=SUBTYPE_DISPLAYOBJECTCONTAINER;
 }
@@ -2980,6 +3261,11 @@ bool DisplayObjectContainer::destruct()
 	clearDisplayList();
 	mouseChildren = true;
 	boundsrectdirty = true;
+	hitTestIndexDirty = true;
+	hitTestBounds.clear();
+	hitTestGrid.clear();
+	hitTestUnprunable.clear();
+	hitTestGridSize = 0;
 	tabChildren = true;
 	legacyChildrenMarkedForDeletion.clear();
 	mapDepthToLegacyChild.clear();
@@ -6309,15 +6595,22 @@ void MovieClip::declareFrame()
 	{
 		if(getFramesLoaded())
 		{
-			auto iter=frames.begin();
-			for(uint32_t i=0;i<=state.FP;i++)
+			// all frames are executed again if we moved backwards
+			uint32_t first = (int)state.FP < state.last_FP ? 0 : state.last_FP+1;
+			uint32_t keyframe=0;
+			const std::vector<DisplayListTag*>* snapshot = getSnapshot(first,state.FP,keyframe);
+			if (snapshot)
 			{
-				if((int)state.FP < state.last_FP || (int)i > state.last_FP)
-				{
-					iter->execute(this,i!=state.FP);
-				}
-				++iter;
+				// build the display list of the keyframe instead of executing all frames before it
+				if (first > 0)
+					purgeLegacyChildren();
+				for (auto it = snapshot->begin(); it != snapshot->end(); ++it)
+					(*it)->execute(this,true);
+				checkClipDepth();
+				first = keyframe+1;
 			}
+			for(uint32_t i=first;i<=state.FP;i++)
+				getFrame(i)->execute(this,i!=state.FP);
 		}
 		if (newFrame)
 			state.frameadvanced=true;
@@ -6621,14 +6914,7 @@ Frame *MovieClip::getCurrentFrame()
 		LOG(LOG_ERROR,"MovieClip.getCurrentFrame invalid frame:"<<state.FP<<" "<<frames.size()<<" "<<this->toDebugString());
 		throw RunTimeException("invalid current frame");
 	}
-	auto it = frames.begin();
-	uint32_t i = 0;
-	while (i < state.FP)
-	{
-		it++;
-		i++;
-	}
-	return &(*it);
+	return getFrame(state.FP);
 }
 
 void AVM1Movie::sinit(Class_base* c)
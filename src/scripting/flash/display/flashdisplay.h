@@ -30,6 +30,8 @@
 #include "scripting/flash/display/NativeWindow.h"
 #include "abcutils.h"
 #include <unordered_set>
+#include <deque>
+#include <memory>
 
 namespace lightspark
 {
@@ -116,6 +118,26 @@ private:
 	number_t boundsrectXmax;
 	number_t boundsrectYmax;
 	bool boundsrectdirty;
+	// cached bounds of the children (in local coordinates), used to skip children that can't be hit
+	struct HitTestBounds
+	{
+		DisplayObject* child;
+		number_t xmin,xmax,ymin,ymax;
+		// false if the child may report hits outside of its bounds (SimpleButton, Sprite with hitArea)
+		bool prunable;
+	};
+	std::vector<HitTestBounds> hitTestBounds;
+	// uniform grid over the bounds of the prunable children, only built for containers with many children
+	// each cell contains the indices of the children overlapping it in ascending order
+	std::vector<std::vector<uint32_t>> hitTestGrid;
+	std::vector<uint32_t> hitTestUnprunable;
+	number_t hitTestGridXmin, hitTestGridYmin, hitTestGridCellWidth, hitTestGridCellHeight;
+	uint32_t hitTestGridSize;
+	bool hitTestIndexDirty;
+	// must be called with mutexDisplayList locked
+	void updateHitTestIndex();
+	bool hasUnprunableHitTestChildren();
+	void getHitTestCandidates(number_t x, number_t y, std::vector<uint32_t>& candidates) const;
 protected:
 	//This is shared between RenderThread and VM
 	std::vector < DisplayObject* > dynamicDisplayList;
@@ -147,7 +169,7 @@ public:
 	int getChildIndex(DisplayObject* child);
 	DisplayObjectContainer(ASWorker* wrk,Class_base* c);
 	void markAsChanged() override;
-	inline void markBoundsRectDirty() { boundsrectdirty=true; }
+	inline void markBoundsRectDirty() { boundsrectdirty=true; hitTestIndexDirty=true; }
 	void markBoundsRectDirtyChildren();
 	void setChildrenCachedAsBitmapOf(DisplayObject* cachedBitmapObject);
 	bool destruct() override;
@@ -584,8 +606,50 @@ public:
 	void removeActionTags();
 };
 
+class FrameContainer;
+/*
+ * Display lists of a timeline at every interval-th frame, stored as the PlaceObject/RemoveObject
+ * tags that are still needed to build them. Seeking to a frame executes the tags of the nearest
+ * keyframe before it and replays at most interval-1 frames after that.
+ * The snapshots are built on first use and shared by all instances of a sprite
+ */
+class FrameSnapshots
+{
+private:
+	struct TagEntry
+	{
+		uint32_t seq;
+		DisplayListTag* tag;
+		uint32_t properties;
+		// the tag can't be dropped by a later tag modifying the same properties
+		bool keep;
+	};
+	struct DepthEntry
+	{
+		uint32_t characterId;
+		std::vector<TagEntry> tags;
+	};
+	Mutex mutex;
+	uint32_t interval;
+	// current display list of the frames added so far
+	std::map<int32_t,DepthEntry> depths;
+	uint32_t nextFrame;
+	uint32_t nextSeq;
+	std::deque<std::vector<DisplayListTag*>> snapshots;
+	void addTag(DisplayListTag* tag);
+	void takeSnapshot();
+public:
+	FrameSnapshots(uint32_t _interval):interval(_interval),nextFrame(0),nextSeq(0) {}
+	/*
+	 * returns the tags building the display list of the last keyframe not after frame,
+	 * or nullptr if there is no such keyframe. The returned tags are never modified
+	 */
+	const std::vector<DisplayListTag*>* find(FrameContainer* container, uint32_t frame, uint32_t& keyframe);
+};
+
 class FrameContainer
 {
+friend class FrameSnapshots;
 protected:
 	/* This list is accessed by both the vm thread and the parsing thread,
 	 * but the parsing thread only accesses frames.back(), while
@@ -602,7 +666,16 @@ protected:
 	 * would break concurrent access.
 	 */
 	std::list<Frame> frames;
+	/* Positions of the frames accessed by the vm thread, extended on demand,
+	 * so that seeking doesn't have to walk the list of frames
+	 */
+	std::vector<std::list<Frame>::iterator> frameIndex;
+	// shared with the copies of this container
+	mutable std::shared_ptr<FrameSnapshots> snapshots;
 	std::vector<Scene_data> scenes;
+	Frame* getFrame(uint32_t frame);
+	const std::vector<DisplayListTag*>* getSnapshot(uint32_t first, uint32_t frame, uint32_t& keyframe);
+	void resetFrameIndex();
 	void addToFrame(DisplayListTag *r);
 	void addAvm1ActionToFrame(AVM1ActionTag* t);
 	void setFramesLoaded(uint32_t fl) { framesLoaded = fl; }
@@ -604,7 +604,7 @@ bool EventDispatcher::countCylicMemberReferences(garbagecollectorstate& gcstate)
 	bool ret = ASObject::countCylicMemberReferences(gcstate);
 	for (auto it = handlers.begin(); it != handlers.end(); it++)
 	{
-		for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++)
+		for (auto it2 = it->second->begin(); it2 != it->second->end(); it2++)
 			ret = asAtomHandler::getObjectNoCheck((*it2).f)->countAllCylicMemberReferences(gcstate) || ret;
 	}
 	return ret;
@@ -621,8 +621,8 @@ void EventDispatcher::prepareShutdown()
 	auto it=handlers.begin();
 	while(it!=handlers.end())
 	{
-		auto it2 = it->second.begin();
-		while (it2 != it->second.end())
+		auto it2 = it->second->begin();
+		while (it2 != it->second->end())
 		{
 			ASObject* f = asAtomHandler::getObject((*it2).f);
 			if (f)
@@ -637,17 +637,23 @@ void EventDispatcher::clearEventListeners()
 	auto it=handlers.begin();
 	while(it!=handlers.end())
 	{
-		auto it2 = it->second.begin();
-		while (it2 != it->second.end())
-		{
-			IFunction* f = asAtomHandler::as<IFunction>((*it2).f);
-			it2 = it->second.erase(it2);
-			f->removeStoredMember();
-		}
+		// a running dispatch may still use the vector, so only drop our reference to it
+		std::shared_ptr<listenerList> listeners = it->second;
 		it = handlers.erase(it);
+		for (auto it2 = listeners->begin(); it2 != listeners->end(); it2++)
+			asAtomHandler::as<IFunction>((*it2).f)->removeStoredMember();
 	}
 }
 
+EventDispatcher::listenerList& EventDispatcher::getListenersForWriting(std::shared_ptr<listenerList>& listeners)
+{
+	if (!listeners)
+		listeners = std::make_shared<listenerList>();
+	else if (listeners.use_count() > 1)
+		listeners = std::make_shared<listenerList>(*listeners);
+	return *listeners;
+}
+
 
 void EventDispatcher::sinit(Class_base* c)
 {
@@ -664,11 +670,10 @@ void EventDispatcher::sinit(Class_base* c)
 
 void EventDispatcher::dumpHandlers()
 {
-	std::map<tiny_string,list<listener> >::iterator it=handlers.begin();
-	for(;it!=handlers.end();++it)
+	for(auto it=handlers.begin();it!=handlers.end();++it)
 	{
-		for (auto it2 = it->second.begin();it2 != it->second.end(); it2++)
-			LOG(LOG_INFO, it->first<<":"<<asAtomHandler::toDebugString(it2->f));
+		for (auto it2 = it->second->begin();it2 != it->second->end(); it2++)
+			LOG(LOG_INFO, getSystemState()->getStringFromUniqueId(it->first)<<":"<<asAtomHandler::toDebugString(it2->f));
 	}
 }
 
@@ -690,11 +695,12 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 		LOG(LOG_NOT_IMPLEMENTED,"EventDispatcher::addEventListener parameter useWeakReference is ignored");
 
 	const tiny_string& eventName=asAtomHandler::toString(args[0],wrk);
+	uint32_t eventId=wrk->getSystemState()->getUniqueStringId(eventName);
 	if(wrk->isPrimordial // don't register frame listeners for background workers
-			&& th->is<DisplayObject>() && (eventName=="enterFrame"
-				|| eventName=="exitFrame"
-				|| eventName=="frameConstructed"
-				|| eventName=="render") )
+			&& th->is<DisplayObject>() && (eventId==BUILTIN_STRINGS::STRING_ENTERFRAME
+				|| eventId==BUILTIN_STRINGS::STRING_EXITFRAME
+				|| eventId==BUILTIN_STRINGS::STRING_FRAMECONSTRUCTED
+				|| eventId==BUILTIN_STRINGS::STRING_RENDER) )
 	{
 		th->getSystemState()->registerFrameListener(th->as<DisplayObject>());
 	}
@@ -702,10 +708,10 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 	{
 		Locker l(th->handlersMutex);
 		//Search if any listener is already registered for the event
-		list<listener>& listeners=th->handlers[eventName];
+		listenerList& listeners=th->getListenersForWriting(th->handlers[eventId]);
 		const listener newListener(args[1], priority, useCapture, wrk);
 		//Ordered insertion
-		list<listener>::iterator insertionPoint=lower_bound(listeners.begin(),listeners.end(),newListener);
+		listenerList::iterator insertionPoint=lower_bound(listeners.begin(),listeners.end(),newListener);
 		IFunction* newfunc = asAtomHandler::as<IFunction>(args[1]);
 		// check if a listener that matches type, use_capture and function is already registered
 		if (insertionPoint != listeners.end() && (*insertionPoint).use_capture == newListener.use_capture)
@@ -743,9 +749,10 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 	if(argslen>=3)
 		useCapture=asAtomHandler::Boolean_concrete(args[2]);
 
+	uint32_t eventId=wrk->getSystemState()->getUniqueStringId(eventName);
 	{
 		Locker l(th->handlersMutex);
-		map<tiny_string, list<listener> >::iterator h=th->handlers.find(eventName);
+		auto h=th->handlers.find(eventId);
 		if(h==th->handlers.end())
 		{
 			LOG(LOG_CALLS,"Event not found");
@@ -753,25 +760,27 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 		}
 
 		const listener ls(args[1],0,useCapture,wrk);
-		std::list<listener>::iterator it=find(h->second.begin(),h->second.end(),ls);
-		if(it!=h->second.end())
+		auto it=find(h->second->begin(),h->second->end(),ls);
+		if(it!=h->second->end())
 		{
 			ASObject* listenerfunc = asAtomHandler::getObject(it->f);
 			assert(listenerfunc);
-			h->second.erase(it);
+			size_t index=it-h->second->begin();
+			listenerList& listeners=th->getListenersForWriting(h->second);
+			listeners.erase(listeners.begin()+index);
 			listenerfunc->removeStoredMember();
 		}
-		if(h->second.empty()) //Remove the entry from the map
+		if(h->second->empty()) //Remove the entry from the map
 			th->handlers.erase(h);
 	}
 
 	// Only unregister the enterFrame listener _after_ the handlers have been erased.
-	if(th->is<DisplayObject>() && (eventName=="enterFrame"
-					|| eventName=="exitFrame"
-					|| eventName=="frameConstructed")
-				&& (!th->hasEventListener("enterFrame")
-					&& !th->hasEventListener("exitFrame")
-					&& !th->hasEventListener("frameConstructed")) )
+	if(th->is<DisplayObject>() && (eventId==BUILTIN_STRINGS::STRING_ENTERFRAME
+					|| eventId==BUILTIN_STRINGS::STRING_EXITFRAME
+					|| eventId==BUILTIN_STRINGS::STRING_FRAMECONSTRUCTED)
+				&& (!th->hasEventListener(BUILTIN_STRINGS::STRING_ENTERFRAME)
+					&& !th->hasEventListener(BUILTIN_STRINGS::STRING_EXITFRAME)
+					&& !th->hasEventListener(BUILTIN_STRINGS::STRING_FRAMECONSTRUCTED)) )
 	{
 		th->getSystemState()->unregisterFrameListener(th->as<DisplayObject>());
 	}
@@ -840,19 +849,25 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,_constructor)
 }
 
 void EventDispatcher::handleEvent(_R<Event> e)
+{
+	handleEvent(e,getSystemState()->getUniqueStringId(e->type));
+}
+
+void EventDispatcher::handleEvent(_R<Event> e, uint32_t eventId)
 {
 	check();
 	e->check();
 	Locker l(handlersMutex);
-	map<tiny_string, list<listener> >::iterator h=handlers.find(e->type);
+	auto h=handlers.find(eventId);
 	if(h==handlers.end())
 		return;
 
-	LOG(LOG_CALLS,"Handling event " << h->first<<" "<<e->getInstanceWorker());
+	LOG(LOG_CALLS,"Handling event " << e->type<<" "<<e->getInstanceWorker());
 
-	//Create a temporary copy of the listeners, as the list can be modified during the calls
-	vector<listener> tmpListener(h->second.begin(),h->second.end());
+	//Share the listeners with add/removeEventListener, they copy the vector before modifying it
+	std::shared_ptr<const listenerList> listeners=h->second;
 	l.release();
+	const listenerList& tmpListener=*listeners;
 	// listeners may be removed during the call to a listener, so we have to incref them before the call
 	// TODO how to handle listeners that are removed during the call to a listener, should they really be executed anyway?
 	for(unsigned int i=0;i<tmpListener.size();i++)
@@ -876,25 +891,28 @@ void EventDispatcher::handleEvent(_R<Event> e)
 		if (e->immediatePropagationStopped)
 			break;
 		asAtom arg0= asAtomHandler::fromObject(e.getPtr());
-		IFunction* func = asAtomHandler::as<IFunction>(tmpListener[i].f);
+		asAtom f = tmpListener[i].f;
+		IFunction* func = asAtomHandler::as<IFunction>(f);
 		asAtom v = asAtomHandler::fromObject(func->closure_this ? func->closure_this : this);
 		asAtom ret=asAtomHandler::invalidAtom;
-		asAtomHandler::callFunction(tmpListener[i].f,tmpListener[i].worker,ret,v,&arg0,1,false);
+		asAtomHandler::callFunction(f,tmpListener[i].worker,ret,v,&arg0,1,false);
 		ASATOM_DECREF(ret);
 		//And now no more, f can also be deleted
-		ASATOM_DECREF(tmpListener[i].f);
+		ASATOM_DECREF(f);
 		afterExecution(e);
 	}
 	e->check();
 }
 
 bool EventDispatcher::hasEventListener(const tiny_string& eventName)
+{
+	return hasEventListener(getSystemState()->getUniqueStringId(eventName));
+}
+
+bool EventDispatcher::hasEventListener(uint32_t eventId)
 {
 	Locker l(handlersMutex);
-	if(handlers.find(eventName)==handlers.end())
-		return false;
-	else
-		return true;
+	return handlers.find(eventId)!=handlers.end();
 }
 
 NetStatusEvent::NetStatusEvent(ASWorker* wrk, Class_base* c, const tiny_string& level, const tiny_string& code):Event(wrk,c, "netStatus"),statuscode(code)
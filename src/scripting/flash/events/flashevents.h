@@ -24,6 +24,8 @@
 #include "asobject.h"
 #include "threading.h"
 #include <string>
+#include <memory>
+#include <unordered_map>
 #include <SDL2/SDL_keycode.h>
 #undef MOUSE_EVENT
 
@@ -323,7 +325,15 @@ class EventDispatcher: public ASObject, public IEventDispatcher
 {
 private:
 	Mutex handlersMutex;
-	std::map<tiny_string,std::list<listener> > handlers;
+	/*
+	 * The listeners of every event type, keyed by the unique string id of the type
+	 * and sorted by priority. handleEvent shares the vector with the dispatch instead
+	 * of copying it, so it must be copied before it is modified while a dispatch uses it
+	 */
+	typedef std::vector<listener> listenerList;
+	std::unordered_map<uint32_t,std::shared_ptr<listenerList> > handlers;
+	// must be called with handlersMutex held
+	listenerList& getListenersForWriting(std::shared_ptr<listenerList>& listeners);
 	/*
 	 * This will be used when a target is passed to EventDispatcher constructor
 	 */
@@ -343,8 +353,11 @@ public:
 	virtual void afterHandleEvent(Event* ev) {}
 	static void sinit(Class_base*);
 	void handleEvent(_R<Event> e);
+	// eventId is the unique string id of the type of e
+	void handleEvent(_R<Event> e, uint32_t eventId);
 	void dumpHandlers();
 	bool hasEventListener(const tiny_string& eventName);
+	bool hasEventListener(uint32_t eventId);
 	virtual void defaultEventBehavior(_R<Event> e) {}
 	virtual void afterExecution(_R<Event> e) {}
 	ASFUNCTION_ATOM(_constructor);
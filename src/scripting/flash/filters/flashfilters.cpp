@@ -22,6 +22,8 @@
 #include "scripting/argconv.h"
 #include "scripting/flash/display/BitmapData.h"
 #include "scripting/flash/geom/flashgeom.h"
+#include "platforms/fastpaths.h"
+#include "swf.h"
 
 using namespace std;
 using namespace lightspark;
@@ -66,19 +68,12 @@ int SHG_TABLE[] =
 	17, 16, 17, 17, 16, 17, 15, 16, 17, 14, 17, 16, 15, 17, 16, 17, 13, 17, 16, 17, 17, 16, 17, 14, 17, 16, 17, 16, 17, 16, 17, 9
 };
 
-void BitmapFilter::applyBlur(uint8_t* data, uint32_t width, uint32_t height, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley)
+/*
+ * The original scalar implementation of the blur. It is only used to verify
+ * the results of the optimized kernels if LIGHTSPARK_VERIFY_BLUR is set.
+ */
+static void applyBlurReference(uint8_t* data, uint32_t width, uint32_t height, int radiusX, int radiusY, int quality)
 {
-	blurx*=scalex;
-	blury*=scaley;
-	int radiusX = int(round(blurx)) >> 1;
-	int radiusY = int(round(blury)) >> 1;
-	if (radiusX >= int(sizeof(MUL_TABLE)/sizeof(int)))
-		radiusX = sizeof(MUL_TABLE)/sizeof(int)-1;
-	if (radiusY >= int(sizeof(MUL_TABLE)/sizeof(int)))
-		radiusY = sizeof(MUL_TABLE)/sizeof(int)-1;
-	if (radiusX<=0 || radiusY <= 0)
-		return;
-
 	int iterations = quality;
 
 	uint8_t* px = data;
@@ -275,6 +270,69 @@ void BitmapFilter::applyBlur(uint8_t* data, uint32_t width, uint32_t height, num
 		}
 	}
 }
+
+//Bitmaps smaller than this are blurred in the calling thread
+#define BLUR_PARALLEL_MIN_PIXELS (256*256)
+//Number of rows or columns blurred by one job
+#define BLUR_PARALLEL_CHUNK 64
+
+void BitmapFilter::applyBlur(uint8_t* data, uint32_t width, uint32_t height, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley)
+{
+	blurx*=scalex;
+	blury*=scaley;
+	int radiusX = int(round(blurx)) >> 1;
+	int radiusY = int(round(blury)) >> 1;
+	if (radiusX >= int(sizeof(MUL_TABLE)/sizeof(int)))
+		radiusX = sizeof(MUL_TABLE)/sizeof(int)-1;
+	if (radiusY >= int(sizeof(MUL_TABLE)/sizeof(int)))
+		radiusY = sizeof(MUL_TABLE)/sizeof(int)-1;
+	if (radiusX<=0 || radiusY <= 0)
+		return;
+
+	static bool verify = getenv("LIGHTSPARK_VERIFY_BLUR") != nullptr;
+	uint8_t* reference = nullptr;
+	if (verify)
+	{
+		reference = new uint8_t[width*height*4];
+		memcpy(reference,data,width*height*4);
+		applyBlurReference(reference,width,height,radiusX,radiusY,quality);
+	}
+
+	int32_t w = width;
+	int32_t h = height;
+	bool parallel = width*height >= BLUR_PARALLEL_MIN_PIXELS && getSys();
+	int32_t rowchunks = (h+BLUR_PARALLEL_CHUNK-1)/BLUR_PARALLEL_CHUNK;
+	int32_t columnchunks = (w+BLUR_PARALLEL_CHUNK-1)/BLUR_PARALLEL_CHUNK;
+	for (int i = quality; i > 0; i--)
+	{
+		// rows and columns are independent of each other, but the vertical pass needs the complete horizontal pass
+		if (parallel)
+		{
+			getSys()->runParallel(rowchunks,[&](uint32_t chunk)
+			{
+				int32_t first = chunk*BLUR_PARALLEL_CHUNK;
+				fastBlurRows(data,w,first,min(first+BLUR_PARALLEL_CHUNK,h),radiusX,MUL_TABLE[radiusX],SHG_TABLE[radiusX]);
+			});
+			getSys()->runParallel(columnchunks,[&](uint32_t chunk)
+			{
+				int32_t first = chunk*BLUR_PARALLEL_CHUNK;
+				fastBlurColumns(data,w,h,first,min(first+BLUR_PARALLEL_CHUNK,w),radiusY,MUL_TABLE[radiusY],SHG_TABLE[radiusY],i==1);
+			});
+		}
+		else
+		{
+			fastBlurRows(data,w,0,h,radiusX,MUL_TABLE[radiusX],SHG_TABLE[radiusX]);
+			fastBlurColumns(data,w,h,0,w,radiusY,MUL_TABLE[radiusY],SHG_TABLE[radiusY],i==1);
+		}
+	}
+
+	if (reference)
+	{
+		if (memcmp(reference,data,width*height*4) != 0)
+			LOG(LOG_ERROR,"blur result differs from reference implementation: size " << width << "x" << height << " radius " << radiusX << "/" << radiusY << " quality " << quality);
+		delete[] reference;
+	}
+}
 void BitmapFilter::applyDropShadowFilter(BitmapContainer* target, uint8_t* tmpdata, const RECT& sourceRect, int xpos, int ypos, number_t strength, number_t alpha, uint32_t color, bool inner, bool knockout,number_t scalex,number_t scaley)
 {
 	xpos *= scalex;
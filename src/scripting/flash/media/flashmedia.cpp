@@ -32,6 +32,7 @@
 #include "scripting/toplevel/UInteger.h"
 #include "scripting/flash/utils/ByteArray.h"
 #include "scripting/flash/net/flashnet.h"
+#include "scripting/flash/display/BitmapContainer.h"
 #include <unistd.h>
 
 using namespace lightspark;
@@ -115,6 +116,8 @@ void Video::resetDecoder()
 {
 	Locker l(mutex);
 	lastuploadedframe=UINT32_MAX;
+	softwareFrame.reset();
+	softwareFrameBuffer.clear();
 	if (embeddedVideoDecoder)
 	{
 		if (embeddedVideoDecoder->isUploading())
@@ -221,13 +224,10 @@ bool Video::renderImpl(RenderContext& ctxt)
 	if(skipRender())
 		return false;
 
-	//Video is especially optimized for GL rendering
-	//It needs special treatment for SOFTWARE contextes
+	//Video is especially optimized for GL rendering, the YUV to RGB conversion is done in the shader
+	//On SOFTWARE contextes the frame has already been converted to BGRA by invalidate()
 	if(ctxt.contextType != RenderContext::GL)
-	{
-		LOG(LOG_NOT_IMPLEMENTED, "Video::renderImpl on SOFTWARE context is not yet supported");
-		return false;
-	}
+		return defaultRender(ctxt);
 
 	bool valid=false;
 	if(!netStream.isNull() && netStream->lockIfReady())
@@ -268,6 +268,72 @@ bool Video::renderImpl(RenderContext& ctxt)
 	return true;
 }
 
+void Video::requestInvalidation(InvalidateQueue* q, bool forceTextureRefresh)
+{
+	if(skipRender())
+		return;
+	DisplayObject::requestInvalidation(q);
+	//The GL path renders the decoder texture directly, a cached surface is only needed when drawing in software
+	if(!q->isSoftwareQueue)
+		return;
+	incRef();
+	q->addToInvalidateQueue(_MR(this));
+}
+
+IDrawable* Video::invalidate(DisplayObject* target, const MATRIX& initialMatrix, bool smoothing, InvalidateQueue* q, _NR<DisplayObject>* cachedBitmap)
+{
+	Locker l(mutex);
+	uint32_t frameWidth=0;
+	uint32_t frameHeight=0;
+	bool valid=false;
+	if (embeddedVideoDecoder)
+	{
+		frameWidth=embeddedVideoDecoder->getWidth();
+		frameHeight=embeddedVideoDecoder->getHeight();
+		uint32_t stride=cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, frameWidth);
+		softwareFrameBuffer.resize(stride*frameHeight);
+		valid=embeddedVideoDecoder->copyFrameBGRA(softwareFrameBuffer.data(),stride);
+	}
+	else if(!netStream.isNull() && netStream->lockIfReady())
+	{
+		frameWidth=netStream->getVideoWidth();
+		frameHeight=netStream->getVideoHeight();
+		uint32_t stride=cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, frameWidth);
+		softwareFrameBuffer.resize(stride*frameHeight);
+		valid=netStream->copyFrameBGRA(softwareFrameBuffer.data(),stride);
+		netStream->unlock();
+	}
+	if (!valid || frameWidth==0 || frameHeight==0)
+		return nullptr;
+	if (softwareFrame.isNull())
+		softwareFrame=_MR(new BitmapContainer(nullptr));
+	softwareFrame->fromRawData(softwareFrameBuffer.data(),frameWidth,frameHeight);
+
+	//The frame is stretched to the size of the Video object
+	MATRIX frameMatrix(number_t(width)/frameWidth,number_t(height)/frameHeight);
+	MATRIX totalMatrix;
+	std::vector<IDrawable::MaskData> masks;
+	bool isMask;
+	computeMasksAndMatrix(target,masks,totalMatrix,true,isMask,mask);
+	totalMatrix=initialMatrix.multiplyMatrix(totalMatrix).multiplyMatrix(frameMatrix);
+	number_t rx,ry;
+	number_t rwidth,rheight;
+	computeBoundsForTransformedRect(0,frameWidth,0,frameHeight,rx,ry,rwidth,rheight,totalMatrix);
+	if (rwidth==0 || rheight==0)
+		return nullptr;
+	cachedSurface.isValid=true;
+	//The color transform is applied by BitmapData::drawDisplayObject
+	return new BitmapRenderer(softwareFrame
+				, 0, 0, frameWidth, frameHeight
+				, rx, ry, round(rwidth), round(rheight), 0
+				, 1, 1
+				, isMask, mask
+				, getConcatenatedAlpha(), masks
+				, 1.0, 1.0, 1.0, 1.0
+				, 0.0, 0.0, 0.0, 0.0
+				, smoothing ? SMOOTH_MODE::SMOOTH_ANTIALIAS:SMOOTH_MODE::SMOOTH_NONE,totalMatrix);
+}
+
 bool Video::boundsRect(number_t& xmin, number_t& xmax, number_t& ymin, number_t& ymax)
 {
 	xmin=0;
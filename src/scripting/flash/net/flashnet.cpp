@@ -2330,6 +2330,12 @@ const TextureChunk& NetStream::getTexture() const
 	return videoDecoder->getTexture();
 }
 
+bool NetStream::copyFrameBGRA(uint8_t* dest, uint32_t stride)
+{
+	assert(isReady());
+	return videoDecoder->copyFrameBGRA(dest,stride);
+}
+
 uint32_t NetStream::getStreamTime()
 {
 	assert(isReady());
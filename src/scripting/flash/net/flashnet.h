@@ -395,6 +395,13 @@ public:
 		@return a TextureChunk ready to be blitted
 	*/
 	const TextureChunk& getTexture() const;
+	/**
+	  	Convert the current video frame to premultiplied BGRA
+
+		@pre lock on the object should be acquired and object should be ready
+		@return false if no frame is available
+	*/
+	bool copyFrameBGRA(uint8_t* dest, uint32_t stride);
 	/**
 	  	Get the stream time
 
@@ -29,6 +29,7 @@
 #include "scripting/toplevel/UInteger.h"
 #include "scripting/toplevel/XML.h"
 #include "scripting/toplevel/XMLList.h"
+#include "scripting/toplevel/RegExp.h"
 #include "scripting/toplevel/Vector.h"
 #include "parsing/streams.h"
 #include "platforms/engineutils.h"
@@ -890,7 +891,7 @@ extern uint32_t asClassCount;
 ASWorker::ASWorker(SystemState* s):
 	EventDispatcher(this,nullptr),parser(nullptr),
 	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),
-	freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(true),state("running")
+	freelist(new asfreelist[asClassCount]),regexpCache(new RegExpCache(s)),currentCallContext(nullptr),cur_recursion(0),isPrimordial(true),state("running")
 {
 	subtype = SUBTYPE_WORKER;
 	setSystemState(s);
@@ -906,7 +907,7 @@ ASWorker::ASWorker(SystemState* s):
 ASWorker::ASWorker(Class_base* c):
 	EventDispatcher(c->getSystemState()->worker,c),parser(nullptr),
 	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),
-	freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new")
+	freelist(new asfreelist[asClassCount]),regexpCache(new RegExpCache(c->getSystemState())),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new")
 {
 	subtype = SUBTYPE_WORKER;
 	// TODO: it seems that AIR applications have a higher default value for max_recursion
@@ -920,7 +921,7 @@ ASWorker::ASWorker(Class_base* c):
 ASWorker::ASWorker(ASWorker* wrk, Class_base* c):
 	EventDispatcher(wrk,c),parser(nullptr),
 	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),
-	freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new")
+	freelist(new asfreelist[asClassCount]),regexpCache(new RegExpCache(c->getSystemState())),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new")
 {
 	subtype = SUBTYPE_WORKER;
 	// TODO: it seems that AIR applications have a higher default value for max_recursion
@@ -1019,6 +1020,8 @@ void ASWorker::finalize()
 	delete[] stacktrace;
 	delete[] freelist;
 	freelist=nullptr;
+	delete regexpCache;
+	regexpCache=nullptr;
 }
 
 void ASWorker::prepareShutdown()
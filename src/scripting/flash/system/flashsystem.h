@@ -33,6 +33,7 @@ namespace lightspark
 {
 
 class SecurityDomain;
+class RegExpCache;
 struct call_context;
 
 class Capabilities: public ASObject
@@ -341,6 +342,7 @@ private:
 public:
 	asfreelist* freelist;
 	asfreelist freelist_syntheticfunction;
+	RegExpCache* regexpCache;
 	ASWorker(SystemState* s); // constructor for primordial worker only to be used in SystemState constructor
 	ASWorker(Class_base* c);
 	ASWorker(ASWorker* wrk,Class_base* c);
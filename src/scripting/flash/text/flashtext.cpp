@@ -1897,6 +1897,7 @@ bool TextField::renderImpl(RenderContext& ctxt)
 						redOffset, greenOffset, blueOffset, alphaOffset,
 						isMask, mask,3.0, tcolor,SMOOTH_MODE::SMOOTH_NONE, m);
 			}
+			getSystemState()->getRenderThread()->releaseTexture(tex);
 		}
 		number_t ypos=-TEXTFIELD_PADDING/yscale;
 		linemutex->lock();
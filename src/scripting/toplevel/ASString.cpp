@@ -166,38 +166,26 @@ ASFUNCTIONBODY_ATOM(ASString,search)
 		restr = asAtomHandler::toString(args[0],wrk);
 	}
 
-	const char* error;
-	int errorOffset;
-	pcre* pcreRE=pcre_compile(restr.raw_buf(), options, &error, &errorOffset,nullptr);
-	if(error)
+	RegExpPattern* pattern = RegExp::compile(wrk,restr,options);
+	if(!pattern)
 	{
-		pcre_free(pcreRE);
-		asAtomHandler::setInt(ret,wrk,res);
-		return;
-	}
-	int capturingGroups;
-	int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
 		asAtomHandler::setInt(ret,wrk,res);
 		return;
 	}
+	int capturingGroups = pattern->capturingGroups;
 	pcre_extra extra;
-	extra.match_limit_recursion=500;
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	pattern->fillExtra(extra,500);
 	int ovector[(capturingGroups+1)*3];
 	int offset=0;
 	//Global is not used in search
-	int rc=pcre_exec(pcreRE, &extra, data.raw_buf(), data.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+	int rc=pattern->exec(&extra, data.raw_buf(), data.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+	pattern->decRef();
 	if(rc<0)
 	{
 		//No matches or error
-		pcre_free(pcreRE);
 		asAtomHandler::setInt(ret,wrk,res);
 		return;
 	}
-	pcre_free(pcreRE);
 	res=ovector[0];
 	// pcre_exec returns byte position, so we have to convert it to character position 
 	tiny_string tmp = data.substr_bytes(0, res);
@@ -326,23 +314,15 @@ ASFUNCTIONBODY_ATOM(ASString,split)
 			return;
 		}
 
-		pcre* pcreRE = re->compile(!data.isSinglebyte());
-		if (!pcreRE)
-		{
-			ret = asAtomHandler::fromObject(res);
-			return;
-		}
-		int capturingGroups;
-		int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-		if(infoOk!=0)
+		RegExpPattern* pattern = re->compile(!data.isSinglebyte());
+		if (!pattern)
 		{
-			pcre_free(pcreRE);
 			ret = asAtomHandler::fromObject(res);
 			return;
 		}
+		int capturingGroups = pattern->capturingGroups;
 		pcre_extra extra;
-		extra.match_limit_recursion=200;
-		extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+		pattern->fillExtra(extra,200);
 		int ovector[(capturingGroups+1)*3];
 		int offset=0;
 		unsigned int end;
@@ -350,7 +330,7 @@ ASFUNCTIONBODY_ATOM(ASString,split)
 		do
 		{
 			//offset is a byte offset that must point to the beginning of an utf8 character
-			int rc=pcre_exec(pcreRE, &extra, data.raw_buf(), data.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+			int rc=pattern->exec(&extra, data.raw_buf(), data.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
 			end=ovector[0];
 			if(rc<0)
 				break;
@@ -382,7 +362,7 @@ ASFUNCTIONBODY_ATOM(ASString,split)
 			ASObject* s=abstract_s(wrk,data.substr_bytes(lastMatch,data.numBytes()-lastMatch));
 			res->push(asAtomHandler::fromObject(s));
 		}
-		pcre_free(pcreRE);
+		pattern->decRef();
 	}
 	else
 	{
@@ -988,24 +968,16 @@ ASFUNCTIONBODY_ATOM(ASString,replace)
 	{
 		RegExp* re=asAtomHandler::as<RegExp>(args[0]);
 
-		pcre* pcreRE = re->compile(!data.isSinglebyte());
-		if (!pcreRE)
+		RegExpPattern* pattern = re->compile(!data.isSinglebyte());
+		if (!pattern)
 		{
 			ret = asAtomHandler::fromObject(res);
 			return;
 		}
 
-		int capturingGroups;
-		int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-		if(infoOk!=0)
-		{
-			pcre_free(pcreRE);
-			ret = asAtomHandler::fromObject(res);
-			return;
-		}
+		int capturingGroups = pattern->capturingGroups;
 		pcre_extra extra;
-		extra.match_limit_recursion=200;
-		extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+		pattern->fillExtra(extra,200);
 		int ovector[(capturingGroups+1)*3];
 		int offset=0;
 		int retDiff=0;
@@ -1013,11 +985,11 @@ ASFUNCTIONBODY_ATOM(ASString,replace)
 		do
 		{
 			tiny_string replaceWithTmp = replaceWith;
-			int rc=pcre_exec(pcreRE, &extra, res->getData().raw_buf(), res->getData().numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+			int rc=pattern->exec(&extra, res->getData().raw_buf(), res->getData().numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
 			if(rc<0)
 			{
 				//No matches or error
-				pcre_free(pcreRE);
+				pattern->decRef();
 				ret = asAtomHandler::fromObject(res);
 				return;
 			}
@@ -1098,7 +1070,7 @@ ASFUNCTIONBODY_ATOM(ASString,replace)
 			retDiff+=replaceWithTmp.numBytes()-(ovector[1]-ovector[0]);
 		}
 		while(re->global);
-		pcre_free(pcreRE);
+		pattern->decRef();
 	}
 	else
 	{
@@ -26,6 +26,7 @@
 #include "scripting/toplevel/UInteger.h"
 #include "scripting/toplevel/Vector.h"
 #include "scripting/toplevel/RegExp.h"
+#include "scripting/toplevel/JSON.h"
 #include "scripting/flash/utils/flashutils.h"
 #include <algorithm>
 
@@ -2379,23 +2380,20 @@ void Array::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap
 	}
 }
 
-tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string& spaces,const tiny_string& filter)
+void Array::toJSON(JSONWriter& out, std::vector<ASObject *> &path, asAtom replacer, const tiny_string& spaces,const tiny_string& filter)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (call_toJSON(out,path,replacer,spaces,filter))
+		return;
 	// check for cylic reference
 	if (std::find(path.begin(),path.end(), this) != path.end())
 	{
 		createError<TypeError>(getInstanceWorker(),kJSONCyclicStructure);
-		return res;
+		return;
 	}
 	
 	path.push_back(this);
-	res += "[";
+	out.append('[');
 	bool bfirst = true;
-	tiny_string newline = (spaces.empty() ? "" : "\n");
 	uint32_t denseCount = currentsize;
 	asAtom closure = asAtomHandler::isValid(replacer) && asAtomHandler::getClosure(replacer) ? asAtomHandler::fromObject(asAtomHandler::getClosure(replacer)) : asAtomHandler::nullAtom;
 	
@@ -2410,7 +2408,12 @@ tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			if (it != data_second.end())
 				a = it->second;
 		}
-		tiny_string subres;
+		// the separator is removed again if nothing is written for the element
+		uint32_t start = out.size();
+		if (!bfirst)
+			out.append(',');
+		out.appendIndent(spaces,spaces.numBytes());
+		uint32_t valuestart = out.size();
 		if (asAtomHandler::isValid(replacer) && asAtomHandler::isValid(a))
 		{
 			asAtom params[2];
@@ -2421,40 +2424,31 @@ tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			asAtomHandler::callFunction(replacer,getInstanceWorker(),funcret,closure, params, 2,false);
 			if (asAtomHandler::isValid(funcret))
 			{
-				subres = asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(path,asAtomHandler::invalidAtom,spaces,filter);
+				asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(out,path,asAtomHandler::invalidAtom,spaces,filter);
 				ASATOM_DECREF(funcret);
 			}
 		}
-		else
+		else if (!out.appendPrimitive(asAtomHandler::isInvalid(a) ? asAtomHandler::nullAtom : a))
 		{
 			asAtom tmp = a;
 			bool newobj = !asAtomHandler::isInvalid(a) && !asAtomHandler::isObject(a); // member is not a pointer to an ASObject, so toObject() will create a temporary ASObject that has to be decreffed after usage
 			ASObject* o = asAtomHandler::isInvalid(a) ? getSystemState()->getNullRef() : asAtomHandler::toObject(tmp,getInstanceWorker());
 			if (o)
 			{
-				subres = o->toJSON(path,replacer,spaces,filter);
+				o->toJSON(out,path,replacer,spaces,filter);
 				if (newobj)
 					o->decRef();
 			}
-			else
-				continue;
 		}
-		if (!subres.empty())
-		{
-			if (!bfirst)
-				res += ",";
-			res += newline+spaces;
-			
+		if (out.size() == valuestart)
+			out.truncate(start);
+		else
 			bfirst = false;
-			res += subres;
-		}
 	}
 	if (!bfirst)
-		res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
-	res += "]";
+		out.appendIndent(spaces,spaces.numBytes()/2);
+	out.append(']');
 	path.pop_back();
-	return res;
-	
 }
 
 Array::~Array()
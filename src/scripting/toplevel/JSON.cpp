@@ -20,6 +20,12 @@
 #include "scripting/argconv.h"
 #include "scripting/toplevel/JSON.h"
 #include "scripting/toplevel/Integer.h"
+#include "scripting/toplevel/UInteger.h"
+#include "scripting/toplevel/Number.h"
+#include "scripting/toplevel/Boolean.h"
+#include "scripting/toplevel/ASString.h"
+#include "scripting/class.h"
+#include <cerrno>
 
 using namespace std;
 using namespace lightspark;
@@ -146,59 +152,200 @@ ASFUNCTIONBODY_ATOM(JSON,_stringify)
 				spaces = spaces.substr_bytes(0,10);
 		}
 	}
-	tiny_string res;
+	JSONWriter out(wrk);
 	if (asAtomHandler::isObject(value))
-		res = asAtomHandler::getObjectNoCheck(value)->toJSON(path,replacer,spaces,filter);
+		asAtomHandler::getObjectNoCheck(value)->toJSON(out,path,replacer,spaces,filter);
 	else if (asAtomHandler::isUndefined(value))
-		res ="null";
+		out.append("null");
 	else if(asAtomHandler::isString(value))
-		res = asAtomHandler::toString(value,wrk).toQuotedString();
+		out.appendQuoted(asAtomHandler::toString(value,wrk));
 	else
-		res = asAtomHandler::toString(value,wrk);
-	ret = asAtomHandler::fromObject(abstract_s(wrk,res));
+		out.append(asAtomHandler::toString(value,wrk));
+	ret = asAtomHandler::fromObject(abstract_s(wrk,out.toString()));
+}
+
+// the same lookup ASObject::call_toJSON does for the temporary objects of primitive values
+static bool classHasToJSON(Class_base* c, const multiname& name, ASWorker* wrk)
+{
+	if (c->borrowedVariables.findObjVar(c->getSystemState(),name,DECLARED_TRAIT)!=nullptr)
+		return true;
+	Prototype* proto = c->getPrototype(wrk);
+	while(proto)
+	{
+		if(proto->getObj()->hasPropertyByMultiname(name,true,false,wrk))
+			return true;
+		proto=proto->prevPrototype.getPtr();
+	}
+	return false;
+}
+
+JSONWriter::JSONWriter(ASWorker* _wrk):wrk(_wrk),directPrimitives(true)
+{
+	SystemState* sys = wrk->getSystemState();
+	multiname toJSONName(nullptr);
+	toJSONName.name_type=multiname::NAME_STRING;
+	toJSONName.name_s_id=sys->getUniqueStringId("toJSON");
+	toJSONName.ns.emplace_back(sys,BUILTIN_STRINGS::EMPTY,NAMESPACE);
+	toJSONName.ns.emplace_back(sys,BUILTIN_STRINGS::STRING_AS3NS,NAMESPACE);
+	toJSONName.isAttribute = false;
+	// toJSON methods are usually not added to the builtin classes, so this is only checked once per call of stringify
+	Class_base* classes[] = { Class<ASString>::getClass(sys), Class<Number>::getClass(sys), Class<Integer>::getClass(sys),
+							  Class<UInteger>::getClass(sys), Class<Boolean>::getClass(sys) };
+	for (uint32_t i = 0; i < sizeof(classes)/sizeof(classes[0]); i++)
+	{
+		if (classHasToJSON(classes[i],toJSONName,wrk))
+		{
+			directPrimitives = false;
+			break;
+		}
+	}
+}
+
+void JSONWriter::appendQuoted(const tiny_string& s)
+{
+	buf.push_back('\"');
+	const char* it = s.raw_buf();
+	const char* end = it+s.numBytes();
+	while (it != end)
+	{
+		// copy runs of characters that don't need escaping at once
+		const char* start = it;
+		while (it != end && (unsigned char)*it >= 0x20 && (unsigned char)*it < 0x80 && *it != '\"' && *it != '\\')
+			it++;
+		buf.append(start,it-start);
+		if (it == end)
+			break;
+		uint32_t c = g_utf8_get_char(it);
+		const char* next = g_utf8_next_char(it);
+		switch (c)
+		{
+			case '\b':
+				buf.append("\\b");
+				break;
+			case '\f':
+				buf.append("\\f");
+				break;
+			case '\n':
+				buf.append("\\n");
+				break;
+			case '\r':
+				buf.append("\\r");
+				break;
+			case '\t':
+				buf.append("\\t");
+				break;
+			case '\"':
+				buf.append("\\\"");
+				break;
+			case '\\':
+				buf.append("\\\\");
+				break;
+			default:
+				if ((c < 0x20) || (c > 0xff))
+				{
+					char hexstr[16];
+					snprintf(hexstr,sizeof(hexstr),"\\u%04x",c);
+					buf.append(hexstr);
+				}
+				else
+					buf.append(it,next-it);
+				break;
+		}
+		it = next;
+	}
+	buf.push_back('\"');
+}
+
+void JSONWriter::appendNumber(number_t n)
+{
+	if (std::isnan(n) || std::isinf(n))
+		buf.append("null");
+	else
+		append(Number::toString(n));
+}
+
+bool JSONWriter::appendPrimitive(asAtom a)
+{
+	if (asAtomHandler::isInvalid(a))
+		return false;
+	char numstr[20];
+	switch (asAtomHandler::getObjectType(a))
+	{
+		case T_NULL:
+		case T_UNDEFINED:
+			buf.append("null");
+			return true;
+		case T_INTEGER:
+			if (!directPrimitives)
+				return false;
+			buf.append(numstr,snprintf(numstr,sizeof(numstr),"%i",asAtomHandler::toInt(a)));
+			return true;
+		case T_UINTEGER:
+			if (!directPrimitives)
+				return false;
+			buf.append(numstr,snprintf(numstr,sizeof(numstr),"%u",asAtomHandler::toUInt(a)));
+			return true;
+		case T_NUMBER:
+			if (!directPrimitives)
+				return false;
+			appendNumber(asAtomHandler::toNumber(a));
+			return true;
+		case T_BOOLEAN:
+			if (!directPrimitives)
+				return false;
+			buf.append(asAtomHandler::Boolean_concrete(a) ? "true" : "false");
+			return true;
+		case T_STRING:
+			if (!directPrimitives)
+				return false;
+			appendQuoted(asAtomHandler::toString(a,wrk));
+			return true;
+		default:
+			return false;
+	}
+}
+
+static inline void skipWhitespace(const char*& it, const char* end)
+{
+	while (it != end && (*it == ' ' ||
+						 *it == '\t' ||
+						 *it == '\n' ||
+						 *it == '\r'))
+		it++;
 }
 
 bool JSON::parseAll(const tiny_string &jsonstring, asAtom& parent , multiname& key, asAtom reviver, ASWorker* wrk)
 {
-	CharIterator it = jsonstring.begin();
-	while (it != jsonstring.end())
+	const char* it = jsonstring.raw_buf();
+	const char* end = it+jsonstring.numBytes();
+	while (it != end)
 	{
 		if (asAtomHandler::isPrimitive(parent))
 			return false;
-		if (!parse(jsonstring, it, parent , key, reviver,wrk))
+		if (!parse(it, end, parent , key, reviver,wrk))
 			return false;
-		while (*it == ' ' ||
-			   *it == '\t' ||
-			   *it == '\n' ||
-			   *it == '\r'
-			   )
-			it++;
+		skipWhitespace(it,end);
 	}
 	return true;
 }
-bool JSON::parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent , multiname& key, asAtom reviver, ASWorker* wrk)
+bool JSON::parse(const char*& it, const char* end, asAtom& parent , multiname& key, asAtom reviver, ASWorker* wrk)
 {
-	while (*it == ' ' ||
-		   *it == '\t' ||
-		   *it == '\n' ||
-		   *it == '\r'
-		   )
-		   it++;
-	if (it != jsonstring.end())
+	skipWhitespace(it,end);
+	if (it != end)
 	{
 		char c = *it;
 		switch(c)
 		{
 			case '{':
-				if (!parseObject(jsonstring,it,parent,key, reviver,wrk))
+				if (!parseObject(it,end,parent,key, reviver,wrk))
 					return false;
 				break;
 			case '[': 
-				if (!parseArray(jsonstring,it,parent,key, reviver,wrk))
+				if (!parseArray(it,end,parent,key, reviver,wrk))
 					return false;
 				break;
 			case '"':
-				if (!parseString(jsonstring,it,parent,key,wrk))
+				if (!parseString(it,end,parent,key,wrk))
 					return false;
 				break;
 			case '0':
@@ -212,19 +359,19 @@ bool JSON::parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent
 			case '8':
 			case '9':
 			case '-':
-				if (!parseNumber(jsonstring,it,parent,key,wrk))
+				if (!parseNumber(it,end,parent,key,wrk))
 					return false;
 				break;
 			case 't':
-				if (!parseTrue(it,parent,key,wrk))
+				if (!parseLiteral(it,end,"true",4) || !setValue(parent,key,asAtomHandler::trueAtom,wrk))
 					return false;
 				break;
 			case 'f':
-				if (!parseFalse(it,parent,key,wrk))
+				if (!parseLiteral(it,end,"false",5) || !setValue(parent,key,asAtomHandler::falseAtom,wrk))
 					return false;
 				break;
 			case 'n':
-				if (!parseNull(it,parent,key,wrk))
+				if (!parseLiteral(it,end,"null",4) || !setValue(parent,key,asAtomHandler::nullAtom,wrk))
 					return false;
 				break;
 			default:
@@ -232,146 +379,122 @@ bool JSON::parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent
 		}
 	}
 	if (asAtomHandler::isValid(reviver))
+		return revive(parent,key,reviver,wrk);
+	return true;
+}
+bool JSON::revive(asAtom& parent, multiname& key, asAtom reviver, ASWorker* wrk)
+{
+	bool haskey = key.name_type!= multiname::NAME_OBJECT;
+	asAtom params[2];
+	
+	if (haskey)
 	{
-		bool haskey = key.name_type!= multiname::NAME_OBJECT;
-		asAtom params[2];
-		
-		if (haskey)
+		params[0] = asAtomHandler::fromObject(abstract_s(wrk,key.normalizedName(wrk->getSystemState())));
+		if (asAtomHandler::isObject(parent) && asAtomHandler::getObjectNoCheck(parent)->hasPropertyByMultiname(key,true,false,wrk))
 		{
-			params[0] = asAtomHandler::fromObject(abstract_s(wrk,key.normalizedName(wrk->getSystemState())));
-			if (asAtomHandler::isObject(parent) && asAtomHandler::getObjectNoCheck(parent)->hasPropertyByMultiname(key,true,false,wrk))
-			{
-				asAtomHandler::getObjectNoCheck(parent)->getVariableByMultiname(params[1],key,GET_VARIABLE_OPTION::NONE,wrk);
-			}
-			else
-				params[1] = asAtomHandler::nullAtom;
+			asAtomHandler::getObjectNoCheck(parent)->getVariableByMultiname(params[1],key,GET_VARIABLE_OPTION::NONE,wrk);
 		}
 		else
-		{
-			params[0] = asAtomHandler::fromStringID(BUILTIN_STRINGS::EMPTY);
-			params[1] = parent;
-			ASATOM_INCREF(params[1]);
-		}
+			params[1] = asAtomHandler::nullAtom;
+	}
+	else
+	{
+		params[0] = asAtomHandler::fromStringID(BUILTIN_STRINGS::EMPTY);
+		params[1] = parent;
+		ASATOM_INCREF(params[1]);
+	}
 
-		asAtom funcret=asAtomHandler::invalidAtom;
-		asAtom closure = asAtomHandler::getClosure(reviver) ? asAtomHandler::fromObject(asAtomHandler::getClosure(reviver)) : asAtomHandler::nullAtom;
-		ASATOM_INCREF(closure);
-		asAtomHandler::callFunction(reviver,wrk,funcret,closure, params, 2,true);
-		if(asAtomHandler::isValid(funcret))
+	asAtom funcret=asAtomHandler::invalidAtom;
+	asAtom closure = asAtomHandler::getClosure(reviver) ? asAtomHandler::fromObject(asAtomHandler::getClosure(reviver)) : asAtomHandler::nullAtom;
+	ASATOM_INCREF(closure);
+	asAtomHandler::callFunction(reviver,wrk,funcret,closure, params, 2,true);
+	if(asAtomHandler::isValid(funcret))
+	{
+		if (haskey)
 		{
-			if (haskey)
+			if (asAtomHandler::isUndefined(funcret))
 			{
-				if (asAtomHandler::isUndefined(funcret))
-				{
-					if (asAtomHandler::isObject(parent))
-						asAtomHandler::getObjectNoCheck(parent)->deleteVariableByMultiname(key,wrk);
-				}
-				else
-				{
-					if (asAtomHandler::isObject(parent))
-					{
-						bool alreadyset=false;
-						asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,funcret,ASObject::CONST_NOT_ALLOWED,&alreadyset,wrk);
-						if (alreadyset)
-							ASATOM_DECREF(funcret)
-					}
-					else
-						return false;
-				}
+				if (asAtomHandler::isObject(parent))
+					asAtomHandler::getObjectNoCheck(parent)->deleteVariableByMultiname(key,wrk);
 			}
-			else 
+			else
 			{
-				if (parent.uintval == funcret.uintval)
+				if (asAtomHandler::isObject(parent))
 				{
-					ASATOM_DECREF(funcret)
+					bool alreadyset=false;
+					asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,funcret,ASObject::CONST_NOT_ALLOWED,&alreadyset,wrk);
+					if (alreadyset)
+						ASATOM_DECREF(funcret)
 				}
 				else
-				{
-					ASATOM_DECREF(parent);
-					parent= funcret;
-				}
+					return false;
+			}
+		}
+		else 
+		{
+			if (parent.uintval == funcret.uintval)
+			{
+				ASATOM_DECREF(funcret)
+			}
+			else
+			{
+				ASATOM_DECREF(parent);
+				parent= funcret;
 			}
 		}
-		else
-			return false;
-	}
-	return true;
-}
-bool JSON::parseTrue(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
-{
-	if (*it++ != 't')
-		return false;
-	if (*it++ != 'r')
-		return false;
-	if (*it++ != 'u')
-		return false;
-	if (*it++ != 'e')
-		return false;
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::trueAtom;
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::trueAtom;
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
 	}
 	else
 		return false;
 	return true;
 }
-bool JSON::parseFalse(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
+bool JSON::setValue(asAtom& parent, multiname& key, asAtom v, ASWorker* wrk)
 {
-	if (*it++ != 'f')
-		return false;
-	if (*it++ != 'a')
-		return false;
-	if (*it++ != 'l')
-		return false;
-	if (*it++ != 's')
-		return false;
-	if (*it++ != 'e')
-		return false;
 	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::falseAtom;
+		parent = v;
 	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::falseAtom;
 		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
 	else
+	{
+		ASATOM_DECREF(v);
 		return false;
+	}
 	return true;
 }
-bool JSON::parseNull(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
+bool JSON::parseLiteral(const char*& it, const char* end, const char* literal, uint32_t len)
 {
-	if (*it++ != 'n')
-		return false;
-	if (*it++ != 'u')
-		return false;
-	if (*it++ != 'l')
-		return false;
-	if (*it++ != 'l')
-		return false;
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::nullAtom;
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::nullAtom;
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
-	else
+	if (uint32_t(end-it) < len || strncmp(it,literal,len) != 0)
 		return false;
+	it += len;
 	return true;
 }
-bool JSON::parseString(const tiny_string& jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk, tiny_string* result)
+static inline int hexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c-'0';
+	if (c >= 'a' && c <= 'f')
+		return c-'a'+10;
+	if (c >= 'A' && c <= 'F')
+		return c-'A'+10;
+	return -1;
+}
+bool JSON::parseString(const char*& it, const char* end, asAtom& parent, multiname &key, ASWorker* wrk, tiny_string* result)
 {
 	it++; // ignore starting quotes
-	if (it == jsonstring.end())
+	if (it == end)
 		return false;
 
-	tiny_string res;
+	std::string res;
 	bool done = false;
-	while (it!=jsonstring.end())
+	while (it!=end)
 	{
+		// copy everything up to the next quote, escape sequence or invalid character at once,
+		// this includes the bytes of multibyte characters, as they are never below 0x80
+		const char* start = it;
+		while (it != end && *it != '\"' && *it != '\\' && (unsigned char)*it >= 0x20)
+			it++;
+		res.append(start,it-start);
+		if (it == end)
+			break;
 		if (*it == '\"')
 		{
 			it++;
@@ -381,166 +504,125 @@ bool JSON::parseString(const tiny_string& jsonstring, CharIterator& it, asAtom&
 		else if(*it == '\\')
 		{
 			it++;
-			if (it == jsonstring.end())
+			if (it == end)
 				break;
-			if(*it == '\"')
-				res += '\"';
-			else if(*it == '\\')
-				res += '\\';
-			else if(*it == '/')
-				res += '/';
-			else if(*it == 'b')
-				res += '\b';
-			else if(*it == 'f')
-				res += '\f';
-			else if(*it == 'n')
-				res += '\n';
-			else if(*it == 'r')
-				res += '\r';
-			else if(*it == 't')
-				res += '\t';
-			else if(*it == 'u')
+			switch (*it)
 			{
-				tiny_string strhex;
-				for (int i = 0; i < 4; i++)
+				case '\"':
+					res += '\"';
+					break;
+				case '\\':
+					res += '\\';
+					break;
+				case '/':
+					res += '/';
+					break;
+				case 'b':
+					res += '\b';
+					break;
+				case 'f':
+					res += '\f';
+					break;
+				case 'n':
+					res += '\n';
+					break;
+				case 'r':
+					res += '\r';
+					break;
+				case 't':
+					res += '\t';
+					break;
+				case 'u':
 				{
-					it++;
-					if (it == jsonstring.end())
-						return false;
-					switch(*it)
+					uint32_t hexnum = 0;
+					for (int i = 0; i < 4; i++)
 					{
-						case '0':
-						case '1':
-						case '2':
-						case '3':
-						case '4':
-						case '5':
-						case '6':
-						case '7':
-						case '8':
-						case '9':
-						case 'a':
-						case 'b':
-						case 'c':
-						case 'd':
-						case 'e':
-						case 'f':
-						case 'A':
-						case 'B':
-						case 'C':
-						case 'D':
-						case 'E':
-						case 'F':
-							strhex += *it;
-							break;
-						default:
+						it++;
+						if (it == end)
 							return false;
+						int v = hexValue(*it);
+						if (v < 0)
+							return false;
+						hexnum = (hexnum<<4) | v;
 					}
-					if (it == jsonstring.end())
-						return false;
-				}
-				number_t hexnum;
-				if (Integer::fromStringFlashCompatible(strhex.raw_buf(),hexnum,16))
-				{
 					if (hexnum < 0x20 && hexnum != 0xf)
 						return false;
-					res += tiny_string::fromChar(hexnum);
-				}
-				else
+					tiny_string c = tiny_string::fromChar(hexnum);
+					res.append(c.raw_buf(),c.numBytes());
 					break;
+				}
+				default:
+					return false;
 			}
-			else
-				return false;
 		}
-		else if (*it < 0x20)
-			return false;
 		else
-		{
-			res += *it;
-		}
+			return false;
 		it++;
 	}
 	if (!done)
 		return false;
 	
 	if (result)
-		*result =res;
+		*result = res;
 	else
+		return setValue(parent,key,asAtomHandler::fromObject(abstract_s(wrk,tiny_string(res))),wrk);
+	return true;
+}
+bool JSON::parseNumber(const char*& it, const char* end, asAtom& parent, multiname &key, ASWorker* wrk)
+{
+	const char* start = it;
+	bool isInteger = true;
+	while (it != end)
 	{
-		if (asAtomHandler::isInvalid(parent))
-			parent = asAtomHandler::fromObject(abstract_s(wrk,res));
-		else if (asAtomHandler::isObject(parent))
+		char c = *it;
+		if (c >= '0' && c <= '9')
+			it++;
+		else if (c == '-' || c == '+' || c == '.' || c == 'E' || c == 'e')
 		{
-			asAtom v = asAtomHandler::fromObject(abstract_s(wrk,res));
-			asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
+			isInteger = isInteger && c == '-' && it == start;
+			it++;
 		}
 		else
-			return false;
+			break;
 	}
-	return true;
-}
-bool JSON::parseNumber(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
-{
-	tiny_string res;
-	bool done = false;
-	while (!done && it != jsonstring.end())
+	number_t num;
+	const char* digits = *start == '-' ? start+1 : start;
+	if (isInteger && it != digits && it-digits <= 15)
 	{
-		char c = *it;
-		switch(c)
+		// integers that are exactly representable are converted directly
+		int64_t v = 0;
+		for (const char* p = digits; p != it; p++)
+			v = v*10 + (*p-'0');
+		num = *start == '-' ? -(number_t)v : (number_t)v;
+	}
+	else
+	{
+		// same conversion as ASString::toNumber, the token can't contain spaces or "Infinity"
+		std::string token(start,it-start);
+		char* tokenend = nullptr;
+		errno = 0;
+		num = g_ascii_strtod(token.c_str(), &tokenend);
+		if (errno == ERANGE)
 		{
-			case '0':
-			case '1':
-			case '2':
-			case '3':
-			case '4':
-			case '5':
-			case '6':
-			case '7':
-			case '8':
-			case '9':
-			case '-':
-			case '+':
-			case '.':
-			case 'E':
-			case 'e':
-				res += c;
-				it++;
-				break;
-			default:
-				done = true;
-				break;
+			if (num == HUGE_VAL)
+				num = numeric_limits<double>::infinity();
+			else if (num == -HUGE_VAL)
+				num = -numeric_limits<double>::infinity();
 		}
+		if (*tokenend)
+			num = numeric_limits<double>::quiet_NaN();
 	}
-	ASObject* numstr = abstract_s(wrk,res);
-	number_t num = numstr->toNumber();
-	numstr->decRef();
 
 	if (std::isnan(num))
 		return false;
 
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::fromNumber(wrk,num,false);
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::fromNumber(wrk,num,false);
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
-	else
-		return false;
-	return true;
+	return setValue(parent,key,asAtomHandler::fromNumber(wrk,num,false),wrk);
 }
-bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
+bool JSON::parseObject(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
 {
 	it++; // ignore '{' or ','
 	ASObject* subobj = Class<ASObject>::getInstanceS(wrk);
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::fromObject(subobj);
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::fromObject(subobj);
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
-	else
+	if (!setValue(parent,key,asAtomHandler::fromObject(subobj),wrk))
 		return false;
 	multiname name(nullptr);
 	name.name_type=multiname::NAME_STRING;
@@ -551,14 +633,11 @@ bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom&
 	bool needkey = true;
 	bool needvalue = false;
 
-	while (!done && it != jsonstring.end())
+	while (!done && it != end)
 	{
-		while (*it == ' ' ||
-			   *it == '\t' ||
-			   *it == '\n' ||
-			   *it == '\r'
-			   )
-			it++;
+		skipWhitespace(it,end);
+		if (it == end)
+			break;
 		char c = *it;
 		switch(c)
 		{
@@ -572,7 +651,7 @@ bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom&
 				{
 					tiny_string keyname;
 					asAtom p = asAtomHandler::invalidAtom;
-					if (!parseString(jsonstring,it,p,name,wrk,&keyname))
+					if (!parseString(it,end,p,name,wrk,&keyname))
 						return false;
 					name.name_s_id=wrk->getSystemState()->getUniqueStringId(keyname);
 					needkey = false;
@@ -590,7 +669,7 @@ bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom&
 			{
 				it++;
 				asAtom p = asAtomHandler::fromObjectNoPrimitive(subobj);
-				if (!parse(jsonstring,it,p,name,reviver,wrk))
+				if (!parse(it,end,p,name,reviver,wrk))
 					return false;
 				needvalue = false;
 				break;
@@ -603,18 +682,11 @@ bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom&
 	return done;
 }
 
-bool JSON::parseArray(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
+bool JSON::parseArray(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
 {
 	it++; // ignore '['
 	ASObject* subobj = Class<Array>::getInstanceSNoArgs(wrk);
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::fromObject(subobj);
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::fromObject(subobj);
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
-	else
+	if (!setValue(parent,key,asAtomHandler::fromObject(subobj),wrk))
 		return false;
 	multiname name(nullptr);
 	name.name_type=multiname::NAME_UINT;
@@ -623,14 +695,11 @@ bool JSON::parseArray(const tiny_string &jsonstring, CharIterator& it, asAtom& p
 	name.isAttribute = false;
 	bool done = false;
 	bool needdata = false;
-	while (!done && it != jsonstring.end())
+	while (!done && it != end)
 	{
-		while (*it == ' ' ||
-			   *it == '\t' ||
-			   *it == '\n' ||
-			   *it == '\r'
-			   )
-			it++;
+		skipWhitespace(it,end);
+		if (it == end)
+			break;
 		char c = *it;
 		switch(c)
 		{
@@ -646,7 +715,7 @@ bool JSON::parseArray(const tiny_string &jsonstring, CharIterator& it, asAtom& p
 			default:
 			{
 				asAtom p = asAtomHandler::fromObjectNoPrimitive(subobj);
-				if (!parse(jsonstring,it,p,name, reviver,wrk))
+				if (!parse(it,end,p,name, reviver,wrk))
 					return false;
 				needdata = false;
 				break;
@@ -25,6 +25,44 @@
 namespace lightspark
 {
 
+/*
+ * Output buffer of JSON.stringify. All values are appended to one buffer that
+ * grows geometrically, the result string is only created once at the end
+ */
+class JSONWriter
+{
+private:
+	std::string buf;
+	ASWorker* wrk;
+	// primitive values are written directly if no toJSON method was added to their classes
+	bool directPrimitives;
+public:
+	JSONWriter(ASWorker* _wrk);
+	void append(char c) { buf.push_back(c); }
+	void append(const char* s) { buf.append(s); }
+	void append(const tiny_string& s) { buf.append(s.raw_buf(),s.numBytes()); }
+	// appends a newline and len bytes of the indentation, nothing if no indentation is used
+	void appendIndent(const tiny_string& spaces, uint32_t len)
+	{
+		if (spaces.empty())
+			return;
+		buf.push_back('\n');
+		buf.append(spaces.raw_buf(),len);
+	}
+	// same output as tiny_string::toQuotedString
+	void appendQuoted(const tiny_string& s);
+	void appendNumber(number_t n);
+	/*
+	 * appends a value that is not a real object without creating a temporary object for it,
+	 * returns false if the value has to be written by its toJSON method
+	 */
+	bool appendPrimitive(asAtom a);
+	uint32_t size() const { return buf.size(); }
+	// removes everything appended after the first len bytes
+	void truncate(uint32_t len) { buf.resize(len); }
+	tiny_string toString() const { return tiny_string(buf); }
+};
+
 class JSON : public ASObject
 {
 public:
@@ -37,15 +75,20 @@ public:
 	ASFUNCTION_ATOM(_stringify);
 	static bool doParse(asAtom& res,const tiny_string &jsonstring, asAtom reviver, ASWorker* wrk);
 private:
+	/*
+	 * The parser works on the UTF-8 bytes of the string, it points to the next byte
+	 * and end behind the last one. All JSON tokens are ASCII and multibyte characters
+	 * only have to be copied, so the string doesn't have to be decoded
+	 */
 	static bool parseAll(const tiny_string &jsonstring, asAtom& parent , multiname &key, asAtom reviver, ASWorker* wrk);
-	static bool parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
-	static bool parseTrue(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseFalse(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseNull(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseString(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk, tiny_string *result = nullptr);
-	static bool parseNumber(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
-	static bool parseArray(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	static bool parse(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	static bool revive(asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	static bool setValue(asAtom& parent, multiname &key, asAtom v, ASWorker* wrk);
+	static bool parseLiteral(const char*& it, const char* end, const char* literal, uint32_t len);
+	static bool parseString(const char*& it, const char* end, asAtom& parent, multiname &key, ASWorker* wrk, tiny_string *result = nullptr);
+	static bool parseNumber(const char*& it, const char* end, asAtom& parent, multiname &key, ASWorker* wrk);
+	static bool parseObject(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	static bool parseArray(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
 };
 
 }
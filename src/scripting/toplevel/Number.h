@@ -46,7 +46,8 @@ public:
 		number_t dval;
 		int64_t ival;
 	};
-	bool isfloat:1;
+	// not a bitfield, so the baseline jit can access it
+	bool isfloat;
 	inline void setNumber(number_t v)
 	{
 		isfloat = true;
@@ -19,18 +19,222 @@
 
 #include "scripting/argconv.h"
 #include "scripting/toplevel/RegExp.h"
+#include "scripting/flash/system/flashsystem.h"
 
 using namespace std;
 using namespace lightspark;
 
-RegExp::RegExp(ASWorker* wrk, Class_base* c):ASObject(wrk,c,T_OBJECT,SUBTYPE_REGEXP),dotall(false),global(false),ignoreCase(false),
-	extended(false),multiline(false),lastIndex(0)
+RegExpPattern::RegExpPattern(pcre* _re, pcre_extra* _study):refcount(1),literalMatching(false),re(_re),study(_study),capturingGroups(0)
 {
+	if (pcre_fullinfo(re, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups)!=0)
+		capturingGroups=0;
 }
 
-RegExp::RegExp(ASWorker* wrk,Class_base* c, const tiny_string& _re):ASObject(wrk,c,T_OBJECT,SUBTYPE_REGEXP),dotall(false),global(false),ignoreCase(false),
-	extended(false),multiline(false),lastIndex(0),source(_re)
+RegExpPattern::~RegExpPattern()
 {
+	if (study)
+		pcre_free(study);
+	pcre_free(re);
+}
+
+void RegExpPattern::fillExtra(pcre_extra& extra, long unsigned int match_limit_recursion) const
+{
+	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	extra.match_limit_recursion = match_limit_recursion;
+	if (study)
+	{
+		extra.flags |= PCRE_EXTRA_STUDY_DATA;
+		extra.study_data = study->study_data;
+	}
+}
+
+void RegExpPattern::setupLiteralMatching(const tiny_string& source, int options)
+{
+	literalMatching=false;
+	literal.clear();
+	// case insensitive matching needs unicode case folding, so we leave it to pcre
+	if (options & PCRE_CASELESS)
+		return;
+	if (source.empty() || capturingGroups != 0)
+		return;
+	const char* buf = source.raw_buf();
+	uint32_t len = source.numBytes();
+	std::string res;
+	for (uint32_t i = 0; i < len; i++)
+	{
+		char c = buf[i];
+		switch (c)
+		{
+			case '\\':
+				// escaped non-alphanumeric characters are literals, everything else (\d, \b, \1, ...) is regex syntax
+				if (i+1 == len || isalnum((unsigned char)buf[i+1]) || buf[i+1] == '\0' || (buf[i+1]&0x80))
+					return;
+				res += buf[++i];
+				break;
+			case '^':
+			case '$':
+			case '.':
+			case '|':
+			case '?':
+			case '*':
+			case '+':
+			case '(':
+			case ')':
+			case '[':
+			case ']':
+			case '{':
+			case '}':
+			case '\0':
+				return;
+			case ' ':
+			case '\t':
+			case '\n':
+			case '\r':
+			case '\f':
+			case '\v':
+			case '#':
+				// whitespace and comments are ignored in extended mode
+				if (options & PCRE_EXTENDED)
+					return;
+				res += c;
+				break;
+			default:
+				res += c;
+				break;
+		}
+	}
+	literal = res;
+	literalMatching = true;
+}
+
+int RegExpPattern::exec(const pcre_extra* extra, const char* subject, int length, int offset, int options, int* ovector, int ovecsize) const
+{
+	if (!literalMatching)
+		return pcre_exec(re, extra, subject, length, offset, options, ovector, ovecsize);
+	int literallen = literal.numBytes();
+	if (offset < 0 || offset > length - literallen)
+		return PCRE_ERROR_NOMATCH;
+	const char* lit = literal.raw_buf();
+	const char* end = subject + length - literallen;
+	const char* p = subject + offset;
+	while (p <= end)
+	{
+		p = (const char*)memchr(p, lit[0], end - p + 1);
+		if (!p)
+			break;
+		if (memcmp(p+1, lit+1, literallen-1) == 0)
+		{
+			if (ovecsize < 2)
+				return 0;
+			ovector[0] = p - subject;
+			ovector[1] = ovector[0] + literallen;
+			return 1;
+		}
+		p++;
+	}
+	return PCRE_ERROR_NOMATCH;
+}
+
+RegExpCache::RegExpCache(SystemState* _sys, uint32_t _maxEntries):maxEntries(_maxEntries),sys(_sys),instanceHits(0),hits(0),misses(0),literalPatterns(0)
+{
+}
+
+RegExpCache::~RegExpCache()
+{
+	clear();
+}
+
+RegExpPattern* RegExpCache::get(const tiny_string& source, int options)
+{
+	cacheKey key = make_pair(source,options);
+	auto it = entries.find(key);
+	if (it != entries.end())
+	{
+		hits++;
+		// move entry to front of lru list
+		lru.splice(lru.begin(),lru,it->second);
+		RegExpPattern* p = it->second->second;
+		p->incRef();
+		return p;
+	}
+	misses++;
+	const char * error;
+	int errorOffset;
+	int errorcode;
+	pcre* pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,nullptr);
+	if(error)
+	{
+//		if (errorcode == 64) // invalid pattern in javascript compatibility mode (we try again in normal mode to match flash behaviour)
+//		{
+//			options &= ~PCRE_JAVASCRIPT_COMPAT;
+//			pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,NULL);
+//		}
+		if (error)
+			return nullptr;
+	}
+	// study data is optional, pcre_study returns nullptr if it couldn't find anything to speed up matching
+	pcre_extra* study = pcre_study(pcreRE,0,&error);
+	RegExpPattern* p = new RegExpPattern(pcreRE,study);
+	if (sys->useFastRegExp)
+	{
+		p->setupLiteralMatching(source,options);
+		if (p->isLiteralMatching())
+			literalPatterns++;
+	}
+	if (lru.size() >= maxEntries)
+	{
+		// evict least recently used entry, RegExp instances still using it keep their reference
+		entries.erase(lru.back().first);
+		lru.back().second->decRef();
+		lru.pop_back();
+	}
+	lru.push_front(make_pair(key,p));
+	entries[key]=lru.begin();
+	p->incRef();
+	return p;
+}
+
+void RegExpCache::clear()
+{
+	for (auto it = lru.begin(); it != lru.end(); it++)
+		it->second->decRef();
+	lru.clear();
+	entries.clear();
+}
+
+RegExp::RegExp(ASWorker* wrk, Class_base* c):ASObject(wrk,c,T_OBJECT,SUBTYPE_REGEXP),pattern{nullptr,nullptr},patternOptions{0,0},
+	dotall(false),global(false),ignoreCase(false),extended(false),multiline(false),lastIndex(0)
+{
+}
+
+RegExp::RegExp(ASWorker* wrk,Class_base* c, const tiny_string& _re):ASObject(wrk,c,T_OBJECT,SUBTYPE_REGEXP),pattern{nullptr,nullptr},patternOptions{0,0},
+	dotall(false),global(false),ignoreCase(false),extended(false),multiline(false),lastIndex(0),source(_re)
+{
+}
+
+bool RegExp::destruct()
+{
+	releasePatterns();
+	dotall=false;
+	global=false;
+	ignoreCase=false;
+	extended=false;
+	multiline=false;
+	lastIndex=0;
+	source.clear();
+	return ASObject::destruct();
+}
+
+void RegExp::releasePatterns()
+{
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		if (pattern[i])
+			pattern[i]->decRef();
+		pattern[i]=nullptr;
+		patternSource[i].clear();
+		patternOptions[i]=0;
+	}
 }
 
 void RegExp::sinit(Class_base* c)
@@ -70,6 +274,7 @@ ASFUNCTIONBODY_ATOM(RegExp,_constructor)
 			return;
 		}
 		RegExp *src=asAtomHandler::as<RegExp>(args[0]);
+		th->releasePatterns();
 		th->source=src->source;
 		th->dotall=src->dotall;
 		th->global=src->global;
@@ -78,7 +283,8 @@ ASFUNCTIONBODY_ATOM(RegExp,_constructor)
 		th->multiline=src->multiline;
 		return;
 	}
-	else if(argslen > 0)
+	th->releasePatterns();
+	if(argslen > 0)
 		th->source=asAtomHandler::toString(args[0],wrk).raw_buf();
 	if(argslen>1 && !asAtomHandler::is<Undefined>(args[1]))
 	{
@@ -149,22 +355,17 @@ ASFUNCTIONBODY_ATOM(RegExp,exec)
 
 ASObject *RegExp::match(const tiny_string& str)
 {
-	pcre* pcreRE = compile(!str.isSinglebyte());
-	if (!pcreRE)
-		return getSystemState()->getNullRef();
-	int capturingGroups;
-	int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
+	RegExpPattern* pattern = compile(!str.isSinglebyte());
+	if (!pattern)
 		return getSystemState()->getNullRef();
-	}
+	pcre* pcreRE = pattern->re;
+	int capturingGroups = pattern->capturingGroups;
 	//Get information about named capturing groups
 	int namedGroups;
-	infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_NAMECOUNT, &namedGroups);
+	int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_NAMECOUNT, &namedGroups);
 	if(infoOk!=0)
 	{
-		pcre_free(pcreRE);
+		pattern->decRef();
 		return getSystemState()->getNullRef();
 	}
 	//Get information about the size of named entries
@@ -172,7 +373,7 @@ ASObject *RegExp::match(const tiny_string& str)
 	infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_NAMEENTRYSIZE, &namedSize);
 	if(infoOk!=0)
 	{
-		pcre_free(pcreRE);
+		pattern->decRef();
 		return getSystemState()->getNullRef();
 	}
 	struct nameEntry
@@ -184,27 +385,28 @@ ASObject *RegExp::match(const tiny_string& str)
 	infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_NAMETABLE, &entries);
 	if(infoOk!=0)
 	{
-		pcre_free(pcreRE);
+		pattern->decRef();
 		lastIndex=0;
 		return getSystemState()->getNullRef();
 	}
 	pcre_extra extra;
-	extra.match_limit_recursion=500;
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	pattern->fillExtra(extra,500);
+	if (capturingGroups <= 500)
+		extra.flags &= ~PCRE_EXTRA_MATCH_LIMIT_RECURSION;
 	int ovector[(capturingGroups+1)*3];
 	int offset=global?lastIndex:0;
 	if(offset<0)
 	{
 		//beyond last match
-		pcre_free(pcreRE);
+		pattern->decRef();
 		lastIndex=0;
 		return getSystemState()->getNullRef();
 	}
-	int rc=pcre_exec(pcreRE,capturingGroups > 500 ? &extra : nullptr, str.raw_buf(), str.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+	int rc=pattern->exec(&extra, str.raw_buf(), str.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
 	if(rc<0)
 	{
 		//No matches or error
-		pcre_free(pcreRE);
+		pattern->decRef();
 		lastIndex=0;
 		return getSystemState()->getNullRef();
 	}
@@ -234,7 +436,7 @@ ASObject *RegExp::match(const tiny_string& str)
 		entries+=namedSize;
 	}
 	lastIndex=ovector[1];
-	pcre_free(pcreRE);
+	pattern->decRef();
 	return a;
 }
 
@@ -250,29 +452,21 @@ ASFUNCTIONBODY_ATOM(RegExp,test)
 	const tiny_string& arg0 = asAtomHandler::toString(args[0],wrk);
 	if (wrk->currentCallContext->exceptionthrown)
 		return;
-	pcre* pcreRE = th->compile(!arg0.isSinglebyte());
-	if (!pcreRE)
-	{
-		asAtomHandler::setNull(ret);
-		return;
-	}
-	int capturingGroups;
-	int infoOk=pcre_fullinfo(pcreRE, NULL, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-	if(infoOk!=0)
+	RegExpPattern* pattern = th->compile(!arg0.isSinglebyte());
+	if (!pattern)
 	{
-		pcre_free(pcreRE);
 		asAtomHandler::setNull(ret);
 		return;
 	}
+	int capturingGroups = pattern->capturingGroups;
 	int ovector[(capturingGroups+1)*3];
 	
 	int offset=(th->global)?th->lastIndex:0;
 	pcre_extra extra;
-	extra.match_limit_recursion=200;
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
-	int rc = pcre_exec(pcreRE, &extra, arg0.raw_buf(), arg0.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+	pattern->fillExtra(extra,200);
+	int rc = pattern->exec(&extra, arg0.raw_buf(), arg0.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
 	bool res = (rc >= 0);
-	pcre_free(pcreRE);
+	pattern->decRef();
 	asAtomHandler::setBool(ret,res);
 }
 
@@ -305,7 +499,7 @@ ASFUNCTIONBODY_ATOM(RegExp,_toString)
 	ret = asAtomHandler::fromObject(abstract_s(wrk,res));
 }
 
-pcre* RegExp::compile(bool isutf8)
+int RegExp::getOptions(bool isutf8) const
 {
 	int options = PCRE_NEWLINE_ANY | PCRE_NO_UTF8_CHECK;
 	if(isutf8)
@@ -318,20 +512,32 @@ pcre* RegExp::compile(bool isutf8)
 		options |= PCRE_MULTILINE;
 	if(dotall)
 		options|=PCRE_DOTALL;
+	return options;
+}
 
-	const char * error;
-	int errorOffset;
-	int errorcode;
-	pcre* pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,nullptr);
-	if(error)
+RegExpPattern* RegExp::compile(bool isutf8)
+{
+	int options = getOptions(isutf8);
+	uint32_t idx = isutf8 ? 1 : 0;
+	RegExpCache* cache = getInstanceWorker()->regexpCache;
+	if (pattern[idx] && patternOptions[idx]==options && patternSource[idx]==source)
 	{
-//		if (errorcode == 64) // invalid pattern in javascript compatibility mode (we try again in normal mode to match flash behaviour)
-//		{
-//			options &= ~PCRE_JAVASCRIPT_COMPAT;
-//			pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,NULL);
-//		}
-		if (error)
-			return nullptr;
+		cache->instanceHits++;
+		pattern[idx]->incRef();
+		return pattern[idx];
 	}
-	return pcreRE;
+	// source or flags have changed since the last compilation
+	if (pattern[idx])
+		pattern[idx]->decRef();
+	pattern[idx] = cache->get(source,options);
+	patternSource[idx] = source;
+	patternOptions[idx] = options;
+	if (pattern[idx])
+		pattern[idx]->incRef();
+	return pattern[idx];
+}
+
+RegExpPattern* RegExp::compile(ASWorker* wrk, const tiny_string& source, int options)
+{
+	return wrk->regexpCache->get(source,options);
 }
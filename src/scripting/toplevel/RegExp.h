@@ -22,16 +22,96 @@
 #include "compat.h"
 #include "asobject.h"
 #include "3rdparty/avmplus/pcre/pcre.h"
+#include <list>
+#include <map>
 
 namespace lightspark
 {
 
+/*
+ * A compiled pcre pattern together with its pcre_study() data.
+ * Patterns are shared between the worker-wide RegExpCache and the RegExp
+ * instances that use them, so they are reference counted.
+ * They are only used from the thread of the owning worker.
+ */
+class RegExpPattern
+{
+private:
+	uint32_t refcount;
+	/*
+	 * patterns without any regex syntax are matched by a plain byte search
+	 * instead of the pcre interpreter, if enabled by --enable-fast-regexp
+	 */
+	tiny_string literal;
+	bool literalMatching;
+	~RegExpPattern();
+public:
+	RegExpPattern(pcre* _re, pcre_extra* _study);
+	pcre* re;
+	pcre_extra* study;
+	int capturingGroups;
+	// checks if the pattern can be matched by a byte search and enables literal matching
+	void setupLiteralMatching(const tiny_string& source, int options);
+	bool isLiteralMatching() const { return literalMatching; }
+	// same as pcre_exec() on this pattern
+	int exec(const pcre_extra* extra, const char* subject, int length, int offset, int options, int* ovector, int ovecsize) const;
+	void incRef() { ++refcount; }
+	void decRef()
+	{
+		if (--refcount == 0)
+			delete this;
+	}
+	// fills extra with the study data and the recursion limit for pcre_exec()
+	void fillExtra(pcre_extra& extra, unsigned long int match_limit_recursion) const;
+};
+
+/*
+ * Bounded LRU cache of compiled patterns, keyed by source and pcre options
+ * (which include the RegExp flags and the utf8 mode).
+ * There is one instance per ASWorker.
+ */
+class RegExpCache
+{
+private:
+	typedef std::pair<tiny_string,int> cacheKey;
+	typedef std::list<std::pair<cacheKey,RegExpPattern*>> lruList;
+	lruList lru;
+	std::map<cacheKey,lruList::iterator> entries;
+	uint32_t maxEntries;
+	SystemState* sys;
+public:
+	RegExpCache(SystemState* _sys, uint32_t _maxEntries=64);
+	~RegExpCache();
+	// returns a pattern with an added reference, or nullptr if the source is not a valid pattern
+	RegExpPattern* get(const tiny_string& source, int options);
+	void clear();
+	// statistics for the profiling output
+	uint64_t instanceHits;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t literalPatterns;
+};
+
 class RegExp: public ASObject
 {
+private:
+	// the pattern used for the last compile, one for utf8 and one for single byte strings
+	RegExpPattern* pattern[2];
+	tiny_string patternSource[2];
+	int patternOptions[2];
+	int getOptions(bool isutf8) const;
+	void releasePatterns();
 public:
 	RegExp(ASWorker* wrk,Class_base* c);
 	RegExp(ASWorker* wrk, Class_base* c, const tiny_string& _re);
-	pcre* compile(bool isutf8);
+	bool destruct() override;
+	/*
+	 * returns the compiled pattern for the current source and flags, or nullptr if the pattern is invalid
+	 * the caller has to decRef() the returned pattern
+	 */
+	RegExpPattern* compile(bool isutf8);
+	// same as compile(), for patterns that are not backed by a RegExp object
+	static RegExpPattern* compile(ASWorker* wrk, const tiny_string& source, int options);
 	static void sinit(Class_base* c);
 	static void buildTraits(ASObject* o);
 	ASObject *match(const tiny_string& str);
@@ -26,6 +26,7 @@
 #include "scripting/toplevel/Integer.h"
 #include "scripting/toplevel/UInteger.h"
 #include "scripting/toplevel/XML.h"
+#include "scripting/toplevel/JSON.h"
 #include <3rdparty/pugixml/src/pugixml.hpp>
 #include <algorithm>
 
@@ -1625,28 +1626,30 @@ bool Vector::isValidMultiname(SystemState* sys,const multiname& name, uint32_t&
 	return validIndex;
 }
 
-tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter)
+void Vector::toJSON(JSONWriter& out, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (call_toJSON(out,path,replacer,spaces,filter))
+		return;
 	// check for cylic reference
 	if (std::find(path.begin(),path.end(), this) != path.end())
 	{
 		createError<TypeError>(getInstanceWorker(),kJSONCyclicStructure);
-		return res;
+		return;
 	}
 
 	path.push_back(this);
-	res += "[";
+	out.append('[');
 	bool bfirst = true;
-	tiny_string newline = (spaces.empty() ? "" : "\n");
 	asAtom closure = asAtomHandler::isValid(replacer) && asAtomHandler::getClosure(replacer) ? asAtomHandler::fromObject(asAtomHandler::getClosure(replacer)) : asAtomHandler::nullAtom;
 	for (unsigned int i =0;  i < vec.size(); i++)
 	{
-		tiny_string subres;
 		asAtom o = vec[i];
+		// the separator is removed again if nothing is written for the element
+		uint32_t start = out.size();
+		if (!bfirst)
+			out.append(',');
+		out.appendIndent(spaces,spaces.numBytes());
+		uint32_t valuestart = out.size();
 		if (asAtomHandler::isValid(replacer))
 		{
 			asAtom params[2];
@@ -1657,32 +1660,26 @@ tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			asAtomHandler::callFunction(replacer,getInstanceWorker(),funcret,closure, params, 2,false);
 			if (asAtomHandler::isValid(funcret))
 			{
-				subres = asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(path,asAtomHandler::invalidAtom,spaces,filter);
+				asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(out,path,asAtomHandler::invalidAtom,spaces,filter);
 				ASATOM_DECREF(funcret);
 			}
 		}
-		else
+		else if (!out.appendPrimitive(o))
 		{
 			bool newobj = !asAtomHandler::isObject(o); // member is not a pointer to an ASObject, so toObject() will create a temporary ASObject that has to be decreffed after usage
-			subres = asAtomHandler::toObject(o,getInstanceWorker())->toJSON(path,replacer,spaces,filter);
+			asAtomHandler::toObject(o,getInstanceWorker())->toJSON(out,path,replacer,spaces,filter);
 			if (newobj)
 				ASATOM_DECREF(o);
 		}
-		if (!subres.empty())
-		{
-			if (!bfirst)
-				res += ",";
-			res += newline+spaces;
-			
+		if (out.size() == valuestart)
+			out.truncate(start);
+		else
 			bfirst = false;
-			res += subres;
-		}
 	}
 	if (!bfirst)
-		res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
-	res += "]";
+		out.appendIndent(spaces,spaces.numBytes()/2);
+	out.append(']');
 	path.pop_back();
-	return res;
 }
 
 asAtom Vector::at(unsigned int index, asAtom defaultValue) const
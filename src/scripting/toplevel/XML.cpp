@@ -27,6 +27,7 @@
 #include "scripting/argconv.h"
 #include "abc.h"
 #include "parsing/amf3_generator.h"
+#include "backends/config.h"
 #include <unordered_set>
 
 using namespace std;
@@ -47,16 +48,49 @@ void setDefaultXMLSettings()
 	prettyPrinting = true;
 }
 
-XML::XML(ASWorker* wrk,Class_base* c):ASObject(wrk,c,T_OBJECT,SUBTYPE_XML),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
+// compares the name of a pugixml node without the namespace prefix
+static bool isLocalName(const char* qname, const tiny_string& name)
 {
+	const char* localname = strchr(qname,':');
+	return strcmp(localname ? localname+1 : qname,name.raw_buf())==0;
 }
 
-XML::XML(ASWorker* wrk,Class_base* c, const std::string &str):ASObject(wrk,c,T_OBJECT,SUBTYPE_XML),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
+XML::LazyXMLList::LazyXMLList(XML* o, bool attr):owner(o),attributes(attr)
+{
+}
+
+XML::LazyXMLList::operator _NR<XMLList>() const
+{
+	materialize();
+	return list;
+}
+
+XML::LazyXMLList& XML::LazyXMLList::operator=(const _NR<XMLList>& l)
+{
+	(attributes ? owner->lazyattributes : owner->lazychildren) = false;
+	list = l;
+	return *this;
+}
+
+void XML::LazyXMLList::reset()
+{
+	(attributes ? owner->lazyattributes : owner->lazychildren) = false;
+	list.reset();
+}
+
+XML::XML(ASWorker* wrk,Class_base* c):ASObject(wrk,c,T_OBJECT,SUBTYPE_XML),childrenlist(this,false),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),attributelist(this,true),
+	parsedefaultns(BUILTIN_STRINGS::EMPTY),parseignorewhitespace(true),lazyparse(false),lazychildren(false),lazyattributes(false),constructed(false)
+{
+}
+
+XML::XML(ASWorker* wrk,Class_base* c, const std::string &str):ASObject(wrk,c,T_OBJECT,SUBTYPE_XML),childrenlist(this,false),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),attributelist(this,true),
+	parsedefaultns(BUILTIN_STRINGS::EMPTY),parseignorewhitespace(true),lazyparse(false),lazychildren(false),lazyattributes(false),constructed(false)
 {
 	createTree(buildFromString(str, getParseMode()),false);
 }
 
-XML::XML(ASWorker* wrk,Class_base* c, const pugi::xml_node& _n, XML* parent, bool fromXMLList):ASObject(wrk,c,T_OBJECT,SUBTYPE_XML),parentNode(0),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
+XML::XML(ASWorker* wrk,Class_base* c, const pugi::xml_node& _n, XML* parent, bool fromXMLList):ASObject(wrk,c,T_OBJECT,SUBTYPE_XML),childrenlist(this,false),parentNode(0),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),attributelist(this,true),
+	parsedefaultns(BUILTIN_STRINGS::EMPTY),parseignorewhitespace(true),lazyparse(false),lazychildren(false),lazyattributes(false),constructed(false)
 {
 	if (parent)
 		parentNode = parent;
@@ -85,6 +119,10 @@ bool XML::destruct()
 	attributelist.reset();
 	procinstlist.reset();
 	namespacedefs.clear();
+	parsedefaultns=BUILTIN_STRINGS::EMPTY;
+	parseignorewhitespace=true;
+	lazyparse=false;
+	lazynode=pugi::xml_node();
 	return destructIntern();
 }
 
@@ -93,10 +131,10 @@ void XML::prepareShutdown()
 	if (preparedforshutdown)
 		return;
 	ASObject::prepareShutdown();
-	if (childrenlist)
-		childrenlist->prepareShutdown();
-	if (attributelist)
-		attributelist->prepareShutdown();
+	if (childrenlist.peek())
+		childrenlist.peek()->prepareShutdown();
+	if (attributelist.peek())
+		attributelist.peek()->prepareShutdown();
 	if (procinstlist)
 		procinstlist->prepareShutdown();
 	for (auto it = namespacedefs.begin(); it != namespacedefs.end(); it++)
@@ -438,7 +476,7 @@ void XML::appendChild(_NR<XML> newChild)
 			}
 			node = node->parentNode;
 		}
-		newChild->parentNode = this;
+		newChild->setParentNode(this);
 		newChild->incRef();
 		childrenlist->append(newChild);
 		handleNotification("nodeAdded",asAtomHandler::fromObject(newChild.getPtr()),asAtomHandler::nullAtom);
@@ -976,6 +1014,8 @@ ASFUNCTIONBODY_ATOM(XML,addNamespace)
 	}
 	else
 		ns_uri = th->getSystemState()->getUniqueStringId(newNamespace->toString());
+	// lazy nodes resolve their prefixes with the namespaces of their parents
+	th->materializeTree();
 	if (th->nodenamespace_prefix == ns_prefix)
 		th->nodenamespace_prefix=BUILTIN_STRINGS::EMPTY;
 	for (uint32_t i = 0; i < th->namespacedefs.size(); i++)
@@ -1166,6 +1206,7 @@ ASFUNCTIONBODY_ATOM(XML,_setNamespace)
 	if (th->isAttribute && th->parentNode)
 	{
 		XML* tmp = th->parentNode;
+		tmp->materializeTree();
 		for (uint32_t i = 0; i < tmp->namespacedefs.size(); i++)
 		{
 			bool b;
@@ -1182,6 +1223,8 @@ ASFUNCTIONBODY_ATOM(XML,_setNamespace)
 
 void XML::setNamespace(uint32_t ns_uri, uint32_t ns_prefix)
 {
+	// the children of lazy nodes inherit the namespace of their parent
+	materializeTree();
 	this->nodenamespace_prefix = ns_prefix;
 	this->nodenamespace_uri = ns_uri;
 	handleNotification("namespaceSet",asAtomHandler::fromObject(this),asAtomHandler::nullAtom);
@@ -1298,7 +1341,8 @@ void XML::getDescendantsByQName(const tiny_string& name, uint32_t ns, bool bIsAt
 {
 	if (!constructed)
 		return;
-	if (bIsAttribute && !attributelist.isNull())
+	bool anyname = name=="" || name=="*";
+	if (bIsAttribute && (anyname || !lazyattributes || lazynode.find_attribute([&name](const pugi::xml_attribute& a) { return isLocalName(a.name(),name); })) && !attributelist.isNull())
 	{
 		for (uint32_t i = 0; i < attributelist->nodes.size(); i++)
 		{
@@ -1310,12 +1354,15 @@ void XML::getDescendantsByQName(const tiny_string& name, uint32_t ns, bool bIsAt
 			}
 		}
 	}
+	// don't create the nodes of lazy subtrees that don't contain the name
+	if (lazychildren && !anyname && !lazySubtreeContains(name,bIsAttribute))
+		return;
 	if (childrenlist.isNull())
 		return;
 	for (uint32_t i = 0; i < childrenlist->nodes.size(); i++)
 	{
 		_NR<XML> child= childrenlist->nodes[i];
-		if(!bIsAttribute && (name=="" || name=="*" || (name == child->nodename && (ns == BUILTIN_STRINGS::STRING_WILDCARD || ns == child->nodenamespace_uri))))
+		if(!bIsAttribute && (anyname || (name == child->nodename && (ns == BUILTIN_STRINGS::STRING_WILDCARD || ns == child->nodenamespace_uri))))
 		{
 			ret.push_back(child);
 		}
@@ -1751,7 +1798,7 @@ multiname* XML::setVariableByMultinameIntern(multiname& name, asAtom& o, CONST_A
 					else
 					{
 						XML* tmp = asAtomHandler::getObject(o)->as<XML>();
-						tmp->parentNode = this;
+						tmp->setParentNode(this);
 						if (!found)
 						{
 							tmp->incRef();
@@ -1798,7 +1845,7 @@ multiname* XML::setVariableByMultinameIntern(multiname& name, asAtom& o, CONST_A
 			if(asAtomHandler::getObject(o) && asAtomHandler::getObject(o)->is<XML>())
 			{
 				_NR<XML> tmp = _MNR(asAtomHandler::getObject(o)->as<XML>());
-				tmp->parentNode = this;
+				tmp->setParentNode(this);
 				tmp->incRef();
 				tmpnodes.push_back(tmp);
 			}
@@ -1835,7 +1882,7 @@ multiname* XML::setVariableByMultinameIntern(multiname& name, asAtom& o, CONST_A
 				tmpstr += normalizedName;
 				tmpstr +=">";
 				_NR<XML> tmp = _MR<XML>(createFromString(this->getInstanceWorker(),tmpstr));
-				tmp->parentNode = this;
+				tmp->setParentNode(this);
 				tmpnodes.push_back(tmp);
 			}
 		}
@@ -2284,14 +2331,14 @@ ASFUNCTIONBODY_ATOM(XML,insertChildAfter)
 		{
 			if (incref)
 				asAtomHandler::as<XML>(child2)->incRef();
-			asAtomHandler::as<XML>(child2)->parentNode = th;
+			asAtomHandler::as<XML>(child2)->setParentNode(th);
 			th->childrenlist->nodes.insert(th->childrenlist->nodes.begin(),_MNR(asAtomHandler::as<XML>(child2)));
 		}
 		else if (asAtomHandler::is<XMLList>(child2))
 		{
 			for (auto it2 = asAtomHandler::as<XMLList>(child2)->nodes.begin(); it2 < asAtomHandler::as<XMLList>(child2)->nodes.end(); it2++)
 			{
-				(*it2)->parentNode = th;
+				(*it2)->setParentNode(th);
 			}
 			th->childrenlist->nodes.insert(th->childrenlist->nodes.begin(),asAtomHandler::as<XMLList>(child2)->nodes.begin(), asAtomHandler::as<XMLList>(child2)->nodes.end());
 		}
@@ -2316,14 +2363,14 @@ ASFUNCTIONBODY_ATOM(XML,insertChildAfter)
 			{
 				if (incref)
 					asAtomHandler::as<XML>(child2)->incRef();
-				asAtomHandler::as<XML>(child2)->parentNode = th;
+				asAtomHandler::as<XML>(child2)->setParentNode(th);
 				th->childrenlist->nodes.insert(it+1,_NR<XML>(asAtomHandler::as<XML>(child2)));
 			}
 			else if (asAtomHandler::is<XMLList>(child2))
 			{
 				for (auto it2 = asAtomHandler::as<XMLList>(child2)->nodes.begin(); it2 < asAtomHandler::as<XMLList>(child2)->nodes.end(); it2++)
 				{
-					(*it2)->parentNode = th;
+					(*it2)->setParentNode(th);
 				}
 				th->childrenlist->nodes.insert(it+1,asAtomHandler::as<XMLList>(child2)->nodes.begin(), asAtomHandler::as<XMLList>(child2)->nodes.end());
 			}
@@ -2380,7 +2427,7 @@ ASFUNCTIONBODY_ATOM(XML,insertChildBefore)
 			for (auto it = asAtomHandler::as<XMLList>(child2)->nodes.begin(); it < asAtomHandler::as<XMLList>(child2)->nodes.end(); it++)
 			{
 				(*it)->incRef();
-				(*it)->parentNode = th;
+				(*it)->setParentNode(th);
 				th->childrenlist->nodes.push_back(_NR<XML>(*it));
 			}
 		}
@@ -2405,14 +2452,14 @@ ASFUNCTIONBODY_ATOM(XML,insertChildBefore)
 			{
 				if (incref)
 					asAtomHandler::as<XML>(child2)->incRef();
-				asAtomHandler::as<XML>(child2)->parentNode = th;
+				asAtomHandler::as<XML>(child2)->setParentNode(th);
 				th->childrenlist->nodes.insert(it,_NR<XML>(asAtomHandler::as<XML>(child2)));
 			}
 			else if (asAtomHandler::is<XMLList>(child2))
 			{
 				for (auto it2 = asAtomHandler::as<XMLList>(child2)->nodes.begin(); it2 < asAtomHandler::as<XMLList>(child2)->nodes.end(); it2++)
 				{
-					(*it2)->parentNode = th;
+					(*it2)->setParentNode(th);
 				}
 				th->childrenlist->nodes.insert(it,asAtomHandler::as<XMLList>(child2)->nodes.begin(), asAtomHandler::as<XMLList>(child2)->nodes.end());
 			}
@@ -2452,6 +2499,7 @@ ASFUNCTIONBODY_ATOM(XML,removeNamespace)
 	else
 		ns = Class<Namespace>::getInstanceS(wrk,arg1->toStringId(), BUILTIN_STRINGS::EMPTY);
 
+	th->materializeTree();
 	th->RemoveNamespace(ns);
 	th->incRef();
 	ret = asAtomHandler::fromObject(th);
@@ -2843,6 +2891,14 @@ void XML::createTree(const pugi::xml_node& rootnode,bool fromXMLList)
 				case pugi::node_element: // Element tag, i.e. '<node/>'
 				{
 					fillNode(this,node);
+					if (lazyparse && node.first_child())
+					{
+						// children are created on first access
+						lazynode = node;
+						lazychildren = true;
+						done = true;
+						break;
+					}
 					pugi::xml_node_iterator it=node.begin();
 					while(it!=node.end())
 					{
@@ -2881,6 +2937,13 @@ void XML::createTree(const pugi::xml_node& rootnode,bool fromXMLList)
 			case pugi::node_element: // Element tag, i.e. '<node/>'
 			{
 				fillNode(this,node);
+				if (lazyparse && node.first_child())
+				{
+					// children are created on first access
+					lazynode = node;
+					lazychildren = true;
+					break;
+				}
 				pugi::xml_node_iterator it=node.begin();
 				{
 					while(it!=node.end())
@@ -2905,14 +2968,29 @@ void XML::fillNode(XML* node, const pugi::xml_node &srcnode)
 	{
 		node->childrenlist = _MR(Class<XMLList>::getInstanceSNoArgs(node->getInstanceWorker()));
 	}
+	if (node->parentNode)
+	{
+		// lazily created nodes have to use the settings of the time the document was parsed
+		node->parsedefaultns = node->parentNode->parsedefaultns;
+		node->parseignorewhitespace = node->parentNode->parseignorewhitespace;
+		node->lazyparse = node->parentNode->lazyparse;
+		if (node->lazyparse)
+			node->xmldoc = node->parentNode->xmldoc;
+	}
+	else
+	{
+		node->parsedefaultns = node->getInstanceWorker()->getDefaultXMLNamespaceID();
+		node->parseignorewhitespace = ignoreWhitespace;
+		node->lazyparse = node->xmldoc && Config::getConfig()->isLazyXMLEnabled();
+	}
 	node->nodetype = srcnode.type();
 	node->nodename = srcnode.name();
 	node->nodevalue = srcnode.value();
 	if (node->parentNode && node->parentNode->nodenamespace_prefix == BUILTIN_STRINGS::EMPTY)
 		node->nodenamespace_uri = node->parentNode->nodenamespace_uri;
 	else
-		node->nodenamespace_uri = node->getInstanceWorker()->getDefaultXMLNamespaceID();
-	if (ignoreWhitespace && node->nodetype == pugi::node_pcdata)
+		node->nodenamespace_uri = node->parsedefaultns;
+	if (node->parseignorewhitespace && node->nodetype == pugi::node_pcdata)
 		node->nodevalue = node->removeWhitespace(node->nodevalue);
 	node->attributelist = _MR(Class<XMLList>::getInstanceSNoArgs(node->getInstanceWorker()));
 	pugi::xml_attribute_iterator itattr;
@@ -2966,6 +3044,20 @@ void XML::fillNode(XML* node, const pugi::xml_node &srcnode)
 			}
 		}
 	}
+	if (node->lazyparse && node->nodetype == pugi::node_element && srcnode.first_attribute())
+	{
+		// attributes are created on first access
+		node->lazynode = srcnode;
+		node->lazyattributes = true;
+	}
+	else
+		fillAttributes(node,srcnode);
+	node->constructed=true;
+}
+
+void XML::fillAttributes(XML* node, const pugi::xml_node &srcnode)
+{
+	pugi::xml_attribute_iterator itattr;
 	for(itattr = srcnode.attributes_begin();itattr!=srcnode.attributes_end();++itattr)
 	{
 		tiny_string aname = tiny_string(itattr->name(),true);
@@ -2976,8 +3068,8 @@ void XML::fillNode(XML* node, const pugi::xml_node &srcnode)
 		tmp->nodetype = pugi::node_null;
 		tmp->isAttribute = true;
 		tmp->nodename = aname;
-		tmp->nodenamespace_uri = node->getInstanceWorker()->getDefaultXMLNamespaceID();
-		pos = tmp->nodename.find(":");
+		tmp->nodenamespace_uri = node->parsedefaultns;
+		uint32_t pos = tmp->nodename.find(":");
 		if (pos != tiny_string::npos)
 		{
 			tmp->nodenamespace_prefix = node->getSystemState()->getUniqueStringId(tmp->nodename.substr(0,pos));
@@ -3012,7 +3104,74 @@ void XML::fillNode(XML* node, const pugi::xml_node &srcnode)
 		tmp->constructed = true;
 		node->attributelist->nodes.push_back(tmp);
 	}
-	node->constructed=true;
+}
+
+void XML::materialize(bool attributes)
+{
+	pugi::xml_node node = lazynode;
+	if (attributes)
+	{
+		lazyattributes = false;
+		fillAttributes(this,node);
+	}
+	else
+	{
+		lazychildren = false;
+		for (pugi::xml_node_iterator it=node.begin(); it!=node.end(); it++)
+			childrenlist->append(_NR<XML>(XML::createFromNode(getInstanceWorker(),*it,this)));
+	}
+	if (!lazychildren && !lazyattributes)
+	{
+		// the document is released when the last node using it is complete
+		lazynode = pugi::xml_node();
+		xmldoc.reset();
+	}
+}
+
+void XML::materializeTree()
+{
+	// lazy nodes only exist below nodes of lazily parsed documents
+	if (!lazyparse)
+		return;
+	if (lazyattributes)
+		materialize(true);
+	if (lazychildren)
+		materialize(false);
+	if (childrenlist.peek())
+	{
+		for (auto it = childrenlist.peek()->nodes.begin(); it != childrenlist.peek()->nodes.end(); it++)
+			(*it)->materializeTree();
+	}
+}
+
+bool XML::lazySubtreeContains(const tiny_string& name, bool bIsAttribute) const
+{
+	// walks the pugixml nodes below lazynode without creating any XML objects
+	pugi::xml_node n = lazynode.first_child();
+	while (n)
+	{
+		if (bIsAttribute)
+		{
+			for (pugi::xml_attribute a = n.first_attribute(); a; a = a.next_attribute())
+			{
+				if (strcmp(a.name(),"xmlns")!=0 && strncmp(a.name(),"xmlns:",6)!=0 && isLocalName(a.name(),name))
+					return true;
+			}
+		}
+		else if (isLocalName(n.name(),name))
+			return true;
+		if (n.first_child())
+			n = n.first_child();
+		else
+		{
+			while (n != lazynode && !n.next_sibling())
+				n = n.parent();
+			if (n == lazynode)
+				break;
+			n = n.next_sibling();
+		}
+	}
+	return false;
 }
 
 ASFUNCTIONBODY_ATOM(XML,_prependChild)
@@ -3082,7 +3241,7 @@ void XML::prependChild(_NR<XML> newChild)
 			}
 			node = node->parentNode;
 		}
-		newChild->parentNode = this;
+		newChild->setParentNode(this);
 		childrenlist->prepend(newChild);
 	}
 }
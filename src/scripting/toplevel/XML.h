@@ -33,7 +33,36 @@ public:
 	typedef std::vector<_NR<XML>> XMLVector;
 	typedef std::vector<_R<Namespace>> NSVector;
 private:
-	_NR<XMLList> childrenlist;
+	/*
+	 * The children or the attributes of a node. If the node was parsed in
+	 * lazy mode they are only created from the pugixml node on first access
+	 */
+	class LazyXMLList
+	{
+	friend class XML;
+	private:
+		XML* owner;
+		bool attributes;
+		mutable _NR<XMLList> list;
+		void materialize() const
+		{
+			if (attributes ? owner->lazyattributes : owner->lazychildren)
+				owner->materialize(attributes);
+		}
+	public:
+		// the methods changing the reference count are defined in XML.cpp, as XMLList is incomplete here
+		LazyXMLList(XML* o, bool attr);
+		XMLList* operator->() const { materialize(); return list.getPtr(); }
+		XMLList* getPtr() const { materialize(); return list.getPtr(); }
+		bool isNull() const { materialize(); return list.isNull(); }
+		explicit operator bool() const { return !isNull(); }
+		operator _NR<XMLList>() const;
+		// returns the list without creating the lazy nodes
+		XMLList* peek() const { return list.getPtr(); }
+		LazyXMLList& operator=(const _NR<XMLList>& l);
+		void reset();
+	};
+	LazyXMLList childrenlist;
 	XML* parentNode;
 	pugi::xml_node_type nodetype;
 	bool isAttribute;
@@ -41,13 +70,34 @@ private:
 	tiny_string nodevalue;
 	uint32_t nodenamespace_uri;
 	uint32_t nodenamespace_prefix;
-	_NR<XMLList> attributelist;
+	LazyXMLList attributelist;
 	_NR<XMLList> procinstlist;
 	_NR<IFunction> notifierfunction;
 	NSVector namespacedefs;
+	// the default namespace and whitespace setting at parse time, nodes created lazily use them
+	uint32_t parsedefaultns;
+	bool parseignorewhitespace;
+	// true if the node was parsed in lazy mode and may still have lazy children
+	bool lazyparse;
+	bool lazychildren;
+	bool lazyattributes;
+	// the pugixml node of the lazy children/attributes, kept alive by xmldoc
+	pugi::xml_node lazynode;
 
 	void createTree(const pugi::xml_node &rootnode, bool fromXMLList);
 	static void fillNode(XML* node, const pugi::xml_node &srcnode);
+	static void fillAttributes(XML* node, const pugi::xml_node &srcnode);
+	void materialize(bool attributes);
+	// creates all lazy nodes of the subtree, needed before the namespaces
+	// used to resolve the prefixes of the lazy nodes are changed
+	void materializeTree();
+	void setParentNode(XML* parent)
+	{
+		if (parent != parentNode)
+			materializeTree();
+		parentNode = parent;
+	}
+	bool lazySubtreeContains(const tiny_string& name, bool bIsAttribute) const;
 	tiny_string toString_priv();
 	const char* nodekindString();
 	
@@ -706,7 +706,7 @@ void XMLList::removeNode(XML *node)
 		_NR<XML> n = *it;
 		if (n.getPtr() == node)
 		{
-			node->parentNode = nullptr;
+			node->setParentNode(nullptr);
 			nodes.erase(it);
 			break;
 		}
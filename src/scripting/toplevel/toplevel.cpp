@@ -474,6 +474,16 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 		assert(val);
 	}
 	++mi->body->hit_count;
+#else
+	// compile mildly hot functions with the baseline jit
+	const uint32_t jit_hit_threshold=20;
+	if(getSystemState()->useJit && !mi->body->jitfailed && mi->body->jitcode==nullptr)
+	{
+		if (mi->body->hit_count>=jit_hit_threshold)
+			ABCVm::jitFunction(mi);
+		else
+			++mi->body->hit_count;
+	}
 #endif
 
 	//Prepare arguments
@@ -646,8 +656,10 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 					cc->scope_stack_dynamic[0] = false;
 					cc->curr_scope_stack++;
 				}
-				//This is not a hot function, execute it using the interpreter
-				ABCVm::executeFunction(cc);
+				if (mi->body->jitcode)
+					mi->body->jitcode(cc);
+				else//This is not a hot function, execute it using the interpreter
+					ABCVm::executeFunction(cc);
 				//Restore the previous codeStatus
 				mi->body->codeStatus = oldCodeStatus;
 			}
@@ -1500,6 +1512,8 @@ void Class_base::handleConstruction(asAtom& target, asAtom* args, unsigned int a
 
 void Class_base::finalize()
 {
+	// the class pointer may be reused for another class, so all inline caches keyed on it have to be dropped
+	getSystemState()->invalidatePropertyCaches();
 	borrowedVariables.destroyContents();
 	super.reset();
 	prototype.reset();
@@ -2202,6 +2216,7 @@ bool Class_base::isInterfaceMethod(const multiname& name)
 
 void Class_base::removeAllDeclaredProperties()
 {
+	getSystemState()->invalidatePropertyCaches();
 	Variables.removeAllDeclaredProperties();
 	borrowedVariables.removeAllDeclaredProperties();
 }
@@ -20,6 +20,7 @@
 #ifndef SMARTREFS_H
 #define SMARTREFS_H 1
 
+#include <cstddef>
 #include <stdexcept>
 #include "compat.h"
 
@@ -29,7 +30,8 @@ namespace lightspark
 class RefCountable {
 private:
 	ATOMIC_INT32(ref_count);
-	bool isConstant:1;
+	// no bitfield, the baseline jit checks it in generated code
+	bool isConstant;
 	bool inDestruction:1;
 	bool cached:1;
 protected:
@@ -39,6 +41,9 @@ public:
 	virtual ~RefCountable() {}
 
 	int getRefCount() const { return ref_count; }
+	// layout used by the generated code of the baseline jit
+	static size_t getRefCountOffset() { return offsetof(RefCountable,ref_count); }
+	static size_t getConstantOffset() { return offsetof(RefCountable,isConstant); }
 	inline bool isLastRef() const { return !isConstant && ref_count==1; }
 	inline void setConstant()
 	{
@@ -0,0 +1,210 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "string_pool.h"
+#include "exceptions.h"
+#include "logger.h"
+
+using namespace std;
+using namespace lightspark;
+
+UniqueStringPool::Table::Table(uint32_t capacity):slots(new std::atomic<uint64_t>[capacity]),mask(capacity-1),count(0)
+{
+	assert((capacity&mask)==0);
+	for(uint32_t i=0;i<capacity;i++)
+		slots[i].store(0,std::memory_order_relaxed);
+}
+
+UniqueStringPool::Table::~Table()
+{
+	delete[] slots;
+}
+
+UniqueStringPool::Shard::Shard():table(new Table(STRINGPOOL_SHARD_CAPACITY)),inserts(0),lockedLookups(0),contended(0)
+{
+}
+
+UniqueStringPool::Shard::~Shard()
+{
+	delete table.load(std::memory_order_relaxed);
+	for(auto it=retired.begin();it!=retired.end();it++)
+		delete *it;
+}
+
+UniqueStringPool::UniqueStringPool():segments(new std::atomic<tiny_string*>[STRINGPOOL_MAX_SEGMENTS]),nextId(0)
+{
+	for(uint32_t i=0;i<STRINGPOOL_MAX_SEGMENTS;i++)
+		segments[i].store(nullptr,std::memory_order_relaxed);
+}
+
+UniqueStringPool::~UniqueStringPool()
+{
+	for(uint32_t i=0;i<STRINGPOOL_MAX_SEGMENTS;i++)
+		delete[] segments[i].load(std::memory_order_relaxed);
+	delete[] segments;
+}
+
+uint32_t UniqueStringPool::hashString(const tiny_string& s)
+{
+	// FNV-1a
+	uint32_t hash=2166136261u;
+	const unsigned char* p=(const unsigned char*)s.raw_buf();
+	const unsigned char* end=p+s.numBytes();
+	for(;p!=end;p++)
+	{
+		hash^=*p;
+		hash*=16777619u;
+	}
+	return hash;
+}
+
+bool UniqueStringPool::find(const Table* t, uint32_t hash, const tiny_string& s, uint32_t& id) const
+{
+	uint32_t i=hash&t->mask;
+	while(true)
+	{
+		uint64_t v=t->slots[i].load(std::memory_order_acquire);
+		if(v==0)
+			return false;
+		if(uint32_t(v>>32)==hash)
+		{
+			uint32_t candidate=uint32_t(v)-1;
+			if(getString(candidate)==s)
+			{
+				id=candidate;
+				return true;
+			}
+		}
+		i=(i+1)&t->mask;
+	}
+}
+
+void UniqueStringPool::insert(Shard& shard, uint32_t hash, uint32_t id)
+{
+	Table* t=shard.table.load(std::memory_order_relaxed);
+	if((t->count+1)*2 > t->mask+1)
+	{
+		// grow the table, readers of the old one will find new strings
+		// with the mutex held
+		Table* bigger=new Table((t->mask+1)*2);
+		for(uint32_t i=0;i<=t->mask;i++)
+		{
+			uint64_t v=t->slots[i].load(std::memory_order_relaxed);
+			if(v==0)
+				continue;
+			uint32_t j=uint32_t(v>>32)&bigger->mask;
+			while(bigger->slots[j].load(std::memory_order_relaxed)!=0)
+				j=(j+1)&bigger->mask;
+			bigger->slots[j].store(v,std::memory_order_relaxed);
+		}
+		bigger->count=t->count;
+		shard.table.store(bigger,std::memory_order_release);
+		shard.retired.push_back(t);
+		t=bigger;
+	}
+	uint32_t i=hash&t->mask;
+	while(t->slots[i].load(std::memory_order_relaxed)!=0)
+		i=(i+1)&t->mask;
+	t->count++;
+	// publishes the string stored by allocateString as well
+	t->slots[i].store((uint64_t(hash)<<32)|(id+1),std::memory_order_release);
+}
+
+tiny_string& UniqueStringPool::allocateString(uint32_t id)
+{
+	uint32_t index=id>>STRINGPOOL_SEGMENT_BITS;
+	if(index>=STRINGPOOL_MAX_SEGMENTS)
+		throw RunTimeException("Too many unique strings");
+	tiny_string* segment=segments[index].load(std::memory_order_acquire);
+	if(segment==nullptr)
+	{
+		// several shards may need the same segment at the same time
+		tiny_string* newSegment=new tiny_string[1<<STRINGPOOL_SEGMENT_BITS];
+		if(segments[index].compare_exchange_strong(segment,newSegment,std::memory_order_acq_rel))
+			segment=newSegment;
+		else
+			delete[] newSegment;
+	}
+	return segment[id&((1<<STRINGPOOL_SEGMENT_BITS)-1)];
+}
+
+uint32_t UniqueStringPool::addLocked(Shard& shard, uint32_t hash, const tiny_string& s)
+{
+	uint32_t id=nextId.fetch_add(1,std::memory_order_relaxed);
+	tiny_string& stored=allocateString(id);
+	stored += s; // ensure that a deep copy of the string is stored, as s might be type READONLY/DYNAMIC and be deleted later
+	insert(shard,hash,id);
+	shard.inserts++;
+	return id;
+}
+
+uint32_t UniqueStringPool::getId(const tiny_string& s)
+{
+	uint32_t hash=hashString(s);
+	Shard& shard=shardFor(hash);
+	uint32_t id;
+	if(find(shard.table.load(std::memory_order_acquire),hash,s,id))
+		return id;
+
+	if(!shard.mutex.trylock())
+	{
+		shard.mutex.lock();
+		shard.contended++;
+	}
+	// another thread may have added the string in the meantime
+	if(find(shard.table.load(std::memory_order_relaxed),hash,s,id))
+		shard.lockedLookups++;
+	else
+		id=addLocked(shard,hash,s);
+	shard.mutex.unlock();
+	return id;
+}
+
+uint32_t UniqueStringPool::addString(const tiny_string& s)
+{
+	uint32_t hash=hashString(s);
+	Shard& shard=shardFor(hash);
+	Locker l(shard.mutex);
+	uint32_t id;
+	if(!find(shard.table.load(std::memory_order_relaxed),hash,s,id))
+		return addLocked(shard,hash,s);
+	// keep the id sequence of duplicated builtin strings, lookups return the first id
+	id=nextId.fetch_add(1,std::memory_order_relaxed);
+	allocateString(id) += s;
+	return id;
+}
+
+void UniqueStringPool::logStatistics() const
+{
+	uint32_t inserts=0;
+	uint32_t lockedLookups=0;
+	uint32_t contended=0;
+	uint32_t capacity=0;
+	for(uint32_t i=0;i<(1<<STRINGPOOL_SHARD_BITS);i++)
+	{
+		Shard& shard=const_cast<Shard&>(shards[i]);
+		Locker l(shard.mutex);
+		inserts+=shard.inserts;
+		lockedLookups+=shard.lockedLookups;
+		contended+=shard.contended;
+		capacity+=shard.table.load(std::memory_order_relaxed)->mask+1;
+	}
+	LOG(LOG_INFO,"unique strings: " << size() << " strings, " << inserts << " added, table capacity " << capacity
+		<< ", " << lockedLookups << " lookups raced with an insertion, " << contended << " contended insertions");
+}
@@ -0,0 +1,102 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H 1
+
+#include "compat.h"
+#include <atomic>
+#include <vector>
+#include "threading.h"
+#include "tiny_string.h"
+
+namespace lightspark
+{
+
+/*
+ * Table of unique strings, every string gets a sequential id.
+ * Looking up an id by string does not take any lock if the string is already
+ * known, only new strings are added under the lock of one of the shards.
+ * Looking up a string by id never blocks, the strings are never moved or
+ * released before the pool is destroyed.
+ */
+class UniqueStringPool
+{
+private:
+	// strings are stored in segments of 2^SEGMENT_BITS strings
+	#define STRINGPOOL_SEGMENT_BITS 12
+	#define STRINGPOOL_MAX_SEGMENTS 0x10000
+	#define STRINGPOOL_SHARD_BITS 4
+	#define STRINGPOOL_SHARD_CAPACITY 8192
+	/*
+	 * Open addressing hash table, every slot contains the hash in the
+	 * high 32 bits and id+1 in the low 32 bits, 0 marks empty slots
+	 */
+	struct Table
+	{
+		std::atomic<uint64_t>* slots;
+		uint32_t mask;
+		// only accessed with the shard mutex held
+		uint32_t count;
+		Table(uint32_t capacity);
+		~Table();
+	};
+	struct Shard
+	{
+		std::atomic<Table*> table;
+		Mutex mutex;
+		// tables replaced by a bigger one, readers may still use them
+		std::vector<Table*> retired;
+		// statistics, only written with the mutex held
+		uint32_t inserts;
+		uint32_t lockedLookups;
+		uint32_t contended;
+		// keep the shards on separate cache lines
+		char padding[64];
+		Shard();
+		~Shard();
+	};
+	Shard shards[1<<STRINGPOOL_SHARD_BITS];
+	std::atomic<tiny_string*>* segments;
+	std::atomic<uint32_t> nextId;
+
+	static uint32_t hashString(const tiny_string& s);
+	bool find(const Table* t, uint32_t hash, const tiny_string& s, uint32_t& id) const;
+	void insert(Shard& shard, uint32_t hash, uint32_t id);
+	tiny_string& allocateString(uint32_t id);
+	uint32_t addLocked(Shard& shard, uint32_t hash, const tiny_string& s);
+	Shard& shardFor(uint32_t hash) { return shards[hash>>(32-STRINGPOOL_SHARD_BITS)]; }
+public:
+	UniqueStringPool();
+	~UniqueStringPool();
+	uint32_t getId(const tiny_string& s);
+	// always creates a new id, used to forge the builtin strings
+	uint32_t addString(const tiny_string& s);
+	const tiny_string& getString(uint32_t id) const
+	{
+		assert(id < nextId.load(std::memory_order_relaxed));
+		tiny_string* segment = segments[id>>STRINGPOOL_SEGMENT_BITS].load(std::memory_order_acquire);
+		return segment[id&((1<<STRINGPOOL_SEGMENT_BITS)-1)];
+	}
+	uint32_t size() const { return nextId.load(std::memory_order_relaxed); }
+	void logStatistics() const;
+};
+
+}
+#endif /* STRING_POOL_H */
@@ -19,6 +19,8 @@
 
 #include <string>
 #include <algorithm>
+#include <deque>
+#include <tuple>
 #include "backends/security.h"
 #include "scripting/abc.h"
 #include "scripting/flash/events/flashevents.h"
@@ -30,6 +32,7 @@
 #include "scripting/toplevel/Number.h"
 #include "scripting/toplevel/Boolean.h"
 #include "scripting/toplevel/Vector.h"
+#include "scripting/toplevel/RegExp.h"
 #include "scripting/avm1/avm1display.h"
 #include "logger.h"
 #include "parsing/streams.h"
@@ -51,6 +54,7 @@
 #endif
 
 #include "compat.h"
+#include <glib/gstdio.h>
 
 #ifdef ENABLE_LIBAVCODEC
 extern "C" {
@@ -177,9 +181,13 @@ void SystemState::addBroadcastEvent(const tiny_string& event)
 	if(!frameListeners.empty())
 	{
 		_R<Event> e(Class<Event>::getInstanceS(this->worker,event));
+		uint32_t eventId=getUniqueStringId(event);
 		auto it=frameListeners.begin();
 		for(;it!=frameListeners.end();it++)
 		{
+			// AS3 objects are registered for any of the frame events, AVM1 objects need all of them
+			if((*it)->needsActionScript3() && !(*it)->hasEventListener(eventId))
+				continue;
 			(*it)->incRef();
 			getVm(this)->addEvent(_MR(*it),e);
 		}
@@ -235,7 +243,8 @@ static const char* builtinStrings[] = {"any", "void", "prototype", "Function", "
 									   "onEnterFrame","onMouseMove","onMouseDown","onMouseUp","onPress","onRelease","onReleaseOutside","onMouseWheel","onLoad",
 									   "object","undefined","boolean","number","string","function","onRollOver","onRollOut",
 									   "__proto__","target","flash.events:IEventDispatcher","addEventListener","removeEventListener","dispatchEvent","hasEventListener",
-									   "onConnect","onData","onClose","onSelect"
+									   "onConnect","onData","onClose","onSelect",
+									   "enterFrame","exitFrame","frameConstructed","render"
 									  };
 
 extern uint32_t asClassCount;
@@ -245,33 +254,21 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	renderThread(nullptr),inputThread(nullptr),engineData(nullptr),dumpedSWFPathAvailable(0),
 	vmVersion(VMNONE),childPid(0),
 	parameters(NullRef),
-	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedStringId(0),lastUsedNamespaceId(0x7fffffff),
-	showProfilingData(false),allowFullscreen(false),flashMode(mode),swffilesize(fileSize),avm1global(nullptr),
-	currentVm(nullptr),builtinClasses(nullptr),useInterpreter(true),useFastInterpreter(false),useJit(false),ignoreUnhandledExceptions(false),exitOnError(ERROR_NONE),
+	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedNamespaceId(0x7fffffff),
+	showProfilingData(false),showDirtyRects(false),allowFullscreen(false),flashMode(mode),swffilesize(fileSize),avm1global(nullptr),
+	currentVm(nullptr),builtinClasses(nullptr),useInterpreter(true),useFastInterpreter(false),useJit(false),useFastRegExp(false),ignoreUnhandledExceptions(false),exitOnError(ERROR_NONE),
 	systemDomain(nullptr),worker(nullptr),workerDomain(nullptr),singleworker(true),
-	downloadManager(nullptr),extScriptObject(nullptr),scaleMode(SHOW_ALL),unaccountedMemory(nullptr),tagsMemory(nullptr),stringMemory(nullptr),textTokenMemory(nullptr),shapeTokenMemory(nullptr),morphShapeTokenMemory(nullptr),bitmapTokenMemory(nullptr),spriteTokenMemory(nullptr),
+	downloadManager(nullptr),extScriptObject(nullptr),scaleMode(SHOW_ALL),samplingProfiler(nullptr),propertyCacheEpoch(1),unaccountedMemory(nullptr),tagsMemory(nullptr),stringMemory(nullptr),textTokenMemory(nullptr),shapeTokenMemory(nullptr),morphShapeTokenMemory(nullptr),bitmapTokenMemory(nullptr),spriteTokenMemory(nullptr),
 	static_SoundMixer_bufferTime(0),static_Multitouch_inputMode("gesture"),isinitialized(false)
 {
 	//Forge the builtin strings
-	uniqueStringIDMap.reserve(LAST_BUILTIN_STRING);
 	tiny_string sempty;
-	uniqueStringMap.emplace(make_pair(sempty,lastUsedStringId));
-	uniqueStringIDMap.push_back(sempty);
-	lastUsedStringId++;
+	uniqueStrings.addString(sempty);
 	for(uint32_t i=1;i<BUILTIN_STRINGS_CHAR_MAX;i++)
-	{
-		tiny_string s = tiny_string::fromChar(i);
-		uniqueStringMap.emplace(make_pair(s,lastUsedStringId));
-		uniqueStringIDMap.push_back(s);
-		lastUsedStringId++;
-	}
+		uniqueStrings.addString(tiny_string::fromChar(i));
 	for(uint32_t i=BUILTIN_STRINGS_CHAR_MAX;i<LAST_BUILTIN_STRING;i++)
-	{
-		tiny_string s(builtinStrings[i-BUILTIN_STRINGS_CHAR_MAX]);
-		uniqueStringMap.emplace(make_pair(s,lastUsedStringId));
-		uniqueStringIDMap.push_back(s);
-		lastUsedStringId++;
-	}
+		uniqueStrings.addString(tiny_string(builtinStrings[i-BUILTIN_STRINGS_CHAR_MAX]));
+	assert(uniqueStrings.size()==LAST_BUILTIN_STRING);
 	//Forge the empty namespace and make sure it gets id 0
 	nsNameAndKindImpl emptyNs(BUILTIN_STRINGS::EMPTY, NAMESPACE);
 	uint32_t nsId;
@@ -351,8 +348,8 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 
 	static_SoundMixer_soundTransform  = _MR(Class<SoundTransform>::getInstanceS(this->worker));
 	static_SoundMixer_soundTransform->setRefConstant();
-	threadPool=new ThreadPool(this);
-	downloadThreadPool=new ThreadPool(this);
+	threadPool=new ThreadPool(this,Config::getConfig()->getThreadPoolSize());
+	downloadThreadPool=new ThreadPool(this,max(Config::getConfig()->getThreadPoolSize(),uint32_t(DOWNLOAD_THREADPOOL_MIN_THREADS)));
 
 	timerThread=new TimerThread(this);
 	frameTimerThread=new TimerThread(this);
@@ -582,19 +579,32 @@ void SystemState::stopEngines()
 	audioManager=nullptr;
 }
 
-#ifdef PROFILING_SUPPORT
 void SystemState::saveProfilingInformation()
 {
 	if(profOut.numBytes())
 	{
+#ifdef PROFILING_SUPPORT
 		ofstream f(profOut.raw_buf());
 		f << "events: Time" << endl;
 		for(uint32_t i=0;i<contextes.size();i++)
 			contextes[i]->dumpProfilingData(f);
+		if (worker && worker->regexpCache)
+		{
+			RegExpCache* c = worker->regexpCache;
+			f << "# regexp cache: instance hits=" << c->instanceHits << " hits=" << c->hits << " misses=" << c->misses << " literal patterns=" << c->literalPatterns << endl;
+		}
 		f.close();
+#else
+		if (samplingProfiler)
+			samplingProfiler->save(profOut);
+		if (worker && worker->regexpCache)
+		{
+			RegExpCache* c = worker->regexpCache;
+			LOG(LOG_INFO,"regexp cache: instance hits=" << c->instanceHits << " hits=" << c->hits << " misses=" << c->misses << " literal patterns=" << c->literalPatterns);
+		}
+#endif
 	}
 }
-#endif
 
 MemoryAccount* SystemState::allocateMemoryAccount(const tiny_string& name)
 {
@@ -684,9 +694,7 @@ SystemState::~SystemState()
 
 void SystemState::destroy()
 {
-#ifdef PROFILING_SUPPORT
 	saveProfilingInformation();
-#endif
 	terminated.wait();
 	//Acquire the mutex to sure that the engines are not being started right now
 	Locker l(rootMutex);
@@ -762,6 +770,8 @@ void SystemState::destroy()
 	//Some objects needs to remove the jobs when destroyed so keep the timerThread until now
 	delete timerThread;
 	timerThread=nullptr;
+	delete samplingProfiler;
+	samplingProfiler=nullptr;
 	delete frameTimerThread;
 	frameTimerThread= nullptr;
 	
@@ -774,7 +784,8 @@ void SystemState::destroy()
 
 	for(auto it=profilingData.begin();it!=profilingData.end();it++)
 		delete *it;
-	uniqueStringMap.clear();
+	uniqueStrings.logStatistics();
+	ObjectShape::logStatistics();
 }
 
 bool SystemState::isOnError() const
@@ -1214,6 +1225,20 @@ void SystemState::addJob(IThreadJob* j)
 {
 	threadPool->addJob(j);
 }
+uint32_t SystemState::getJobThreadCount() const
+{
+	return threadPool ? threadPool->getThreadCount() : 1;
+}
+void SystemState::runParallel(uint32_t count, const std::function<void(uint32_t)>& f)
+{
+	if (threadPool)
+		threadPool->runParallel(count,f);
+	else
+	{
+		for (uint32_t i=0;i<count;i++)
+			f(i);
+	}
+}
 void SystemState::addDownloadJob(IThreadJob* j)
 {
 	downloadThreadPool->addJob(j);
@@ -1370,10 +1395,17 @@ void SystemState::swapAsyncDrawJobQueue()
 }
 
 
-#ifdef PROFILING_SUPPORT
 void SystemState::setProfilingOutput(const tiny_string& t)
 {
 	profOut=t;
+#ifndef PROFILING_SUPPORT
+	// without instruction level profiling we use the sampling profiler
+	if (!samplingProfiler && !profOut.empty())
+	{
+		samplingProfiler = new SamplingProfiler();
+		addTick(1,samplingProfiler);
+	}
+#endif
 }
 
 
@@ -1381,7 +1413,6 @@ const tiny_string& SystemState::getProfilingOutput() const
 {
 	return profOut;
 }
-#endif
 
 void ThreadProfile::setTag(const std::string& t)
 {
@@ -1392,6 +1423,20 @@ void ThreadProfile::setTag(const std::string& t)
 	data.back().tag=t;
 }
 
+void ThreadProfile::setCounter(const std::string& name, uint32_t value)
+{
+	Locker locker(mutex);
+	for(auto it=counters.begin();it!=counters.end();++it)
+	{
+		if(it->first==name)
+		{
+			it->second=value;
+			return;
+		}
+	}
+	counters.emplace_back(name,value);
+}
+
 void ThreadProfile::accountTime(uint32_t time)
 {
 	Locker locker(mutex);
@@ -1489,11 +1534,21 @@ void ThreadProfile::plot(uint32_t maxTime, cairo_t *cr)
 			}
 		}
 	}
+
+	//Draw counters on the right of the plot
+	int counterY=height;
+	for(auto it=counters.begin();it!=counters.end();++it)
+	{
+		string line=it->first+": "+to_string(it->second);
+		cairo_text_extents (cr, line.c_str(), &te);
+		counterY-=te.height+2;
+		getRenderThread()->renderText(cr, line.c_str(), width+10, imax(counterY,0));
+	}
 }
 
 ParseThread::ParseThread(istream& in, _R<ApplicationDomain> appDomain, _R<SecurityDomain> secDomain, Loader *_loader, tiny_string srcurl)
   : version(0),applicationDomain(appDomain),securityDomain(secDomain),
-    f(in),uncompressingFilter(nullptr),backend(nullptr),bytearraybuf(nullptr),loader(_loader),
+    f(in),uncompressingFilter(nullptr),backend(nullptr),bytearraybuf(nullptr),cachedSWFBody(nullptr),swfBodyBuf(nullptr),swfCacheEnabled(false),loader(_loader),
     parsedObject(NullRef),url(srcurl),fileType(FT_UNKNOWN)
 {
 	f.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
@@ -1501,7 +1556,7 @@ ParseThread::ParseThread(istream& in, _R<ApplicationDomain> appDomain, _R<Securi
 
 ParseThread::ParseThread(std::istream& in, RootMovieClip *root)
   : version(0),applicationDomain(NullRef),securityDomain(NullRef), //The domains are not needed since the system state create them itself
-    f(in),uncompressingFilter(nullptr),backend(nullptr),bytearraybuf(nullptr),loader(nullptr),
+    f(in),uncompressingFilter(nullptr),backend(nullptr),bytearraybuf(nullptr),cachedSWFBody(nullptr),swfBodyBuf(nullptr),swfCacheEnabled(true),loader(nullptr),
     parsedObject(NullRef),url(),fileType(FT_UNKNOWN)
 {
 	f.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
@@ -1521,6 +1576,13 @@ ParseThread::~ParseThread()
 		f.rdbuf(backend);
 		delete uncompressingFilter;
 	}
+	if(swfBodyBuf)
+	{
+		f.rdbuf(backend);
+		delete swfBodyBuf;
+	}
+	if(cachedSWFBody)
+		g_mapped_file_unref(cachedSWFBody);
 	parsedObject.reset();
 }
 
@@ -1558,6 +1620,15 @@ void ParseThread::parseSWFHeader(RootMovieClip *root, UI8 ver)
 		LOG(LOG_INFO, "Uncompressed SWF file: Version " << (int)version);
 		root->loaderInfo->setBytesTotal(FileLength);
 	}
+	else if(swfCacheEnabled && Config::getConfig()->isSWFCacheEnabled())
+	{
+		if(fileType==FT_COMPRESSED_SWF)
+			LOG(LOG_INFO, "zlib compressed SWF file: Version " << (int)version);
+		else
+			LOG(LOG_INFO, "lzma compressed SWF file: Version " << (int)version);
+		useSWFCache(FileLength);
+		root->loaderInfo->setBytesTotal(FileLength-8);
+	}
 	else
 	{
 		//The file is compressed, create a filtering streambuf
@@ -1600,6 +1671,115 @@ void ParseThread::parseSWFHeader(RootMovieClip *root, UI8 ver)
 	root->totalFrames_unreliable = FrameCount;
 }
 
+/*
+ * Replaces the compressed body of the swf file by its decompressed version from the cache.
+ * The cache key is a hash of the compressed data, so the whole file is read first.
+ * On a cache miss the body is decompressed at once and stored in the cache.
+ * The modification time of the cache files is used to find the least recently used ones
+ */
+void ParseThread::useSWFCache(uint32_t FileLength)
+{
+	backend=f.rdbuf();
+	vector<uint8_t> compressed;
+	char buf[65536];
+	streamsize n;
+	while((n=backend->sgetn(buf,sizeof(buf)))>0)
+		compressed.insert(compressed.end(),buf,buf+n);
+
+	GChecksum* checksum=g_checksum_new(G_CHECKSUM_SHA256);
+	uint8_t header[6]={(uint8_t)fileType,(uint8_t)version,
+		(uint8_t)FileLength,(uint8_t)(FileLength>>8),(uint8_t)(FileLength>>16),(uint8_t)(FileLength>>24)};
+	g_checksum_update(checksum,header,sizeof(header));
+	g_checksum_update(checksum,compressed.data(),compressed.size());
+	string cacheDirectory=Config::getConfig()->getCacheDirectory()+G_DIR_SEPARATOR_S+"swf";
+	string cacheFile=cacheDirectory+G_DIR_SEPARATOR_S+g_checksum_get_string(checksum);
+	g_checksum_free(checksum);
+
+	uint32_t expectedLength=FileLength-8;
+	const uint8_t* body=nullptr;
+	size_t bodyLength=0;
+	cachedSWFBody=g_mapped_file_new(cacheFile.c_str(),FALSE,nullptr);
+	if(cachedSWFBody && g_mapped_file_get_length(cachedSWFBody)==expectedLength)
+	{
+		LOG(LOG_INFO,"Using cached SWF body " << cacheFile);
+		body=(const uint8_t*)g_mapped_file_get_contents(cachedSWFBody);
+		bodyLength=expectedLength;
+		g_utime(cacheFile.c_str(),nullptr);
+	}
+	else
+	{
+		if(cachedSWFBody)
+		{
+			g_mapped_file_unref(cachedSWFBody);
+			cachedSWFBody=nullptr;
+		}
+		bytes_buf compressedBuf(compressed.data(),compressed.size());
+		uncompressing_filter* filter;
+		if(fileType==FT_COMPRESSED_SWF)
+			filter=new zlib_filter(&compressedBuf);
+		else
+			filter=new liblzma_filter(&compressedBuf);
+		swfBody.resize(expectedLength);
+		bodyLength=filter->sgetn((char*)swfBody.data(),expectedLength);
+		delete filter;
+		swfBody.resize(bodyLength);
+		body=swfBody.data();
+		// only complete files are cached, g_file_set_contents replaces the file atomically
+		uint64_t maxSize=uint64_t(Config::getConfig()->getSWFCacheMaxSize())*1024*1024;
+		if(bodyLength!=expectedLength)
+			LOG(LOG_ERROR,"Truncated compressed SWF file, not cached");
+		else if(maxSize && bodyLength>maxSize)
+			LOG(LOG_INFO,"SWF file larger than the SWF cache, not cached");
+		else
+		{
+			GError* error=nullptr;
+			if(g_mkdir_with_parents(cacheDirectory.c_str(),0700) ||
+				!g_file_set_contents(cacheFile.c_str(),(const gchar*)body,bodyLength,&error))
+			{
+				LOG(LOG_ERROR,"Could not write SWF cache file " << cacheFile << (error ? ": " : "") << (error ? error->message : ""));
+				if(error)
+					g_error_free(error);
+			}
+			else if(maxSize)
+				trimSWFCache(cacheDirectory,maxSize);
+		}
+	}
+	swfBodyBuf=new bytes_buf(body,bodyLength);
+	f.rdbuf(swfBodyBuf);
+}
+
+void ParseThread::trimSWFCache(const string& cacheDirectory, uint64_t maxSize)
+{
+	GDir* dir=g_dir_open(cacheDirectory.c_str(),0,nullptr);
+	if(!dir)
+		return;
+	// (modification time, size, path) of every cache file
+	vector<std::tuple<time_t,uint64_t,string>> files;
+	uint64_t totalSize=0;
+	const gchar* name;
+	while((name=g_dir_read_name(dir)))
+	{
+		string path=cacheDirectory+G_DIR_SEPARATOR_S+name;
+		GStatBuf st;
+		if(g_stat(path.c_str(),&st)==0 && S_ISREG(st.st_mode))
+		{
+			files.emplace_back(st.st_mtime,st.st_size,path);
+			totalSize+=st.st_size;
+		}
+	}
+	g_dir_close(dir);
+	if(totalSize<=maxSize)
+		return;
+	sort(files.begin(),files.end());
+	for(auto it=files.begin();it!=files.end() && totalSize>maxSize;it++)
+	{
+		// another instance may have removed the file already
+		if(g_unlink(std::get<2>(*it).c_str())==0)
+			LOG(LOG_INFO,"Removed SWF cache file " << std::get<2>(*it));
+		totalSize-=std::get<1>(*it);
+	}
+}
+
 void ParseThread::execute()
 {
 	tls_set(parse_thread_tls,this);
@@ -1643,6 +1823,66 @@ void ParseThread::execute()
 		LOG(LOG_ERROR,"Stream exception in ParseThread " << e.what());
 	}
 }
+
+/*
+ * Returns the next tag of the file. Runs of tags that can be parsed independently are read
+ * ahead and parsed in parallel on the thread pool, they are still returned in file order,
+ * so all tags are added to the dictionary and the frames in the same order as before
+ */
+static Tag* readNextTag(TagFactory& factory, RootMovieClip* root, std::deque<PendingTag>& pendingTags, ParseThread* parseThread)
+{
+	if(pendingTags.empty())
+	{
+		size_t bytes=0;
+		Tag* next=nullptr;
+		while(pendingTags.size()<PARSE_BATCH_MAXTAGS && bytes<PARSE_BATCH_MAXBYTES)
+		{
+			pendingTags.emplace_back();
+			next=factory.readTag(root,nullptr,&pendingTags.back());
+			if(next)
+			{
+				pendingTags.pop_back();
+				break;
+			}
+			// a tag that looks up the dictionary ends the run, it is parsed when the tags before it are added
+			if(pendingTags.back().sequential)
+				break;
+			bytes+=pendingTags.back().data.size();
+		}
+		size_t parallelTags=pendingTags.size();
+		if(parallelTags && pendingTags.back().sequential)
+			--parallelTags;
+		root->getSystemState()->runParallel(parallelTags,[&pendingTags,root,parseThread](uint32_t i)
+		{
+			// the tags look up the root movie through the parse thread
+			ParseThread* prev=(ParseThread*)tls_get(parse_thread_tls);
+			tls_set(parse_thread_tls,parseThread);
+			TagFactory::parsePendingTag(pendingTags[i],root);
+			tls_set(parse_thread_tls,prev);
+		});
+		if(next)
+		{
+			pendingTags.emplace_back();
+			pendingTags.back().tag=next;
+		}
+	}
+	PendingTag& p=pendingTags.front();
+	if(p.sequential)
+		TagFactory::parsePendingTag(p,root);
+	Tag* ret=p.tag;
+	std::exception_ptr error=p.error;
+	pendingTags.pop_front();
+	if(error)
+	{
+		// the tags still waiting are skipped as the exception aborts parsing
+		for(auto it=pendingTags.begin();it!=pendingTags.end();++it)
+			delete it->tag;
+		pendingTags.clear();
+		std::rethrow_exception(error);
+	}
+	return ret;
+}
+
 void ParseThread::parseSWF(UI8 ver)
 {
 	if (loader && !loader->allowLoadingSWF())
@@ -1701,6 +1941,9 @@ void ParseThread::parseSWF(UI8 ver)
 			}
 		}
 
+		uint64_t startTime=compat_msectiming();
+		bool parallelParsing=Config::getConfig()->isParallelParsingEnabled();
+		std::deque<PendingTag> pendingTags;
 		TagFactory factory(f);
 		Tag* tag=factory.readTag(root);
 
@@ -1877,8 +2120,11 @@ void ParseThread::parseSWF(UI8 ver)
 				break;
 
 			if (!done)
-				tag=factory.readTag(root);
+				tag=parallelParsing ? readNextTag(factory,root,pendingTags,this) : factory.readTag(root);
 		}// end while
+		for(auto it=pendingTags.begin();it!=pendingTags.end();++it)
+			delete it->tag;
+		LOG(LOG_INFO,"SWF parsed in " << compat_msectiming()-startTime << " ms");
 	}
 	catch(std::exception& e)
 	{
@@ -2180,8 +2426,14 @@ void RootMovieClip::setBackground(const RGB& bg)
 /* called in parser's thread context */
 void RootMovieClip::addToDictionary(DictionaryTag* r)
 {
-	Locker l(dictSpinlock);
-	dictionary[r->getId()] = r;
+	{
+		Locker l(dictSpinlock);
+		dictionary[r->getId()] = r;
+	}
+	// fonts are registered here instead of in their constructors, as those may run on the thread pool
+	FontTag* font=dynamic_cast<FontTag*>(r);
+	if(font)
+		registerEmbeddedFont(font->getFontname(),font);
 }
 
 /* called in vm's thread context */
@@ -2387,26 +2639,12 @@ void SystemState::resizeCompleted()
 
 const tiny_string& SystemState::getStringFromUniqueId(uint32_t id) const
 {
-	Locker l(poolMutex);
-	assert(uniqueStringIDMap.size() > id);
-	return uniqueStringIDMap[id];
+	return uniqueStrings.getString(id);
 }
 
 uint32_t SystemState::getUniqueStringId(const tiny_string& s)
 {
-	Locker l(poolMutex);
-	auto it=uniqueStringMap.find(s);
-	if(it==uniqueStringMap.end())
-	{
-		tiny_string s2;
-		s2 += s; // ensure that a deep copy of the string is stored in the map, as s might be type READONLY/DYNAMIC and be deleted later
-		auto ret=uniqueStringMap.insert(make_pair(s2,lastUsedStringId));
-		uniqueStringIDMap.push_back(s2);
-		assert(ret.second);
-		it=ret.first;
-		lastUsedStringId++;
-	}
-	return it->second;
+	return uniqueStrings.getId(s);
 }
 
 const nsNameAndKindImpl& SystemState::getNamespaceFromUniqueId(uint32_t id) const
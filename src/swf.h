@@ -26,11 +26,13 @@
 #include <queue>
 #include <map>
 #include <unordered_set>
+#include <functional>
 #include <string>
 #include "swftypes.h"
 #include "scripting/flash/display/flashdisplay.h"
 #include "timer.h"
 #include "memory_support.h"
+#include "string_pool.h"
 
 class uncompressing_filter;
 
@@ -52,6 +54,7 @@ class ParseThread;
 class PluginManager;
 class RenderThread;
 class SecurityManager;
+class SamplingProfiler;
 class LocaleManager;
 class CurrencyManager;
 class Tag;
@@ -185,6 +188,7 @@ private:
  		ProfilingData(uint32_t i, uint32_t t):index(i),timing(t){}
 	};
 	std::deque<ProfilingData> data;
+	std::vector<std::pair<std::string,uint32_t>> counters;
 	RGB color;
 	int32_t len;
 	uint32_t tickCount;
@@ -193,6 +197,8 @@ public:
 	ThreadProfile(const RGB& c,uint32_t l,EngineData* _engineData):color(c),len(l),tickCount(0),engineData(_engineData){}
 	void accountTime(uint32_t time);
 	void setTag(const std::string& tag);
+	//Counters are shown next to the plot, setting an existing counter updates its value
+	void setCounter(const std::string& name, uint32_t value);
 	void tick();
 	void plot(uint32_t max, cairo_t *cr);
 };
@@ -292,12 +298,10 @@ private:
 	Mutex drawjobLock;
 	std::unordered_set<AsyncDrawJob*> drawJobsNew;
 	std::unordered_set<AsyncDrawJob*> drawJobsPending;
-#ifdef PROFILING_SUPPORT
 	/*
 	   Output file for the profiling data
 	*/
 	tiny_string profOut;
-#endif
 #ifdef MEMORY_USAGE_PROFILING
 	mutable Mutex memoryAccountsMutex;
 	std::list<MemoryAccount> memoryAccounts;
@@ -306,9 +310,7 @@ private:
 	 * Pooling support
 	 */
 	mutable Mutex poolMutex;
-	map<tiny_string, uint32_t> uniqueStringMap;
-	vector<tiny_string> uniqueStringIDMap;
-	uint32_t lastUsedStringId;
+	UniqueStringPool uniqueStrings;
 	map<nsNameAndKindImpl, uint32_t> uniqueNamespaceImplMap;
 	unordered_map<uint32_t,nsNameAndKindImpl> uniqueNamespaceIDMap;
 	//This needs to be atomic because it's decremented without the mutex held
@@ -325,6 +327,7 @@ public:
 
 	//Interative analysis flags
 	bool showProfilingData;
+	bool showDirtyRects;
 	bool standalone;
 	bool allowFullscreen;
 	bool allowFullscreenInteractive;
@@ -422,6 +425,7 @@ public:
 	bool useInterpreter;
 	bool useFastInterpreter;
 	bool useJit;
+	bool useFastRegExp;
 	bool ignoreUnhandledExceptions;
 	ERROR_TYPE exitOnError;
 
@@ -438,6 +442,10 @@ public:
 
 	//Interfaces to the internal thread pool and timer thread
 	void addJob(IThreadJob* j) DLL_PUBLIC;
+	// number of worker threads executing jobs added by addJob()
+	uint32_t getJobThreadCount() const;
+	// calls f(i) for every i in [0,count) on the thread pool, see ThreadPool::runParallel
+	void runParallel(uint32_t count, const std::function<void(uint32_t)>& f);
 	// downloaders may be executed from inside a job from the main threadpool,
 	// so we use a second threadpool for them, to avoid deadlocks
 	void addDownloadJob(IThreadJob* j) DLL_PUBLIC;
@@ -499,12 +507,17 @@ public:
 	//Resize support
 	void resizeCompleted();
 
-#ifdef PROFILING_SUPPORT
 	void setProfilingOutput(const tiny_string& t) DLL_PUBLIC;
 	const tiny_string& getProfilingOutput() const;
+#ifdef PROFILING_SUPPORT
 	std::vector<ABCContext*> contextes;
-	void saveProfilingInformation();
 #endif
+	void saveProfilingInformation();
+	// only used if no instruction level profiling support is compiled in
+	SamplingProfiler* samplingProfiler;
+	// incremented whenever class layouts may have changed, invalidates all property inline caches
+	ATOMIC_INT32(propertyCacheEpoch);
+	void invalidatePropertyCaches() { ATOMIC_INCREMENT(propertyCacheEpoch); }
 	MemoryAccount* allocateMemoryAccount(const tiny_string& name) DLL_PUBLIC;
 	MemoryAccount* unaccountedMemory;
 	MemoryAccount* tagsMemory;
@@ -634,12 +647,20 @@ public:
 	_NR<SecurityDomain> securityDomain;
 	void getSWFByteArray(ByteArray* ba);
 	void addExtensions(std::vector<tiny_string>& ext) { extensions = ext; }
+	// the swf cache is used for the main swf file, Loader enables it for swf files loaded from an URL
+	void enableSWFCache() { swfCacheEnabled=true; }
 private:
 	std::vector<tiny_string> extensions;
 	std::istream& f;
 	uncompressing_filter* uncompressingFilter;
 	std::streambuf* backend;
 	std::streambuf* bytearraybuf;
+	// decompressed body of a compressed swf file when the swf cache is used,
+	// either decompressed into swfBody or mapped from the cache
+	std::vector<uint8_t> swfBody;
+	GMappedFile* cachedSWFBody;
+	std::streambuf* swfBodyBuf;
+	bool swfCacheEnabled;
 	Loader *loader;
 	_NR<DisplayObject> parsedObject;
 	Mutex objectSpinlock;
@@ -648,6 +669,8 @@ private:
 	void threadAbort() override;
 	void jobFence() override {}
 	void parseSWFHeader(RootMovieClip *root, UI8 ver);
+	void useSWFCache(uint32_t FileLength);
+	static void trimSWFCache(const std::string& cacheDirectory, uint64_t maxSize);
 	void parseSWF(UI8 ver);
 	void parseBitmap();
 	void setRootMovie(RootMovieClip *root);
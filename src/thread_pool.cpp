@@ -17,6 +17,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **************************************************************************/
 #include <cassert>
+#include <algorithm>
+#include <memory>
 
 #include "thread_pool.h"
 #include "exceptions.h"
@@ -27,16 +29,19 @@
 
 using namespace lightspark;
 
-ThreadPool::ThreadPool(SystemState* s):num_jobs(0),stopFlag(false),runcount(0)
+// the ThreadPoolData of the current thread, if it is a worker thread of a pool
+DEFINE_AND_INITIALIZE_TLS(tls_pool_worker);
+
+ThreadPool::ThreadPool(SystemState* s, uint32_t threadcount):num_jobs(0),stopFlag(false),busyJobs(0),runningHighPriorityJobs(0),nextQueue(0),
+	queuedJobs(0),executedJobs(0),stolenJobs(0),additionalThreads(0),runningAdditionalThreads(new std::atomic<int32_t>(0))
 {
 	m_sys=s;
-	for(uint32_t i=0;i<NUM_THREADS;i++)
-	{
-		curJobs[i]=nullptr;
-		data[i].index=i;
-		data[i].pool = this;
-		threads[i] = SDL_CreateThread(job_worker,"ThreadPool",&data[i]);
-	}
+	if (threadcount == 0)
+		threadcount = std::max(SDL_GetCPUCount(),2);
+	for(uint32_t i=0;i<threadcount;i++)
+		data.push_back(new ThreadPoolData(this,i));
+	for(uint32_t i=0;i<threadcount;i++)
+		data[i]->thread = SDL_CreateThread(job_worker,"ThreadPool",data[i]);
 }
 
 void ThreadPool::forceStop()
@@ -45,43 +50,78 @@ void ThreadPool::forceStop()
 	{
 		stopFlag=true;
 		//Signal an event for all the threads
-		for(int i=0;i<NUM_THREADS;i++)
+		for(uint32_t i=0;i<data.size();i++)
 			num_jobs.signal();
 
+		for(uint32_t i=0;i<data.size();i++)
 		{
-			Locker l(mutex);
+			Locker l(data[i]->mutex);
 			//Now abort any job that is still executing
-			for(int i=0;i<NUM_THREADS;i++)
+			if(data[i]->curJob)
 			{
-				if(curJobs[i])
-				{
-					curJobs[i]->threadAborting = true;
-					curJobs[i]->threadAbort();
-				}
+				data[i]->curJob->threadAborting = true;
+				data[i]->curJob->threadAbort();
 			}
 			//Fence all the non executed jobs
-			std::deque<IThreadJob*>::iterator it=jobs.begin();
-			for(;it!=jobs.end();++it)
-				(*it)->jobFence();
-			jobs.clear();
+			for (int prio = 0; prio < 2; prio++)
+			{
+				for(auto it=data[i]->jobs[prio].begin();it!=data[i]->jobs[prio].end();++it)
+					(*it)->jobFence();
+				data[i]->jobs[prio].clear();
+			}
 		}
 
-		for(int i=0;i<NUM_THREADS;i++)
+		for(uint32_t i=0;i<data.size();i++)
 		{
-			SDL_WaitThread(threads[i],nullptr);
+			SDL_WaitThread(data[i]->thread,nullptr);
 		}
+		LOG(LOG_INFO,"ThreadPool: "<<data.size()<<" threads executed "<<executedJobs<<" jobs, "<<stolenJobs<<" stolen, "<<additionalThreads<<" in additional threads");
 	}
 }
 
 ThreadPool::~ThreadPool()
 {
 	forceStop();
+	for(uint32_t i=0;i<data.size();i++)
+		delete data[i];
+}
+
+IThreadJob* ThreadPool::getJob(ThreadPoolData* d)
+{
+	// high priority jobs are always taken first, regardless of the queue they are in
+	for (int prio = 1; prio >= 0; prio--)
+	{
+		for (uint32_t i = 0; i < data.size(); i++)
+		{
+			ThreadPoolData* q = data[(d->index+i)%data.size()];
+			Locker l(q->mutex);
+			if (q->jobs[prio].empty())
+				continue;
+			IThreadJob* j;
+			if (q == d)
+			{
+				j = q->jobs[prio].front();
+				q->jobs[prio].pop_front();
+			}
+			else
+			{
+				// steal from the other end of the queue to avoid competing with the owner for the same jobs
+				j = q->jobs[prio].back();
+				q->jobs[prio].pop_back();
+				ATOMIC_INCREMENT(stolenJobs);
+			}
+			ATOMIC_DECREMENT(queuedJobs);
+			return j;
+		}
+	}
+	return nullptr;
 }
 
 int ThreadPool::job_worker(void *d)
 {
 	ThreadPoolData* data = (ThreadPoolData*)d;
 	setTLSSys(data->pool->m_sys);
+	tls_set(tls_pool_worker,data);
 
 	ThreadProfile* profile=data->pool->m_sys->allocateProfiler(RGB(200,200,0));
 	char buf[16];
@@ -94,12 +134,16 @@ int ThreadPool::job_worker(void *d)
 		data->pool->num_jobs.wait();
 		if(data->pool->stopFlag)
 			return 0;
-		Locker l(data->pool->mutex);
-		IThreadJob* myJob=data->pool->jobs.front();
-		data->pool->jobs.pop_front();
-		data->pool->curJobs[data->index]=myJob;
-		data->pool->runcount++;
-		l.release();
+		// every signal of num_jobs belongs to a job that was added to one of the queues before,
+		// so we will always find a job unless the queues were cleared in forceStop
+		IThreadJob* myJob=data->pool->getJob(data);
+		if (!myJob)
+			continue;
+		data->mutex.lock();
+		data->curJob=myJob;
+		data->mutex.unlock();
+		if (myJob->highPriority)
+			ATOMIC_INCREMENT(data->pool->runningHighPriorityJobs);
 
 		setTLSWorker(myJob->fromWorker);
 		chronometer.checkpoint();
@@ -127,10 +171,13 @@ int ThreadPool::job_worker(void *d)
 		
 		profile->accountTime(chronometer.checkpoint());
 
-		l.acquire();
-		data->pool->curJobs[data->index]=nullptr;
-		data->pool->runcount--;
-		l.release();
+		data->mutex.lock();
+		data->curJob=nullptr;
+		data->mutex.unlock();
+		if (myJob->highPriority)
+			ATOMIC_DECREMENT(data->pool->runningHighPriorityJobs);
+		ATOMIC_DECREMENT(data->pool->busyJobs);
+		ATOMIC_INCREMENT(data->pool->executedJobs);
 
 		//jobFencing is allowed to happen outside the mutex
 		myJob->jobFence();
@@ -140,34 +187,125 @@ int ThreadPool::job_worker(void *d)
 
 void ThreadPool::addJob(IThreadJob* j)
 {
-	Locker l(mutex);
+	assert(j);
 	j->setWorker(getWorker());
 	if(stopFlag)
 	{
 		j->jobFence();
 		return;
 	}
-	assert(j);
-	if (runcount == NUM_THREADS)
+	if (ATOMIC_INCREMENT(busyJobs) > (int32_t)data.size())
 	{
-		// no slot available, we create an additional thread
-		runAdditionalThread(j);
+		// all workers are busy. A queued high priority job will be executed soon if another
+		// high priority job is running, in all other cases the running jobs may block for a long time,
+		// so we create an additional thread. There are at most as many additional threads as workers,
+		// further jobs are queued to avoid oversubscribing the CPUs
+		if (!j->highPriority || runningHighPriorityJobs == 0)
+		{
+			if (runningAdditionalThreads->fetch_add(1) < (int32_t)data.size())
+			{
+				ATOMIC_DECREMENT(busyJobs);
+				ATOMIC_INCREMENT(additionalThreads);
+				runAdditionalThread(j);
+				return;
+			}
+			runningAdditionalThreads->fetch_sub(1);
+		}
 	}
-	else
+	ThreadPoolData* q = (ThreadPoolData*)tls_get(tls_pool_worker);
+	if (!q || q->pool != this)
+		q = data[uint32_t(ATOMIC_INCREMENT(nextQueue))%data.size()];
+	q->mutex.lock();
+	// check stopFlag again while holding the queue mutex, so the job can't get lost if forceStop() was called in between
+	if(stopFlag)
 	{
-		jobs.push_back(j);
-		num_jobs.signal();
+		q->mutex.unlock();
+		ATOMIC_DECREMENT(busyJobs);
+		j->jobFence();
+		return;
+	}
+	q->jobs[j->highPriority ? 1 : 0].push_back(j);
+	ATOMIC_INCREMENT(queuedJobs);
+	q->mutex.unlock();
+	num_jobs.signal();
+}
+namespace
+{
+/*
+ * State shared between the caller of runParallel and the helper jobs.
+ * Helpers may start after all items are done, so it is reference counted
+ * and the function is only accessed for claimed items.
+ */
+struct ParallelRun
+{
+	const std::function<void(uint32_t)>* f;
+	int32_t count;
+	ATOMIC_INT32(nextItem);
+	ATOMIC_INT32(doneItems);
+	Semaphore finished;
+	ParallelRun(const std::function<void(uint32_t)>* _f, int32_t c):f(_f),count(c),nextItem(0),doneItems(0),finished(0) {}
+	void run()
+	{
+		while(true)
+		{
+			int32_t item=ATOMIC_INCREMENT(nextItem)-1;
+			if(item>=count)
+				break;
+			(*f)(item);
+			if(ATOMIC_INCREMENT(doneItems)==count)
+				finished.signal();
+		}
+	}
+};
+
+class ParallelRunJob: public IThreadJob
+{
+private:
+	std::shared_ptr<ParallelRun> state;
+public:
+	ParallelRunJob(std::shared_ptr<ParallelRun> s):state(s)
+	{
+		highPriority=true;
 	}
+	void execute() override { state->run(); }
+	void jobFence() override { delete this; }
+};
+}
+
+void ThreadPool::runParallel(uint32_t count, const std::function<void(uint32_t)>& f)
+{
+	if(count==0)
+		return;
+	std::shared_ptr<ParallelRun> state=std::make_shared<ParallelRun>(&f,count);
+	// only use idle workers, so we never spawn additional threads for the helpers
+	int32_t helpers=std::min(int32_t(count)-1,int32_t(data.size())-busyJobs);
+	for(int32_t i=0;i<helpers;i++)
+		addJob(new ParallelRunJob(state));
+	state->run();
+	// all items are claimed now, wait for the ones still running in the helpers
+	state->finished.wait();
 }
+
+namespace
+{
+struct AdditionalThreadData
+{
+	IThreadJob* job;
+	std::shared_ptr<std::atomic<int32_t>> running;
+	AdditionalThreadData(IThreadJob* j, const std::shared_ptr<std::atomic<int32_t>>& r):job(j),running(r) {}
+};
+}
+
 void ThreadPool::runAdditionalThread(IThreadJob* j)
 {
-	SDL_Thread* t = SDL_CreateThread(additional_job_worker,"additionalThread",j);
+	SDL_Thread* t = SDL_CreateThread(additional_job_worker,"additionalThread",new AdditionalThreadData(j,runningAdditionalThreads));
 	SDL_DetachThread(t);
 }
 
 int ThreadPool::additional_job_worker(void* d)
 {
-	IThreadJob* myJob=(IThreadJob*)d;
+	AdditionalThreadData* threadData=(AdditionalThreadData*)d;
+	IThreadJob* myJob=threadData->job;
 
 	setTLSSys(myJob->fromWorker->getSystemState());
 	setTLSWorker(myJob->fromWorker);
@@ -189,6 +327,8 @@ int ThreadPool::additional_job_worker(void* d)
 		LOG(LOG_ERROR,"std Exception in AdditionalThread:"<<myJob<<" "<<e.what());
 		myJob->fromWorker->getSystemState()->setError(e.what());
 	}
+	threadData->running->fetch_sub(1);
+	delete threadData;
 	myJob->jobFence();
 	return 0;
 }
@@ -22,16 +22,29 @@
 
 #include "compat.h"
 #include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
 #include <cstdlib>
 #include "threading.h"
 
 namespace lightspark
 {
 
-#define NUM_THREADS 20
-
 class SystemState;
 
+// minimum number of threads of the download pool, downloads block their thread for a long time
+#define DOWNLOAD_THREADPOOL_MIN_THREADS 20
+
+/*
+ * Work-stealing thread pool:
+ * Every worker thread has its own job queues. New jobs are distributed round-robin over the queues,
+ * jobs added from inside a pool thread go to the queue of that thread. A worker takes jobs
+ * from its own queue first and steals from the other queues if its queue is empty.
+ * High priority jobs (like AsyncDrawJob) are always taken before normal jobs.
+ * As jobs may block for a long time (e.g. waiting for downloads), jobs are executed in an
+ * additional thread if all workers are busy.
+ */
 class ThreadPool
 {
 private:
@@ -39,24 +52,50 @@ private:
 	{
 		ThreadPool* pool;
 		int index;
+		SDL_Thread* thread;
+		Mutex mutex;
+		// queues for normal and high priority jobs, protected by mutex
+		std::deque<IThreadJob*> jobs[2];
+		IThreadJob* volatile curJob;
+		ThreadPoolData(ThreadPool* p,int i):pool(p),index(i),thread(nullptr),curJob(nullptr) {}
 	};
-	Mutex mutex;
-	SDL_Thread* threads[NUM_THREADS];
-	ThreadPoolData data[NUM_THREADS];
-	IThreadJob* volatile curJobs[NUM_THREADS];
-	std::deque<IThreadJob*> jobs;
+	std::vector<ThreadPoolData*> data;
 	Semaphore num_jobs;
 	static int job_worker(void* d);
+	IThreadJob* getJob(ThreadPoolData* d);
 	SystemState* m_sys;
 	volatile bool stopFlag;
-	uint32_t runcount;
+	// number of jobs that are queued or running in one of the worker threads
+	ATOMIC_INT32(busyJobs);
+	ATOMIC_INT32(runningHighPriorityJobs);
+	ATOMIC_INT32(nextQueue);
+	// statistics
+	ATOMIC_INT32(queuedJobs);
+	ATOMIC_INT32(executedJobs);
+	ATOMIC_INT32(stolenJobs);
+	ATOMIC_INT32(additionalThreads);
+	// number of running additional threads, shared with the threads as they may outlive the pool
+	std::shared_ptr<std::atomic<int32_t>> runningAdditionalThreads;
 	void runAdditionalThread(IThreadJob* j);
 	static int additional_job_worker(void* d);
 public:
-	ThreadPool(SystemState* s);
+	/* threadcount == 0 creates one worker thread for every CPU */
+	ThreadPool(SystemState* s, uint32_t threadcount=0);
 	~ThreadPool();
 	void addJob(IThreadJob* j);
+	/*
+	 * Calls f(i) for every i in [0,count), distributed over the idle worker threads.
+	 * The calling thread runs items as well and returns after all items are done,
+	 * so it is safe to call this from inside a job.
+	 */
+	void runParallel(uint32_t count, const std::function<void(uint32_t)>& f);
 	void forceStop();
+	uint32_t getThreadCount() const { return data.size(); }
+	/* number of jobs waiting for a free worker thread */
+	int32_t getQueueDepth() const { return queuedJobs; }
+	int32_t getExecutedJobs() const { return executedJobs; }
+	int32_t getStolenJobs() const { return stolenJobs; }
+	int32_t getAdditionalThreads() const { return additionalThreads; }
 };
 
 }
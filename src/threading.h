@@ -122,6 +122,8 @@ public:
 	void signal();
 	void wait();
 	bool try_wait();
+	//Returns false if the semaphore was not signaled within ms milliseconds
+	bool wait_until(uint32_t ms);
 };
 
 class SemaphoreLighter
@@ -157,6 +159,12 @@ public:
 	 * to poll threadAborted and not implement threadAbort().
 	 */
 	volatile bool threadAborting;
+	/*
+	 * High priority jobs are executed by the ThreadPool
+	 * before all normal jobs. Should only be set for
+	 * short running jobs that never block (like rendering).
+	 */
+	bool highPriority;
 	/*
 	 * Called in a dedicated thread to do the actual
 	 * work. You may throw a JobTerminationException
@@ -180,7 +188,7 @@ public:
 	 * 'delete this'.
 	 */
 	virtual void jobFence()=0;
-	IThreadJob() : fromWorker(nullptr),threadAborting(false) {}
+	IThreadJob() : fromWorker(nullptr),threadAborting(false),highPriority(false) {}
 	virtual ~IThreadJob() {}
 	void setWorker(ASWorker* w) { fromWorker = w;}
 };
@@ -233,6 +241,14 @@ public:
 		freeBuffers.signal();
 		return true;
 	}
+	//Blocks until an element is available or ms milliseconds passed, the element is not removed
+	bool waitNotEmpty(uint32_t ms)
+	{
+		if(!usedBuffers.wait_until(ms))
+			return false;
+		usedBuffers.signal();
+		return true;
+	}
 	T& acquireLast()
 	{
 		freeBuffers.wait();
@@ -240,6 +256,15 @@ public:
 		bufferTail=(bufferTail+1)%size;
 		return queue[ret];
 	}
+	//Returns nullptr if no buffer gets free within ms milliseconds
+	T* acquireLast(uint32_t ms)
+	{
+		if(!freeBuffers.wait_until(ms))
+			return nullptr;
+		uint32_t ret=bufferTail;
+		bufferTail=(bufferTail+1)%size;
+		return &queue[ret];
+	}
 	void commitLast()
 	{
 		empty=false;
@@ -0,0 +1,29 @@
+package
+{
+	public class PropertyAccessPoint
+	{
+		public var x:Number = 0;
+		public var y:Number = 0;
+
+		// returns instances of different classes sharing the same properties
+		public static function create(kind:int):PropertyAccessPoint
+		{
+			switch (kind)
+			{
+				case 1: return new PropertyAccessPointB();
+				case 2: return new PropertyAccessPointC();
+			}
+			return new PropertyAccessPoint();
+		}
+	}
+}
+
+class PropertyAccessPointB extends PropertyAccessPoint
+{
+	public var z:Number = 0;
+}
+
+class PropertyAccessPointC extends PropertyAccessPoint
+{
+	public var name:String = "c";
+}